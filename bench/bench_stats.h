@@ -0,0 +1,38 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <ure_utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * Nearest-rank percentile @p p, in [0,1], of @p sorted values; 0 when empty.
+ */
+inline ure::double_t  percentile( const std::vector<ure::double_t>& sorted, ure::double_t p ) noexcept
+{
+  if ( sorted.empty() )
+    return 0.0;
+
+  const std::size_t rank = static_cast<std::size_t>( std::ceil( p * static_cast<ure::double_t>( sorted.size() ) ) );
+
+  return sorted[ std::min( ( rank > 0 ) ? rank - 1 : 0, sorted.size() - 1 ) ];
+}
+
+#endif // BENCH_STATS_H
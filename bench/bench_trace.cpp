@@ -0,0 +1,107 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "bench_trace.h"
+
+#include <fstream>
+#include <sstream>
+
+ure::bool_t  BenchTrace::load( const std::string& path ) noexcept(true)
+{
+  std::ifstream file( path );
+  if ( file.is_open() == false )
+    return false;
+
+  std::stringstream text;
+  text << file.rdbuf();
+
+  return parse( text.str() );
+}
+
+ure::bool_t  BenchTrace::parse( const std::string& text ) noexcept(true)
+{
+  std::vector<event_t>  events;
+  std::istringstream    lines( text );
+  std::string           line;
+
+  while ( std::getline( lines, line ) )
+  {
+    std::istringstream  fields( line );
+    std::string         command;
+
+    if ( !( fields >> command ) || ( command[0] == '#' ) )
+      continue;
+
+    if ( command == "pan" )
+    {
+      ure::float_t  dx, dy;
+      ure::uint_t   frames;
+
+      if ( !( fields >> dx >> dy >> frames ) || ( frames == 0 ) )
+        return false;
+
+      events.insert( events.end(), frames, event_t{ dx / frames, dy / frames, 0.0f, 0.0f, 0.0f } );
+    }
+    else if ( command == "zoom" )
+    {
+      ure::float_t  notches, x, y;
+
+      if ( !( fields >> notches >> x >> y ) )
+        return false;
+
+      events.push_back( event_t{ 0.0f, 0.0f, notches, x, y } );
+    }
+    else if ( command == "idle" )
+    {
+      ure::uint_t   frames;
+
+      if ( !( fields >> frames ) )
+        return false;
+
+      events.insert( events.end(), frames, event_t{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } );
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  if ( events.empty() )
+    return false;
+
+  m_events = std::move( events );
+
+  return true;
+}
+
+const char*  BenchTrace::default_trace() noexcept
+{
+  return
+    "idle 30\n"
+    "zoom 1 0 0\n"
+    "idle 20\n"
+    "zoom 1 120 -80\n"
+    "idle 20\n"
+    "pan 600 0 60\n"
+    "pan 0 400 40\n"
+    "zoom 1 -200 100\n"
+    "idle 20\n"
+    "pan -900 -300 90\n"
+    "zoom -1 0 0\n"
+    "idle 20\n"
+    "zoom -2 50 50\n"
+    "idle 30\n";
+}
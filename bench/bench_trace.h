@@ -0,0 +1,73 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef BENCH_TRACE_H
+#define BENCH_TRACE_H
+
+#include <ure_utils.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Input replayed by map_bench, one command per line:
+ *
+ *   pan  DX DY FRAMES   drag the map by ( DX, DY ) pixels spread over FRAMES frames
+ *   zoom NOTCHES X Y    wheel NOTCHES at ( X, Y ), relative to the window centre
+ *   idle FRAMES         no input for FRAMES frames
+ *
+ * Empty lines and lines starting with '#' are ignored.
+ */
+class BenchTrace
+{
+public:
+  struct event_t
+  {
+    ure::float_t  dx;         /* Pan for this frame */
+    ure::float_t  dy;
+    ure::float_t  notches;    /* Wheel notches for this frame, 0 for none */
+    ure::float_t  x;          /* Wheel position */
+    ure::float_t  y;
+  };
+
+  /**
+   * Load @p path, return false and leave the trace unchanged on errors.
+   */
+  ure::bool_t     load( const std::string& path ) noexcept(true);
+  /**
+   * Parse @p text, same format as files.
+   */
+  ure::bool_t     parse( const std::string& text ) noexcept(true);
+
+  /**
+   * Pans and zooms across a few levels, used when no trace is given.
+   */
+  static const char*  default_trace() noexcept;
+
+  /**
+   * Input for frame @p frame, the trace loops when it is shorter than the run.
+   */
+  const event_t&  at( std::size_t frame ) const noexcept(true)
+  { return m_events[ frame % m_events.size() ]; }
+
+  /***/
+  std::size_t     frames() const noexcept
+  { return m_events.size(); }
+
+private:
+  std::vector<event_t>   m_events;   /* One per frame */
+};
+
+#endif // BENCH_TRACE_H
@@ -0,0 +1,198 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef BENCH_VIEW_H
+#define BENCH_VIEW_H
+
+#include <ure_utils.h>
+
+#include "bench_trace.h"
+
+#include "map_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+/**
+ * MapView driving a set of layers the way Map::update_view() does.
+ *
+ * Every layer gets set_zoom(), set_origin() and set_view() for the drawn level each time
+ * the view changes, draw() draws them in order. The view starts at the top left corner
+ * of the world.
+ */
+template<typename... layers_t>
+class BenchView
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /***/
+  BenchView( const ure::Size& size, ure::int_t level, ure::int_t max_levels, layers_t&... layers ) noexcept
+    : m_layers( layers... ), m_size( size ), m_view( max_levels )
+  {
+    m_view.reset( m_size, std::clamp( level, 0, max_levels - 1 ) );
+    update_view();
+  }
+
+  /**
+   * Centre the window on @p point, normalized world coordinates, before the first frame.
+   */
+  void  centre_on( const glm::dvec2& point, ure::uint_t tile_pixels ) noexcept
+  {
+    const ure::double_t  world = std::ldexp( static_cast<ure::double_t>( tile_pixels ), m_view.levels().current );
+
+    m_view.centre_on( point * world );
+    update_view();
+  }
+
+  /**
+   * Apply the pan and wheel of @p event and move the zoom animation to @p now.
+   */
+  void  input( const BenchTrace::event_t& event, clock_t::time_point now ) noexcept
+  {
+    if ( ( event.dx != 0.0f ) || ( event.dy != 0.0f ) )
+    {
+      m_view.pan( glm::vec2( event.dx, event.dy ) );
+      update_view();
+    }
+
+    if ( event.notches != 0.0f )
+      m_view.zoom_by( event.notches, glm::vec2( event.x, event.y ), now );
+
+    if ( m_view.animate( now ) )
+      update_view();
+  }
+
+  /***/
+  void  draw() noexcept
+  { std::apply( []( auto&... layer ) { ( layer.draw(), ... ); }, m_layers ); }
+
+  /**
+   * input() followed by draw().
+   */
+  void  frame( const BenchTrace::event_t& event, clock_t::time_point now ) noexcept
+  {
+    input( event, now );
+    draw();
+  }
+
+  /***/
+  const MapView&     view() const noexcept
+  { return m_view; }
+  /** Model matrix of the drawn level, as given to the layers */
+  const glm::mat4&   model() const noexcept
+  { return m_model; }
+
+private:
+  /***/
+  void  update_view() noexcept
+  {
+    const MapView::levels_t  levels = m_view.levels();
+    const glm::vec2          origin = m_view.origin( levels.draw );
+
+    m_model = m_view.level_model( levels.draw );
+
+    std::apply( [&]( auto&... layer )
+    {
+      ( ( layer.set_zoom( static_cast<ure::word_t>(levels.draw) ), layer.set_origin( origin ), layer.set_view( m_model, m_size ) ), ... );
+    }, m_layers );
+  }
+
+private:
+  std::tuple<layers_t&...>   m_layers;
+  const ure::Size            m_size;
+  MapView                    m_view;
+  glm::mat4                  m_model;
+};
+
+/**
+ * Replay of a BenchTrace with a fixed 60 Hz clock, @p warmup frames then @p frames
+ * measured ones:
+ *
+ *   while ( replay.next() )
+ *   {
+ *     replay.begin();
+ *     view.frame( replay.event(), replay.now() );
+ *     replay.end();
+ *   }
+ *
+ * Only the time between begin() and end() of measured frames is recorded.
+ */
+class BenchReplay
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /***/
+  BenchReplay( const BenchTrace& trace, ure::uint_t warmup, ure::uint_t frames ) noexcept
+    : m_trace( trace ), m_warmup( warmup ), m_frames( frames ), m_epoch( clock_t::now() ), m_index( 0 ), m_next( 0 )
+  { m_frame_ms.reserve( frames ); }
+
+  /**
+   * Move to the next frame, false once all frames have run.
+   */
+  ure::bool_t   next() noexcept
+  {
+    m_index = m_next++;
+
+    return m_index < m_warmup + m_frames;
+  }
+
+  /** Frame number, warmup included */
+  ure::uint_t   index() const noexcept
+  { return m_index; }
+  /** True for the first measured frame, counters are sampled before it */
+  ure::bool_t   starting() const noexcept
+  { return m_index == m_warmup; }
+  /***/
+  ure::bool_t   measured() const noexcept
+  { return m_index >= m_warmup; }
+
+  /***/
+  const BenchTrace::event_t&  event() const noexcept
+  { return m_trace.at( m_index ); }
+  /** Clock of the current frame */
+  clock_t::time_point         now() const noexcept
+  { return m_epoch + m_index * std::chrono::microseconds(16667); }
+
+  /***/
+  void  begin() noexcept
+  { m_begin = clock_t::now(); }
+  /***/
+  void  end() noexcept
+  {
+    if ( measured() )
+      m_frame_ms.push_back( std::chrono::duration<ure::double_t, std::milli>( clock_t::now() - m_begin ).count() );
+  }
+
+  /** Time of the measured frames, in order */
+  const std::vector<ure::double_t>&  frame_ms() const noexcept
+  { return m_frame_ms; }
+
+private:
+  const BenchTrace&           m_trace;
+  const ure::uint_t           m_warmup;
+  const ure::uint_t           m_frames;
+  const clock_t::time_point   m_epoch;
+  ure::uint_t                 m_index;
+  ure::uint_t                 m_next;
+  clock_t::time_point         m_begin;
+  std::vector<ure::double_t>  m_frame_ms;
+};
+
+#endif // BENCH_VIEW_H
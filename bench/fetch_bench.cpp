@@ -0,0 +1,326 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Throughput and latency of the tile download path:
+ * ResourcesFetcher -> TileLevel::on_download_succeeded() -> decoder -> atlas texture.
+ *
+ * Tiles come from a TileServer on the loopback interface, or from --url, and are
+ * loaded one screen at a time at each concurrency level, i.e. downloads in flight
+ * per host. GL calls go to the null driver, the upload path is exercised without a GPU.
+ */
+
+#include "bench_stats.h"
+#include "null_gl.h"
+#include "tile_server.h"
+
+#include "map_view.h"
+#include "tile_context.h"
+#include "tile_level.h"
+
+#include <ure_resources_fetcher.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+
+  struct options_t
+  {
+    std::vector<ure::uint_t>    concurrency   = { 1, 2, 4, 8, 16 };
+    ure::uint_t                 tiles         = 256;      /* Tiles loaded per concurrency level */
+    ure::int_t                  zoom          = 10;
+    ure::Size                   viewport      = { 1024, 768 };
+    std::string                 url;                      /* External server, the loopback one by default */
+    std::string                 directory;
+    TileServer::options_t       server;
+    std::chrono::seconds        timeout       { 60 };     /* Per concurrency level */
+  };
+
+  struct result_t
+  {
+    ure::uint_t                 tiles;
+    ure::double_t               seconds;
+    std::vector<ure::double_t>  network_ms;   /* Dispatch to on_download_succeeded() */
+    std::vector<ure::double_t>  total_ms;     /* Dispatch to texture in the atlas */
+    ure::bool_t                 timed_out;
+  };
+
+  /**
+   * Tile level recording when downloads complete.
+   */
+  class TimedLevel : public TileLevel
+  {
+  public:
+    TimedLevel( TileContext& tiles, ure::word_t zoom ) noexcept(true)
+      : TileLevel( tiles, zoom )
+    {}
+
+    /** Completion time of @p key, erased once returned */
+    std::optional<bench_clock_t::time_point>  take_arrival( const TileKey& key ) noexcept(true)
+    {
+      std::lock_guard<std::mutex> lock( m_mutex );
+
+      auto it = m_arrivals.find( key );
+      if ( it == m_arrivals.end() )
+        return std::nullopt;
+
+      const bench_clock_t::time_point at = it->second;
+      m_arrivals.erase( it );
+      return at;
+    }
+
+  protected:
+    virtual ure::void_t on_download_succeeded( std::string_view name, const std::type_info& type, const ure::byte_t* data, ure::uint_t length ) noexcept(true) override
+    {
+      const bench_clock_t::time_point now = bench_clock_t::now();
+      std::optional<TileKey>          key = TileKey::parse( name );
+
+      if ( key.has_value() )
+      {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_arrivals.insert_or_assign( key.value(), now );
+      }
+
+      TileLevel::on_download_succeeded( name, type, data, length );
+    }
+
+  private:
+    std::mutex                                                m_mutex;
+    std::unordered_map<TileKey, bench_clock_t::time_point>    m_arrivals;
+  };
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    auto ms = []( const char* value ) { return std::chrono::microseconds( static_cast<std::int64_t>( std::strtod( value, nullptr ) * 1000 ) ); };
+
+    options.server.latency = std::chrono::milliseconds(20);
+    options.server.jitter  = std::chrono::milliseconds(10);
+
+    for ( int i = 1; i < argc; i += 2 )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[i + 1];
+
+      if ( arg == "--concurrency" )
+      {
+        std::istringstream  list( value );
+        std::string         item;
+
+        options.concurrency.clear();
+        while ( std::getline( list, item, ',' ) )
+          options.concurrency.push_back( static_cast<ure::uint_t>( std::strtoul( item.c_str(), nullptr, 10 ) ) );
+      }
+      else if ( arg == "--tiles-per-run" ) options.tiles               = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--zoom"          ) options.zoom                = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--url"           ) options.url                 = value;
+      else if ( arg == "--tiles"         ) options.directory           = value;
+      else if ( arg == "--latency"       ) options.server.latency      = ms( value );
+      else if ( arg == "--jitter"        ) options.server.jitter       = ms( value );
+      else if ( arg == "--failure-rate"  ) options.server.failure_rate = std::strtod( value, nullptr );
+      else if ( arg == "--timeout"       ) options.timeout             = std::chrono::seconds( std::strtoul( value, nullptr, 10 ) );
+      else
+        return false;
+    }
+
+    return ( options.concurrency.empty() == false ) && ( options.tiles > 0 ) && ( options.zoom >= 4 ) && ( options.zoom < 19 );
+  }
+
+  /**
+   * Load options.tiles tiles with @p concurrency downloads in flight, panning to a
+   * new screen of tiles every time the current one is complete.
+   */
+  result_t  run( const options_t& options, const std::string& url, ure::uint_t concurrency )
+  {
+    const ure::Size   tile_size{ 256, 256 };
+    TileContext       tiles( tile_size, 256u << 20 );
+    result_t          result{ 0, 0.0, {}, {}, false };
+
+    tiles.initialize( "./resources/shaders/", std::string() );
+    tiles.add_source( url );
+
+    std::unordered_map<TileKey, bench_clock_t::time_point>  dispatched;
+
+    tiles.scheduler().set_per_host( concurrency );
+    tiles.scheduler().set_fetcher( [&dispatched]( ure::ResourcesFetcherEvents& events, const std::string& name, const std::string& tile_url ) {
+      std::optional<TileKey> key = TileKey::parse( name );
+
+      // Retries keep the first dispatch, latency includes the backoff
+      if ( key.has_value() )
+        dispatched.try_emplace( key.value(), bench_clock_t::now() );
+
+      ure::ResourcesFetcher::get_instance()->fetch( events, name, typeid(ure::Texture), tile_url,
+                                                    ure::ResourcesFetcher::customer_request_t::Get,
+                                                    ure::ResourcesFetcher::http_headers_t{},
+                                                    std::string{} );
+    } );
+
+    {
+      TimedLevel   level( tiles, static_cast<ure::word_t>(options.zoom) );
+      MapView      view( options.zoom + 1 );
+
+      view.reset( options.viewport, options.zoom );
+
+      const bench_clock_t::time_point  start = bench_clock_t::now();
+
+      result.network_ms.reserve( options.tiles * 2 );
+      result.total_ms.reserve( options.tiles * 2 );
+
+      while ( result.tiles < options.tiles )
+      {
+        const bench_clock_t::time_point now = bench_clock_t::now();
+
+        if ( now - start > options.timeout )
+        {
+          result.timed_out = true;
+          break;
+        }
+
+        tiles.cache().begin_frame();
+        tiles.scheduler().begin_frame( static_cast<ure::uint_t>(options.zoom) );
+
+        tiles.decoder().upload( 64, std::chrono::milliseconds(4) );
+
+        // Tiles turned into textures since the last frame
+        for ( auto it = dispatched.begin(); it != dispatched.end(); )
+        {
+          if ( tiles.cache().contains( it->first ) == false )
+          {
+            ++it;
+            continue;
+          }
+
+          const bench_clock_t::time_point arrival = level.take_arrival( it->first ).value_or( now );
+
+          result.network_ms.push_back( std::chrono::duration<ure::double_t, std::milli>( arrival - it->second ).count() );
+          result.total_ms.push_back  ( std::chrono::duration<ure::double_t, std::milli>( now     - it->second ).count() );
+          ++result.tiles;
+
+          it = dispatched.erase( it );
+        }
+
+        const std::uint64_t misses = tiles.cache().stats().misses;
+
+        level.set_origin( view.origin( options.zoom ) );
+        level.set_view( view.level_model( options.zoom ), options.viewport );
+        level.draw_tiles( 1.0f );
+
+        // Screen complete, next one is made of new tiles only
+        if ( tiles.cache().stats().misses == misses )
+          view.pan( glm::vec2( -1.0f * options.viewport.width, 0.0f ) );
+
+        tiles.scheduler().dispatch();
+
+        tiles.redraw().wait( std::chrono::milliseconds(1) );
+        tiles.redraw().consume();
+      }
+
+      result.seconds = std::chrono::duration<ure::double_t>( bench_clock_t::now() - start ).count();
+
+      // Callbacks must not outlive the level
+      const bench_clock_t::time_point drain = bench_clock_t::now();
+
+      while ( ( tiles.scheduler().stats().in_flight > 0 ) && ( bench_clock_t::now() - drain < options.timeout ) )
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    }
+
+    tiles.dispose();
+
+    std::sort( result.network_ms.begin(), result.network_ms.end() );
+    std::sort( result.total_ms.begin(),   result.total_ms.end()   );
+
+    return result;
+  }
+}
+
+int main( int argc, char** argv )
+{
+  options_t  options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    printf( "usage: %s [options]\n"
+            "  --concurrency LIST   downloads in flight per host, comma separated (1,2,4,8,16)\n"
+            "  --tiles-per-run N    tiles loaded per concurrency level (256)\n"
+            "  --zoom N             zoom level of the tiles, 4 to 18 (10)\n"
+            "  --url TEMPLATE       external tile server, a loopback one is started otherwise\n"
+            "  --tiles DIR          loopback server reads DIR/z/x/y.png instead of generating tiles\n"
+            "  --latency MS         loopback server latency (20)\n"
+            "  --jitter MS          loopback server jitter (10)\n"
+            "  --failure-rate P     share of loopback requests failing with 503 (0)\n"
+            "  --timeout S          max seconds per concurrency level (60)\n", argv[0] );
+    return 2;
+  }
+
+  null_gl::install();
+
+  TileSource  source( ure::Size{ 256, 256 }, options.directory );
+  TileServer  server( source, options.server );
+  std::string url( options.url );
+
+  if ( url.empty() )
+  {
+    if ( server.start() == false )
+    {
+      printf( "unable to start the loopback tile server\n" );
+      return 1;
+    }
+
+    url = "http://127.0.0.1:" + std::to_string( server.port() ) + "/{z}/{x}/{y}.png";
+  }
+
+  ure::ResourcesFetcher::initialize();
+
+  printf( "%s, latency %.1f ms, jitter %.1f ms, failure rate %.2f\n\n", url.c_str(),
+          options.server.latency.count() / 1000.0, options.server.jitter.count() / 1000.0, options.server.failure_rate );
+  // Loopback tiles are generated on first request, the same tiles are used by every run
+  if ( options.url.empty() )
+    run( options, url, options.concurrency.back() );
+
+  printf( "concurrency   tiles   tiles/s   net p50   net p99   e2e p50   e2e p99   (ms)\n" );
+
+  int result = 0;
+
+  for ( ure::uint_t concurrency : options.concurrency )
+  {
+    const result_t r = run( options, url, concurrency );
+
+    printf( "%11u %7u %9.1f %9.2f %9.2f %9.2f %9.2f%s\n", concurrency, r.tiles, ( r.seconds > 0.0 ) ? r.tiles / r.seconds : 0.0,
+            percentile( r.network_ms, 0.50 ), percentile( r.network_ms, 0.99 ),
+            percentile( r.total_ms,   0.50 ), percentile( r.total_ms,   0.99 ),
+            r.timed_out ? "   TIMEOUT" : "" );
+
+    if ( r.timed_out )
+      result = 1;
+  }
+
+  ure::ResourcesFetcher::get_instance()->finalize();
+
+  server.stop();
+
+  return result;
+}
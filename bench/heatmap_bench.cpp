@@ -0,0 +1,405 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Headless benchmark and check of the heatmap layer.
+ *
+ * Bins generated events in a grid and checks the counts against a scalar reference,
+ * and the density updated batch by batch against the one of a grid built at once.
+ * Ingestion is then measured in points per second, for the binning alone and with
+ * the blur and colouring of every batch, before replaying a pan/zoom trace against
+ * a null GL driver with a fixed 60 Hz clock while events keep arriving.
+ */
+
+#include "bench_stats.h"
+#include "bench_trace.h"
+#include "bench_view.h"
+#include "null_gl.h"
+
+#include "fixed_point.h"
+#include "heatmap_grid.h"
+#include "heatmap_set.h"
+#include "map_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+  using point_t       = HeatmapGrid::point_t;
+
+  struct options_t
+  {
+    ure::uint_t   points      = 1000000;
+    ure::uint_t   batch       = 10000;   /* Points arriving per frame */
+    ure::uint_t   frames      = 600;
+    ure::uint_t   warmup      = 60;
+    ure::int_t    level       = 6;
+    ure::Size     size        = { 1024, 768 };
+    ure::uint_t   cell        = 4;       /* Pixels */
+    ure::uint_t   radius      = 8;       /* Cells */
+    std::string   trace;
+    std::string   shaders     = "./resources/shaders/";
+    ure::double_t min_rate    = 0.0;     /* Points per second ingested, 0 to disable */
+    ure::double_t max_p99     = 0.0;     /* Milliseconds, 0 to disable */
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s [options]\n"
+            "  --points N        points binned before the first frame (1000000)\n"
+            "  --batch N         points arriving per frame (10000)\n"
+            "  --frames N        measured frames (600)\n"
+            "  --warmup N        frames run before measuring (60)\n"
+            "  --level N         initial zoom level (6)\n"
+            "  --width N         viewport width (1024)\n"
+            "  --height N        viewport height (768)\n"
+            "  --cell N          cell size in pixels (4)\n"
+            "  --radius N        blur radius in cells (8)\n"
+            "  --trace FILE      pan/zoom trace, a built-in one by default\n"
+            "  --shaders DIR     shaders location (./resources/shaders/)\n"
+            "  --min-rate N      fail if fewer points per second are ingested\n"
+            "  --max-p99 MS      fail if p99 frame time exceeds MS\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[++i];
+
+      if      ( arg == "--points"     ) options.points     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--batch"      ) options.batch      = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--frames"     ) options.frames     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--warmup"     ) options.warmup     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--level"      ) options.level      = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--width"      ) options.size.width = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--height"     ) options.size.height= static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--cell"       ) options.cell       = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--radius"     ) options.radius     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--trace"      ) options.trace      = value;
+      else if ( arg == "--shaders"    ) options.shaders    = value;
+      else if ( arg == "--min-rate"   ) options.min_rate   = std::strtod( value, nullptr );
+      else if ( arg == "--max-p99"    ) options.max_p99    = std::strtod( value, nullptr );
+      else
+        return false;
+    }
+
+    return ( options.frames > 0 ) && ( options.points > 0 ) && ( options.batch > 0 ) && ( options.cell > 0 ) &&
+           ( options.size.width > 0 ) && ( options.size.height > 0 );
+  }
+
+  /** Middle of the area covered by generate() */
+  constexpr point_t  centre() noexcept
+  { return point_t{ 0.53, 0.43 }; }
+
+  /**
+   * Events clustered around a few places near centre(), one in four anywhere in the world.
+   */
+  std::vector<point_t>  generate( ure::uint_t count, std::uint32_t seed ) noexcept(true)
+  {
+    std::mt19937                            rng( seed );
+    std::uniform_real_distribution<double>  uniform( 0.0, 1.0 );
+    std::normal_distribution<double>        spread( 0.0, 0.004 );
+    std::vector<point_t>                    points( count );
+
+    for ( ure::uint_t i = 0; i < count; ++i )
+    {
+      if ( i % 4 == 0 )
+        points[i] = point_t{ uniform( rng ), uniform( rng ) };
+      else
+        points[i] = point_t{ centre().x + ( i % 5 ) * 0.003 - 0.006 + spread( rng ), centre().y + ( i % 3 ) * 0.004 - 0.004 + spread( rng ) };
+    }
+
+    return points;
+  }
+
+  /**
+   * Counts of @p grid must be those of a scalar binning of @p points, return the
+   * number of cells that differ. @p inside receives the points in the grid.
+   */
+  std::size_t  check_counts( const HeatmapGrid& grid, const std::vector<point_t>& points, ure::uint_t tile_pixels, std::size_t& inside ) noexcept(true)
+  {
+    const ure::double_t           cells = std::ldexp( static_cast<ure::double_t>( tile_pixels ) / grid.cell_pixels(), static_cast<int>( grid.level() ) );
+    std::vector<std::uint32_t>    reference( std::size_t(grid.width()) * grid.height(), 0 );
+
+    inside = 0;
+
+    for ( const point_t& point : points )
+    {
+      const std::int64_t  x = static_cast<std::int64_t>( std::floor( std::clamp( point.x, 0.0, 1.0 ) * cells ) ) - grid.cell_x();
+      const std::int64_t  y = static_cast<std::int64_t>( std::floor( std::clamp( point.y, 0.0, 1.0 ) * cells ) ) - grid.cell_y();
+
+      if ( ( x < 0 ) || ( y < 0 ) || ( x >= grid.width() ) || ( y >= grid.height() ) )
+        continue;
+
+      ++reference[ std::size_t(y) * grid.width() + std::size_t(x) ];
+      ++inside;
+    }
+
+    std::size_t  different = 0;
+
+    for ( std::size_t i = 0; i < reference.size(); ++i )
+      different += ( reference[i] != grid.counts()[i] ) ? 1 : 0;
+
+    return different;
+  }
+
+  /** Largest difference between the densities of @p a and @p b, relative to the largest density */
+  ure::double_t  compare_density( const HeatmapGrid& a, const HeatmapGrid& b ) noexcept(true)
+  {
+    ure::double_t  peak  = 0.0;
+    ure::double_t  error = 0.0;
+
+    for ( std::size_t i = 0; i < a.density().size(); ++i )
+    {
+      peak  = std::max( peak , static_cast<ure::double_t>( b.density()[i] ) );
+      error = std::max( error, static_cast<ure::double_t>( std::abs( a.density()[i] - b.density()[i] ) ) );
+    }
+
+    return ( peak > 0.0 ) ? error / peak : error;
+  }
+
+  /***/
+  ure::double_t  elapsed_ms( bench_clock_t::time_point start ) noexcept
+  { return std::chrono::duration<ure::double_t, std::milli>( bench_clock_t::now() - start ).count(); }
+}
+
+int main( int argc, char** argv )
+{
+  options_t   options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  BenchTrace  trace;
+
+  if ( options.trace.empty() ? ( trace.parse( BenchTrace::default_trace() ) == false ) : ( trace.load( options.trace ) == false ) )
+  {
+    printf( "unable to load trace [%s]\n", options.trace.c_str() );
+    return 2;
+  }
+
+  const ure::uint_t   tile_pixels = 256;
+  const ure::int_t    max_levels  = 19;
+  const ure::uint_t   level       = static_cast<ure::uint_t>( std::clamp( options.level, 0, max_levels - 1 ) );
+
+  int result = 0;
+
+  const std::vector<point_t>  points = generate( options.points, 1 );
+
+  // Grid over the viewport and half of it on every side, as HeatmapSet does
+  const ure::double_t  cells  = std::ldexp( static_cast<ure::double_t>( tile_pixels ) / options.cell, static_cast<int>( level ) );
+  const ure::uint_t    width  = 2 * options.size.width  / options.cell;
+  const ure::uint_t    height = 2 * options.size.height / options.cell;
+  const std::int64_t   cell_x = static_cast<std::int64_t>( centre().x * cells ) - width  / 2;
+  const std::int64_t   cell_y = static_cast<std::int64_t>( centre().y * cells ) - height / 2;
+
+  ure::uint_t  first = 0;
+  ure::uint_t  count = 0;
+
+  /////////////////
+  // Whole grid built at once
+  HeatmapGrid  built( tile_pixels );
+
+  built.set_style( options.cell, options.radius );
+  built.add( points );
+
+  bench_clock_t::time_point  start = bench_clock_t::now();
+
+  built.reset( level, cell_x, cell_y, width, height );
+
+  const ure::double_t  reset_ms = elapsed_ms( start );
+
+  start = bench_clock_t::now();
+
+  built.update( first, count );
+
+  const ure::double_t  update_ms = elapsed_ms( start );
+
+  std::size_t  inside    = 0;
+  std::size_t  different = check_counts( built, points, tile_pixels, inside );
+
+  if ( different > 0 )
+  {
+    printf( "FAIL: %zu cells differ from the scalar binning\n", different );
+    result = 1;
+  }
+
+  /////////////////
+  // Same points arriving in batches, each one blurred and coloured
+  HeatmapGrid  streamed( tile_pixels );
+  ure::uint_t  bands = 0;
+  std::size_t  rows  = 0;
+
+  streamed.set_style( options.cell, options.radius );
+  streamed.reset( level, cell_x, cell_y, width, height );
+  streamed.update( first, count );
+
+  std::vector<point_t>  batch;
+
+  start = bench_clock_t::now();
+
+  for ( std::size_t i = 0; i < points.size(); i += options.batch )
+  {
+    batch.assign( points.begin() + i, points.begin() + std::min( points.size(), i + options.batch ) );
+
+    streamed.add( batch );
+
+    if ( streamed.update( first, count ) )
+    {
+      ++bands;
+      rows += count;
+    }
+  }
+
+  const ure::double_t  stream_ms   = elapsed_ms( start );
+  const ure::double_t  stream_rate = points.size() / ( stream_ms / 1000.0 );
+  const ure::double_t  error       = compare_density( streamed, built );
+
+  if ( error > 1e-4 )
+  {
+    printf( "FAIL: density updated in batches differs by %.2g from the one built at once\n", error );
+    result = 1;
+  }
+
+  /////////////////
+  // Binning alone, the SIMD part of ingestion
+  std::vector<std::uint32_t>  fx( points.size() );
+  std::vector<std::uint32_t>  fy( points.size() );
+  std::vector<std::uint32_t>  bins( std::size_t(width) * height, 0 );
+  const ure::uint_t           shift = 32 - 8 - level + static_cast<ure::uint_t>( std::log2( options.cell ) );
+
+  for ( std::size_t i = 0; i < points.size(); ++i )
+  {
+    fx[i] = FixedPoint::from_normalized( points[i].x );
+    fy[i] = FixedPoint::from_normalized( points[i].y );
+  }
+
+  const ure::uint_t  repeats = 10;
+  ure::uint_t        changed[2];
+
+  start = bench_clock_t::now();
+
+  for ( ure::uint_t r = 0; r < repeats; ++r )
+    HeatmapGrid::bin( fx.data(), fy.data(), fx.size(), static_cast<std::uint32_t>( cell_x << shift ), static_cast<std::uint32_t>( cell_y << shift ),
+                      shift, width, height, bins.data(), changed );
+
+  const ure::double_t  bin_ms   = elapsed_ms( start ) / repeats;
+  const ure::double_t  bin_rate = points.size() / ( bin_ms / 1000.0 );
+
+  /////////////////
+  // Render loop with events arriving every frame
+  null_gl::install();
+
+  HeatmapSet  heatmap( tile_pixels );
+
+  heatmap.set_shaders_path( options.shaders );
+  heatmap.set_style( options.cell, options.radius );
+  heatmap.add_points( points );
+
+  std::vector<ure::double_t>  frame_ms;
+  null_gl::counters_t         before{};
+  std::uint64_t               resets   = 0;
+  std::uint64_t               uploaded = 0;
+
+  {
+    BenchView<HeatmapSet>  view( options.size, options.level, max_levels, heatmap );
+    BenchReplay            replay( trace, options.warmup, options.frames );
+
+    // Events in the centre of the window
+    view.centre_on( glm::dvec2( centre().x, centre().y ), tile_pixels );
+
+    while ( replay.next() )
+    {
+      if ( replay.starting() )
+      {
+        before   = null_gl::counters();
+        resets   = heatmap.resets();
+        uploaded = heatmap.uploaded();
+      }
+
+      const std::vector<point_t>  arrived = generate( options.batch, 2 + replay.index() );
+
+      replay.begin();
+
+      view.input( replay.event(), replay.now() );
+      heatmap.add_points( arrived );
+      view.draw();
+
+      replay.end();
+    }
+
+    frame_ms = replay.frame_ms();
+  }
+
+  const null_gl::counters_t  after  = null_gl::counters();
+  const ure::double_t        frames = static_cast<ure::double_t>( frame_ms.size() );
+
+  std::sort( frame_ms.begin(), frame_ms.end() );
+
+  const ure::double_t  p99 = percentile( frame_ms, 0.99 );
+
+  printf( "points            %zu, %zu in a %ux%u grid at level %u, cells of %u pixels, radius %u\n", points.size(), inside, width, height, level,
+          built.cell_pixels(), options.radius );
+  printf( "full build ms     bin %.2f  blur and colour %.2f\n", reset_ms, update_ms );
+  printf( "binning           %.1f M points/s\n", bin_rate / 1e6 );
+  printf( "ingestion         %.1f M points/s in batches of %u, %.0f rows updated per batch, density error %.1g\n", stream_rate / 1e6, options.batch,
+          bands ? static_cast<ure::double_t>( rows ) / bands : 0.0, error );
+  printf( "frames            %zu (warmup %u, trace %zu, %u points per frame)\n", frame_ms.size(), options.warmup, trace.frames(), options.batch );
+  printf( "frame time ms     p50 %.3f  p99 %.3f  max %.3f\n", percentile( frame_ms, 0.50 ), p99, frame_ms.back() );
+  printf( "draw calls/frame  %.2f\n", ( after.draw_calls - before.draw_calls ) / frames );
+  printf( "uploads/frame     %.2f, %.1f KB/frame, %llu grid resets\n", ( after.texture_uploads - before.texture_uploads ) / frames,
+          ( heatmap.uploaded() - uploaded ) / frames / 1024.0, static_cast<unsigned long long>( heatmap.resets() - resets ) );
+
+  if ( after.draw_calls == before.draw_calls )
+  {
+    printf( "FAIL: nothing has been drawn, check --shaders\n" );
+    result = 1;
+  }
+
+  if ( ( options.min_rate > 0.0 ) && ( stream_rate < options.min_rate ) )
+  {
+    printf( "FAIL: %.0f points/s ingested, %.0f expected\n", stream_rate, options.min_rate );
+    result = 1;
+  }
+
+  if ( ( options.max_p99 > 0.0 ) && ( p99 > options.max_p99 ) )
+  {
+    printf( "FAIL: p99 %.3f ms exceeds %.3f ms\n", p99, options.max_p99 );
+    result = 1;
+  }
+
+  heatmap.dispose();
+
+  return result;
+}
@@ -0,0 +1,514 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Headless benchmark of the tile render loop.
+ *
+ * Runs the same per-frame steps as Map::on_run() against a null GL driver and a
+ * local tile source, replaying a pan/zoom trace with a fixed 60 Hz clock.
+ * Tiles are decoded between frames so that every run uploads the same tiles in
+ * the same frames, frame time measures the main thread work only.
+ * Uploads follow the count, byte and time budgets of Map::on_run(), their cost is
+ * reported separately.
+ * With --overlays, translucent sources are stacked over the base map.
+ * With --events, every trace step is split into several pointer events summed by the
+ * input accumulator, frame time should not depend on their number.
+ */
+
+#include "bench_stats.h"
+#include "bench_trace.h"
+#include "null_gl.h"
+#include "tile_source.h"
+
+#include "input_accumulator.h"
+#include "map_view.h"
+#include "tile_context.h"
+#include "tile_level.h"
+#include "tile_prefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////
+// Allocations counter, main thread only
+/////////////////////////////////////////////////////
+
+namespace
+{
+  thread_local std::uint64_t  t_allocations = 0;
+
+  void* counted_alloc( std::size_t size ) noexcept
+  {
+    ++t_allocations;
+    return std::malloc( ( size > 0 ) ? size : 1 );
+  }
+}
+
+void* operator new  ( std::size_t size )
+{
+  void* ptr = counted_alloc( size );
+  if ( ptr == nullptr )
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[]( std::size_t size )
+{
+  void* ptr = counted_alloc( size );
+  if ( ptr == nullptr )
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new  ( std::size_t size, const std::nothrow_t& ) noexcept { return counted_alloc( size ); }
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept { return counted_alloc( size ); }
+
+void  operator delete  ( void* ptr ) noexcept                          { std::free( ptr ); }
+void  operator delete[]( void* ptr ) noexcept                          { std::free( ptr ); }
+void  operator delete  ( void* ptr, std::size_t ) noexcept             { std::free( ptr ); }
+void  operator delete[]( void* ptr, std::size_t ) noexcept             { std::free( ptr ); }
+void  operator delete  ( void* ptr, const std::nothrow_t& ) noexcept   { std::free( ptr ); }
+void  operator delete[]( void* ptr, const std::nothrow_t& ) noexcept   { std::free( ptr ); }
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+
+  struct options_t
+  {
+    ure::uint_t   frames      = 600;
+    ure::uint_t   warmup      = 60;
+    ure::int_t    level       = 2;
+    ure::uint_t   overlays    = 0;
+    std::size_t   upload_kb   = 2048;    /* Pixels copied to the atlas per frame */
+    ure::uint_t   gles        = 3;       /* Version reported by the null driver */
+    ure::uint_t   events      = 1;       /* Pointer events per frame, e.g. 16 for a 1 kHz mouse */
+    ure::Size     size        = { 1024, 768 };
+    std::string   trace;
+    std::string   tiles;
+    std::string   shaders     = "./resources/shaders/";
+    TileImage::format_t format = TileImage::format_t::rgba8;
+    ure::double_t max_p99     = 0.0;     /* Milliseconds, 0 to disable */
+    ure::double_t max_allocs  = -1.0;    /* Allocations per frame, negative to disable */
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s [options]\n"
+            "  --frames N        measured frames (600)\n"
+            "  --warmup N        frames run before measuring (60)\n"
+            "  --level N         initial zoom level (2)\n"
+            "  --overlays N      tile sources stacked over the base map (0)\n"
+            "  --upload-kb N     pixels uploaded per frame, in KB (2048)\n"
+            "  --gles N          OpenGL ES version of the null driver, 2 uploads from client memory (3)\n"
+            "  --events N        pointer events each trace step is split into (1)\n"
+            "  --width N         viewport width (1024)\n"
+            "  --height N        viewport height (768)\n"
+            "  --trace FILE      pan/zoom trace, a built-in one by default\n"
+            "  --tiles DIR       read tiles from DIR/z/x/y.png instead of generating them\n"
+            "  --shaders DIR     shaders location (./resources/shaders/)\n"
+            "  --format F        tile texture format: rgba8, rgb565 or etc2 (rgba8)\n"
+            "  --max-p99 MS      fail if p99 frame time exceeds MS\n"
+            "  --max-allocs N    fail if allocations per frame exceed N\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[++i];
+
+      if      ( arg == "--frames"     ) options.frames     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--warmup"     ) options.warmup     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--level"      ) options.level      = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--overlays"   ) options.overlays   = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--upload-kb"  ) options.upload_kb  = std::strtoul( value, nullptr, 10 );
+      else if ( arg == "--gles"       ) options.gles       = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--events"     ) options.events     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--width"      ) options.size.width = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--height"     ) options.size.height= static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--trace"      ) options.trace      = value;
+      else if ( arg == "--tiles"      ) options.tiles      = value;
+      else if ( arg == "--shaders"    ) options.shaders    = value;
+      else if ( arg == "--format"     )
+      {
+        if      ( std::strcmp( value, "rgba8"  ) == 0 ) options.format = TileImage::format_t::rgba8;
+        else if ( std::strcmp( value, "rgb565" ) == 0 ) options.format = TileImage::format_t::rgb565;
+        else if ( std::strcmp( value, "etc2"   ) == 0 ) options.format = TileImage::format_t::etc2_rgb8;
+        else
+          return false;
+      }
+      else if ( arg == "--max-p99"    ) options.max_p99    = std::strtod( value, nullptr );
+      else if ( arg == "--max-allocs" ) options.max_allocs = std::strtod( value, nullptr );
+      else
+        return false;
+    }
+
+    return ( options.frames > 0 ) && ( options.events > 0 ) && ( options.size.width > 0 ) && ( options.size.height > 0 ) && ( options.overlays < TileContext::max_sources() );
+  }
+
+  /**
+   * Zoom levels and per-frame steps of Map, without window and scene graph.
+   */
+  class BenchMap
+  {
+  public:
+    BenchMap( TileContext& tiles, const ure::Size& size, ure::int_t level, std::size_t upload_bytes, ure::uint_t events ) noexcept(true)
+      : m_tiles( tiles ), m_size( size ), m_upload_bytes( upload_bytes ), m_events( events ), m_upload_ms( 0.0 ), m_input_ns( 0.0 ), m_view( max_levels ),
+        m_curLevel( std::clamp( level, 0, max_levels - 1 ) ), m_drawLevel( m_curLevel ),
+        m_levels( max_levels )
+    {
+      m_view.reset( m_size, m_curLevel );
+      update_view();
+
+      // The trace is a single drag
+      m_input.grab();
+    }
+
+    ure::void_t  frame( const BenchTrace::event_t& input, bench_clock_t::time_point now, bench_clock_t::duration step ) noexcept(true)
+    {
+      // Event handlers of Map, spread over the frame interval
+      const bench_clock_t::time_point  events = bench_clock_t::now();
+      const glm::vec2                  delta  = glm::vec2( input.dx, input.dy ) * ( 1.0f / static_cast<ure::float_t>(m_events) );
+
+      for ( ure::uint_t e = 0; e < m_events; ++e )
+      {
+        const bench_clock_t::time_point  at = now - step + ( step * ( e + 1 ) ) / m_events;
+
+        if ( ( input.dx != 0.0f ) || ( input.dy != 0.0f ) )
+          m_input.pan( delta, at );
+        if ( input.notches != 0.0f )
+          m_input.scroll( input.notches / static_cast<ure::float_t>(m_events), glm::vec2( input.x, input.y ) );
+      }
+
+      m_input_ns = std::chrono::duration<ure::double_t, std::nano>( bench_clock_t::now() - events ).count() / m_events;
+
+      ure::bool_t               moved = false;
+      InputAccumulator::frame_t coalesced;
+
+      if ( m_input.take( now, coalesced ) )
+      {
+        if ( ( coalesced.pan.x != 0.0f ) || ( coalesced.pan.y != 0.0f ) )
+        {
+          m_view.pan( coalesced.pan );
+          m_prefetcher.on_pan( coalesced.pan.x, coalesced.pan.y, now );
+          moved = true;
+        }
+
+        if ( coalesced.notches != 0.0f )
+        {
+          m_prefetcher.on_zoom( ( coalesced.notches > 0.0f ) ? 1 : -1, now );
+          m_view.zoom_by( coalesced.notches, coalesced.anchor, now );
+        }
+      }
+
+      m_tiles.cache().begin_frame();
+      m_tiles.scheduler().begin_frame( static_cast<ure::uint_t>(m_curLevel) );
+
+      if ( m_view.animate( now ) )
+        moved = true;
+
+      if ( moved )
+        update_view();
+
+      const bench_clock_t::time_point  upload = bench_clock_t::now();
+
+      m_tiles.decoder().upload( 32, std::chrono::microseconds(4000), m_upload_bytes );
+
+      m_upload_ms = std::chrono::duration<ure::double_t, std::milli>( bench_clock_t::now() - upload ).count();
+
+      TileLevel* level = m_levels[m_drawLevel].get();
+      if ( level != nullptr )
+        level->draw();
+
+      prefetch( now );
+
+      m_tiles.scheduler().dispatch();
+    }
+
+    /** Time spent uploading tiles in the last frame */
+    ure::double_t  upload_ms() const noexcept
+    { return m_upload_ms; }
+    /** Time spent handling a pointer event in the last frame */
+    ure::double_t  input_ns() const noexcept
+    { return m_input_ns; }
+
+  private:
+    static constexpr ure::int_t  max_levels    = 19;
+    static constexpr ure::int_t  levels_window = 2;
+
+    TileLevel*   get_zoom_level( ure::int_t zl ) noexcept(true)
+    {
+      if ( ( zl < 0 ) || ( zl >= max_levels ) )
+        return nullptr;
+
+      std::unique_ptr<TileLevel>& level = m_levels[zl];
+
+      if ( level != nullptr )
+        return level.get();
+
+      if ( m_spare_levels.empty() == false )
+      {
+        level = std::move( m_spare_levels.back() );
+        m_spare_levels.pop_back();
+
+        level->set_zoom( static_cast<ure::word_t>(zl) );
+        level->set_overlay( nullptr, 0.0f );
+      }
+      else
+      {
+        level = std::make_unique<TileLevel>( m_tiles, static_cast<ure::word_t>(zl) );
+      }
+
+      level->set_origin( m_view.origin( zl ) );
+
+      return level.get();
+    }
+
+    ure::void_t  trim_zoom_levels() noexcept(true)
+    {
+      for ( ure::int_t zl = 0; zl < max_levels; ++zl )
+      {
+        if ( ( m_levels[zl] == nullptr ) || ( std::abs( zl - m_curLevel ) <= levels_window ) )
+          continue;
+
+        m_tiles.cache().evict_level( static_cast<ure::uint_t>(zl) );
+
+        m_spare_levels.push_back( std::move( m_levels[zl] ) );
+      }
+    }
+
+    ure::void_t  update_view() noexcept(true)
+    {
+      const MapView::levels_t  levels = m_view.levels();
+      TileLevel*               blend  = ( ( levels.fade > 0.0f ) && ( levels.fade < 1.0f ) ) ? get_zoom_level( levels.upper ) : nullptr;
+
+      m_curLevel = levels.current;
+
+      if ( ( levels.draw != m_drawLevel ) && ( m_levels[m_drawLevel] != nullptr ) )
+        m_levels[m_drawLevel]->set_overlay( nullptr, 0.0f );
+
+      m_drawLevel = levels.draw;
+
+      TileLevel* level = get_zoom_level( m_drawLevel );
+      if ( level != nullptr )
+        level->set_overlay( blend, levels.fade );
+
+      trim_zoom_levels();
+
+      for ( ure::int_t zl : { levels.lower, levels.upper } )
+      {
+        if ( m_levels[zl] == nullptr )
+          continue;
+
+        m_levels[zl]->set_origin( m_view.origin( zl ) );
+        m_levels[zl]->set_view( m_view.level_model( zl ), m_size );
+      }
+    }
+
+    ure::void_t  prefetch( bench_clock_t::time_point now ) noexcept(true)
+    {
+      TileRequests&  requests = m_tiles.requests();
+      ure::uint_t    budget   = m_prefetcher.available( requests.pending(), requests.pending_prefetch() );
+
+      if ( budget == 0 )
+        return;
+
+      const glm::vec2 offset = m_prefetcher.predicted_offset( now );
+
+      if ( ( ( offset.x != 0.0f ) || ( offset.y != 0.0f ) ) && ( m_levels[m_curLevel] != nullptr ) )
+        budget -= m_levels[m_curLevel]->prefetch( m_view.level_model( m_curLevel, offset ), m_size, budget );
+
+      const ure::int_t direction = m_prefetcher.zoom_direction( now );
+      const ure::int_t next      = m_curLevel + direction;
+
+      if ( ( direction != 0 ) && ( budget > 0 ) && ( next >= 0 ) && ( next < max_levels ) )
+      {
+        TileLevel* level = get_zoom_level( next );
+
+        if ( level != nullptr )
+          level->prefetch( m_view.level_model( next ), m_size, budget );
+      }
+    }
+
+  private:
+    TileContext&                              m_tiles;
+    const ure::Size                           m_size;
+    const std::size_t                         m_upload_bytes;
+    const ure::uint_t                         m_events;
+    ure::double_t                             m_upload_ms;
+    ure::double_t                             m_input_ns;
+    MapView                                   m_view;
+    TilePrefetcher                            m_prefetcher;
+    InputAccumulator                          m_input;
+    ure::int_t                                m_curLevel;
+    ure::int_t                                m_drawLevel;
+    std::vector<std::unique_ptr<TileLevel>>   m_levels;
+    std::vector<std::unique_ptr<TileLevel>>   m_spare_levels;
+  };
+}
+
+int main( int argc, char** argv )
+{
+  options_t   options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  BenchTrace  trace;
+
+  if ( options.trace.empty() ? ( trace.parse( BenchTrace::default_trace() ) == false ) : ( trace.load( options.trace ) == false ) )
+  {
+    printf( "unable to load trace [%s]\n", options.trace.c_str() );
+    return 2;
+  }
+
+  null_gl::install( ( options.gles >= 3 ) ? "OpenGL ES 3.0 null" : "OpenGL ES 2.0 null" );
+
+  const ure::Size  tile_size{ 256, 256 };
+  TileContext      tiles( tile_size, 128u << 20 );
+  TileSource       source( tile_size, options.tiles );
+
+  // No disk cache, every tile comes from the source
+  tiles.initialize( options.shaders, std::string() );
+  tiles.set_texture_format( options.format );
+  tiles.add_source( "http://localhost/%u/%u/%u.png" );
+
+  // Overlays come from the same source, tiles are told apart by their key
+  for ( ure::uint_t i = 0; i < options.overlays; ++i )
+    tiles.add_source( "http://localhost/overlay/%u/%u/%u.png", 0.5f );
+  tiles.scheduler().set_fetcher( [&source]( ure::ResourcesFetcherEvents& events, const std::string& name, const std::string& url ) {
+    source.fetch( events, name, url );
+  } );
+
+  std::vector<ure::double_t>  frame_ms;
+  std::vector<ure::double_t>  upload_ms;
+  std::vector<ure::double_t>  input_ns;
+  std::uint64_t               allocations = 0;
+  null_gl::counters_t         start{};
+  std::uint64_t               streamed    = 0;
+  std::uint64_t               direct      = 0;
+
+  frame_ms.reserve( options.frames );
+  upload_ms.reserve( options.frames );
+  input_ns.reserve( options.frames );
+
+  {
+    BenchMap                   map( tiles, options.size, options.level, options.upload_kb * 1024, options.events );
+    const bench_clock_t::time_point  epoch = bench_clock_t::now();
+    const bench_clock_t::duration    step  = std::chrono::microseconds(16667);
+
+    for ( ure::uint_t i = 0; i < options.warmup + options.frames; ++i )
+    {
+      const ure::bool_t  measured = ( i >= options.warmup );
+
+      if ( i == options.warmup )
+      {
+        start    = null_gl::counters();
+        streamed = tiles.atlas().uploader().streamed();
+        direct   = tiles.atlas().uploader().direct();
+      }
+
+      const std::uint64_t        allocs_before = t_allocations;
+      const bench_clock_t::time_point  begin         = bench_clock_t::now();
+
+      map.frame( trace.at( i ), epoch + i * step, step );
+
+      const bench_clock_t::time_point  end           = bench_clock_t::now();
+
+      if ( measured )
+      {
+        frame_ms.push_back( std::chrono::duration<ure::double_t, std::milli>( end - begin ).count() );
+        upload_ms.push_back( map.upload_ms() );
+        input_ns.push_back( map.input_ns() );
+        allocations += t_allocations - allocs_before;
+      }
+
+      // Decoding runs on worker threads, wait for it so that uploads do not depend on timing
+      while ( tiles.decoder().pending() != tiles.decoder().ready() )
+        std::this_thread::yield();
+    }
+  }
+
+  const null_gl::counters_t  end    = null_gl::counters();
+  const ure::double_t        frames = static_cast<ure::double_t>( frame_ms.size() );
+
+  std::vector<ure::double_t> sorted( frame_ms );
+  std::sort( sorted.begin(), sorted.end() );
+  std::sort( upload_ms.begin(), upload_ms.end() );
+  std::sort( input_ns.begin(), input_ns.end() );
+
+  const ure::double_t  p50            = percentile( sorted, 0.50 );
+  const ure::double_t  p99            = percentile( sorted, 0.99 );
+  const ure::double_t  allocs_frame   = allocations / frames;
+
+  printf( "frames            %zu (warmup %u, trace %zu)\n", frame_ms.size(), options.warmup, trace.frames() );
+  printf( "tile format       %s, %zu KB per tile, %u sources\n", TileImage::name( tiles.atlas().format() ), tiles.tile_bytes() / 1024, tiles.sources() );
+  printf( "frame time ms     p50 %.3f  p99 %.3f  max %.3f\n", p50, p99, sorted.back() );
+  printf( "input ns/event    p50 %.1f  p99 %.1f, %u events/frame\n", percentile( input_ns, 0.50 ), percentile( input_ns, 0.99 ), options.events );
+  printf( "draw calls/frame  %.2f\n", ( end.draw_calls      - start.draw_calls      ) / frames );
+  printf( "uploads/frame     %.2f\n", ( end.texture_uploads - start.texture_uploads ) / frames );
+  printf( "texture KB/frame  %.2f\n", ( end.texture_bytes   - start.texture_bytes   ) / frames / 1024.0 );
+  printf( "upload ms         p50 %.3f  p99 %.3f  max %.3f, budget %zu KB/frame\n", percentile( upload_ms, 0.50 ), percentile( upload_ms, 0.99 ), upload_ms.back(),
+          options.upload_kb );
+  printf( "upload path       %s, %.0f KB streamed  %.0f KB direct\n", tiles.atlas().uploader().streaming() ? "unpack buffers" : "client memory",
+          ( tiles.atlas().uploader().streamed() - streamed ) / 1024.0, ( tiles.atlas().uploader().direct() - direct ) / 1024.0 );
+  printf( "vertex KB/frame   %.2f\n", ( end.buffer_bytes    - start.buffer_bytes    ) / frames / 1024.0 );
+  printf( "allocs/frame      %.2f\n", allocs_frame );
+  printf( "tiles served      %llu\n", static_cast<unsigned long long>( source.served() ) );
+
+  int result = 0;
+
+  if ( end.draw_calls == 0 )
+  {
+    printf( "FAIL: nothing has been drawn, check --shaders\n" );
+    result = 1;
+  }
+
+  if ( ( options.max_p99 > 0.0 ) && ( p99 > options.max_p99 ) )
+  {
+    printf( "FAIL: p99 %.3f ms exceeds %.3f ms\n", p99, options.max_p99 );
+    result = 1;
+  }
+
+  if ( ( options.max_allocs >= 0.0 ) && ( allocs_frame > options.max_allocs ) )
+  {
+    printf( "FAIL: %.2f allocations per frame exceed %.2f\n", allocs_frame, options.max_allocs );
+    result = 1;
+  }
+
+  tiles.dispose();
+
+  return result;
+}
@@ -0,0 +1,331 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Headless benchmark and check of the markers layer.
+ *
+ * Builds the index of generated markers, checks that clustering keeps every marker at
+ * every level, then replays a pan/zoom trace against a null GL driver with a fixed
+ * 60 Hz clock. After each frame markers are picked at the centre of drawn discs, each
+ * must be found, and at random positions; frame and pick times are reported.
+ */
+
+#include "bench_stats.h"
+#include "bench_trace.h"
+#include "bench_view.h"
+#include "null_gl.h"
+
+#include "map_view.h"
+#include "marker_index.h"
+#include "marker_set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+
+  struct options_t
+  {
+    ure::uint_t   markers     = 1000000;
+    ure::uint_t   frames      = 600;
+    ure::uint_t   warmup      = 60;
+    ure::int_t    level       = 4;
+    ure::Size     size        = { 1024, 768 };
+    ure::uint_t   picks       = 16;      /* Per frame, half on drawn discs and half at random */
+    std::string   trace;
+    std::string   shaders     = "./resources/shaders/";
+    ure::double_t max_p99     = 0.0;     /* Milliseconds, 0 to disable */
+    ure::double_t max_pick    = 0.0;     /* Microseconds, 0 to disable */
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s [options]\n"
+            "  --markers N       markers generated (1000000)\n"
+            "  --frames N        measured frames (600)\n"
+            "  --warmup N        frames run before measuring (60)\n"
+            "  --level N         initial zoom level (4)\n"
+            "  --width N         viewport width (1024)\n"
+            "  --height N        viewport height (768)\n"
+            "  --picks N         picks per frame (16)\n"
+            "  --trace FILE      pan/zoom trace, a built-in one by default\n"
+            "  --shaders DIR     shaders location (./resources/shaders/)\n"
+            "  --max-p99 MS      fail if p99 frame time exceeds MS\n"
+            "  --max-pick US     fail if p99 pick time exceeds US\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[++i];
+
+      if      ( arg == "--markers"    ) options.markers    = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--frames"     ) options.frames     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--warmup"     ) options.warmup     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--level"      ) options.level      = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--width"      ) options.size.width = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--height"     ) options.size.height= static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--picks"      ) options.picks      = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--trace"      ) options.trace      = value;
+      else if ( arg == "--shaders"    ) options.shaders    = value;
+      else if ( arg == "--max-p99"    ) options.max_p99    = std::strtod( value, nullptr );
+      else if ( arg == "--max-pick"   ) options.max_pick   = std::strtod( value, nullptr );
+      else
+        return false;
+    }
+
+    return ( options.frames > 0 ) && ( options.markers > 0 ) && ( options.size.width > 0 ) && ( options.size.height > 0 );
+  }
+
+  /** Middle of the dense area of generate() */
+  constexpr MarkerIndex::point_t  centre() noexcept
+  { return MarkerIndex::point_t{ 0.53, 0.43 }; }
+
+  /**
+   * A quarter of the markers spread over the world, the others around a few places,
+   * so that there are clusters at every zoom level.
+   */
+  std::vector<MarkerIndex::point_t>  generate( ure::uint_t count ) noexcept(true)
+  {
+    std::mt19937                            rng( 1 );
+    std::uniform_real_distribution<double>  uniform( 0.0, 1.0 );
+    std::normal_distribution<double>        spread( 0.0, 0.01 );
+    std::vector<MarkerIndex::point_t>       points;
+
+    points.reserve( count );
+
+    for ( ure::uint_t i = 0; i < count; ++i )
+    {
+      if ( i % 4 == 0 )
+        points.push_back( MarkerIndex::point_t{ uniform( rng ), uniform( rng ) } );
+      else
+        points.push_back( MarkerIndex::point_t{ centre().x + ( i % 16 ) / 256.0 - 0.03 + spread( rng ), centre().y + ( i % 11 ) / 176.0 - 0.03 + spread( rng ) } );
+    }
+
+    return points;
+  }
+
+  /**
+   * Every marker must belong to exactly one cluster of a whole world query, whatever
+   * the level. Return the number of failed levels.
+   */
+  ure::uint_t  check_clusters( const MarkerIndex& index, ure::uint_t tile_pixels, ure::float_t distance, ure::int_t max_levels ) noexcept(true)
+  {
+    ure::uint_t                          failed = 0;
+    std::vector<MarkerIndex::cluster_t>  clusters;
+
+    for ( ure::int_t level = 0; level < max_levels; ++level )
+    {
+      clusters.clear();
+      index.query( MarkerIndex::bounds_t{ 0.0, 0.0, 1.0, 1.0 }, distance / std::ldexp( static_cast<ure::double_t>( tile_pixels ), level ), clusters );
+
+      std::uint64_t markers = 0;
+
+      for ( const MarkerIndex::cluster_t& cluster : clusters )
+        markers += cluster.count;
+
+      if ( markers != index.size() )
+      {
+        printf( "FAIL: level %d clusters hold %llu markers instead of %zu\n", level, static_cast<unsigned long long>( markers ), index.size() );
+        ++failed;
+      }
+    }
+
+    return failed;
+  }
+
+  /**
+   * Window position of @p cluster, as drawn by @p view.
+   */
+  glm::vec2  window( const BenchView<MarkerSet>& view, const MarkerSet& markers, const MarkerIndex::cluster_t& cluster, ure::uint_t tile_pixels, const ure::Size& size ) noexcept(true)
+  {
+    const ure::double_t  world  = std::ldexp( static_cast<ure::double_t>( tile_pixels ), markers.zoom() );
+    const glm::vec2      origin = view.view().origin( markers.zoom() );
+    const glm::vec4      clip   = view.model() * glm::vec4( static_cast<ure::float_t>( origin.x + cluster.x * world ),
+                                                            static_cast<ure::float_t>( origin.y + cluster.y * world ), 0.0f, 1.0f );
+
+    return glm::vec2( ( clip.x / clip.w + 1.0f ) / 2.0f * size.width, ( 1.0f - clip.y / clip.w ) / 2.0f * size.height );
+  }
+}
+
+int main( int argc, char** argv )
+{
+  options_t   options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  BenchTrace  trace;
+
+  if ( options.trace.empty() ? ( trace.parse( BenchTrace::default_trace() ) == false ) : ( trace.load( options.trace ) == false ) )
+  {
+    printf( "unable to load trace [%s]\n", options.trace.c_str() );
+    return 2;
+  }
+
+  const ure::uint_t   tile_pixels = 256;
+  const ure::int_t    max_levels  = 19;
+  const ure::float_t  distance    = 48.0f;
+
+  int result = 0;
+
+  MarkerIndex  index;
+
+  const bench_clock_t::time_point  build_start = bench_clock_t::now();
+
+  index.build( generate( options.markers ) );
+
+  const ure::double_t  build_ms = std::chrono::duration<ure::double_t, std::milli>( bench_clock_t::now() - build_start ).count();
+
+  if ( check_clusters( index, tile_pixels, distance, max_levels ) > 0 )
+    result = 1;
+
+  null_gl::install();
+
+  MarkerSet  markers( tile_pixels );
+
+  markers.set_shaders_path( options.shaders );
+  markers.set_style( 6.0f, distance );
+  markers.set_markers( std::move(index) );
+
+  std::vector<ure::double_t>  frame_ms;
+  std::vector<ure::double_t>  pick_us;
+  null_gl::counters_t         start{};
+  std::uint64_t               queries = 0;
+  ure::uint_t                 missed  = 0;
+  ure::uint_t                 hits    = 0;
+  std::mt19937                rng( 2 );
+
+  pick_us.reserve( options.frames * options.picks );
+
+  {
+    BenchView<MarkerSet>  view( options.size, options.level, max_levels, markers );
+    BenchReplay           replay( trace, options.warmup, options.frames );
+
+    // Dense area in the centre of the window
+    view.centre_on( glm::dvec2( centre().x, centre().y ), tile_pixels );
+
+    std::uniform_real_distribution<ure::float_t>  x( 0.0f, static_cast<ure::float_t>( options.size.width  ) );
+    std::uniform_real_distribution<ure::float_t>  y( 0.0f, static_cast<ure::float_t>( options.size.height ) );
+
+    while ( replay.next() )
+    {
+      if ( replay.starting() )
+      {
+        start   = null_gl::counters();
+        queries = markers.queries();
+      }
+
+      replay.begin();
+      view.frame( replay.event(), replay.now() );
+      replay.end();
+
+      if ( replay.measured() == false )
+        continue;
+
+      const std::vector<MarkerIndex::cluster_t>& visible = markers.visible();
+
+      for ( ure::uint_t p = 0; p < options.picks; ++p )
+      {
+        // Centre of a drawn disc, or anywhere in the window
+        const ure::bool_t  on_disc = ( p % 2 == 0 ) && ( visible.empty() == false );
+        glm::vec2          point( x( rng ), y( rng ) );
+
+        if ( on_disc )
+          point = window( view, markers, visible[ rng() % visible.size() ], tile_pixels, options.size );
+
+        const bench_clock_t::time_point  pick_begin = bench_clock_t::now();
+        const auto                       hit        = markers.pick( point, options.size );
+        const bench_clock_t::time_point  pick_end   = bench_clock_t::now();
+
+        pick_us.push_back( std::chrono::duration<ure::double_t, std::micro>( pick_end - pick_begin ).count() );
+
+        hits += hit.has_value() ? 1 : 0;
+
+        // Discs outside of the window can not be picked
+        const ure::bool_t  in_window = ( point.x >= 0.0f ) && ( point.y >= 0.0f ) && ( point.x < options.size.width ) && ( point.y < options.size.height );
+
+        if ( on_disc && in_window && ( hit.has_value() == false ) )
+          ++missed;
+      }
+    }
+
+    frame_ms = replay.frame_ms();
+  }
+
+  const null_gl::counters_t  end    = null_gl::counters();
+  const ure::double_t        frames = static_cast<ure::double_t>( frame_ms.size() );
+
+  std::sort( frame_ms.begin(), frame_ms.end() );
+  std::sort( pick_us.begin(), pick_us.end() );
+
+  const ure::double_t  p99      = percentile( frame_ms, 0.99 );
+  const ure::double_t  pick_p99 = percentile( pick_us, 0.99 );
+
+  printf( "markers           %zu, %zu index nodes, built in %.1f ms\n", markers.markers().size(), markers.markers().nodes(), build_ms );
+  printf( "frames            %zu (warmup %u, trace %zu, level %d)\n", frame_ms.size(), options.warmup, trace.frames(), options.level );
+  printf( "frame time ms     p50 %.3f  p99 %.3f  max %.3f\n", percentile( frame_ms, 0.50 ), p99, frame_ms.back() );
+  printf( "queries           %llu\n", static_cast<unsigned long long>( markers.queries() - queries ) );
+  printf( "draw calls/frame  %.2f\n", ( end.draw_calls   - start.draw_calls   ) / frames );
+  printf( "instance KB/frame %.2f\n", ( end.buffer_bytes - start.buffer_bytes ) / frames / 1024.0 );
+  printf( "pick time us      p50 %.2f  p99 %.2f  max %.2f (%zu picks, %u hits)\n", percentile( pick_us, 0.50 ), pick_p99, pick_us.empty() ? 0.0 : pick_us.back(), pick_us.size(), hits );
+
+  if ( end.draw_calls == start.draw_calls )
+  {
+    printf( "FAIL: nothing has been drawn, check --shaders\n" );
+    result = 1;
+  }
+
+  if ( missed > 0 )
+  {
+    printf( "FAIL: %u picks at the centre of a drawn marker found nothing\n", missed );
+    result = 1;
+  }
+
+  if ( ( options.max_p99 > 0.0 ) && ( p99 > options.max_p99 ) )
+  {
+    printf( "FAIL: p99 %.3f ms exceeds %.3f ms\n", p99, options.max_p99 );
+    result = 1;
+  }
+
+  if ( ( options.max_pick > 0.0 ) && ( pick_p99 > options.max_pick ) )
+  {
+    printf( "FAIL: pick p99 %.2f us exceeds %.2f us\n", pick_p99, options.max_pick );
+    result = 1;
+  }
+
+  markers.dispose();
+
+  return result;
+}
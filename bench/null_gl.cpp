@@ -0,0 +1,165 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "null_gl.h"
+
+#include <ure_texture.h>
+
+#include <vector>
+
+namespace
+{
+  null_gl::counters_t   g_counters{ 0, 0, 0, 0, 0 };
+  GLuint                g_names = 0;
+  const char*           g_version = "";
+  std::vector<GLubyte>  g_mapped;         /* Storage handed out by glMapBufferRange, any buffer */
+
+  GLuint  name() { return ++g_names; }
+
+  void    nActiveTexture( GLenum ) {}
+  void    nAttachShader( GLuint, GLuint ) {}
+  void    nBindBuffer( GLenum, GLuint ) {}
+  void    nBindTexture( GLenum, GLuint ) {}
+  void    nBlendFunc( GLenum, GLenum ) {}
+  void    nBufferData( GLenum, GLsizeiptr size, const void*, GLenum ) { g_counters.buffer_bytes += static_cast<std::uint64_t>(size); }
+  void    nBufferSubData( GLenum, GLintptr, GLsizeiptr size, const void* ) { g_counters.buffer_bytes += static_cast<std::uint64_t>(size); }
+  void    nCompileShader( GLuint ) {}
+  void    nCompressedTexImage2D( GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const void* ) { ++g_counters.texture_uploads; }
+  void    nCompressedTexSubImage2D( GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei size, const void* )
+  { ++g_counters.texture_uploads; g_counters.texture_bytes += static_cast<std::uint64_t>(size); }
+  GLuint  nCreateProgram() { return name(); }
+  GLuint  nCreateShader( GLenum ) { return name(); }
+  void    nDeleteBuffers( GLsizei, const GLuint* ) {}
+  void    nDeleteProgram( GLuint ) {}
+  void    nDeleteShader( GLuint ) {}
+  void    nDeleteTextures( GLsizei, const GLuint* ) {}
+  void    nDisable( GLenum ) {}
+  void    nDisableVertexAttribArray( GLuint ) {}
+  void    nDrawArrays( GLenum, GLint, GLsizei ) { ++g_counters.draw_calls; }
+  void    nDrawArraysInstanced( GLenum, GLint, GLsizei, GLsizei ) { ++g_counters.draw_calls; }
+  void    nDrawElements( GLenum, GLsizei, GLenum, const void* ) { ++g_counters.draw_calls; }
+  void    nEnable( GLenum ) {}
+  void    nEnableVertexAttribArray( GLuint ) {}
+  void    nGenBuffers( GLsizei n, GLuint* buffers ) { for ( GLsizei i = 0; i < n; ++i ) buffers[i] = name(); }
+  void    nGenTextures( GLsizei n, GLuint* textures ) { for ( GLsizei i = 0; i < n; ++i ) textures[i] = name(); }
+  GLint   nGetAttribLocation( GLuint, const GLchar* ) { return 0; }
+  GLenum  nGetError() { return GL_NO_ERROR; }
+  void    nGetIntegerv( GLenum pname, GLint* data ) { *data = ( pname == GL_MAX_TEXTURE_SIZE ) ? 4096 : 0; }
+  const GLubyte* nGetString( GLenum name ) { return reinterpret_cast<const GLubyte*>( ( name == GL_VERSION ) ? g_version : "null" ); }
+  void    nGetProgramiv( GLuint, GLenum, GLint* params ) { *params = GL_TRUE; }
+  void    nGetShaderInfoLog( GLuint, GLsizei size, GLsizei* length, GLchar* log ) { if ( length ) *length = 0; if ( size > 0 ) log[0] = 0; }
+  void    nGetShaderiv( GLuint, GLenum, GLint* params ) { *params = GL_TRUE; }
+  GLint   nGetUniformLocation( GLuint, const GLchar* ) { return 0; }
+  GLboolean nIsEnabled( GLenum ) { return GL_FALSE; }
+  void    nLineWidth( GLfloat ) {}
+  void    nLinkProgram( GLuint ) {}
+  void*   nMapBufferRange( GLenum, GLintptr, GLsizeiptr length, GLbitfield )
+  {
+    if ( g_mapped.size() < static_cast<std::size_t>(length) )
+      g_mapped.resize( static_cast<std::size_t>(length) );
+
+    g_counters.mapped_bytes += static_cast<std::uint64_t>(length);
+    return g_mapped.data();
+  }
+  void    nPixelStorei( GLenum, GLint ) {}
+  void    nShaderSource( GLuint, GLsizei, const GLchar* const*, const GLint* ) {}
+  void    nTexImage2D( GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void* ) { ++g_counters.texture_uploads; }
+  void    nTexParameteri( GLenum, GLenum, GLint ) {}
+  void    nTexSubImage2D( GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum type, const void* )
+  {
+    ++g_counters.texture_uploads;
+    g_counters.texture_bytes += static_cast<std::uint64_t>( width ) * static_cast<std::uint64_t>( height ) * ( ( type == GL_UNSIGNED_SHORT_5_6_5 ) ? 2 : 4 );
+  }
+  void    nUniform1f( GLint, GLfloat ) {}
+  void    nUniform1fv( GLint, GLsizei, const GLfloat* ) {}
+  void    nUniform1i( GLint, GLint ) {}
+  void    nUniform2f( GLint, GLfloat, GLfloat ) {}
+  void    nUniform4f( GLint, GLfloat, GLfloat, GLfloat, GLfloat ) {}
+  void    nUniformMatrix4fv( GLint, GLsizei, GLboolean, const GLfloat* ) {}
+  GLboolean nUnmapBuffer( GLenum ) { return GL_TRUE; }
+  void    nUseProgram( GLuint ) {}
+  void    nVertexAttribDivisor( GLuint, GLuint ) {}
+  void    nVertexAttribPointer( GLuint, GLint, GLenum, GLboolean, GLsizei, const void* ) {}
+}
+
+namespace null_gl
+{
+
+ure::void_t   install( const char* version ) noexcept
+{
+  g_counters = counters_t{ 0, 0, 0, 0, 0 };
+  g_version  = version;
+
+  glad_glActiveTexture            = nActiveTexture;
+  glad_glAttachShader             = nAttachShader;
+  glad_glBindBuffer               = nBindBuffer;
+  glad_glBindTexture              = nBindTexture;
+  glad_glBlendFunc                = nBlendFunc;
+  glad_glBufferData               = nBufferData;
+  glad_glBufferSubData            = nBufferSubData;
+  glad_glCompileShader            = nCompileShader;
+  glad_glCompressedTexImage2D     = nCompressedTexImage2D;
+  glad_glCompressedTexSubImage2D  = nCompressedTexSubImage2D;
+  glad_glCreateProgram            = nCreateProgram;
+  glad_glCreateShader             = nCreateShader;
+  glad_glDeleteBuffers            = nDeleteBuffers;
+  glad_glDeleteProgram            = nDeleteProgram;
+  glad_glDeleteShader             = nDeleteShader;
+  glad_glDeleteTextures           = nDeleteTextures;
+  glad_glDisable                  = nDisable;
+  glad_glDisableVertexAttribArray = nDisableVertexAttribArray;
+  glad_glDrawArrays               = nDrawArrays;
+  glad_glDrawArraysInstanced      = nDrawArraysInstanced;
+  glad_glDrawElements             = nDrawElements;
+  glad_glEnable                   = nEnable;
+  glad_glEnableVertexAttribArray  = nEnableVertexAttribArray;
+  glad_glGenBuffers               = nGenBuffers;
+  glad_glGenTextures              = nGenTextures;
+  glad_glGetAttribLocation        = nGetAttribLocation;
+  glad_glGetError                 = nGetError;
+  glad_glGetIntegerv              = nGetIntegerv;
+  glad_glGetString                = nGetString;
+  glad_glGetProgramiv             = nGetProgramiv;
+  glad_glGetShaderInfoLog         = nGetShaderInfoLog;
+  glad_glGetShaderiv              = nGetShaderiv;
+  glad_glGetUniformLocation       = nGetUniformLocation;
+  glad_glIsEnabled                = nIsEnabled;
+  glad_glLineWidth                = nLineWidth;
+  glad_glLinkProgram              = nLinkProgram;
+  glad_glMapBufferRange           = nMapBufferRange;
+  glad_glPixelStorei              = nPixelStorei;
+  glad_glShaderSource             = nShaderSource;
+  glad_glTexImage2D               = nTexImage2D;
+  glad_glTexParameteri            = nTexParameteri;
+  glad_glTexSubImage2D            = nTexSubImage2D;
+  glad_glUniform1f                = nUniform1f;
+  glad_glUniform1fv               = nUniform1fv;
+  glad_glUniform1i                = nUniform1i;
+  glad_glUniform2f                = nUniform2f;
+  glad_glUniform4f                = nUniform4f;
+  glad_glUniformMatrix4fv         = nUniformMatrix4fv;
+  glad_glUnmapBuffer              = nUnmapBuffer;
+  glad_glUseProgram               = nUseProgram;
+  glad_glVertexAttribDivisor      = nVertexAttribDivisor;
+  glad_glVertexAttribPointer      = nVertexAttribPointer;
+}
+
+counters_t    counters() noexcept
+{
+  return g_counters;
+}
+
+}
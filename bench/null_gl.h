@@ -0,0 +1,51 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef NULL_GL_H
+#define NULL_GL_H
+
+#include <ure_utils.h>
+
+#include <cstdint>
+
+/**
+ * GL entry points that do nothing but count, so that the render loop runs
+ * without a GPU or a window. Only the functions used by the tile renderer are
+ * provided, they replace the pointers normally resolved by the glad loader.
+ */
+namespace null_gl
+{
+  struct counters_t
+  {
+    std::uint64_t   draw_calls;
+    std::uint64_t   texture_uploads;    /* glTexImage2D and glTexSubImage2D calls, compressed ones included */
+    std::uint64_t   texture_bytes;      /* Bytes passed to glTexSubImage2D and glCompressedTexSubImage2D */
+    std::uint64_t   buffer_bytes;       /* Bytes passed to glBufferData and glBufferSubData */
+    std::uint64_t   mapped_bytes;       /* Bytes mapped with glMapBufferRange */
+  };
+
+  /**
+   * Install the null entry points, must be called before any GL call.
+   * @p version is returned for GL_VERSION, OpenGL ES 2 contexts can not map buffers.
+   */
+  ure::void_t   install( const char* version = "OpenGL ES 3.0 null" ) noexcept;
+
+  /**
+   * Counters accumulated since install().
+   */
+  counters_t    counters() noexcept;
+}
+
+#endif // NULL_GL_H
@@ -0,0 +1,284 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_server.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+  // Path in the "/z/x/y.png" form, query string ignored
+  std::optional<TileKey> parse_path( std::string_view path )
+  {
+    path = path.substr( 0, path.find( '?' ) );
+
+    if ( ( path.size() > 4 ) && ( path.substr( path.size() - 4 ) == ".png" ) )
+      path.remove_suffix( 4 );
+
+    TileKey      key{};
+    ure::uint_t* fields[3] = { &key.z, &key.x, &key.y };
+    const char*  first     = path.data();
+    const char*  last      = path.data() + path.size();
+
+    for ( std::size_t i = 0; i < 3; ++i )
+    {
+      if ( ( first == last ) || ( *first != '/' ) )
+        return std::nullopt;
+
+      auto [ptr, ec] = std::from_chars( first + 1, last, *fields[i] );
+      if ( ec != std::errc() )
+        return std::nullopt;
+
+      first = ptr;
+    }
+
+    if ( first != last )
+      return std::nullopt;
+
+    return key;
+  }
+
+  ure::bool_t  send_all( int fd, const char* data, std::size_t length )
+  {
+    while ( length > 0 )
+    {
+      const ssize_t sent = ::send( fd, data, length, MSG_NOSIGNAL );
+      if ( sent <= 0 )
+        return false;
+
+      data   += sent;
+      length -= static_cast<std::size_t>(sent);
+    }
+
+    return true;
+  }
+}
+
+TileServer::TileServer( TileSource& source, const options_t& options ) noexcept(true)
+  : m_source( source ), m_options( options ), m_listen(-1), m_port(0), m_running(false),
+    m_random( std::random_device{}() ), m_requests(0), m_failures(0), m_not_found(0), m_connections(0)
+{
+}
+
+TileServer::~TileServer() noexcept(true)
+{
+  stop();
+}
+
+ure::bool_t  TileServer::start() noexcept(true)
+{
+  if ( m_running )
+    return true;
+
+  m_listen = ::socket( AF_INET, SOCK_STREAM, 0 );
+  if ( m_listen < 0 )
+    return false;
+
+  const int reuse = 1;
+  ::setsockopt( m_listen, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse) );
+
+  sockaddr_in addr{};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons( m_options.port );
+  addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+  socklen_t   length   = sizeof(addr);
+
+  if ( ( ::bind( m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr) ) != 0 ) ||
+       ( ::listen( m_listen, 64 ) != 0 ) ||
+       ( ::getsockname( m_listen, reinterpret_cast<sockaddr*>(&addr), &length ) != 0 ) )
+  {
+    ::close( m_listen );
+    m_listen = -1;
+    return false;
+  }
+
+  m_port    = ntohs( addr.sin_port );
+  m_running = true;
+
+  m_acceptor = std::thread( &TileServer::accept_loop, this );
+
+  return true;
+}
+
+ure::void_t  TileServer::stop() noexcept(true)
+{
+  if ( m_running.exchange( false ) == false )
+    return;
+
+  // Wakes up accept()
+  ::shutdown( m_listen, SHUT_RDWR );
+  ::close( m_listen );
+  m_listen = -1;
+
+  if ( m_acceptor.joinable() )
+    m_acceptor.join();
+
+  std::vector<std::thread> threads;
+
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    // Wakes up recv(), every thread closes its own socket
+    for ( int fd : m_clients )
+      ::shutdown( fd, SHUT_RDWR );
+
+    threads.swap( m_threads );
+  }
+
+  for ( std::thread& thread : threads )
+    thread.join();
+}
+
+TileServer::stats_t  TileServer::stats() const noexcept(true)
+{
+  return stats_t{ m_requests.load(), m_failures.load(), m_not_found.load(), m_connections.load() };
+}
+
+ure::void_t  TileServer::accept_loop() noexcept(true)
+{
+  while ( m_running )
+  {
+    const int fd = ::accept( m_listen, nullptr, nullptr );
+    if ( fd < 0 )
+      continue;
+
+    const int nodelay = 1;
+    ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay) );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if ( m_running == false )
+    {
+      ::close( fd );
+      break;
+    }
+
+    ++m_connections;
+
+    m_clients.push_back( fd );
+    m_threads.emplace_back( &TileServer::serve, this, fd );
+  }
+}
+
+ure::void_t  TileServer::serve( int fd ) noexcept(true)
+{
+  std::string  buffer;
+  char         chunk[4096];
+  ure::bool_t  open = true;
+
+  while ( open && m_running )
+  {
+    const std::size_t end = buffer.find( "\r\n\r\n" );
+
+    if ( end == std::string::npos )
+    {
+      const ssize_t received = ::recv( fd, chunk, sizeof(chunk), 0 );
+      if ( received <= 0 )
+        break;
+
+      buffer.append( chunk, static_cast<std::size_t>(received) );
+      continue;
+    }
+
+    // Request line: METHOD SP PATH SP VERSION, no request body expected
+    const std::string_view  request( buffer.data(), end );
+    const std::size_t       method = request.find( ' ' );
+    const std::size_t       path   = ( method != std::string_view::npos ) ? request.find( ' ', method + 1 ) : std::string_view::npos;
+
+    if ( path == std::string_view::npos )
+      break;
+
+    open = respond( fd, request.substr( method + 1, path - method - 1 ) ) &&
+           ( request.find( "Connection: close" ) == std::string_view::npos );
+
+    buffer.erase( 0, end + 4 );
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_clients.erase( std::remove( m_clients.begin(), m_clients.end(), fd ), m_clients.end() );
+  ::close( fd );
+}
+
+ure::bool_t  TileServer::respond( int fd, std::string_view path ) noexcept(true)
+{
+  ++m_requests;
+
+  std::this_thread::sleep_for( delay() );
+
+  const char*                      status = "200 OK";
+  const std::vector<ure::byte_t>*  body   = nullptr;
+  std::optional<TileKey>           key    = parse_path( path );
+
+  if ( inject_failure() )
+  {
+    status = "503 Service Unavailable";
+    ++m_failures;
+  }
+  else
+  {
+    if ( key.has_value() )
+      body = &m_source.get( key.value() );
+
+    if ( ( body == nullptr ) || body->empty() )
+    {
+      status = "404 Not Found";
+      body   = nullptr;
+      ++m_not_found;
+    }
+  }
+
+  const std::size_t  length = ( body != nullptr ) ? body->size() : 0;
+  const std::string  header = std::string( "HTTP/1.1 " ) + status + "\r\n"
+                              "Content-Type: image/png\r\n"
+                              "Content-Length: " + std::to_string( length ) + "\r\n"
+                              "Connection: keep-alive\r\n\r\n";
+
+  return send_all( fd, header.data(), header.size() ) &&
+         ( ( body == nullptr ) || send_all( fd, reinterpret_cast<const char*>( body->data() ), length ) );
+}
+
+std::chrono::microseconds  TileServer::delay() noexcept(true)
+{
+  if ( m_options.jitter.count() <= 0 )
+    return m_options.latency;
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  std::uniform_int_distribution<std::int64_t> jitter( 0, m_options.jitter.count() );
+
+  return m_options.latency + std::chrono::microseconds( jitter( m_random ) );
+}
+
+ure::bool_t  TileServer::inject_failure() noexcept(true)
+{
+  if ( m_options.failure_rate <= 0.0 )
+    return false;
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return std::uniform_real_distribution<ure::double_t>( 0.0, 1.0 )( m_random ) < m_options.failure_rate;
+}
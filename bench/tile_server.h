@@ -0,0 +1,113 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_SERVER_H
+#define TILE_SERVER_H
+
+#include <ure_utils.h>
+
+#include "tile_source.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal HTTP/1.1 server on the loopback interface, standing in for a tile server.
+ *
+ * Serves GET /z/x/y.png from a TileSource, one thread per connection with keep-alive.
+ * Every response is delayed by latency plus a uniform jitter, and a share of the
+ * requests fail with 503 so that retries can be exercised.
+ * Only meant for benchmarks and local testing, POSIX sockets only.
+ */
+class TileServer
+{
+public:
+  struct options_t
+  {
+    std::uint16_t               port         = 0;     /* 0 picks a free port, see port() */
+    std::chrono::microseconds   latency      { 0 };   /* Added to every response */
+    std::chrono::microseconds   jitter       { 0 };   /* Uniform in [0, jitter], added to latency */
+    ure::double_t               failure_rate = 0.0;   /* Share of requests answered with 503 */
+  };
+
+  struct stats_t
+  {
+    std::uint64_t   requests;
+    std::uint64_t   failures;     /* Injected 503 */
+    std::uint64_t   not_found;
+    std::uint64_t   connections;
+  };
+
+  /***/
+  TileServer( TileSource& source, const options_t& options ) noexcept(true);
+  /***/
+  ~TileServer() noexcept(true);
+
+  TileServer( const TileServer& ) = delete;
+  TileServer& operator=( const TileServer& ) = delete;
+
+  /**
+   * Bind 127.0.0.1 and start accepting connections, return false on errors.
+   */
+  ure::bool_t     start() noexcept(true);
+  /**
+   * Close all connections and wait for their threads.
+   */
+  ure::void_t     stop() noexcept(true);
+
+  /** Port bound by start() */
+  std::uint16_t   port() const noexcept
+  { return m_port; }
+
+  /***/
+  stats_t         stats() const noexcept(true);
+
+private:
+  /***/
+  ure::void_t     accept_loop() noexcept(true);
+  /***/
+  ure::void_t     serve( int fd ) noexcept(true);
+  /**
+   * Answer a single request for @p path on @p fd, return false if the connection is lost.
+   */
+  ure::bool_t     respond( int fd, std::string_view path ) noexcept(true);
+  /***/
+  std::chrono::microseconds  delay() noexcept(true);
+  /***/
+  ure::bool_t     inject_failure() noexcept(true);
+
+private:
+  TileSource&                 m_source;
+  const options_t             m_options;
+  int                         m_listen;
+  std::uint16_t               m_port;
+  std::atomic<ure::bool_t>    m_running;
+  std::thread                 m_acceptor;
+  std::mutex                  m_mutex;
+  std::vector<int>            m_clients;         /* Open connections, closed by stop() */
+  std::vector<std::thread>    m_threads;
+  std::minstd_rand            m_random;
+  std::atomic<std::uint64_t>  m_requests;
+  std::atomic<std::uint64_t>  m_failures;
+  std::atomic<std::uint64_t>  m_not_found;
+  std::atomic<std::uint64_t>  m_connections;
+};
+
+#endif // TILE_SERVER_H
@@ -0,0 +1,95 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Local stand-in for a tile server, to load-test the download path without using
+ * public tile servers. Point the map at it with:
+ *
+ *   map --tiles-url http://127.0.0.1:8080/{z}/{x}/{y}.png
+ */
+
+#include "tile_server.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+namespace
+{
+  volatile std::sig_atomic_t  g_stop = 0;
+
+  void  on_signal( int ) { g_stop = 1; }
+}
+
+int main( int argc, char** argv )
+{
+  TileServer::options_t  options;
+  std::string            directory;
+
+  options.port = 8080;
+
+  for ( int i = 1; i + 1 < argc; i += 2 )
+  {
+    const std::string_view arg( argv[i] );
+    const char*            value = argv[i + 1];
+
+    if      ( arg == "--port"         ) options.port         = static_cast<std::uint16_t>( std::strtoul( value, nullptr, 10 ) );
+    else if ( arg == "--tiles"        ) directory            = value;
+    else if ( arg == "--latency"      ) options.latency      = std::chrono::microseconds( static_cast<std::int64_t>( std::strtod( value, nullptr ) * 1000 ) );
+    else if ( arg == "--jitter"       ) options.jitter       = std::chrono::microseconds( static_cast<std::int64_t>( std::strtod( value, nullptr ) * 1000 ) );
+    else if ( arg == "--failure-rate" ) options.failure_rate = std::strtod( value, nullptr );
+    else
+    {
+      argc = 0;
+      break;
+    }
+  }
+
+  if ( ( argc == 0 ) || ( argc % 2 == 0 ) )
+  {
+    printf( "usage: %s [--port N] [--tiles DIR] [--latency MS] [--jitter MS] [--failure-rate P]\n"
+            "  tiles are read from DIR/z/x/y.png, or generated when no directory is given\n", argv[0] );
+    return 2;
+  }
+
+  TileSource  source( ure::Size{ 256, 256 }, directory );
+  TileServer  server( source, options );
+
+  if ( server.start() == false )
+  {
+    printf( "unable to listen on 127.0.0.1:%u\n", options.port );
+    return 1;
+  }
+
+  std::signal( SIGINT,  on_signal );
+  std::signal( SIGTERM, on_signal );
+
+  printf( "serving %s on http://127.0.0.1:%u/{z}/{x}/{y}.png\n", directory.empty() ? "generated tiles" : directory.c_str(), server.port() );
+
+  while ( g_stop == 0 )
+    std::this_thread::sleep_for( std::chrono::milliseconds(100) );
+
+  server.stop();
+
+  const TileServer::stats_t stats = server.stats();
+
+  printf( "requests %llu, injected failures %llu, not found %llu, connections %llu\n",
+          static_cast<unsigned long long>( stats.requests  ), static_cast<unsigned long long>( stats.failures    ),
+          static_cast<unsigned long long>( stats.not_found ), static_cast<unsigned long long>( stats.connections ) );
+
+  return 0;
+}
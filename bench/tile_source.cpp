@@ -0,0 +1,235 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_source.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <typeinfo>
+
+#include <ure_texture.h>
+
+namespace
+{
+  const std::array<std::uint32_t, 256>& crc_table()
+  {
+    static const std::array<std::uint32_t, 256> table = [] {
+      std::array<std::uint32_t, 256> t{};
+
+      for ( std::uint32_t n = 0; n < 256; ++n )
+      {
+        std::uint32_t c = n;
+        for ( int k = 0; k < 8; ++k )
+          c = ( c & 1 ) ? ( 0xEDB88320u ^ ( c >> 1 ) ) : ( c >> 1 );
+        t[n] = c;
+      }
+
+      return t;
+    }();
+
+    return table;
+  }
+
+  void  put_u32( std::vector<ure::byte_t>& out, std::uint32_t value )
+  {
+    out.push_back( static_cast<ure::byte_t>( value >> 24 ) );
+    out.push_back( static_cast<ure::byte_t>( value >> 16 ) );
+    out.push_back( static_cast<ure::byte_t>( value >>  8 ) );
+    out.push_back( static_cast<ure::byte_t>( value       ) );
+  }
+
+  // Chunk length, type, data and the CRC over type and data
+  void  put_chunk( std::vector<ure::byte_t>& out, const char* type, const ure::byte_t* data, std::size_t length )
+  {
+    put_u32( out, static_cast<std::uint32_t>( length ) );
+
+    const std::size_t start = out.size();
+
+    out.insert( out.end(), type, type + 4 );
+    out.insert( out.end(), data, data + length );
+
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for ( std::size_t i = start; i < out.size(); ++i )
+      crc = crc_table()[ ( crc ^ out[i] ) & 0xFF ] ^ ( crc >> 8 );
+
+    put_u32( out, crc ^ 0xFFFFFFFFu );
+  }
+}
+
+TileSource::TileSource( const ure::Size& tile_size, const std::string& directory ) noexcept(true)
+  : m_tile_size( tile_size ), m_directory( directory ), m_served(0)
+{
+}
+
+ure::void_t   TileSource::fetch( ure::ResourcesFetcherEvents& events, const std::string& name, [[maybe_unused]] const std::string& url ) noexcept(true)
+{
+  std::optional<TileKey> key = TileKey::parse( name );
+
+  if ( key.has_value() == false )
+  {
+    events.on_download_failed( name );
+    return;
+  }
+
+  const std::vector<ure::byte_t>& png = get( key.value() );
+
+  if ( png.empty() )
+  {
+    events.on_download_failed( name );
+    return;
+  }
+
+  events.on_download_succeeded( name, typeid(ure::Texture), png.data(), static_cast<ure::uint_t>( png.size() ) );
+}
+
+const std::vector<ure::byte_t>&  TileSource::get( const TileKey& key ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  ++m_served;
+
+  auto it = m_tiles.find( key );
+  if ( it != m_tiles.end() )
+    return it->second;
+
+  std::vector<ure::byte_t>& png = m_tiles[key];
+
+  if ( m_directory.empty() )
+    generate( key, m_tile_size, png );
+  else if ( load( key, png ) == false )
+    png.clear();
+
+  return png;
+}
+
+std::uint64_t  TileSource::served() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_served;
+}
+
+ure::bool_t   TileSource::load( const TileKey& key, std::vector<ure::byte_t>& png ) const noexcept(true)
+{
+  std::string   path( m_directory );
+
+  if ( ( path.empty() == false ) && ( path.back() != '/' ) )
+    path += '/';
+
+  path += std::to_string( key.z ) + '/' + std::to_string( key.x ) + '/' + std::to_string( key.y ) + ".png";
+
+  std::ifstream file( path, std::ios::binary );
+  if ( file.is_open() == false )
+    return false;
+
+  png.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+
+  return png.empty() == false;
+}
+
+ure::void_t  TileSource::encode_png( const ure::byte_t* rgb, ure::uint_t width, ure::uint_t height, std::vector<ure::byte_t>& png ) noexcept(true)
+{
+  static const ure::byte_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+  const std::size_t stride = std::size_t(width) * 3;
+  const std::size_t raw    = ( stride + 1 ) * height;   // Filter byte in front of every row
+
+  png.clear();
+  png.insert( png.end(), signature, signature + sizeof(signature) );
+
+  // IHDR: 8 bits RGB, no interlace
+  std::vector<ure::byte_t> data;
+
+  data.reserve( raw + raw / 65535 * 5 + 16 );
+
+  put_u32( data, width );
+  put_u32( data, height );
+  data.insert( data.end(), { 8, 2, 0, 0, 0 } );
+
+  put_chunk( png, "IHDR", data.data(), data.size() );
+
+  // IDAT: zlib stream made of stored deflate blocks, at most 65535 bytes each
+  data.clear();
+  data.push_back( 0x78 );
+  data.push_back( 0x01 );
+
+  std::uint32_t   a         = 1;
+  std::uint32_t   b         = 0;
+  std::size_t     remaining = raw;
+  std::size_t     block     = 0;
+
+  for ( ure::uint_t row = 0; row < height; ++row )
+  {
+    for ( std::size_t i = 0; i <= stride; ++i )
+    {
+      if ( block == 0 )
+      {
+        block = std::min<std::size_t>( remaining, 65535 );
+
+        const std::uint16_t len = static_cast<std::uint16_t>( block );
+
+        data.push_back( ( remaining == block ) ? 1 : 0 );
+        data.push_back( static_cast<ure::byte_t>( len      ) );
+        data.push_back( static_cast<ure::byte_t>( len >> 8 ) );
+        data.push_back( static_cast<ure::byte_t>( ~len      ) );
+        data.push_back( static_cast<ure::byte_t>( ~len >> 8 ) );
+      }
+
+      const ure::byte_t value = ( i == 0 ) ? 0 : rgb[ row * stride + i - 1 ];
+
+      data.push_back( value );
+
+      a = ( a + value ) % 65521;
+      b = ( b + a     ) % 65521;
+
+      --block;
+      --remaining;
+    }
+  }
+
+  put_u32( data, ( b << 16 ) | a );
+
+  put_chunk( png, "IDAT", data.data(), data.size() );
+  put_chunk( png, "IEND", nullptr, 0 );
+}
+
+ure::void_t  TileSource::generate( const TileKey& key, const ure::Size& tile_size, std::vector<ure::byte_t>& png ) noexcept(true)
+{
+  const ure::uint_t   width  = tile_size.width;
+  const ure::uint_t   height = tile_size.height;
+  const std::uint64_t seed   = key.packed() * 0x9E3779B97F4A7C15ull;   // Spread neighbour keys apart
+  const ure::byte_t   tint[3] = { static_cast<ure::byte_t>( seed >> 56 ), static_cast<ure::byte_t>( seed >> 48 ), static_cast<ure::byte_t>( 64 * ( key.z % 4 ) ) };
+
+  std::vector<ure::byte_t> rgb( std::size_t(width) * height * 3 );
+
+  // Checkerboard with a border, tile edges stay visible when debugging the renderer
+  for ( ure::uint_t y = 0; y < height; ++y )
+  {
+    for ( ure::uint_t x = 0; x < width; ++x )
+    {
+      ure::byte_t* pixel  = &rgb[ ( std::size_t(y) * width + x ) * 3 ];
+      const bool   border = ( x == 0 ) || ( y == 0 ) || ( x == width - 1 ) || ( y == height - 1 );
+      const bool   dark   = ( ( x / 32 ) + ( y / 32 ) ) % 2 != 0;
+
+      for ( int c = 0; c < 3; ++c )
+        pixel[c] = border ? 0 : static_cast<ure::byte_t>( dark ? tint[c] / 2 : tint[c] );
+    }
+  }
+
+  encode_png( rgb.data(), width, height, png );
+}
@@ -0,0 +1,83 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_SOURCE_H
+#define TILE_SOURCE_H
+
+#include <ure_utils.h>
+#include <ure_size.h>
+#include <ure_resources_fetcher_events.h>
+
+#include "tile_key.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Local tiles for benchmarks, no network involved.
+ *
+ * Tiles are read from DIR/z/x/y.png when a directory is given, otherwise they are
+ * generated: an uncompressed PNG with a pattern depending on the key, so that
+ * every tile goes through the same decoder used for downloaded ones.
+ * Encoded tiles are kept in memory, a tile is read or generated only once.
+ */
+class TileSource
+{
+public:
+  /***/
+  TileSource( const ure::Size& tile_size, const std::string& directory = std::string() ) noexcept(true);
+
+  /**
+   * Serve the tile named @p name, in the "z-x-y" form, notifying @p events before returning.
+   * Signature matches TileScheduler::fetcher_t.
+   */
+  ure::void_t   fetch( ure::ResourcesFetcherEvents& events, const std::string& name, const std::string& url ) noexcept(true);
+
+  /**
+   * Encoded tile for @p key, empty if it does not exist.
+   */
+  const std::vector<ure::byte_t>&
+                get( const TileKey& key ) noexcept(true);
+
+  /**
+   * Encode an RGB image of @p width x @p height pixels as PNG, without compression.
+   */
+  static ure::void_t  encode_png( const ure::byte_t* rgb, ure::uint_t width, ure::uint_t height, std::vector<ure::byte_t>& png ) noexcept(true);
+
+  /**
+   * Generated tile for @p key, with @p tile_size pixels.
+   */
+  static ure::void_t  generate( const TileKey& key, const ure::Size& tile_size, std::vector<ure::byte_t>& png ) noexcept(true);
+
+  /**
+   * Number of tiles served so far.
+   */
+  std::uint64_t       served() const noexcept(true);
+
+private:
+  /***/
+  ure::bool_t   load( const TileKey& key, std::vector<ure::byte_t>& png ) const noexcept(true);
+
+private:
+  const ure::Size                                         m_tile_size;
+  const std::string                                       m_directory;   /* Empty to generate tiles */
+  mutable std::mutex                                      m_mutex;
+  std::unordered_map<TileKey, std::vector<ure::byte_t>>   m_tiles;       /* Encoded tiles, empty if missing */
+  std::uint64_t                                           m_served;
+};
+
+#endif // TILE_SOURCE_H
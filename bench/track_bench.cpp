@@ -0,0 +1,357 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Headless benchmark and check of the tracks layer.
+ *
+ * Simplifies generated vehicle tracks for every level and checks that no original
+ * vertex is farther than the tolerance from the line drawn at any level, then replays
+ * a pan/zoom trace against a null GL driver with a fixed 60 Hz clock. Build time,
+ * frame times, draw calls and segments drawn per frame are reported.
+ */
+
+#include "bench_stats.h"
+#include "bench_trace.h"
+#include "bench_view.h"
+#include "null_gl.h"
+
+#include "map_view.h"
+#include "track_pyramid.h"
+#include "track_set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+
+  struct options_t
+  {
+    ure::uint_t   tracks      = 1000;
+    ure::uint_t   vertices    = 4096;    /* Per track */
+    ure::uint_t   workers     = 0;       /* 0 for one per hardware thread */
+    ure::uint_t   frames      = 600;
+    ure::uint_t   warmup      = 60;
+    ure::int_t    level       = 3;
+    ure::Size     size        = { 1024, 768 };
+    ure::uint_t   checked     = 32;      /* Tracks whose error is measured at every level */
+    std::string   trace;
+    std::string   shaders     = "./resources/shaders/";
+    ure::double_t max_p99     = 0.0;     /* Milliseconds, 0 to disable */
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s [options]\n"
+            "  --tracks N        tracks generated (1000)\n"
+            "  --vertices N      vertices per track (4096)\n"
+            "  --workers N       simplification threads, 0 for all (0)\n"
+            "  --frames N        measured frames (600)\n"
+            "  --warmup N        frames run before measuring (60)\n"
+            "  --level N         initial zoom level (3)\n"
+            "  --width N         viewport width (1024)\n"
+            "  --height N        viewport height (768)\n"
+            "  --check N         tracks checked against the tolerance (32)\n"
+            "  --trace FILE      pan/zoom trace, a built-in one by default\n"
+            "  --shaders DIR     shaders location (./resources/shaders/)\n"
+            "  --max-p99 MS      fail if p99 frame time exceeds MS\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[++i];
+
+      if      ( arg == "--tracks"     ) options.tracks     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--vertices"   ) options.vertices   = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--workers"    ) options.workers    = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--frames"     ) options.frames     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--warmup"     ) options.warmup     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--level"      ) options.level      = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--width"      ) options.size.width = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--height"     ) options.size.height= static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--check"      ) options.checked    = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--trace"      ) options.trace      = value;
+      else if ( arg == "--shaders"    ) options.shaders    = value;
+      else if ( arg == "--max-p99"    ) options.max_p99    = std::strtod( value, nullptr );
+      else
+        return false;
+    }
+
+    return ( options.frames > 0 ) && ( options.tracks > 0 ) && ( options.vertices > 1 ) && ( options.size.width > 0 ) && ( options.size.height > 0 );
+  }
+
+  /** Middle of the area covered by generate() */
+  constexpr TrackPyramid::point_t  centre() noexcept
+  { return TrackPyramid::point_t{ 0.53, 0.43 }; }
+
+  /**
+   * Random walks with a slowly turning heading, starting around centre(), one vertex
+   * about every 40 m.
+   */
+  std::vector<TrackPyramid::track_t>  generate( ure::uint_t count, ure::uint_t vertices ) noexcept(true)
+  {
+    std::mt19937                        rng( 1 );
+    std::normal_distribution<double>    spread( 0.0, 0.02 );
+    std::normal_distribution<double>    turn( 0.0, 0.2 );
+    std::vector<TrackPyramid::track_t>  tracks( count );
+
+    for ( TrackPyramid::track_t& track : tracks )
+    {
+      TrackPyramid::point_t  point{ centre().x + spread( rng ), centre().y + spread( rng ) };
+      double                 heading = turn( rng ) * 30.0;
+
+      track.reserve( vertices );
+
+      for ( ure::uint_t i = 0; i < vertices; ++i )
+      {
+        track.push_back( point );
+
+        heading += turn( rng );
+        point.x += std::cos( heading ) * 1e-6;
+        point.y += std::sin( heading ) * 1e-6;
+      }
+    }
+
+    return tracks;
+  }
+
+  /** Distance from @p p to segment [@p a, @p b] */
+  ure::double_t  distance( const TrackPyramid::point_t& p, const TrackPyramid::point_t& a, const TrackPyramid::point_t& b ) noexcept
+  {
+    const ure::double_t  dx = b.x - a.x;
+    const ure::double_t  dy = b.y - a.y;
+    const ure::double_t  l  = dx * dx + dy * dy;
+    const ure::double_t  t  = ( l > 0.0 ) ? std::clamp( ( ( p.x - a.x ) * dx + ( p.y - a.y ) * dy ) / l, 0.0, 1.0 ) : 0.0;
+
+    return std::hypot( a.x + t * dx - p.x, a.y + t * dy - p.y );
+  }
+
+  /**
+   * Every vertex of the first @p checked tracks must be within the tolerance of the
+   * line of every level, and levels must only add vertices. Return the number of
+   * failed levels, @p worst receives the largest error over tolerance ratio.
+   */
+  ure::uint_t  check_levels( const TrackPyramid& pyramid, ure::uint_t checked, ure::double_t& worst ) noexcept(true)
+  {
+    ure::uint_t                         failed   = 0;
+    std::uint32_t                       previous = 0;
+    std::vector<TrackPyramid::point_t>  vertices;
+    std::vector<std::uint32_t>          kept;
+
+    worst = 0.0;
+
+    for ( ure::uint_t level = 0; level < pyramid.levels(); ++level )
+    {
+      const TrackPyramid::level_t& lv = pyramid.level( level );
+
+      pyramid.vertices( level, vertices );
+
+      if ( ( vertices.size() != lv.vertices ) || ( lv.vertices < previous ) )
+      {
+        printf( "FAIL: level %u has %zu vertices, %u expected, %u at the previous level\n", level, vertices.size(), lv.vertices, previous );
+        ++failed;
+        continue;
+      }
+
+      previous = lv.vertices;
+
+      ure::double_t  error = 0.0;
+      std::size_t    c     = 0;
+
+      for ( std::uint32_t track = 0; ( track < checked ) && ( track < pyramid.tracks().size() ); ++track )
+      {
+        const TrackPyramid::track_t& original = pyramid.tracks()[track];
+
+        while ( ( c < lv.chunks.size() ) && ( lv.chunks[c].track < track ) )
+          ++c;
+
+        if ( ( c == lv.chunks.size() ) || ( lv.chunks[c].track != track ) )
+          continue;
+
+        // Simplified vertices are copies of original ones, in the same order
+        std::uint32_t  next = lv.chunks[c].first;
+
+        kept.clear();
+
+        for ( std::uint32_t i = 0; ( i < original.size() ) && ( next < vertices.size() ); ++i )
+        {
+          if ( ( original[i].x == vertices[next].x ) && ( original[i].y == vertices[next].y ) )
+          {
+            kept.push_back( i );
+            ++next;
+          }
+        }
+
+        if ( ( kept.empty() ) || ( kept.front() != 0 ) || ( kept.back() + 1 != original.size() ) )
+        {
+          printf( "FAIL: level %u track %u does not keep its ends\n", level, track );
+          ++failed;
+          break;
+        }
+
+        for ( std::size_t s = 0; s + 1 < kept.size(); ++s )
+        {
+          for ( std::uint32_t i = kept[s] + 1; i < kept[s + 1]; ++i )
+            error = std::max( error, distance( original[i], original[ kept[s] ], original[ kept[s + 1] ] ) );
+        }
+      }
+
+      worst = std::max( worst, error / lv.tolerance );
+
+      if ( error > lv.tolerance * 1.0001 )
+      {
+        printf( "FAIL: level %u error %g exceeds tolerance %g\n", level, error, lv.tolerance );
+        ++failed;
+      }
+    }
+
+    return failed;
+  }
+}
+
+int main( int argc, char** argv )
+{
+  options_t   options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  BenchTrace  trace;
+
+  if ( options.trace.empty() ? ( trace.parse( BenchTrace::default_trace() ) == false ) : ( trace.load( options.trace ) == false ) )
+  {
+    printf( "unable to load trace [%s]\n", options.trace.c_str() );
+    return 2;
+  }
+
+  const ure::uint_t   tile_pixels = 256;
+  const ure::int_t    max_levels  = 19;
+  const ure::uint_t   workers     = ( options.workers > 0 ) ? options.workers : std::max( 1u, std::thread::hardware_concurrency() );
+
+  int result = 0;
+
+  TrackPyramid  pyramid;
+
+  const bench_clock_t::time_point  build_start = bench_clock_t::now();
+
+  pyramid.build( generate( options.tracks, options.vertices ), max_levels, tile_pixels, 0.5f, workers );
+
+  const ure::double_t  build_ms = std::chrono::duration<ure::double_t, std::milli>( bench_clock_t::now() - build_start ).count();
+
+  ure::double_t  worst = 0.0;
+
+  if ( check_levels( pyramid, options.checked, worst ) > 0 )
+    result = 1;
+
+  null_gl::install();
+
+  TrackSet  tracks( tile_pixels );
+
+  tracks.set_shaders_path( options.shaders );
+  tracks.set_tracks( std::move(pyramid) );
+
+  std::vector<ure::double_t>  frame_ms;
+  std::vector<ure::double_t>  drawn;
+  null_gl::counters_t         start{};
+  ure::uint_t                 uploads = 0;
+
+  drawn.reserve( options.frames );
+
+  {
+    BenchView<TrackSet>  view( options.size, options.level, max_levels, tracks );
+    BenchReplay          replay( trace, options.warmup, options.frames );
+
+    // Tracks in the centre of the window
+    view.centre_on( glm::dvec2( centre().x, centre().y ), tile_pixels );
+
+    while ( replay.next() )
+    {
+      if ( replay.starting() )
+      {
+        start   = null_gl::counters();
+        uploads = tracks.uploads();
+      }
+
+      replay.begin();
+      view.frame( replay.event(), replay.now() );
+      replay.end();
+
+      if ( replay.measured() == false )
+        continue;
+
+      ure::double_t  segments = 0.0;
+
+      for ( const VectorRenderer::lines_t& lines : tracks.lines() )
+        segments += lines.count / 2;
+
+      drawn.push_back( segments );
+    }
+
+    frame_ms = replay.frame_ms();
+  }
+
+  const null_gl::counters_t  end    = null_gl::counters();
+  const ure::double_t        frames = static_cast<ure::double_t>( frame_ms.size() );
+
+  std::sort( frame_ms.begin(), frame_ms.end() );
+  std::sort( drawn.begin(), drawn.end() );
+
+  const ure::double_t  p99 = percentile( frame_ms, 0.99 );
+
+  printf( "tracks            %zu, %zu vertices, built in %.1f ms (%u workers)\n", tracks.tracks().tracks().size(), tracks.tracks().vertices(), build_ms, workers );
+  printf( "levels            %u, vertices level 0 %u, level %u %u, error/tolerance max %.2f\n", tracks.tracks().levels(), tracks.tracks().level( 0 ).vertices,
+          tracks.tracks().levels() - 1, tracks.tracks().level( tracks.tracks().levels() - 1 ).vertices, worst );
+  printf( "frames            %zu (warmup %u, trace %zu, level %d)\n", frame_ms.size(), options.warmup, trace.frames(), options.level );
+  printf( "frame time ms     p50 %.3f  p99 %.3f  max %.3f\n", percentile( frame_ms, 0.50 ), p99, frame_ms.back() );
+  printf( "draw calls/frame  %.2f\n", ( end.draw_calls - start.draw_calls ) / frames );
+  printf( "segments/frame    p50 %.0f  max %.0f\n", percentile( drawn, 0.50 ), drawn.back() );
+  printf( "level uploads     %u, %.1f MB\n", tracks.uploads() - uploads, ( end.buffer_bytes - start.buffer_bytes ) / ( 1024.0 * 1024.0 ) );
+
+  if ( end.draw_calls == start.draw_calls )
+  {
+    printf( "FAIL: nothing has been drawn, check --shaders\n" );
+    result = 1;
+  }
+
+  if ( ( options.max_p99 > 0.0 ) && ( p99 > options.max_p99 ) )
+  {
+    printf( "FAIL: p99 %.3f ms exceeds %.3f ms\n", p99, options.max_p99 );
+    result = 1;
+  }
+
+  tracks.dispose();
+
+  return result;
+}
@@ -0,0 +1,408 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Headless benchmark and check of the vector tile path.
+ *
+ * Every fixture is built first and its triangles are checked against the polygons of
+ * the MVT: the area covered by the fill triangles of a tile must match the signed
+ * area of its rings, holes included. Then the render loop replays a pan/zoom trace
+ * against a null GL driver, tiles being served from the fixtures directory, and
+ * fails if any tile geometry is built more than once.
+ */
+
+#include "bench_stats.h"
+#include "bench_trace.h"
+#include "bench_view.h"
+#include "null_gl.h"
+
+#include "map_view.h"
+#include "mvt_reader.h"
+#include "vector_tile_context.h"
+#include "vector_tile_level.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using bench_clock_t = std::chrono::steady_clock;
+
+  struct options_t
+  {
+    ure::uint_t   frames      = 600;
+    ure::uint_t   warmup      = 60;
+    ure::int_t    level       = 0;
+    ure::Size     size        = { 1024, 768 };
+    std::string   trace;
+    std::string   fixtures    = "bench/fixtures/mvt";
+    std::string   shaders     = "./resources/shaders/";
+    ure::double_t max_p99     = 0.0;     /* Milliseconds, 0 to disable */
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s [options]\n"
+            "  --frames N        measured frames (600)\n"
+            "  --warmup N        frames run before measuring (60)\n"
+            "  --level N         initial zoom level (0)\n"
+            "  --width N         viewport width (1024)\n"
+            "  --height N        viewport height (768)\n"
+            "  --trace FILE      pan/zoom trace, a built-in one by default\n"
+            "  --fixtures DIR    read tiles from DIR/z/x/y.mvt (bench/fixtures/mvt)\n"
+            "  --shaders DIR     shaders location (./resources/shaders/)\n"
+            "  --max-p99 MS      fail if p99 frame time exceeds MS\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string_view arg( argv[i] );
+
+      if ( i + 1 >= argc )
+        return false;
+
+      const char* value = argv[++i];
+
+      if      ( arg == "--frames"     ) options.frames     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--warmup"     ) options.warmup     = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--level"      ) options.level      = static_cast<ure::int_t>( std::strtol( value, nullptr, 10 ) );
+      else if ( arg == "--width"      ) options.size.width = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--height"     ) options.size.height= static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--trace"      ) options.trace      = value;
+      else if ( arg == "--fixtures"   ) options.fixtures   = value;
+      else if ( arg == "--shaders"    ) options.shaders    = value;
+      else if ( arg == "--max-p99"    ) options.max_p99    = std::strtod( value, nullptr );
+      else
+        return false;
+    }
+
+    return ( options.frames > 0 ) && ( options.size.width > 0 ) && ( options.size.height > 0 );
+  }
+
+  /**
+   * MVT payloads read from DIR/z/x/y.mvt, counting how many times each tile is served.
+   */
+  class FixtureSource
+  {
+  public:
+    explicit FixtureSource( const std::filesystem::path& directory ) noexcept(true)
+      : m_directory( directory )
+    {}
+
+    /** Signature matches TileScheduler::fetcher_t */
+    ure::void_t   fetch( ure::ResourcesFetcherEvents& events, const std::string& name, [[maybe_unused]] const std::string& url ) noexcept(true)
+    {
+      std::optional<TileKey> key = TileKey::parse( name );
+
+      const std::vector<ure::byte_t>* mvt = key.has_value() ? get( key.value() ) : nullptr;
+
+      if ( mvt == nullptr )
+      {
+        events.on_download_failed( name );
+        return;
+      }
+
+      ++m_served[ key.value() ];
+
+      events.on_download_succeeded( name, typeid(std::vector<ure::byte_t>), mvt->data(), static_cast<ure::uint_t>( mvt->size() ) );
+    }
+
+    /** Payload of @p key, nullptr if there is no such fixture */
+    const std::vector<ure::byte_t>*  get( const TileKey& key ) noexcept(true)
+    {
+      auto it = m_tiles.find( key );
+
+      if ( it == m_tiles.end() )
+      {
+        std::vector<ure::byte_t> mvt;
+
+        std::ifstream file( m_directory / std::to_string( key.z ) / std::to_string( key.x ) / ( std::to_string( key.y ) + ".mvt" ), std::ios::binary );
+        if ( file )
+          mvt.assign( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+
+        it = m_tiles.emplace( key, std::move(mvt) ).first;
+      }
+
+      return it->second.empty() ? nullptr : &it->second;
+    }
+
+    /** Tiles served more than once */
+    ure::uint_t   duplicates() const noexcept(true)
+    {
+      return static_cast<ure::uint_t>( std::count_if( m_served.begin(), m_served.end(), []( const auto& entry ) { return entry.second > 1; } ) );
+    }
+
+    /***/
+    std::size_t   served() const noexcept(true)
+    { return m_served.size(); }
+
+  private:
+    const std::filesystem::path                             m_directory;
+    std::unordered_map<TileKey, std::vector<ure::byte_t>>   m_tiles;     /* Payloads, empty if missing */
+    std::unordered_map<TileKey, ure::uint_t>                m_served;
+  };
+
+  /**
+   * Expected area of the polygons of fill layers, in tile units.
+   */
+  class AreaCheck : public MvtReader::Handler
+  {
+  public:
+    explicit AreaCheck( const VectorStyle& style ) noexcept(true)
+      : m_style( style ), m_scale( 1.0f ), m_fill( false ), m_area( 0.0 )
+    {}
+
+    /***/
+    ure::double_t  area() const noexcept
+    { return m_area; }
+
+  private:
+    virtual ure::bool_t  on_layer( std::string_view name, ure::uint_t extent ) noexcept(true) override
+    {
+      m_scale = 1.0f / static_cast<ure::float_t>( extent );
+      m_fill  = std::any_of( m_style.rules.begin(), m_style.rules.end(), [name]( const VectorStyle::rule_t& rule ) { return ( rule.layer == name ) && ( rule.width <= 0.0f ); } );
+
+      return m_fill;
+    }
+
+    virtual ure::void_t  on_feature( const MvtReader::feature_t& feature ) noexcept(true) override
+    {
+      if ( feature.type != MvtReader::geometry_t::polygon )
+        return;
+
+      // Exterior rings have a positive area, holes a negative one
+      for ( std::size_t i = 0; i < feature.parts.size(); ++i )
+        m_area += VectorTessellator::area( feature.points.data() + feature.parts[i], feature.part_size( i ) ) * m_scale * m_scale;
+    }
+
+  private:
+    const VectorStyle&  m_style;
+    ure::float_t        m_scale;
+    ure::bool_t         m_fill;
+    ure::double_t       m_area;
+  };
+
+  /** Area covered by the triangles of @p tile */
+  ure::double_t  triangles_area( const VectorTile& tile ) noexcept
+  {
+    ure::double_t area = 0.0;
+
+    for ( std::size_t i = 0; i + 2 < tile.vertices.size(); i += 3 )
+      area += VectorTessellator::area( tile.vertices.data() + i, 3 );
+
+    return area;
+  }
+
+  /**
+   * Build every fixture, check fill triangles and report the build cost.
+   * Return the number of tiles that failed.
+   */
+  ure::uint_t  check_fixtures( const std::filesystem::path& directory, ure::uint_t tile_pixels ) noexcept(true)
+  {
+    // Fill rules only and no background, every triangle belongs to a polygon
+    VectorStyle fills = VectorStyle::basic();
+
+    fills.background = glm::vec4( 0.0f );
+    fills.rules.erase( std::remove_if( fills.rules.begin(), fills.rules.end(), []( const VectorStyle::rule_t& rule ) { return rule.width > 0.0f; } ), fills.rules.end() );
+
+    const VectorStyle  style = VectorStyle::basic();
+    VectorTileBuilder  check( fills, tile_pixels );
+    VectorTileBuilder  builder( style, tile_pixels );
+    VectorTile         tile;
+    ure::uint_t        tiles    = 0;
+    ure::uint_t        failed   = 0;
+    std::size_t        vertices = 0;
+    std::size_t        bytes    = 0;
+    ure::double_t      build_ms = 0.0;
+
+    std::error_code ec;
+
+    for ( const auto& entry : std::filesystem::recursive_directory_iterator( directory, ec ) )
+    {
+      if ( entry.path().extension() != ".mvt" )
+        continue;
+
+      std::ifstream                   file( entry.path(), std::ios::binary );
+      const std::vector<ure::byte_t>  mvt( ( std::istreambuf_iterator<char>(file) ), std::istreambuf_iterator<char>() );
+
+      ++tiles;
+
+      AreaCheck expected( fills );
+      MvtReader reader;
+
+      const ure::bool_t parsed = reader.parse( mvt.data(), mvt.size(), expected );
+      const ure::bool_t built  = check.build( mvt.data(), mvt.size(), tile );
+      const ure::double_t area = triangles_area( tile );
+
+      if ( ( parsed == false ) || ( built == false ) || ( check.failures() > 0 ) || ( std::fabs( area - expected.area() ) > 1e-4 + 1e-3 * std::fabs( expected.area() ) ) )
+      {
+        printf( "FAIL: %s area %.6f expected %.6f, %u polygons failed\n", entry.path().string().c_str(), area, expected.area(), check.failures() );
+        ++failed;
+        continue;
+      }
+
+      const bench_clock_t::time_point begin = bench_clock_t::now();
+
+      builder.build( mvt.data(), mvt.size(), tile );
+
+      build_ms += std::chrono::duration<ure::double_t, std::milli>( bench_clock_t::now() - begin ).count();
+      vertices += tile.vertices.size();
+      bytes    += tile.bytes();
+    }
+
+    if ( tiles == 0 )
+    {
+      printf( "FAIL: no fixture in [%s]\n", directory.string().c_str() );
+      return 1;
+    }
+
+    printf( "fixtures          %u tiles, %u failed\n", tiles, failed );
+    printf( "build ms/tile     %.3f\n", build_ms / tiles );
+    printf( "vertices/tile     %.0f (%.1f KB)\n", static_cast<ure::double_t>( vertices ) / tiles, static_cast<ure::double_t>( bytes ) / tiles / 1024.0 );
+
+    return failed;
+  }
+}
+
+int main( int argc, char** argv )
+{
+  options_t   options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  BenchTrace  trace;
+
+  if ( options.trace.empty() ? ( trace.parse( BenchTrace::default_trace() ) == false ) : ( trace.load( options.trace ) == false ) )
+  {
+    printf( "unable to load trace [%s]\n", options.trace.c_str() );
+    return 2;
+  }
+
+  const ure::uint_t  tile_pixels = 256;
+
+  int result = ( check_fixtures( options.fixtures, tile_pixels ) == 0 ) ? 0 : 1;
+
+  // Deepest fixture level bounds the zoom, tiles below it would all fail
+  ure::int_t max_levels = 1;
+
+  for ( ure::int_t z = 1; std::filesystem::is_directory( std::filesystem::path( options.fixtures ) / std::to_string( z ) ); ++z )
+    max_levels = z + 1;
+
+  null_gl::install();
+
+  RedrawSignal       redraw;
+  VectorTileContext  tiles( tile_pixels, 64u << 20, redraw );
+  FixtureSource      source( options.fixtures );
+
+  // No disk cache, every tile comes from the fixtures
+  tiles.initialize( options.shaders, std::string() );
+  tiles.scheduler().set_fetcher( [&source]( ure::ResourcesFetcherEvents& events, const std::string& name, const std::string& url ) {
+    source.fetch( events, name, url );
+  } );
+
+  std::vector<ure::double_t>  frame_ms;
+  null_gl::counters_t         start{};
+
+  {
+    // Per-frame steps of Map in vector mode, without window and scene graph
+    VectorTileLevel               level( tiles, static_cast<ure::word_t>( std::clamp( options.level, 0, max_levels - 1 ) ), "http://localhost/{z}/{x}/{y}.mvt" );
+    BenchView<VectorTileLevel>    view( options.size, options.level, max_levels, level );
+    BenchReplay                   replay( trace, options.warmup, options.frames );
+
+    while ( replay.next() )
+    {
+      if ( replay.starting() )
+        start = null_gl::counters();
+
+      replay.begin();
+
+      tiles.cache().begin_frame();
+      tiles.scheduler().begin_frame( static_cast<ure::uint_t>( view.view().levels().current ) );
+
+      view.input( replay.event(), replay.now() );
+
+      tiles.decoder().upload( 8, std::chrono::microseconds(4000) );
+
+      view.draw();
+
+      tiles.scheduler().dispatch();
+
+      replay.end();
+
+      // Tiles are built on worker threads, wait for them so that uploads do not depend on timing
+      while ( tiles.decoder().pending() != tiles.decoder().ready() )
+        std::this_thread::yield();
+    }
+
+    frame_ms = replay.frame_ms();
+  }
+
+  const null_gl::counters_t       end    = null_gl::counters();
+  const VectorTileCache::stats_t  cache  = tiles.cache().stats();
+  const ure::double_t             frames = static_cast<ure::double_t>( frame_ms.size() );
+
+  std::vector<ure::double_t> sorted( frame_ms );
+  std::sort( sorted.begin(), sorted.end() );
+
+  const ure::double_t  p99 = percentile( sorted, 0.99 );
+
+  printf( "frames            %zu (warmup %u, trace %zu, levels 0-%d)\n", frame_ms.size(), options.warmup, trace.frames(), max_levels - 1 );
+  printf( "frame time ms     p50 %.3f  p99 %.3f  max %.3f\n", percentile( sorted, 0.50 ), p99, sorted.back() );
+  printf( "draw calls/frame  %.2f\n", ( end.draw_calls   - start.draw_calls   ) / frames );
+  printf( "vertex KB/frame   %.2f\n", ( end.buffer_bytes - start.buffer_bytes ) / frames / 1024.0 );
+  printf( "tiles built       %zu, %zu resident (%.1f KB)\n", source.served(), cache.entries, cache.bytes / 1024.0 );
+
+  if ( end.draw_calls == 0 )
+  {
+    printf( "FAIL: nothing has been drawn, check --shaders\n" );
+    result = 1;
+  }
+
+  if ( source.duplicates() > 0 )
+  {
+    printf( "FAIL: %u tiles have been built more than once\n", source.duplicates() );
+    result = 1;
+  }
+
+  if ( ( options.max_p99 > 0.0 ) && ( p99 > options.max_p99 ) )
+  {
+    printf( "FAIL: p99 %.3f ms exceeds %.3f ms\n", p99, options.max_p99 );
+    result = 1;
+  }
+
+  tiles.dispose();
+
+  return result;
+}
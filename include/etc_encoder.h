@@ -0,0 +1,64 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef ETC_ENCODER_H
+#define ETC_ENCODER_H
+
+#include <ure_utils.h>
+
+#include <cstddef>
+
+/**
+ * Encoder of ETC1 RGB blocks, 4x4 pixels in 8 bytes.
+ *
+ * Only the individual and differential modes are produced, which are also valid
+ * ETC2 RGB8 blocks, so the output can be uploaded as GL_COMPRESSED_RGB8_ETC2.
+ * Both block orientations and all modifier tables are tried, base colours are the
+ * sub-block averages: fast enough for the decode workers, with a quality close to
+ * the "fast" preset of offline encoders on map tiles.
+ */
+class EtcEncoder
+{
+public:
+  /** Bytes of an encoded 4x4 block */
+  static constexpr std::size_t  block_bytes = 8;
+
+  /**
+   * Bytes needed for an image of @p width x @p height pixels, both multiple of 4.
+   */
+  static constexpr std::size_t  size( ure::uint_t width, ure::uint_t height ) noexcept
+  { return std::size_t( width / 4 ) * ( height / 4 ) * block_bytes; }
+
+  /**
+   * Encode tightly packed RGBA8 pixels, top row first, alpha is ignored.
+   * Blocks are written in rows, left to right, as expected by glCompressedTexImage2D.
+   * Return false if the size is not a multiple of 4.
+   */
+  static ure::bool_t  encode_rgb8( const ure::byte_t* rgba, ure::uint_t width, ure::uint_t height, ure::byte_t* blocks ) noexcept(true);
+
+  /**
+   * Decode blocks written by encode_rgb8() back to RGBA8 with opaque alpha, e.g. to
+   * rebuild a parent tile from compressed children. Return false if the size is not
+   * a multiple of 4.
+   */
+  static ure::bool_t  decode_rgb8( const ure::byte_t* blocks, ure::uint_t width, ure::uint_t height, ure::byte_t* rgba ) noexcept(true);
+
+  /**
+   * Encode a single block from 16 RGBA8 pixels in rows.
+   */
+  static ure::void_t  encode_block( const ure::byte_t (&pixels)[16][4], ure::byte_t* block ) noexcept(true);
+};
+
+#endif // ETC_ENCODER_H
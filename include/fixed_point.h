@@ -0,0 +1,47 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <ure_utils.h>
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Normalized world coordinates, [0,1], as 32 bit fixed point.
+ *
+ * Used by MarkerIndex and HeatmapGrid to store positions in half the space of doubles
+ * and to compare or bin them with integer SIMD; a unit is about 9 mm at the equator.
+ */
+class FixedPoint
+{
+public:
+  /** Fixed point value of 1.0 */
+  static constexpr ure::double_t  scale = 4294967296.0;
+
+  /**
+   * Clamp @p value to [0,1] and convert it, 1.0 maps to the largest value.
+   */
+  static constexpr std::uint32_t  from_normalized( ure::double_t value ) noexcept
+  {
+    const ure::double_t fixed = std::clamp( value, 0.0, 1.0 ) * scale;
+
+    return ( fixed >= scale - 1.0 ) ? 0xFFFFFFFFu : static_cast<std::uint32_t>( fixed );
+  }
+};
+
+#endif // FIXED_POINT_H
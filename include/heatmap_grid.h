@@ -0,0 +1,144 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef HEATMAP_GRID_H
+#define HEATMAP_GRID_H
+
+#include <ure_utils.h>
+
+#include "marker_index.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Density of points binned in square cells of a zoom level, blurred and coloured as
+ * RGBA pixels, one per cell.
+ *
+ * Points are kept as 32 bit fixed point positions so that the cell of a point is a
+ * subtraction and a shift, computed four points at a time with SSE2 or NEON. The grid
+ * covers a window of the level; moving it bins every point again, while points added
+ * later only touch their cells. Only rows whose counts changed are blurred and coloured
+ * again, then reported as a band to upload.
+ */
+class HeatmapGrid
+{
+public:
+  /** Normalized Web Mercator position, as markers */
+  using point_t = MarkerIndex::point_t;
+
+  /**
+   * Tiles are @p tile_pixels wide, a power of two.
+   */
+  explicit HeatmapGrid( ure::uint_t tile_pixels ) noexcept(true);
+
+  /**
+   * Cell size in pixels, rounded down to a power of two, and blur radius in cells.
+   * The grid must be reset afterwards.
+   */
+  ure::void_t         set_style( ure::uint_t cell_pixels, ure::uint_t radius ) noexcept(true);
+  /***/
+  ure::uint_t         cell_pixels() const noexcept
+  { return 1u << m_cell_shift; }
+
+  /**
+   * Append @p points, those inside the grid are binned at once.
+   */
+  ure::void_t         add( const std::vector<point_t>& points ) noexcept(true);
+  /** Points added so far */
+  std::size_t         size() const noexcept
+  { return m_x.size(); }
+
+  /**
+   * Cover the cells of @p level from @p cell_x, @p cell_y on, @p width by @p height of
+   * them, clamped to the world, and bin every point again.
+   */
+  ure::void_t         reset( ure::uint_t level, std::int64_t cell_x, std::int64_t cell_y, ure::uint_t width, ure::uint_t height ) noexcept(true);
+
+  /***/
+  ure::uint_t         level() const noexcept
+  { return m_level; }
+  /** First cell covered by the grid */
+  std::int64_t        cell_x() const noexcept
+  { return m_cell_x; }
+  /***/
+  std::int64_t        cell_y() const noexcept
+  { return m_cell_y; }
+  /** Cells covered horizontally, 0 before the first reset() */
+  ure::uint_t         width() const noexcept
+  { return m_width; }
+  /***/
+  ure::uint_t         height() const noexcept
+  { return m_height; }
+
+  /** Points in each cell, row by row */
+  const std::vector<std::uint32_t>&  counts() const noexcept
+  { return m_counts; }
+  /** Counts blurred in both directions, valid for rows reported by update() */
+  const std::vector<ure::float_t>&   density() const noexcept
+  { return m_density; }
+  /** Colour of each cell, RGBA row by row, valid for rows reported by update() */
+  const std::vector<ure::byte_t>&    pixels() const noexcept
+  { return m_pixels; }
+
+  /**
+   * Blur and colour the rows changed since the last call. Return false if there are
+   * none, otherwise @p first and @p count receive the rows of pixels() that changed.
+   */
+  ure::bool_t         update( ure::uint_t& first, ure::uint_t& count ) noexcept(true);
+
+  /**
+   * Increment in @p cells the cell of each of the @p count points @p x, @p y, in a grid
+   * of @p width by @p height cells of 2^@p shift fixed point units starting at @p x0,
+   * @p y0. Points outside are skipped. @p rows receives the first and last rows changed.
+   */
+  static ure::void_t  bin( const std::uint32_t* x, const std::uint32_t* y, std::size_t count,
+                           std::uint32_t x0, std::uint32_t y0, ure::uint_t shift, ure::uint_t width, ure::uint_t height,
+                           std::uint32_t* cells, ure::uint_t (&rows)[2] ) noexcept(true);
+
+private:
+  /** Fixed point units per cell, as a power of two */
+  ure::uint_t         shift() const noexcept(true);
+  /** Add the changed rows @p rows to the dirty ones */
+  ure::void_t         touch( const ure::uint_t (&rows)[2] ) noexcept(true);
+  /** Colour rows [@p first, @p last) with m_scale */
+  ure::void_t         colour( ure::uint_t first, ure::uint_t last ) noexcept(true);
+
+  /** Widest grid, the smallest texture size GLES 3 guarantees */
+  static constexpr ure::uint_t  max_size()
+  { return 2048; }
+
+private:
+  const ure::uint_t           m_tile_shift;     /* log2 of the tile width */
+  ure::uint_t                 m_cell_shift;     /* log2 of the cell size in pixels */
+  ure::uint_t                 m_radius;         /* Blur radius in cells */
+  std::vector<ure::float_t>   m_kernel;         /* 2 * m_radius + 1 weights */
+  std::vector<std::uint32_t>  m_x;              /* Fixed point positions of every point */
+  std::vector<std::uint32_t>  m_y;
+  ure::uint_t                 m_level;
+  std::int64_t                m_cell_x;
+  std::int64_t                m_cell_y;
+  ure::uint_t                 m_width;
+  ure::uint_t                 m_height;
+  std::vector<std::uint32_t>  m_counts;
+  std::vector<ure::float_t>   m_rows;           /* Counts blurred horizontally */
+  std::vector<ure::float_t>   m_density;        /* Counts blurred in both directions */
+  std::vector<ure::float_t>   m_line;           /* A row of counts with m_radius zeros on both sides */
+  std::vector<ure::byte_t>    m_pixels;
+  ure::float_t                m_scale;          /* Density drawn with the last colour of the ramp */
+  ure::uint_t                 m_dirty[2];       /* First and last rows changed, first > last when none */
+};
+
+#endif // HEATMAP_GRID_H
@@ -0,0 +1,94 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef HEATMAP_RENDERER_H
+#define HEATMAP_RENDERER_H
+
+#include <ure_utils.h>
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+/**
+ * Draw an RGBA image as a single textured quad with the DefaultTexture shaders.
+ *
+ * The texture is allocated when the image size changes, otherwise only the rows
+ * that changed are uploaded. All methods must be called from the thread owning the
+ * GL context.
+ */
+class HeatmapRenderer
+{
+public:
+  /***/
+  HeatmapRenderer() noexcept(true);
+  /***/
+  ~HeatmapRenderer() noexcept(true);
+
+  /**
+   * Directory containing DefaultTexture.vs/.fs, program is built on first upload().
+   */
+  ure::void_t   set_shaders_path( const std::string& path ) noexcept(true);
+
+  /**
+   * Upload rows [@p first, @p first + @p count) of the @p width by @p height RGBA
+   * @p pixels, all of them if the size changed. Return false if the program is not available.
+   */
+  ure::bool_t   upload( const ure::byte_t* pixels, ure::uint_t width, ure::uint_t height, ure::uint_t first, ure::uint_t count ) noexcept(true);
+  /**
+   * Stretch the texture over the rectangle from @p min to @p max, in the coordinates
+   * of @p mvp. Return the number of draw calls.
+   */
+  ure::uint_t   draw( const glm::mat4& mvp, const glm::vec2& min, const glm::vec2& max ) noexcept(true);
+
+  /** Bytes uploaded so far */
+  std::uint64_t uploaded() const noexcept
+  { return m_uploaded; }
+
+  /**
+   * Delete program, texture and buffer, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /***/
+  struct vertex_t
+  {
+    ure::float_t  x, y;
+    ure::float_t  u, v;
+  };
+
+  /***/
+  ure::bool_t   init() noexcept(true);
+  /***/
+  GLuint        compile( GLenum type, const std::string& file ) noexcept(true);
+
+private:
+  std::string               m_shaders_path;
+  ure::bool_t               m_failed;          /* Do not try again to build a broken program */
+  GLuint                    m_program;
+  GLint                     m_a_point;
+  GLint                     m_a_texcoord;
+  GLint                     m_u_mvp;
+  GLint                     m_u_texture;
+  GLuint                    m_texture;
+  GLuint                    m_vbo;
+  ure::uint_t               m_width;           /* Size of m_texture, 0 when not allocated */
+  ure::uint_t               m_height;
+  std::uint64_t             m_uploaded;
+};
+
+#endif // HEATMAP_RENDERER_H
@@ -0,0 +1,118 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef HEATMAP_SET_H
+#define HEATMAP_SET_H
+
+#include <ure_size.h>
+
+#include "heatmap_grid.h"
+#include "heatmap_renderer.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Density of points drawn over the tiles of a zoom level, with the same model matrix.
+ *
+ * Points are binned in a grid of cells at the current level covering the view and
+ * a margin around it, uploaded as a single texture. Panning within the margin only
+ * changes the model matrix, new points update and upload the rows they touch; moving
+ * out of it, or changing level, bins every point again.
+ */
+class HeatmapSet
+{
+public:
+  /** Normalized Web Mercator position */
+  using point_t = HeatmapGrid::point_t;
+
+  /***/
+  explicit HeatmapSet( ure::uint_t tile_pixels ) noexcept(true);
+
+  /**
+   * Directory containing DefaultTexture.vs/.fs.
+   */
+  ure::void_t       set_shaders_path( const std::string& path ) noexcept(true)
+  { m_renderer.set_shaders_path( path ); }
+
+  /**
+   * Cell size in pixels, a power of two, and blur radius in cells.
+   */
+  ure::void_t       set_style( ure::uint_t cell_pixels, ure::uint_t radius ) noexcept(true);
+
+  /**
+   * Add @p points, only the cells they fall in are drawn again.
+   */
+  ure::void_t       add_points( const std::vector<point_t>& points ) noexcept(true)
+  { m_grid.add( points ); }
+  /** Points added so far */
+  std::size_t       size() const noexcept
+  { return m_grid.size(); }
+
+  /***/
+  ure::void_t       set_zoom( ure::word_t zoom ) noexcept(true);
+  /***/
+  constexpr ure::word_t zoom() const noexcept
+  { return m_zoom; }
+  /**
+   * Position of tile (0,0), as for the tile levels.
+   */
+  ure::void_t       set_origin( const glm::vec2& origin ) noexcept(true);
+  /**
+   * Model matrix of the level, mapping its pixels to clip space, and frame buffer size.
+   */
+  ure::void_t       set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true);
+
+  /**
+   * Bin points again if the view moved out of the grid, upload the rows that changed
+   * and draw the texture. Return the number of draw calls.
+   */
+  ure::uint_t       draw() noexcept(true);
+
+  /***/
+  const HeatmapGrid&  grid() const noexcept
+  { return m_grid; }
+  /** Times every point has been binned again */
+  std::uint64_t     resets() const noexcept
+  { return m_resets; }
+  /** Bytes of texture uploaded so far */
+  std::uint64_t     uploaded() const noexcept
+  { return m_renderer.uploaded(); }
+
+  /**
+   * Release GL resources, must be called while the GL context is still valid.
+   */
+  ure::void_t       dispose() noexcept(true)
+  { m_renderer.dispose(); }
+
+private:
+  /** Cells of the current level in view, false if there are none */
+  ure::bool_t       view_cells( std::int64_t& x0, std::int64_t& y0, std::int64_t& x1, std::int64_t& y1 ) const noexcept(true);
+
+private:
+  const ure::uint_t         m_tile_pixels;
+  HeatmapGrid               m_grid;
+  HeatmapRenderer           m_renderer;
+  ure::word_t               m_zoom;
+  glm::vec2                 m_origin;
+  glm::mat4                 m_model;
+  ure::Size                 m_fb_size;
+  ure::bool_t               m_stale;            /* Style changed since the last reset */
+  std::uint64_t             m_resets;
+};
+
+#endif // HEATMAP_SET_H
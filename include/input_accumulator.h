@@ -0,0 +1,104 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef INPUT_ACCUMULATOR_H
+#define INPUT_ACCUMULATOR_H
+
+#include <ure_utils.h>
+
+#include <chrono>
+
+#include <glm/glm.hpp>
+
+/**
+ * Pan and scroll input summed between frames, applied once per frame.
+ *
+ * Event handlers only add to the pending totals, so their cost does not depend on the
+ * device polling rate; the frame takes the totals and moves the view once. Releasing a
+ * drag keeps the map moving with the drag velocity, decaying exponentially: momentum is
+ * added to the same pan total, it continues the drag rather than animating on its own.
+ */
+class InputAccumulator
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * Input to apply in a frame.
+   */
+  struct frame_t
+  {
+    glm::vec2     pan;        /* Pixels, drag and momentum */
+    ure::float_t  notches;    /* Wheel steps, 0 if there was no scroll */
+    glm::vec2     anchor;     /* Cursor at the last scroll, relative to the window centre */
+  };
+
+  /**
+   * @param tau        time constant, in seconds, of the momentum decay.
+   * @param min_speed  momentum stops below this speed, in pixels per second.
+   */
+  InputAccumulator( ure::float_t tau = 0.325f, ure::float_t min_speed = 20.0f ) noexcept(true);
+
+  /**
+   * Drag started at @p now, stops the momentum of the previous one.
+   */
+  ure::void_t     grab( clock_t::time_point now = clock_t::now() ) noexcept(true);
+  /**
+   * Drag moved by @p delta pixels at @p now.
+   */
+  ure::void_t     pan( const glm::vec2& delta, clock_t::time_point now = clock_t::now() ) noexcept(true);
+  /**
+   * Wheel moved by @p notches steps with the cursor at @p anchor, relative to the window centre.
+   */
+  ure::void_t     scroll( ure::float_t notches, const glm::vec2& anchor ) noexcept(true);
+  /**
+   * Drag ended at @p now, the map keeps moving unless the cursor was standing still.
+   */
+  ure::void_t     release( clock_t::time_point now = clock_t::now() ) noexcept(true);
+
+  /**
+   * Move input summed since the last call, plus momentum up to @p now, in @p frame.
+   * Return false if there is nothing to apply.
+   */
+  ure::bool_t     take( clock_t::time_point now, frame_t& frame ) noexcept(true);
+
+  /** Momentum still moving the map, frames must keep coming until it stops */
+  ure::bool_t     coasting() const noexcept
+  { return ( m_dragging == false ) && ( ( m_velocity.x != 0.0f ) || ( m_velocity.y != 0.0f ) ); }
+  /** Pixels per second, of the drag or of the momentum */
+  const glm::vec2& velocity() const noexcept
+  { return m_velocity; }
+
+private:
+  /**
+   * Fold the drag moved since the last sample into the velocity.
+   */
+  ure::void_t     sample( clock_t::time_point now ) noexcept(true);
+
+private:
+  const ure::float_t      m_tau;
+  const ure::float_t      m_min_speed;
+  glm::vec2               m_pan;          /* Pending drag */
+  glm::vec2               m_sampled;      /* Part of m_pan already folded into the velocity */
+  ure::float_t            m_notches;      /* Pending scroll */
+  glm::vec2               m_anchor;
+  glm::vec2               m_velocity;     /* Drag velocity while dragging, momentum after */
+  ure::bool_t             m_dragging;
+  clock_t::time_point     m_moved_at;     /* Last drag event */
+  clock_t::time_point     m_sampled_at;   /* Last velocity sample while dragging */
+  clock_t::time_point     m_time;         /* Last momentum step */
+};
+
+#endif // INPUT_ACCUMULATOR_H
@@ -0,0 +1,151 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Bounded multi-producer multi-consumer queue, Dmitry Vyukov's array based algorithm.
+ *
+ * Every slot carries a sequence number telling producers and consumers whether
+ * the slot is free or filled for the current lap, so push and pop only need one
+ * compare-and-swap on their own cursor and never block each other.
+ * Capacity is rounded up to the next power of two.
+ */
+template<typename data_t>
+class LockFreeQueue
+{
+public:
+  /***/
+  explicit LockFreeQueue( std::size_t capacity )
+    : m_mask( std::bit_ceil( capacity < 2 ? std::size_t(2) : capacity ) - 1 ),
+      m_cells( std::make_unique<cell_t[]>( m_mask + 1 ) ),
+      m_enqueue(0), m_dequeue(0)
+  {
+    for ( std::size_t i = 0; i <= m_mask; ++i )
+      m_cells[i].sequence.store( i, std::memory_order_relaxed );
+  }
+
+  LockFreeQueue( const LockFreeQueue& ) = delete;
+  LockFreeQueue& operator=( const LockFreeQueue& ) = delete;
+
+  /**
+   * Return false if the queue is full, @p value is left untouched in that case.
+   */
+  bool  try_push( data_t&& value ) noexcept
+  {
+    cell_t*     cell = nullptr;
+    std::size_t pos  = m_enqueue.load( std::memory_order_relaxed );
+
+    for (;;)
+    {
+      cell = &m_cells[pos & m_mask];
+
+      const std::size_t    seq  = cell->sequence.load( std::memory_order_acquire );
+      const std::intptr_t  diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+      if ( diff == 0 )
+      {
+        if ( m_enqueue.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+          break;
+      }
+      else if ( diff < 0 )
+      {
+        return false;
+      }
+      else
+      {
+        pos = m_enqueue.load( std::memory_order_relaxed );
+      }
+    }
+
+    cell->data = std::move(value);
+    cell->sequence.store( pos + 1, std::memory_order_release );
+
+    return true;
+  }
+
+  /**
+   * Return false if the queue is empty.
+   */
+  bool  try_pop( data_t& value ) noexcept
+  {
+    cell_t*     cell = nullptr;
+    std::size_t pos  = m_dequeue.load( std::memory_order_relaxed );
+
+    for (;;)
+    {
+      cell = &m_cells[pos & m_mask];
+
+      const std::size_t    seq  = cell->sequence.load( std::memory_order_acquire );
+      const std::intptr_t  diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+
+      if ( diff == 0 )
+      {
+        if ( m_dequeue.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+          break;
+      }
+      else if ( diff < 0 )
+      {
+        return false;
+      }
+      else
+      {
+        pos = m_dequeue.load( std::memory_order_relaxed );
+      }
+    }
+
+    value = std::move(cell->data);
+    cell->sequence.store( pos + m_mask + 1, std::memory_order_release );
+
+    return true;
+  }
+
+  /**
+   * Approximated number of items, exact only when no other thread is using the queue.
+   */
+  std::size_t  size() const noexcept
+  {
+    const std::size_t head = m_dequeue.load( std::memory_order_relaxed );
+    const std::size_t tail = m_enqueue.load( std::memory_order_relaxed );
+
+    return ( tail > head ) ? tail - head : 0;
+  }
+
+  /***/
+  constexpr std::size_t  capacity() const noexcept
+  { return m_mask + 1; }
+
+private:
+  struct cell_t
+  {
+    std::atomic<std::size_t>  sequence;
+    data_t                    data;
+  };
+
+  /* Cursors on separate cache lines, producers and consumers do not share them */
+  const std::size_t                      m_mask;
+  std::unique_ptr<cell_t[]>              m_cells;
+  alignas(64) std::atomic<std::size_t>   m_enqueue;
+  alignas(64) std::atomic<std::size_t>   m_dequeue;
+};
+
+#endif // LOCKFREE_QUEUE_H
@@ -0,0 +1,257 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <ure_utils.h>
+
+#include "tile_key.h"
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Tiles kept in LRU order and bounded by a budget in bytes, the policy shared by
+ * TileCache and VectorTileCache.
+ *
+ * Every find() moves the entry in front and stamps it with the current frame. When the
+ * budget is exceeded the least recently used entries are released, skipping the ones
+ * used during the current frame so that a tile still inside a visible range is never
+ * dropped; in that case the cache temporarily grows over the budget.
+ * @p release_t is called with the payload of every entry leaving the cache, the
+ * destructor does not call it, see clear().
+ *
+ * Lookups are thread safe. Pointers returned by find() stay valid until insert(),
+ * evict_level(), begin_frame(), set_budget() or clear() runs, these are meant to be
+ * called by the thread drawing the tiles.
+ */
+template<typename value_t, typename release_t>
+class LruCache
+{
+public:
+  struct stats_t
+  {
+    std::uint64_t   hits;
+    std::uint64_t   misses;
+    std::uint64_t   evictions;
+    std::size_t     entries;
+    std::size_t     bytes;
+  };
+
+  /***/
+  LruCache( std::size_t budget, release_t release ) noexcept
+    : m_release( std::move(release) ), m_budget(budget), m_bytes(0), m_frame(0), m_hits(0), m_misses(0), m_evictions(0)
+  {
+  }
+
+  LruCache( const LruCache& ) = delete;
+  LruCache& operator=( const LruCache& ) = delete;
+
+  /**
+   * Return the payload of @p key, or nullptr if not loaded.
+   * Hits mark the entry as in use for the current frame.
+   */
+  const value_t*  find( const TileKey& key ) noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_index.find( key );
+    if ( it == m_index.end() )
+    {
+      ++m_misses;
+      return nullptr;
+    }
+
+    ++m_hits;
+
+    return touch( it->second );
+  }
+
+  /**
+   * Same as find() but a miss is not counted, for fallback lookups that never fetch.
+   */
+  const value_t*  find_resident( const TileKey& key ) noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_index.find( key );
+    if ( it == m_index.end() )
+      return nullptr;
+
+    return touch( it->second );
+  }
+
+  /***/
+  ure::bool_t   contains( const TileKey& key ) const noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_index.contains( key );
+  }
+
+  /**
+   * Add @p value occupying @p bytes and evict entries over budget.
+   * Return false if @p key is already in the cache, @p value is left untouched in that case.
+   */
+  ure::bool_t   insert( const TileKey& key, value_t&& value, std::size_t bytes ) noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if ( m_index.contains( key ) )
+      return false;
+
+    m_lru.emplace_front( entry_t{ key, std::move(value), bytes, m_frame } );
+    m_index.emplace( key, m_lru.begin() );
+    m_bytes += bytes;
+
+    evict();
+
+    return true;
+  }
+
+  /**
+   * Release all entries of zoom level @p z, except the ones used in the current frame.
+   */
+  ure::void_t   evict_level( ure::uint_t z ) noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for ( auto it = m_lru.begin(); it != m_lru.end(); )
+    {
+      if ( ( it->key.z != z ) || ( it->frame == m_frame ) )
+        ++it;
+      else
+        it = release( it );
+    }
+  }
+
+  /**
+   * Start a new frame, entries used in previous frames become evictable.
+   */
+  ure::void_t   begin_frame() noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    ++m_frame;
+
+    // Entries kept over budget in the previous frame may be released now
+    evict();
+  }
+
+  /***/
+  std::size_t   budget() const noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_budget;
+  }
+  /***/
+  ure::void_t   set_budget( std::size_t budget ) noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_budget = budget;
+
+    evict();
+  }
+
+  /***/
+  stats_t       stats() const noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return stats_t{ m_hits, m_misses, m_evictions, m_index.size(), m_bytes };
+  }
+
+  /**
+   * Release every entry, whatever frame it has been used in. Not counted as evictions.
+   */
+  ure::void_t   clear() noexcept
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for ( entry_t& entry : m_lru )
+      m_release( entry.value );
+
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+  }
+
+private:
+  struct entry_t
+  {
+    TileKey         key;
+    value_t         value;
+    std::size_t     bytes;
+    std::uint64_t   frame;       /* Last frame the entry has been used */
+  };
+
+  using lru_t   = std::list<entry_t>;
+  using index_t = std::unordered_map<TileKey, typename lru_t::iterator>;
+
+  /***/
+  const value_t*  touch( typename lru_t::iterator entry ) noexcept
+  {
+    entry->frame = m_frame;
+    m_lru.splice( m_lru.begin(), m_lru, entry );
+
+    return &entry->value;
+  }
+
+  /***/
+  typename lru_t::iterator  release( typename lru_t::iterator entry ) noexcept
+  {
+    m_bytes -= entry->bytes;
+    m_release( entry->value );
+    m_index.erase( entry->key );
+
+    ++m_evictions;
+
+    return m_lru.erase( entry );
+  }
+
+  /***/
+  ure::void_t   evict() noexcept
+  {
+    while ( ( m_bytes > m_budget ) && ( m_lru.empty() == false ) )
+    {
+      // LRU order: if the tail has been used in this frame, every other entry has been too
+      if ( m_lru.back().frame == m_frame )
+        break;
+
+      release( std::prev( m_lru.end() ) );
+    }
+  }
+
+private:
+  release_t             m_release;
+  mutable std::mutex    m_mutex;
+  lru_t                 m_lru;        /* Most recently used in front */
+  index_t               m_index;
+  std::size_t           m_budget;
+  std::size_t           m_bytes;
+  std::uint64_t         m_frame;
+  std::uint64_t         m_hits;
+  std::uint64_t         m_misses;
+  std::uint64_t         m_evictions;
+};
+
+#endif // LRU_CACHE_H
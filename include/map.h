@@ -24,7 +24,22 @@
 #include <ure_view_port.h>
 #include <ure_position.h>
 #include <ure_size.h>
+#include <ure_scene_layer_node.h>
 
+#include "input_accumulator.h"
+#include "map_view.h"
+#include "marker_index.h"
+#include "metrics_overlay.h"
+#include "tile_context.h"
+#include "tile_prefetcher.h"
+#include "vector_tile_context.h"
+
+
+class HeatmapLayer;
+class MarkerLayer;
+class TileLayer;
+class TrackLayer;
+class VectorTileLayer;
 
 class Map : public ure::ApplicationEvents, public ure::WindowEvents, public ure::ResourcesFetcherEvents
 {
@@ -51,7 +66,54 @@ protected:
   /***/
   void add_camera() noexcept;
   /***/
-  void add_zoom_levels( const std::string& url ) noexcept;
+  void add_zoom_levels() noexcept;
+  /**
+   * Return the layer for zoom level @p zl, creating it on first use.
+   */
+  TileLayer* get_zoom_level( ure::int_t zl ) noexcept;
+  /**
+   * Create the layer drawing vector tiles, moved to the current level by update_view().
+   */
+  void add_vector_layer() noexcept;
+  /**
+   * Create the markers layer from m_markers_path, or m_random_markers generated markers.
+   */
+  void add_marker_layer() noexcept;
+  /**
+   * Create the tracks layer from m_tracks_path, or m_random_tracks generated tracks.
+   */
+  void add_track_layer() noexcept;
+  /**
+   * Create the heatmap layer from m_heatmap_path, or m_random_heatmap generated points.
+   */
+  void add_heatmap_layer() noexcept;
+  /**
+   * Add the points arrived since the last call, at m_heatmap_rate points per second.
+   */
+  void feed_heatmap( const RedrawSignal::clock_t::time_point& now ) noexcept;
+  /**
+   * Append @p count random points to @p points, clustered around a few places.
+   */
+  static void random_events( ure::uint_t count, std::uint64_t seed, std::vector<MarkerIndex::point_t>& points ) noexcept;
+  /**
+   * Tear down levels farther than m_levelsWindow from m_curLevel, releasing their tiles.
+   */
+  void trim_zoom_levels() noexcept;
+  /**
+   * Request tiles expected to become visible, after the visible ones have been requested.
+   */
+  void prefetch() noexcept;
+#if MAP_ENABLE_METRICS
+  /**
+   * Sample cache, downloads and decoder state for the current frame.
+   */
+  void update_metrics() noexcept;
+#endif
+  /**
+   * Select the levels drawn for the current zoom, blending two of them between
+   * integer zoom values, and push their model matrix and frame buffer size.
+   */
+  void update_view() noexcept;
 
 // ure::WindowEvents implementation
 protected:
@@ -104,14 +166,68 @@ private:
   ure::Size                 m_size;
   ure::Size                 m_fb_size;      /* Frame Buffer Size */
   ure::Size                 m_tile_size;
+  TileContext               m_tiles;        /* Tile atlas, caches and decoder for all zoom levels */
+  std::unique_ptr<VectorTileContext>
+                            m_vector;       /* Vector tiles infrastructure, only with a vector tiles URL */
+  const ure::uint_t         m_max_uploads;  /* Max textures created per frame */
+  const std::chrono::microseconds
+                            m_upload_budget;/* Max time spent creating textures per frame, raster and vector tiles together */
+  const std::size_t         m_upload_bytes; /* Max pixels bytes copied to the atlas per frame */
+  ure::bool_t               m_continuous;   /* Render every iteration, otherwise only when m_tiles.redraw() is raised */
+  const std::chrono::milliseconds
+                            m_idle_wait;    /* Max time blocked waiting for a redraw before polling input */
+  const std::chrono::milliseconds
+                            m_refresh_interval;/* Redraw period while visible tiles are missing */
+  RedrawSignal::clock_t::time_point
+                            m_refresh_at;
 
   ure::Window*              m_pWindow;
   ure::ViewPort*            m_pViewPort;
 
+  struct zoom_level_t
+  {
+    std::shared_ptr<TileLayer>  layer;
+    ure::SceneLayerNode*        node;       /* Owned by the scene graph */
+  };
+
   const ure::int_t          m_maxLevels;
-  ure::int_t                m_curLevel;
+  ure::int_t                m_curLevel;     /* Level closest to the zoom, used for downloads priority */
+  ure::int_t                m_drawLevel;    /* Level whose layer is visible, it draws the blended one */
+  MapView                   m_view;         /* Pan and continuous zoom */
+  const ure::int_t          m_levelsWindow; /* Levels kept around m_curLevel, farther ones are torn down */
+  std::vector<zoom_level_t> m_levels;       /* Indexed by zoom level, null layer until first use */
+  std::vector<zoom_level_t> m_spare_levels; /* Torn down levels, recycled by get_zoom_level() */
+  ure::uint_t               m_layer_nodes;  /* Scene nodes created so far */
+  std::string               m_vector_url;   /* Vector tiles URL template, raster levels are not drawn when set */
+  std::shared_ptr<VectorTileLayer>
+                            m_vector_layer;
+  ure::SceneLayerNode*      m_vector_node;  /* Owned by the scene graph */
+  std::string               m_markers_path; /* Markers read from a lon,lat CSV file */
+  ure::uint_t               m_random_markers;/* Markers generated when no file is given, 0 for none */
+  std::shared_ptr<MarkerLayer>
+                            m_marker_layer; /* Drawn over the scene, see on_run() */
+  std::string               m_tracks_path;  /* Tracks read from a lon,lat CSV file, empty lines between tracks */
+  ure::uint_t               m_random_tracks;/* Tracks generated when no file is given, 0 for none */
+  std::shared_ptr<TrackLayer>
+                            m_track_layer;  /* Drawn over the scene, under the markers */
+  std::string               m_heatmap_path; /* Heatmap points read from a lon,lat CSV file */
+  ure::uint_t               m_random_heatmap;/* Heatmap points generated when no file is given, 0 for none */
+  ure::uint_t               m_heatmap_rate; /* Points per second added while running, 0 for none */
+  std::uint64_t             m_heatmap_batches;/* Batches added so far, seeds the next one */
+  RedrawSignal::clock_t::time_point
+                            m_heatmap_fed_at;
+  std::shared_ptr<HeatmapLayer>
+                            m_heatmap_layer;/* Drawn over the scene, between tracks and markers */
+#if MAP_ENABLE_METRICS
+  ure::bool_t               m_show_metrics; /* Draw the metrics overlay */
+  std::string               m_metrics_dump; /* Metrics history written here on exit, JSON or CSV */
+  MetricsOverlay            m_metrics_overlay;
+#endif
+  TilePrefetcher            m_prefetcher;   /* Predict next viewport from pan and zoom input */
+  InputAccumulator          m_input;        /* Pan and scroll events since the last frame, see on_run() */
 
   ure::Position_d           m_mouse_last_pos;
+  ure::Position_d           m_mouse_press_pos;/* Clicks that do not move the map pick markers */
   ure::bool_t               m_move_map;
 
 };
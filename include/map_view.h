@@ -0,0 +1,131 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef MAP_VIEW_H
+#define MAP_VIEW_H
+
+#include <ure_utils.h>
+#include <ure_size.h>
+
+#include <chrono>
+
+#include <glm/glm.hpp>
+
+/**
+ * Pan and continuous zoom state shared by all zoom levels.
+ *
+ * Every level lays its tiles out at 1:1 scale from origin(), the view scales them by
+ * 2^(zoom - level) around the cursor and translates them while panning, so a level
+ * is drawn at any zoom by changing its model matrix only.
+ * Between two integer zoom values the upper level fades in over the lower one.
+ *
+ * Deep levels are 2^26 pixels wide and more, past float precision: the view centre is
+ * kept in double and each level is laid out from a local origin, aligned to its tiles
+ * and close to the centre, so that vertices and model matrices stay small.
+ */
+class MapView
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * Levels to draw for the current zoom.
+   */
+  struct levels_t
+  {
+    ure::int_t    lower;      /* floor(zoom) */
+    ure::int_t    upper;      /* lower + 1, or lower at the last level */
+    ure::float_t  fade;       /* Opacity of upper drawn over lower, 0 and 1 draw a single level */
+    ure::int_t    draw;       /* Level drawn first, it draws upper as overlay while fading */
+    ure::int_t    current;    /* Level closest to the zoom */
+  };
+
+  /**
+   * @param step  zoom change for a mouse wheel notch.
+   * @param tau   time constant, in seconds, of the zoom animation.
+   */
+  MapView( ure::int_t max_levels, ure::float_t step = 1.0f, ure::float_t tau = 0.08f ) noexcept(true);
+
+  /**
+   * Centre the projection on a window of @p size and show @p level at 1:1 scale.
+   */
+  ure::void_t     reset( const ure::Size& size, ure::int_t level ) noexcept(true);
+
+  /**
+   * Position of tile (0,0) of level @p zl in its model coordinates. It moves in steps of
+   * local_extent() pixels while panning, layers must be updated with level_model().
+   */
+  glm::vec2       origin( ure::int_t zl ) const noexcept(true);
+  /** Alignment of the local origins, a multiple of any tile size up to it */
+  static constexpr ure::double_t local_extent()
+  { return 4096.0; }
+
+  /** World point at the window centre, in pixels of the current zoom from tile (0,0) */
+  glm::dvec2      centre() const noexcept(true);
+  /**
+   * Centre the window on @p pixel of the current zoom, counted from tile (0,0).
+   */
+  ure::void_t     centre_on( const glm::dvec2& pixel ) noexcept(true);
+  /***/
+  ure::float_t    zoom() const noexcept
+  { return m_zoom; }
+  /***/
+  ure::float_t    target() const noexcept
+  { return m_target; }
+  /***/
+  ure::bool_t     animating() const noexcept
+  { return m_zoom != m_target; }
+
+  /**
+   * Move the map by @p delta pixels.
+   */
+  ure::void_t     pan( const glm::vec2& delta ) noexcept(true);
+  /**
+   * Move the zoom target by @p notches wheel steps, centred on @p anchor given relative
+   * to the window centre. Return false if the target did not change.
+   */
+  ure::bool_t     zoom_by( ure::float_t notches, const glm::vec2& anchor, clock_t::time_point now = clock_t::now() ) noexcept(true);
+  /**
+   * Move the zoom towards its target, keeping the anchor point still.
+   * Return true if the zoom changed.
+   */
+  ure::bool_t     animate( clock_t::time_point now = clock_t::now() ) noexcept(true);
+
+  /***/
+  levels_t        levels() const noexcept(true);
+  /**
+   * Model matrix of level @p zl for the current zoom, optionally panned by @p pan pixels.
+   */
+  glm::mat4       level_model( ure::int_t zl, const glm::vec2& pan = glm::vec2( 0.0f ) ) const noexcept(true);
+
+private:
+  /**
+   * Tile aligned point of level @p zl close to the window centre, in pixels of the level.
+   */
+  glm::dvec2      local( ure::int_t zl ) const noexcept(true);
+
+private:
+  const ure::int_t        m_max_levels;
+  const ure::float_t      m_step;
+  const ure::float_t      m_tau;
+  glm::mat4               m_projection;   /* Orthographic projection, centred on the window */
+  glm::dvec2              m_centre;       /* World point at the window centre, in pixels of level 0 */
+  ure::float_t            m_zoom;         /* Continuous zoom, integer values show a single level */
+  ure::float_t            m_target;       /* Zoom reached at the end of the animation */
+  glm::vec2               m_anchor;       /* Point kept still while zooming, relative to the window centre */
+  clock_t::time_point     m_time;         /* Last animation step */
+};
+
+#endif // MAP_VIEW_H
@@ -0,0 +1,150 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef MARKER_INDEX_H
+#define MARKER_INDEX_H
+
+#include <ure_utils.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Static spatial index of markers, built once and queried every time the view changes.
+ *
+ * Positions are Web Mercator coordinates normalized to [0,1), stored as 32 bit fixed
+ * point values in separate arrays sorted by Morton code, so that every quadtree cell
+ * covers a contiguous range of markers. Each node keeps the sum of its positions, a
+ * cell smaller than the clustering distance is reported as a single cluster at its
+ * centroid without visiting its markers.
+ */
+class MarkerIndex
+{
+public:
+  /** Normalized Web Mercator position, x east and y south */
+  struct point_t
+  {
+    ure::double_t   x;
+    ure::double_t   y;
+  };
+
+  /** Normalized area, max values are excluded */
+  struct bounds_t
+  {
+    ure::double_t   min_x;
+    ure::double_t   min_y;
+    ure::double_t   max_x;
+    ure::double_t   max_y;
+  };
+
+  /**
+   * Marker, or group of markers closer than the clustering distance.
+   */
+  struct cluster_t
+  {
+    ure::double_t   x;          /* Normalized position, centroid of clusters */
+    ure::double_t   y;
+    ure::uint_t     count;      /* Markers represented, 1 for a single marker */
+    ure::uint_t     id;         /* Position of the marker in build() input, the first one of clusters */
+  };
+
+  /***/
+  MarkerIndex() noexcept(true);
+
+  /**
+   * Normalized position of @p lon, @p lat in degrees, latitudes are clamped to the
+   * Web Mercator range.
+   */
+  static point_t      project( ure::double_t lon, ure::double_t lat ) noexcept(true);
+
+  /**
+   * Append to @p points the positions read from @p path, one "lon,lat" pair in degrees
+   * per line. Lines that do not start with a pair, e.g. a header, are skipped.
+   * Return false if the file can not be read.
+   */
+  static ure::bool_t  read_csv( const std::string& path, std::vector<point_t>& points ) noexcept(true);
+
+  /**
+   * Radius of a cluster of @p count markers relative to a single one, grows with the
+   * number of markers but stays bounded.
+   */
+  static ure::float_t radius_scale( ure::uint_t count ) noexcept(true);
+  /** Upper bound of radius_scale() */
+  static constexpr ure::float_t max_radius_scale()
+  { return 3.0f; }
+
+  /**
+   * Replace the content of the index with @p points, their position in the vector is
+   * the marker identifier.
+   */
+  ure::void_t         build( const std::vector<point_t>& points ) noexcept(true);
+
+  /***/
+  std::size_t         size() const noexcept
+  { return m_x.size(); }
+  /***/
+  ure::bool_t         empty() const noexcept
+  { return m_x.empty(); }
+  /***/
+  std::size_t         nodes() const noexcept
+  { return m_nodes.size(); }
+
+  /**
+   * Append to @p out markers and clusters intersecting @p bounds. Markers closer than
+   * @p cell, in normalized units, are merged; 0 reports every marker.
+   */
+  ure::void_t         query( const bounds_t& bounds, ure::double_t cell, std::vector<cluster_t>& out ) const noexcept(true);
+
+  /**
+   * Marker or cluster, as reported by query() with the same @p cell, whose disc contains
+   * @p point. Discs have @p radius for single markers and are scaled by radius_scale()
+   * for clusters, the closest centre wins when they overlap.
+   */
+  std::optional<cluster_t>  pick( const point_t& point, ure::double_t radius, ure::double_t cell ) const noexcept(true);
+
+private:
+  /**
+   * Quadtree cell, children are -1 when missing or for leaves.
+   */
+  struct node_t
+  {
+    std::uint32_t   first;      /* First marker in sorted order */
+    std::uint32_t   count;
+    std::uint64_t   sum_x;      /* Fixed point sums, centroid without visiting the markers */
+    std::uint64_t   sum_y;
+    std::int32_t    child[4];   /* Indexed by ( y bit << 1 ) | x bit */
+  };
+
+  /***/
+  std::int32_t        build( const std::vector<std::uint64_t>& codes, std::uint32_t first, std::uint32_t last, ure::uint_t depth ) noexcept(true);
+  /**
+   * Clusters of @p node, a cell of 2^(32 - depth) fixed point units at @p x0, @p y0.
+   * Cells of 2^shift units are merged, none when @p shift is negative.
+   */
+  ure::void_t         query( std::int32_t node, ure::uint_t depth, std::uint64_t x0, std::uint64_t y0,
+                             const bounds_t& bounds, std::int32_t shift, std::vector<cluster_t>& out ) const noexcept(true);
+  /***/
+  cluster_t           marker( std::uint32_t index ) const noexcept(true);
+
+private:
+  std::vector<std::uint32_t>  m_x;        /* Fixed point positions, Morton order */
+  std::vector<std::uint32_t>  m_y;
+  std::vector<ure::uint_t>    m_id;       /* Position in build() input */
+  std::vector<node_t>         m_nodes;    /* Root first, empty without markers */
+};
+
+#endif // MARKER_INDEX_H
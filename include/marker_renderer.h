@@ -0,0 +1,116 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef MARKER_RENDERER_H
+#define MARKER_RENDERER_H
+
+#include <ure_utils.h>
+#include <ure_size.h>
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Draw markers as screen aligned discs with the DefaultMarker shaders, whatever their
+ * number in a single draw call.
+ *
+ * On GLES3 and GL 3.3 contexts a unit quad is instanced once per marker, only the
+ * per-marker attributes are uploaded. Elsewhere quads are expanded on the CPU into
+ * six vertices carrying the same attributes, the shaders do not change.
+ * All methods must be called from the thread owning the GL context.
+ */
+class MarkerRenderer
+{
+public:
+  /**
+   * Per-marker attributes.
+   */
+  struct instance_t
+  {
+    glm::vec2     point;      /* Position in the coordinates of the MVP matrix */
+    ure::float_t  radius;     /* Pixels */
+    ure::float_t  cluster;    /* 1 for clusters, 0 for single markers */
+  };
+
+  /***/
+  MarkerRenderer() noexcept(true);
+  /***/
+  ~MarkerRenderer() noexcept(true);
+
+  /**
+   * Directory containing DefaultMarker.vs/.fs, program is built on first upload().
+   */
+  ure::void_t   set_shaders_path( const std::string& path ) noexcept(true);
+  /***/
+  ure::void_t   set_colors( const glm::vec4& marker, const glm::vec4& cluster ) noexcept(true);
+
+  /**
+   * Replace the markers drawn by draw(), false if the program is not available.
+   */
+  ure::bool_t   upload( const std::vector<instance_t>& instances ) noexcept(true);
+  /**
+   * Draw the uploaded markers with @p mvp over a frame buffer of @p fb_size pixels.
+   * Return the number of draw calls.
+   */
+  ure::uint_t   draw( const glm::mat4& mvp, const ure::Size& fb_size ) noexcept(true);
+
+  /** Markers uploaded */
+  ure::uint_t   count() const noexcept
+  { return m_count; }
+  /** True once the program is built if markers are instanced */
+  ure::bool_t   instanced() const noexcept
+  { return m_instanced; }
+
+  /**
+   * Delete program and buffers, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /** Vertex of the expanded quads, without instancing */
+  struct vertex_t
+  {
+    glm::vec2     corner;
+    instance_t    instance;
+  };
+
+  /***/
+  ure::bool_t   init() noexcept(true);
+  /***/
+  GLuint        compile( GLenum type, const std::string& file ) noexcept(true);
+
+private:
+  std::string               m_shaders_path;
+  ure::bool_t               m_failed;          /* Do not try again to build a broken program */
+  ure::bool_t               m_instanced;
+  GLuint                    m_program;
+  GLint                     m_a_corner;
+  GLint                     m_a_instance;
+  GLint                     m_u_mvp;
+  GLint                     m_u_pixel;
+  GLint                     m_u_color;
+  GLint                     m_u_cluster_color;
+  GLuint                    m_corners;         /* Unit quad, instanced path only */
+  GLuint                    m_vbo;
+  std::size_t               m_vbo_size;        /* Bytes allocated for m_vbo */
+  ure::uint_t               m_count;
+  glm::vec4                 m_color;
+  glm::vec4                 m_cluster_color;
+  std::vector<vertex_t>     m_vertices;        /* Expanded quads, reused between uploads */
+};
+
+#endif // MARKER_RENDERER_H
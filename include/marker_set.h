@@ -0,0 +1,130 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef MARKER_SET_H
+#define MARKER_SET_H
+
+#include <ure_size.h>
+
+#include "marker_index.h"
+#include "marker_renderer.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Markers drawn over the tiles of a zoom level, with the same model matrix.
+ *
+ * Markers of the visible area are queried from the index, clustered by a distance
+ * fixed in pixels at the current level, and uploaded once. The query covers a margin
+ * around the viewport, panning within it only changes the model matrix; moving out of
+ * it, or changing level, runs a new query.
+ */
+class MarkerSet
+{
+public:
+  /***/
+  explicit MarkerSet( ure::uint_t tile_pixels ) noexcept(true);
+
+  /**
+   * Directory containing DefaultMarker.vs/.fs.
+   */
+  ure::void_t       set_shaders_path( const std::string& path ) noexcept(true)
+  { m_renderer.set_shaders_path( path ); }
+
+  /**
+   * Replace the markers, cluster identifiers are positions in the points @p index has been built from.
+   */
+  ure::void_t       set_markers( MarkerIndex&& index ) noexcept(true);
+  /***/
+  const MarkerIndex&  markers() const noexcept
+  { return m_index; }
+
+  /**
+   * Disc radius of a single marker and distance under which markers are clustered, in pixels.
+   */
+  ure::void_t       set_style( ure::float_t radius, ure::float_t cluster_distance ) noexcept(true);
+  /***/
+  MarkerRenderer&   renderer() noexcept
+  { return m_renderer; }
+
+  /***/
+  ure::void_t       set_zoom( ure::word_t zoom ) noexcept(true);
+  /***/
+  constexpr ure::word_t zoom() const noexcept
+  { return m_zoom; }
+  /**
+   * Position of tile (0,0), as for the tile levels.
+   */
+  ure::void_t       set_origin( const glm::vec2& origin ) noexcept(true);
+  /**
+   * Model matrix of the level, mapping its pixels to clip space, and frame buffer size.
+   */
+  ure::void_t       set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true);
+
+  /**
+   * Marker or cluster under @p point, in pixels from the top left corner of a window
+   * of @p size, as drawn by the last draw().
+   */
+  std::optional<MarkerIndex::cluster_t>  pick( const glm::vec2& point, const ure::Size& size ) const noexcept(true);
+
+  /**
+   * Query markers if the view moved out of the last query, and draw them.
+   * Return the number of draw calls.
+   */
+  ure::uint_t       draw() noexcept(true);
+
+  /** Markers and clusters of the last query, they include the margin around the view */
+  const std::vector<MarkerIndex::cluster_t>&  visible() const noexcept
+  { return m_visible; }
+  /** Queries run so far */
+  std::uint64_t     queries() const noexcept
+  { return m_queries; }
+
+  /**
+   * Release GL resources, must be called while the GL context is still valid.
+   */
+  ure::void_t       dispose() noexcept(true)
+  { m_renderer.dispose(); }
+
+private:
+  /** Size of the level in pixels */
+  ure::double_t     world() const noexcept(true);
+  /** Normalized area covered by the viewport, expanded by the radius of the largest disc */
+  MarkerIndex::bounds_t  view_bounds() const noexcept(true);
+  /** Query and upload the markers around the view */
+  ure::void_t       refresh( const MarkerIndex::bounds_t& view ) noexcept(true);
+
+private:
+  const ure::uint_t         m_tile_pixels;
+  MarkerIndex               m_index;
+  MarkerRenderer            m_renderer;
+  ure::float_t              m_radius;           /* Pixels */
+  ure::float_t              m_cluster_distance; /* Pixels at the current level */
+  ure::word_t               m_zoom;
+  glm::vec2                 m_origin;
+  glm::mat4                 m_model;
+  ure::Size                 m_fb_size;
+  ure::bool_t               m_dirty;            /* Markers, level or style changed since the last query */
+  MarkerIndex::bounds_t     m_queried;          /* Area of the last query */
+  std::uint64_t             m_queries;
+  std::vector<MarkerIndex::cluster_t>         m_visible;
+  std::vector<MarkerRenderer::instance_t>     m_instances;
+};
+
+#endif // MARKER_SET_H
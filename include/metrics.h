@@ -0,0 +1,205 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "config.h"
+
+/**
+ * Per-frame instrumentation: phase timers, counters and gauges.
+ *
+ * Always go through the MAP_METRICS_* macros, with MAP_ENABLE_METRICS set to 0
+ * they expand to nothing and the Metrics class is not compiled at all.
+ *
+ *   MAP_METRICS_SCOPE( render );              time the enclosing scope
+ *   MAP_METRICS_ADD  ( tiles_uploaded, n );   add to a counter for this frame
+ *   MAP_METRICS_TOTAL( cache_hits, total );   counter sampled from a running total
+ *   MAP_METRICS_SET  ( queue_depth, value );  gauge, last value wins
+ *   MAP_METRICS_END_FRAME();                  close the frame, see Metrics::end_frame()
+ */
+#if MAP_ENABLE_METRICS
+
+#include <ure_utils.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Metrics
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /** Phases timed with MAP_METRICS_SCOPE, decode runs on worker threads */
+  enum class timer_t : ure::uint_t
+  {
+    frame, clear, render, swap, process_message, upload, prefetch, dispatch, decode,
+    count
+  };
+
+  /** Events counted per frame */
+  enum class counter_t : ure::uint_t
+  {
+    cache_hits, cache_misses, tiles_uploaded, upload_bytes, downloads_dispatched,
+    count
+  };
+
+  /** Values sampled once per frame */
+  enum class gauge_t : ure::uint_t
+  {
+    queue_depth, in_flight, decoder_pending, cache_tiles, gpu_bytes,
+    count
+  };
+
+  static constexpr std::size_t  timers   = static_cast<std::size_t>( timer_t::count );
+  static constexpr std::size_t  counters = static_cast<std::size_t>( counter_t::count );
+  static constexpr std::size_t  gauges   = static_cast<std::size_t>( gauge_t::count );
+
+  /**
+   * Values of a single frame.
+   */
+  struct frame_t
+  {
+    std::uint64_t                         index;
+    std::array<ure::double_t, timers>     ms;          /* Time spent in each phase */
+    std::array<ure::uint_t,   timers>     samples;     /* Scopes closed, e.g. tiles decoded */
+    std::array<std::uint64_t, counters>   counts;
+    std::array<ure::double_t, gauges>     values;
+  };
+
+  /***/
+  static Metrics&     instance() noexcept(true);
+
+  /** Thread safe */
+  ure::void_t         add_time( timer_t timer, clock_t::duration elapsed ) noexcept(true)
+  {
+    accumulator_t& acc = m_timers[ static_cast<std::size_t>(timer) ];
+
+    acc.ns.fetch_add( static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count() ), std::memory_order_relaxed );
+    acc.samples.fetch_add( 1, std::memory_order_relaxed );
+  }
+  /** Thread safe */
+  ure::void_t         add( counter_t counter, std::uint64_t value ) noexcept(true)
+  { m_counts[ static_cast<std::size_t>(counter) ].fetch_add( value, std::memory_order_relaxed ); }
+  /**
+   * Count the growth of a running total since the last call, main thread only.
+   */
+  ure::void_t         total( counter_t counter, std::uint64_t value ) noexcept(true);
+  /** Main thread only */
+  ure::void_t         set( gauge_t gauge, ure::double_t value ) noexcept(true)
+  { m_values[ static_cast<std::size_t>(gauge) ] = value; }
+
+  /**
+   * Close the current frame: accumulated values become the last frame, are
+   * appended to the history and reset. Main thread only.
+   */
+  ure::void_t         end_frame() noexcept(true);
+
+  /** Last closed frame */
+  const frame_t&      last() const noexcept
+  { return m_last; }
+  /** Exponential moving average of the time spent in @p timer per frame */
+  ure::double_t       average_ms( timer_t timer ) const noexcept
+  { return m_average_ms[ static_cast<std::size_t>(timer) ]; }
+  /** Longest time spent in @p timer by a frame in the history */
+  ure::double_t       max_ms( timer_t timer ) const noexcept(true);
+
+  /**
+   * Write the frames in the history to @p path, as CSV when the extension is
+   * ".csv" and as JSON otherwise.
+   */
+  ure::bool_t         dump( const std::string& path ) const noexcept(true);
+
+  /***/
+  static const char*  name( timer_t   timer   ) noexcept;
+  /***/
+  static const char*  name( counter_t counter ) noexcept;
+  /***/
+  static const char*  name( gauge_t   gauge   ) noexcept;
+
+private:
+  /***/
+  Metrics( std::size_t history ) noexcept(true);
+
+  /***/
+  ure::bool_t         dump_csv ( std::FILE* file ) const noexcept(true);
+  /***/
+  ure::bool_t         dump_json( std::FILE* file ) const noexcept(true);
+
+private:
+  struct accumulator_t
+  {
+    std::atomic<std::uint64_t>  ns{ 0 };
+    std::atomic<ure::uint_t>    samples{ 0 };
+  };
+
+  std::array<accumulator_t, timers>               m_timers;
+  std::array<std::atomic<std::uint64_t>, counters> m_counts;
+  std::array<std::uint64_t, counters>             m_totals;       /* Last value passed to total() */
+  std::array<ure::double_t, gauges>               m_values;
+  std::array<ure::double_t, timers>               m_average_ms;
+  frame_t                                         m_last;
+  std::vector<frame_t>                            m_history;      /* Ring of the last frames */
+  std::size_t                                     m_next;         /* Next slot written in m_history */
+  std::uint64_t                                   m_frames;
+};
+
+/**
+ * Add the lifetime of this object to a Metrics timer.
+ */
+class ScopedTimer
+{
+public:
+  /***/
+  explicit ScopedTimer( Metrics::timer_t timer ) noexcept(true)
+    : m_timer( timer ), m_start( Metrics::clock_t::now() )
+  {}
+  /***/
+  ~ScopedTimer() noexcept(true)
+  { Metrics::instance().add_time( m_timer, Metrics::clock_t::now() - m_start ); }
+
+  ScopedTimer( const ScopedTimer& ) = delete;
+  ScopedTimer& operator=( const ScopedTimer& ) = delete;
+
+private:
+  const Metrics::timer_t            m_timer;
+  const Metrics::clock_t::time_point m_start;
+};
+
+#define MAP_METRICS_CONCAT_( a, b )       a##b
+#define MAP_METRICS_CONCAT( a, b )        MAP_METRICS_CONCAT_( a, b )
+
+#define MAP_METRICS_SCOPE( timer )        ScopedTimer MAP_METRICS_CONCAT( metrics_scope_, __LINE__ )( Metrics::timer_t::timer )
+#define MAP_METRICS_ADD( counter, value ) Metrics::instance().add  ( Metrics::counter_t::counter, static_cast<std::uint64_t>( value ) )
+#define MAP_METRICS_TOTAL( counter, value ) Metrics::instance().total( Metrics::counter_t::counter, static_cast<std::uint64_t>( value ) )
+#define MAP_METRICS_SET( gauge, value )   Metrics::instance().set  ( Metrics::gauge_t::gauge, static_cast<ure::double_t>( value ) )
+#define MAP_METRICS_END_FRAME()           Metrics::instance().end_frame()
+
+#else
+
+#define MAP_METRICS_SCOPE( timer )
+#define MAP_METRICS_ADD( counter, value )
+#define MAP_METRICS_TOTAL( counter, value )
+#define MAP_METRICS_SET( gauge, value )
+#define MAP_METRICS_END_FRAME()
+
+#endif // MAP_ENABLE_METRICS
+
+#endif // METRICS_H
@@ -0,0 +1,99 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef METRICS_OVERLAY_H
+#define METRICS_OVERLAY_H
+
+#include "metrics.h"
+
+#if MAP_ENABLE_METRICS
+
+#include <ure_texture.h>
+#include <ure_size.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Draw the last Metrics values in the top left corner of the viewport.
+ *
+ * Text is drawn with the DefaultText.vs/.fs shaders and a built-in 8x12 bitmap
+ * font, so no font file is needed. Text and vertices are refreshed a few times
+ * per second, in between a frame costs a single draw call.
+ */
+class MetricsOverlay
+{
+public:
+  /***/
+  MetricsOverlay() noexcept(true);
+  /***/
+  ~MetricsOverlay() noexcept(true);
+
+  /**
+   * Directory containing DefaultText.vs/.fs, program is built on first draw.
+   */
+  ure::void_t   set_shaders_path( const std::string& path ) noexcept(true);
+
+  /**
+   * Draw over a viewport of @p size pixels.
+   */
+  ure::void_t   draw( const ure::Size& size ) noexcept(true);
+
+  /**
+   * Delete GL resources, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  struct vertex_t
+  {
+    ure::float_t  x;
+    ure::float_t  y;
+    ure::float_t  u;
+    ure::float_t  v;
+  };
+
+  /***/
+  ure::bool_t   init() noexcept(true);
+  /***/
+  GLuint        compile( GLenum type, const std::string& file ) noexcept(true);
+  /** Format the current values in m_text */
+  ure::void_t   format() noexcept(true);
+  /** Rebuild and upload vertices of m_text */
+  ure::void_t   build() noexcept(true);
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  std::string               m_shaders_path;
+  ure::bool_t               m_failed;          /* Do not try again to build a broken program */
+  GLuint                    m_program;
+  GLuint                    m_font;            /* Alpha texture, glyphs on a 16x6 grid */
+  GLuint                    m_vbo;
+  GLint                     m_a_point;
+  GLint                     m_a_texcoord;
+  GLint                     m_u_mvp;
+  GLint                     m_u_texture;
+  GLint                     m_u_color;
+  std::string               m_text;
+  std::vector<vertex_t>     m_vertices;        /* Two triangles per glyph */
+  GLsizei                   m_count;           /* Vertices in m_vbo */
+  clock_t::time_point       m_refresh_at;
+};
+
+#endif // MAP_ENABLE_METRICS
+
+#endif // METRICS_OVERLAY_H
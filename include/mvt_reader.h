@@ -0,0 +1,83 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef MVT_READER_H
+#define MVT_READER_H
+
+#include <ure_utils.h>
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Streaming reader of Mapbox Vector Tiles (MVT 2.x protobuf).
+ *
+ * Layers are announced to a Handler, which selects the ones it needs; features of
+ * selected layers are decoded one at a time into a reused feature_t, so that parsing
+ * a tile costs no allocation once buffers have grown. Attributes (keys, values and
+ * feature tags) are skipped, styling is by layer name.
+ */
+class MvtReader
+{
+public:
+  enum class geometry_t : ure::uint_t
+  {
+    unknown    = 0,
+    point      = 1,
+    linestring = 2,
+    polygon    = 3
+  };
+
+  struct feature_t
+  {
+    geometry_t                type;
+    std::vector<glm::vec2>    points;    /* Tile coordinates, [0,extent] plus the tile buffer */
+    std::vector<ure::uint_t>  parts;     /* First point of each ring, line or point group */
+
+    /** Points of part @p i */
+    constexpr std::size_t   part_size( std::size_t i ) const noexcept
+    { return ( ( i + 1 < parts.size() ) ? parts[i + 1] : points.size() ) - parts[i]; }
+  };
+
+  class Handler
+  {
+  public:
+    /***/
+    virtual ~Handler() noexcept(true) = default;
+
+    /**
+     * Start of layer @p name with coordinates in [0,@p extent], return false to skip its features.
+     */
+    virtual ure::bool_t  on_layer  ( std::string_view name, ure::uint_t extent ) noexcept(true) = 0;
+    /**
+     * A feature of the current layer, @p feature is reused for the next one.
+     */
+    virtual ure::void_t  on_feature( const feature_t& feature ) noexcept(true) = 0;
+  };
+
+  /**
+   * Parse a whole tile, return false if the protobuf is malformed. Gzip compressed
+   * tiles are rejected, the fetcher is expected to handle HTTP content encoding.
+   */
+  ure::bool_t  parse( const ure::byte_t* data, std::size_t length, Handler& handler ) noexcept(true);
+
+private:
+  feature_t   m_feature;
+};
+
+#endif // MVT_READER_H
@@ -0,0 +1,63 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef REDRAW_SIGNAL_H
+#define REDRAW_SIGNAL_H
+
+#include <ure_utils.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * Dirty flag telling the main loop that a new frame is required.
+ *
+ * Input handlers and the tile pipeline call request(), from any thread; the main
+ * loop calls consume() once per iteration and, when nothing changed, sleeps in
+ * wait() until a request arrives or the timeout expires.
+ */
+class RedrawSignal
+{
+public:
+  using clock_t    = std::chrono::steady_clock;
+  using duration_t = clock_t::duration;
+
+  /***/
+  RedrawSignal() noexcept(true);
+
+  /**
+   * Mark the view as changed and wake up a thread waiting in wait().
+   */
+  ure::void_t   request() noexcept(true);
+
+  /**
+   * Return true if a redraw has been requested since the last call, clearing the request.
+   */
+  ure::bool_t   consume() noexcept(true);
+
+  /**
+   * Block until a redraw is requested or @p timeout expires, the request is not cleared.
+   * Return true if a redraw is pending.
+   */
+  ure::bool_t   wait( duration_t timeout ) noexcept(true);
+
+private:
+  std::mutex                m_mutex;
+  std::condition_variable   m_cv;
+  ure::bool_t               m_dirty;
+};
+
+#endif // REDRAW_SIGNAL_H
@@ -0,0 +1,139 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_ATLAS_H
+#define TILE_ATLAS_H
+
+#include <ure_texture.h>
+#include <ure_size.h>
+
+#include "tile_image.h"
+#include "tile_uploader.h"
+
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Tile textures packed in a few large GL textures (pages), each split in fixed size slots.
+ *
+ * Pages are created on demand the first time all slots are in use, freed slots are
+ * reused before a new page is created, so the number of pages follows the number of
+ * resident tiles bounded by the TileCache budget.
+ * Pages store one of the TileImage formats, chosen with set_format() before the
+ * first upload: ETC2 where the driver decodes it, RGB565 or RGBA8 elsewhere.
+ * Pixels are staged by a TileUploader, so that uploads do not wait for the transfer.
+ * All methods must be called from the thread owning the GL context.
+ */
+class TileAtlas
+{
+public:
+  struct slot_t
+  {
+    static constexpr ure::uint_t npos = std::numeric_limits<ure::uint_t>::max();
+
+    ure::uint_t   page  = npos;
+    ure::uint_t   index = npos;
+
+    /***/
+    constexpr ure::bool_t valid() const noexcept
+    { return page != npos; }
+  };
+
+  /**
+   * @param page_size  requested side of a page in pixels, reduced to GL_MAX_TEXTURE_SIZE.
+   */
+  TileAtlas( const ure::Size& tile_size, ure::uint_t page_size = 2048 ) noexcept(true);
+  /***/
+  ~TileAtlas() noexcept(true);
+
+  /**
+   * Format of the pages, @p format must be supported(), ignored once a page exists.
+   */
+  ure::bool_t   set_format( TileImage::format_t format ) noexcept(true);
+  /***/
+  constexpr TileImage::format_t   format() const noexcept
+  { return m_format; }
+  /**
+   * Closest format to @p requested the current GL context can store and sub-image update.
+   * ETC2 requires OpenGL ES 3 or OpenGL 4.3, RGB565 is used otherwise: ETC1 textures
+   * on GLES2 can not be updated a slot at a time.
+   */
+  static TileImage::format_t  supported( TileImage::format_t requested ) noexcept(true);
+
+  /**
+   * Reserve a slot, return an invalid slot if a new page can not be created.
+   */
+  slot_t        allocate() noexcept(true);
+  /***/
+  ure::void_t   release( const slot_t& slot ) noexcept(true);
+  /**
+   * Copy @p image in @p slot, image size and format must match the atlas ones.
+   * The copy to the GPU completes asynchronously where unpack buffers are available.
+   */
+  ure::bool_t   upload( const slot_t& slot, const TileImage& image ) noexcept(true);
+
+  /**
+   * Texture coordinates of @p slot as (u0, v0, u1, v1), inset by half a texel so
+   * that linear filtering does not bleed from neighbour slots.
+   */
+  glm::vec4     uv( const slot_t& slot ) const noexcept(true);
+  /**
+   * Texture coordinates of a part of @p slot, @p sub is (x0, y0, x1, y1) in [0,1] tile units.
+   */
+  glm::vec4     uv( const slot_t& slot, const glm::vec4& sub ) const noexcept(true);
+
+  /***/
+  constexpr const ure::Size&  tile_size() const noexcept
+  { return m_tile_size; }
+  /***/
+  GLuint        page_texture( ure::uint_t page ) const noexcept(true);
+  /***/
+  ure::uint_t   pages() const noexcept(true)
+  { return static_cast<ure::uint_t>(m_pages.size()); }
+  /***/
+  constexpr ure::uint_t   slots_per_page() const noexcept
+  { return m_columns * m_rows; }
+  /***/
+  const TileUploader&     uploader() const noexcept
+  { return m_uploader; }
+
+  /**
+   * Delete all GL textures, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /***/
+  ure::bool_t   add_page() noexcept(true);
+
+private:
+  struct page_t
+  {
+    GLuint                    texture;
+    std::vector<ure::uint_t>  free;       /* Available slot indexes */
+  };
+
+  const ure::Size             m_tile_size;
+  TileImage::format_t         m_format;
+  ure::uint_t                 m_page_size;
+  ure::uint_t                 m_columns;
+  ure::uint_t                 m_rows;
+  std::vector<page_t>         m_pages;
+  TileUploader                m_uploader;
+};
+
+#endif // TILE_ATLAS_H
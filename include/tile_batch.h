@@ -0,0 +1,183 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_BATCH_H
+#define TILE_BATCH_H
+
+#include "tile_atlas.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Collect textured quads for a frame and draw them with as few draw calls as possible.
+ *
+ * Quads reference atlas pages, up to max_pages() pages are bound to different texture
+ * units and selected in the fragment shader, so a frame costs one draw call unless
+ * more pages are in use. Shaders are DefaultTextureBatch.vs/.fs.
+ *
+ * Quads belong to a layer, e.g. a tile source, layers are drawn in order with their
+ * own opacity set by set_layer_opacity(). Layers sharing the same pages are drawn by
+ * the same draw call, primitives are blended in the order of the vertex buffer.
+ *
+ * Quads collected with add() are committed to a retained geometry, each layer owns one.
+ * Vertex data is rebuilt and uploaded only when the quads differ from the last commit,
+ * pan, zoom and opacity changes only update uniforms.
+ */
+class TileBatch
+{
+public:
+  struct vertex_t
+  {
+    ure::float_t  x;
+    ure::float_t  y;
+    ure::float_t  u;
+    ure::float_t  v;
+    ure::float_t  page;   /* Page index relative to the pages bound by the draw call */
+    ure::float_t  layer;
+  };
+
+  struct stats_t
+  {
+    ure::uint_t   quads;
+    ure::uint_t   draw_calls;
+  };
+
+  struct quad_t
+  {
+    glm::vec4     rect;
+    glm::vec4     uv;
+    ure::uint_t   page;
+    ure::uint_t   layer;
+
+    /***/
+    ure::bool_t operator==( const quad_t& rhs ) const noexcept
+    { return (rect==rhs.rect) && (uv==rhs.uv) && (page==rhs.page) && (layer==rhs.layer); }
+  };
+
+  /** Pages selectable by the fragment shader in a single draw call */
+  static constexpr ure::uint_t  max_pages()
+  { return 4; }
+  /** Layers with their own opacity, size of the opacity array in the vertex shader */
+  static constexpr ure::uint_t  max_layers()
+  { return 8; }
+
+  /***/
+  TileBatch() noexcept(true);
+  /***/
+  ~TileBatch() noexcept(true);
+
+  /**
+   * Directory containing DefaultTextureBatch.vs/.fs, program is built on first draw.
+   */
+  ure::void_t   set_shaders_path( const std::string& path ) noexcept(true);
+
+  /**
+   * Create an empty retained geometry, released by dispose().
+   * Return the identifier to use with commit() and draw().
+   */
+  ure::uint_t   create_geometry() noexcept(true);
+
+  /**
+   * Start a new batch, previous quads are discarded while allocated memory is kept.
+   */
+  ure::void_t   clear() noexcept(true);
+  /**
+   * @param rect  quad as (left, top, right, bottom) in model coordinates.
+   * @param uv    texture coordinates as (u0, v0, u1, v1).
+   * @param layer drawing order, lower layers first; must be less than max_layers().
+   */
+  ure::void_t   add( const glm::vec4& rect, const glm::vec4& uv, ure::uint_t page, ure::uint_t layer = 0 ) noexcept(true);
+  /***/
+  ure::bool_t   empty() const noexcept(true)
+  { return m_quads.empty(); }
+
+  /**
+   * Store quads added since clear() in @p geometry, vertices are rebuilt only if
+   * they changed. Return true if the vertex buffer has been updated.
+   */
+  ure::bool_t   commit( ure::uint_t geometry ) noexcept(true);
+
+  /**
+   * Opacity of @p layer in every geometry, 1 by default. Only a uniform changes.
+   */
+  ure::void_t   set_layer_opacity( ure::uint_t layer, ure::float_t opacity ) noexcept(true);
+  /***/
+  ure::float_t  layer_opacity( ure::uint_t layer ) const noexcept(true)
+  { return ( layer < max_layers() ) ? m_layer_opacity[layer] : 0.0f; }
+
+  /**
+   * Draw @p geometry grouped by layers and atlas pages, @p opacity multiplies texture
+   * alpha on top of the layer opacity.
+   */
+  stats_t       draw( ure::uint_t geometry, const TileAtlas& atlas, const glm::mat4& mvp, ure::float_t opacity = 1.0f ) noexcept(true);
+
+  /**
+   * Delete program and buffers of all geometries, must be called while the GL context is still valid.
+   * Geometry identifiers stay valid, buffers are created again on next commit().
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /***/
+  ure::bool_t   init() noexcept(true);
+  /***/
+  GLuint        compile( GLenum type, const std::string& file ) noexcept(true);
+
+private:
+  struct run_t
+  {
+    ure::uint_t               first;           /* First quad in vbo */
+    ure::uint_t               count;
+    ure::uint_t               group;           /* Group of pages bound while drawing the run */
+  };
+
+  struct geometry_t
+  {
+    GLuint                    vbo;
+    std::size_t               vbo_size;        /* Bytes allocated for vbo */
+    std::vector<quad_t>       quads;           /* Committed quads, compared with the next commit */
+    std::vector<run_t>        runs;            /* Quads in vbo order, by layer then page group */
+    ure::uint_t               layers;          /* Highest layer in use plus one */
+  };
+
+  /** Quads per draw call, bounded by 16 bits indexes */
+  static constexpr ure::uint_t  max_quads = 16384;
+
+  std::string               m_shaders_path;
+  ure::bool_t               m_failed;          /* Do not try again to build a broken program */
+  GLuint                    m_program;
+  GLuint                    m_ibo;
+  GLint                     m_a_point;
+  GLint                     m_a_texcoord;
+  GLint                     m_a_page;
+  GLint                     m_a_layer;
+  GLint                     m_u_mvp;
+  GLint                     m_u_pages[4];
+  GLint                     m_u_opacity;
+  GLint                     m_u_layer_opacity;
+  ure::float_t              m_layer_opacity[8];
+
+  std::vector<quad_t>       m_quads;
+  std::vector<vertex_t>     m_vertices;        /* Persistent staging for the vertex buffer */
+  std::vector<ure::uint_t>  m_order;           /* Quads sorted by page group */
+  std::vector<ure::uint_t>  m_bins;            /* First quad of each layer and page group while sorting */
+  std::vector<ure::uint_t>  m_fill;            /* Insert position of each layer and page group while sorting */
+  std::vector<geometry_t>   m_geometries;
+};
+
+#endif // TILE_BATCH_H
@@ -0,0 +1,99 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include "lru_cache.h"
+#include "tile_atlas.h"
+#include "tile_key.h"
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * Cache of tiles resident in the TileAtlas, shared by all TileLayer instances and
+ * bounded by a budget in bytes.
+ *
+ * LruCache policy: entries used during the current frame are never evicted, so that a
+ * texture still inside a visible range is never dropped; in that case the cache
+ * temporarily grows over the budget. Evicted slots are given back to the atlas.
+ */
+class TileCache
+{
+public:
+  using slot_t = TileAtlas::slot_t;
+
+  /** Gives the slot of an evicted tile back to the atlas */
+  struct release_t
+  {
+    TileAtlas*    atlas;
+
+    ure::void_t   operator()( slot_t& slot ) const noexcept
+    { atlas->release( slot ); }
+  };
+
+  using entries_t = LruCache<slot_t, release_t>;
+  using stats_t   = entries_t::stats_t;
+
+  /***/
+  TileCache( TileAtlas& atlas, std::size_t budget ) noexcept(true);
+
+  /**
+   * Return the atlas slot holding @p key, or std::nullopt if not loaded.
+   * Hits mark the entry as in use for the current frame.
+   */
+  std::optional<slot_t>  find( const TileKey& key ) noexcept(true);
+  /**
+   * Same as find() but a miss is not counted, for fallback lookups that never fetch.
+   */
+  std::optional<slot_t>  find_resident( const TileKey& key ) noexcept(true);
+  /***/
+  ure::bool_t   contains( const TileKey& key ) const noexcept(true)
+  { return m_entries.contains( key ); }
+  /**
+   * Add a tile occupying @p bytes of GPU memory and evict entries over budget.
+   * Return false if @p key is already in the cache, @p slot is not taken in that case.
+   */
+  ure::bool_t   insert  ( const TileKey& key, const slot_t& slot, std::size_t bytes ) noexcept(true);
+
+  /**
+   * Release all tiles of zoom level @p z, except the ones used in the current frame.
+   */
+  ure::void_t   evict_level( ure::uint_t z ) noexcept(true)
+  { m_entries.evict_level( z ); }
+
+  /**
+   * Start a new frame, entries used in previous frames become evictable.
+   */
+  ure::void_t   begin_frame() noexcept(true)
+  { m_entries.begin_frame(); }
+
+  /***/
+  std::size_t   budget() const noexcept(true)
+  { return m_entries.budget(); }
+  /***/
+  ure::void_t   set_budget( std::size_t budget ) noexcept(true)
+  { m_entries.set_budget( budget ); }
+
+  /***/
+  stats_t       stats() const noexcept(true)
+  { return m_entries.stats(); }
+
+private:
+  entries_t             m_entries;
+};
+
+#endif // TILE_CACHE_H
@@ -0,0 +1,128 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_CONTEXT_H
+#define TILE_CONTEXT_H
+
+#include <ure_size.h>
+
+#include "redraw_signal.h"
+#include "tile_atlas.h"
+#include "tile_batch.h"
+#include "tile_cache.h"
+#include "tile_decoder.h"
+#include "tile_disk_cache.h"
+#include "tile_requests.h"
+#include "tile_scheduler.h"
+#include "tile_url.h"
+
+#include <deque>
+#include <string>
+
+/**
+ * Tile infrastructure shared by all TileLayer instances: tile sources, atlas, caches,
+ * downloads bookkeeping and scheduling, decoder, batch renderer and the redraw signal
+ * raised when tiles become available. Owned by Map, members are declared in
+ * dependency order so that the decoder threads stop before anything they use.
+ *
+ * Sources are stacked, e.g. base map, hillshade and labels, every level draws all of
+ * them in a single batch. Their tiles share the atlas, caches and download slots,
+ * TileKey::source tells them apart.
+ */
+class TileContext
+{
+public:
+  /***/
+  TileContext( const ure::Size& tile_size, std::size_t cache_budget ) noexcept(true);
+
+  /**
+   * Set shaders location and open the disk cache in @p cache_path.
+   */
+  ure::bool_t       initialize( const std::string& shaders_path, const std::string& cache_path ) noexcept(true);
+
+  /**
+   * Store tiles in @p requested, or the closest format supported by the GL context which
+   * must be current. Call before the first tile is requested, return the format in use.
+   */
+  TileImage::format_t  set_texture_format( TileImage::format_t requested ) noexcept(true);
+
+  /**
+   * Release GL resources, must be called before the GL context is destroyed.
+   */
+  ure::void_t       dispose() noexcept(true);
+
+  /** Sources drawn over each other, bounded by the layers of the batch */
+  static constexpr ure::uint_t  max_sources()
+  { return TileBatch::max_layers(); }
+
+  /**
+   * Stack the tiles of @p url over those of the sources added before, the first one is
+   * the base map. Return the source identifier, or max_sources() if there is no room left.
+   */
+  ure::uint_t       add_source( const std::string& url, ure::float_t opacity = 1.0f ) noexcept(true);
+  /***/
+  ure::uint_t       sources() const noexcept
+  { return static_cast<ure::uint_t>( m_sources.size() ); }
+  /** URL template of @p source, which must exist */
+  const TileUrl&    source_url( ure::uint_t source ) const noexcept
+  { return m_sources[source]; }
+
+  /**
+   * Opacity of @p source, only a uniform changes. Transparent sources are neither drawn nor fetched.
+   */
+  ure::void_t       set_source_opacity( ure::uint_t source, ure::float_t opacity ) noexcept(true)
+  { m_batch.set_layer_opacity( source, opacity ); }
+  /***/
+  ure::float_t      source_opacity( ure::uint_t source ) const noexcept(true)
+  { return m_batch.layer_opacity( source ); }
+
+  /***/
+  constexpr const ure::Size& tile_size() const noexcept
+  { return m_tile_size; }
+  /** GPU memory used by a single tile */
+  std::size_t                tile_bytes() const noexcept
+  { return TileImage::size( m_atlas.format(), m_tile_size.width, m_tile_size.height ); }
+
+  /***/
+  TileAtlas&        atlas()    noexcept { return m_atlas;    }
+  /***/
+  TileCache&        cache()    noexcept { return m_cache;    }
+  /***/
+  TileRequests&     requests() noexcept { return m_requests; }
+  /***/
+  TileScheduler&    scheduler() noexcept { return m_scheduler; }
+  /***/
+  TileDiskCache&    disk()     noexcept { return m_disk;     }
+  /***/
+  TileDecoder&      decoder()  noexcept { return m_decoder;  }
+  /***/
+  TileBatch&        batch()    noexcept { return m_batch;    }
+  /***/
+  RedrawSignal&     redraw()   noexcept { return m_redraw;   }
+
+private:
+  const ure::Size   m_tile_size;
+  std::deque<TileUrl> m_sources;     /* Referenced by queued downloads, a deque keeps them in place */
+  RedrawSignal      m_redraw;
+  TileAtlas         m_atlas;
+  TileCache         m_cache;
+  TileRequests      m_requests;
+  TileScheduler     m_scheduler;
+  TileDiskCache     m_disk;
+  TileDecoder       m_decoder;
+  TileBatch         m_batch;
+};
+
+#endif // TILE_CONTEXT_H
@@ -0,0 +1,141 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_DECODER_H
+#define TILE_DECODER_H
+
+#include "redraw_signal.h"
+#include "tile_atlas.h"
+#include "tile_cache.h"
+#include "tile_disk_cache.h"
+#include "tile_image.h"
+#include "tile_requests.h"
+#include "tile_worker_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+/**
+ * Decode downloaded tiles on a pool of worker threads.
+ *
+ * submit() copies the encoded bytes and returns immediately, workers of a TileWorkerPool
+ * decode them to RGBA, convert them to the atlas format and hand the result to the main
+ * thread through its lock-free queue.
+ * upload() must be called from the thread owning the GL context, it copies the
+ * pixels in a TileAtlas slot, stores it in the TileCache and completes the request
+ * in TileRequests.
+ * Downloaded payloads that decode successfully are also persisted in the TileDiskCache,
+ * already compressed when the format is ETC2 so that later loads skip both decoding and
+ * encoding; disk payloads already in the decoder format are copied as they are.
+ * Overview tiles can also be built from their four cached children with TilePyramid.
+ * A redraw is requested every time a decoded tile is ready for upload.
+ */
+class TileDecoder
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * @param workers  number of decoding threads, 0 to use all but one hardware thread.
+   */
+  TileDecoder( TileAtlas& atlas, TileCache& cache, TileRequests& requests, TileDiskCache& disk, RedrawSignal& redraw, std::size_t tile_bytes, ure::uint_t workers = 0 ) noexcept(true);
+  /***/
+  ~TileDecoder() noexcept(true);
+
+  /**
+   * Pixel format produced by the workers and GPU memory accounted for each tile,
+   * set before the first submit() to the format of the TileAtlas.
+   */
+  ure::void_t   set_format( TileImage::format_t format, std::size_t tile_bytes ) noexcept(true);
+  /***/
+  TileImage::format_t   format() const noexcept(true)
+  { return m_format.load(); }
+
+  /**
+   * Queue downloaded @p data for decoding, @p key identify the request in TileRequests.
+   * Data is copied, the caller buffer can be released on return.
+   */
+  ure::void_t   submit( const TileKey& key, const ure::byte_t* data, ure::uint_t length ) noexcept(true);
+  /**
+   * Queue a payload found in the TileDiskCache, decoded straight from the mapped pack
+   * or copied when already in format().
+   */
+  ure::void_t   submit( const TileKey& key, TileDiskCache::blob_t&& blob ) noexcept(true);
+  /**
+   * Queue the four cached children of @p key, in TilePyramid::child() order, to be
+   * downsampled into @p key instead of downloading it.
+   */
+  ure::void_t   submit( const TileKey& key, std::vector<TileDiskCache::blob_t>&& children ) noexcept(true);
+
+  /**
+   * Upload decoded tiles to the atlas, at most @p max_count of them and stopping
+   * once @p budget is elapsed or @p max_bytes of pixels have been copied.
+   * Return the number of tiles uploaded.
+   */
+  ure::uint_t   upload( ure::uint_t max_count, clock_t::duration budget,
+                        std::size_t max_bytes = std::numeric_limits<std::size_t>::max() ) noexcept(true);
+
+  /**
+   * Tiles submitted and not yet uploaded.
+   */
+  ure::uint_t   pending() const noexcept(true);
+  /**
+   * Tiles decoded and waiting for upload().
+   */
+  ure::uint_t   ready() const noexcept(true);
+
+private:
+  struct job_t
+  {
+    TileKey                   key;
+    TileDiskCache::blob_t     blob;            /* Owner is either a pack mapping or a download copy */
+    std::vector<TileDiskCache::blob_t>  children;  /* Cached children to downsample, blob is empty */
+    ure::bool_t               persist;         /* Store in the disk cache once decoded */
+  };
+
+  struct decoded_t
+  {
+    TileKey                   key;
+    TileImage                 image;
+    ure::bool_t               valid;
+  };
+
+  using workers_t = TileWorkerPool<job_t, decoded_t>;
+
+  /**
+   * Worker step, decode @p job in @p tile and update the disk cache.
+   */
+  ure::bool_t   decode( job_t& job, decoded_t& tile ) noexcept(true);
+  /**
+   * Decode an encoded payload or copy stored pixels, false if they do not match the atlas tiles.
+   */
+  ure::bool_t   read( const TileDiskCache::blob_t& blob, TileImage& image ) const noexcept(true);
+  /**
+   * Downsample four children payloads to their parent in RGBA8.
+   */
+  ure::bool_t   build( const std::vector<TileDiskCache::blob_t>& children, TileImage& image ) const noexcept(true);
+
+  TileAtlas&                    m_atlas;
+  TileCache&                    m_cache;
+  TileDiskCache&                m_disk;
+  std::size_t                   m_tile_bytes;      /* GPU memory accounted for a single tile */
+  std::atomic<TileImage::format_t>  m_format;      /* Read by the workers */
+
+  workers_t                     m_workers;         /* Last, threads are joined before the members they use */
+};
+
+#endif // TILE_DECODER_H
@@ -0,0 +1,160 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_DISK_CACHE_H
+#define TILE_DISK_CACHE_H
+
+#include <ure_utils.h>
+
+#include "tile_image.h"
+#include "tile_key.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+/**
+ * Persistent cache of tiles, stored in append-only pack files.
+ *
+ * Each pack is a pair of files in the cache directory:
+ *  - pack-NNNNNN.dat  raw tile payloads, appended one after the other;
+ *  - pack-NNNNNN.idx  fixed size records { key, offset, length, format } appended after the payload,
+ *                     so that a payload without record (e.g. crash while writing) is ignored.
+ *                     A record with no length is a tombstone, it hides older records of the key.
+ *
+ * The tile source is stored next to the format, tiles of stacked sources share the packs.
+ *
+ * Payloads are either encoded images as downloaded or pixels already transcoded to a GPU
+ * format, the record tells which one; packs written before formats existed read as encoded.
+ *
+ * Packs are read through read-only memory mappings, find() returns a view on the mapped
+ * file and no copy is done. The active pack is mapped up to its full capacity, so that
+ * it is not mapped again every time it grows. When the total size exceeds the cap, the
+ * oldest pack is removed.
+ *
+ * All methods are thread safe. Writers only hold the index lock to publish a record,
+ * find() never waits on disk writes.
+ */
+class TileDiskCache
+{
+public:
+  /**
+   * Read-only view on a cached payload; keep the mapping alive as long as it is referenced.
+   */
+  struct blob_t
+  {
+    std::shared_ptr<const void>   owner;
+    const ure::byte_t*            data;
+    ure::uint_t                   length;
+    TileImage::format_t           format = TileImage::format_t::encoded;
+  };
+
+  /***/
+  TileDiskCache( std::uint64_t max_bytes = std::uint64_t(512) << 20, std::uint64_t pack_bytes = std::uint64_t(32) << 20 ) noexcept(true);
+  /***/
+  ~TileDiskCache() noexcept(true);
+
+  /**
+   * Open or create the cache in @p path and load the index of all packs.
+   * An empty @p path leaves the cache disabled.
+   */
+  ure::bool_t             open( const std::filesystem::path& path ) noexcept(true);
+  /***/
+  ure::void_t             close() noexcept(true);
+  /***/
+  ure::bool_t             is_open() const noexcept(true);
+
+  /***/
+  std::optional<blob_t>   find ( const TileKey& key ) noexcept(true);
+  /**
+   * Append @p data to the active pack, a newer entry replaces an older one for the same key.
+   */
+  ure::bool_t             store( const TileKey& key, const ure::byte_t* data, ure::uint_t length,
+                                 TileImage::format_t format = TileImage::format_t::encoded ) noexcept(true);
+  /**
+   * Forget @p key, e.g. when the payload can not be decoded, also on the next open().
+   * Space is reclaimed with the pack.
+   */
+  ure::void_t             erase( const TileKey& key ) noexcept(true);
+
+  /***/
+  std::uint64_t           size() const noexcept(true);
+
+private:
+  struct record_t
+  {
+    std::uint64_t   key;         /* TileKey::packed() */
+    std::uint64_t   offset;
+    std::uint32_t   length;
+    std::uint32_t   format;      /* TileImage::format_t in the low byte, TileKey::source above; was reserved and always 0 */
+  };
+
+  struct location_t
+  {
+    ure::uint_t           pack;
+    std::uint64_t         offset;
+    std::uint32_t         length;
+    TileImage::format_t   format;
+  };
+
+  class Mapping;
+
+  /**
+   * Sizes and mapping are guarded by m_mutex, files by m_write_mutex.
+   */
+  struct pack_t
+  {
+    std::uint64_t                   size;        /* Bytes of the data file referenced by published records */
+    std::uint64_t                   indexed;     /* Bytes of the index file, published records */
+    std::shared_ptr<const Mapping>  mapping;     /* Current mapping, replaced when the pack outgrows it */
+    std::FILE*                      data;        /* Active pack only, open for appending */
+    std::FILE*                      index;       /* Active pack only, open for appending */
+  };
+
+  /***/
+  std::filesystem::path   pack_path( ure::uint_t pack, const char* ext ) const noexcept(true);
+  /***/
+  ure::bool_t             load_pack( ure::uint_t pack ) noexcept(true);
+  /**
+   * Create pack @p pack and make it the active one, m_write_mutex must be held.
+   */
+  ure::bool_t             open_active( ure::uint_t pack ) noexcept(true);
+  /**
+   * Close the active pack, truncated to its published records, m_write_mutex must be held.
+   */
+  ure::void_t             seal_active() noexcept(true);
+  /***/
+  ure::void_t             drop_oldest() noexcept(true);
+
+private:
+  const std::uint64_t                           m_max_bytes;
+  const std::uint64_t                           m_pack_bytes;
+  std::mutex                                    m_write_mutex; /* Serializes writers to the active pack */
+  mutable std::mutex                            m_mutex;     /* Index, packs and sizes */
+  std::filesystem::path                         m_path;
+  std::map<ure::uint_t, pack_t>                 m_packs;     /* Oldest first, last one is the active pack */
+  std::unordered_map<TileKey, location_t>       m_index;
+  std::uint64_t                                 m_size;
+  ure::bool_t                                   m_open;
+  pack_t*                                       m_active;    /* Last of m_packs, null when nothing can be stored */
+  ure::uint_t                                   m_active_id;
+};
+
+#endif // TILE_DISK_CACHE_H
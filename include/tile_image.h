@@ -0,0 +1,83 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_IMAGE_H
+#define TILE_IMAGE_H
+
+#include <ure_utils.h>
+
+#include <vector>
+
+/**
+ * Decoded tile, pixels top row first in one of the GPU formats.
+ *
+ * decode() always produces RGBA8, convert() reduces it to a smaller format on the
+ * decode workers so that only the final bytes reach the main thread and the atlas.
+ */
+struct TileImage
+{
+  enum class format_t : ure::uint_t
+  {
+    encoded   = 0,    /* Not a pixel format, PNG, JPEG, ... as downloaded */
+    rgba8     = 1,    /* 4 bytes per pixel */
+    rgb565    = 2,    /* 2 bytes per pixel, native endian */
+    etc2_rgb8 = 3     /* 4x4 blocks of 8 bytes, alpha is dropped */
+  };
+
+  ure::uint_t                 width;
+  ure::uint_t                 height;
+  format_t                    format = format_t::rgba8;
+  std::vector<ure::byte_t>    pixels;
+
+  /**
+   * Decode an encoded image (PNG, JPEG, ...) and expand it to RGBA8.
+   */
+  static ure::bool_t decode( const ure::byte_t* data, ure::uint_t length, TileImage& image ) noexcept(true);
+
+  /**
+   * Reduce an RGBA8 image to @p target in place.
+   * Return false if the image is not RGBA8 or its size does not fit the target.
+   */
+  ure::bool_t convert( format_t target ) noexcept(true);
+
+  /**
+   * Back to RGBA8 from any pixel format, what was lost by convert() is not restored.
+   * Return false for encoded images or a size that does not fit the format.
+   */
+  ure::bool_t expand() noexcept(true);
+
+  /**
+   * Bytes of a @p width x @p height image stored as @p format, 0 for encoded images.
+   */
+  static constexpr std::size_t  size( format_t format, ure::uint_t width, ure::uint_t height ) noexcept
+  {
+    switch ( format )
+    {
+      case format_t::rgba8:     return std::size_t(width) * height * 4;
+      case format_t::rgb565:    return std::size_t(width) * height * 2;
+      case format_t::etc2_rgb8: return std::size_t(width) * height / 2;
+      default:                  return 0;
+    }
+  }
+
+  /***/
+  static const char*  name( format_t format ) noexcept(true);
+
+  /***/
+  constexpr std::size_t bytes() const noexcept
+  { return size( format, width, height ); }
+};
+
+#endif // TILE_IMAGE_H
@@ -0,0 +1,124 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_KEY_H
+#define TILE_KEY_H
+
+#include <ure_utils.h>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+/**
+ * Identify a single tile by zoom level and column/row at that level, plus the
+ * tile source it comes from when several sources are stacked, 0 for the base map.
+ */
+struct TileKey
+{
+  /** Bits reserved to x and y in packed(), z uses the remaining 6 bits. */
+  static constexpr ure::uint_t  xy_bits   = 29;
+  /** Buffer size required by name(), "z-x-y-source" with four 32 bits values. */
+  static constexpr std::size_t  name_size = 4 * 10 + 3 + 1;
+
+  ure::uint_t   z;
+  ure::uint_t   x;
+  ure::uint_t   y;
+  ure::uint_t   source = 0;
+
+  /***/
+  constexpr ure::bool_t operator==( const TileKey& rhs ) const noexcept
+  { return (z==rhs.z) && (x==rhs.x) && (y==rhs.y) && (source==rhs.source); }
+
+  /**
+   * Key packed in 64 bits as z:6 x:29 y:29, unique up to level 29.
+   * Same layout used by the TileDiskCache index files, source is not included.
+   */
+  constexpr std::uint64_t packed() const noexcept
+  { return ( std::uint64_t(z) << ( 2 * xy_bits ) ) | ( std::uint64_t(x) << xy_bits ) | std::uint64_t(y); }
+
+  /***/
+  static constexpr TileKey unpack( std::uint64_t packed ) noexcept
+  {
+    const std::uint64_t mask = ( std::uint64_t(1) << xy_bits ) - 1;
+
+    return TileKey{ static_cast<ure::uint_t>( packed >> ( 2 * xy_bits ) ), static_cast<ure::uint_t>( ( packed >> xy_bits ) & mask ), static_cast<ure::uint_t>( packed & mask ) };
+  }
+
+  /**
+   * Write the "z-x-y" resource name in @p buffer, without heap allocations.
+   * Tiles of other sources than the base map are named "z-x-y-source".
+   * Returned view refers to @p buffer.
+   */
+  std::string_view name( char (&buffer)[name_size] ) const noexcept
+  {
+    char*             last      = buffer + name_size;
+    char*             ptr       = buffer;
+    const ure::uint_t fields[4] = { z, x, y, source };
+
+    for ( std::size_t i = 0; i < ( ( source > 0 ) ? 4 : 3 ); ++i )
+    {
+      if ( i > 0 )
+        *ptr++ = '-';
+
+      ptr = std::to_chars( ptr, last, fields[i] ).ptr;
+    }
+
+    return std::string_view( buffer, static_cast<std::size_t>( ptr - buffer ) );
+  }
+
+  /**
+   * Parse a resource name in the "z-x-y" or "z-x-y-source" form used when fetching tiles.
+   */
+  static std::optional<TileKey> parse( std::string_view name ) noexcept
+  {
+    TileKey      key{};
+    ure::uint_t* fields[4] = { &key.z, &key.x, &key.y, &key.source };
+    const char*  first     = name.data();
+    const char*  last      = name.data() + name.size();
+
+    for ( std::size_t i = 0; i < 4; ++i )
+    {
+      auto [ptr, ec] = std::from_chars( first, last, *fields[i] );
+      if ( ec != std::errc() )
+        return std::nullopt;
+
+      // Source is optional
+      if ( ptr == last )
+        return ( i >= 2 ) ? std::optional<TileKey>( key ) : std::nullopt;
+
+      if ( ( i == 3 ) || ( *ptr != '-' ) )
+        return std::nullopt;
+
+      first = ptr + 1;
+    }
+
+    return key;
+  }
+};
+
+template<>
+struct std::hash<TileKey>
+{
+  std::size_t operator()( const TileKey& key ) const noexcept
+  {
+    return std::hash<std::uint64_t>{}( key.packed() ^ ( std::uint64_t(key.source) * 0x9E3779B97F4A7C15ull ) );
+  }
+};
+
+#endif // TILE_KEY_H
@@ -0,0 +1,152 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_LEVEL_H
+#define TILE_LEVEL_H
+
+#include <ure_resources_fetcher_events.h>
+
+#include "tile_context.h"
+#include "tile_range.h"
+
+/**
+ * Tiles of a single zoom level: visible range selection, requests, fallback to other
+ * levels and drawing through the shared TileBatch.
+ *
+ * Every source of the TileContext is drawn, each one in its own batch layer so that
+ * all sources of the level cost a single commit and draw.
+ *
+ * Independent from the widgets toolkit, TileLayer puts it in the scene graph while
+ * the benchmark harness drives it directly.
+ */
+class TileLevel : public ure::ResourcesFetcherEvents
+{
+public:
+  /***/
+  TileLevel( TileContext& tiles, ure::word_t zoom ) noexcept(true);
+  /** */
+  virtual ~TileLevel() noexcept(true);
+
+  /***/
+  constexpr ure::word_t  zoom() const
+  { return m_zoom_level; }
+
+  /**
+   * Move to another zoom level, used to recycle levels no longer in use.
+   */
+  ure::void_t            set_zoom( ure::word_t zoom ) noexcept(true);
+
+  /**
+   * Update model matrix and viewport size used to select the visible tiles.
+   * Must be called every time the scene node model matrix changes.
+   */
+  ure::void_t            set_view( const glm::mat4& model, const ure::Size& viewport ) noexcept(true);
+
+  /**
+   * Position of tile (0,0) in model coordinates.
+   */
+  ure::void_t            set_origin( const glm::vec2& origin ) noexcept(true)
+  { m_origin = origin; }
+
+  /**
+   * Number of tiles around the visible area that are also drawn and fetched.
+   */
+  constexpr ure::int_t   margin() const
+  { return m_margin; }
+  /***/
+  constexpr ure::void_t  set_margin( ure::int_t margin )
+  { m_margin = margin; }
+
+  /**
+   * Number of levels searched for a loaded tile to draw while a tile is missing.
+   */
+  constexpr ure::uint_t  fallback_levels() const
+  { return m_fallback_levels; }
+  /***/
+  constexpr ure::void_t  set_fallback_levels( ure::uint_t levels )
+  { m_fallback_levels = levels; }
+
+  /**
+   * Range of tiles intersecting the viewport plus margin().
+   */
+  TileRange              visible_range() const noexcept(true);
+
+  /**
+   * Draw @p overlay, another zoom level, over this one with @p opacity.
+   * The overlay is drawn by draw() to control the order.
+   */
+  ure::void_t            set_overlay( TileLevel* overlay, ure::float_t opacity ) noexcept(true);
+
+  /**
+   * Draw this level and its overlay, if any.
+   */
+  ure::void_t            draw() noexcept(true);
+
+  /**
+   * Draw the visible tiles, filling missing ones from other levels, and request
+   * the missing ones. Vertices are only rebuilt when the drawn tiles change.
+   */
+  ure::void_t            draw_tiles( ure::float_t opacity ) noexcept(true);
+
+  /**
+   * Request up to @p budget tiles, not yet loaded, visible with a predicted @p model.
+   * Tiles are requested at prefetch priority, return the number of requests issued.
+   */
+  ure::uint_t            prefetch( const glm::mat4& model, const ure::Size& viewport, ure::uint_t budget ) noexcept(true);
+
+/* ure::ResourcesFetcherEvents implementation */
+protected:  
+  /***/
+  virtual ure::void_t on_download_succeeded( [[maybe_unused]] std::string_view name, [[maybe_unused]] const std::type_info& type, [[maybe_unused]] const ure::byte_t* data, [[maybe_unused]] ure::uint_t length ) noexcept(true) override;
+  /***/
+  virtual ure::void_t on_download_failed   ( [[maybe_unused]] std::string_view name ) noexcept(true) override;
+
+private:
+  /**
+   * Load @p key from the disk cache, build it from cached children or queue its download,
+   * unless already requested.
+   * @p distance from the viewport centre, in tiles, orders the download queue.
+   * Return true if a request has been issued.
+   */
+  ure::bool_t               request_tile( const TileKey& key, ure::bool_t prefetch, ure::float_t distance ) noexcept(true);
+  /**
+   * Queue @p key to be built from its four children when all of them are in the disk cache.
+   */
+  ure::bool_t               build_from_children( const TileKey& key ) noexcept(true);
+  /**
+   * Draw @p quad with resident tiles of the next level or of an ancestor level.
+   * Cache only, nothing is fetched. Return false if nothing has been found.
+   */
+  ure::bool_t               add_fallback( const TileKey& key, const glm::vec4& quad ) noexcept(true);
+  /** Size of a single tile in layer coordinates, the same at all levels so that they can be blended. */
+  glm::vec2                 tile_extent() const noexcept(true);
+
+private:
+  TileContext&              m_tiles;             /* Atlas, caches, downloads and renderer shared with other levels */
+  const ure::Size           m_tile_size;         /* Size of single tile */
+  ure::int_t                m_zoom_level;
+  ure::uint_t               m_max_tiles;         /* Tiles per side, 2^zoom does not fit a word_t past level 15 */
+  ure::Size                 m_tile_area;         /* Size of the full area covered by all tiles */ 
+  glm::mat4                 m_model;             /* Model matrix of the scene node drawing this level */
+  ure::Size                 m_viewport;          /* Viewport size in pixels */
+  glm::vec2                 m_origin;            /* Position of tile (0,0) in model coordinates */
+  ure::int_t                m_margin;            /* Tiles drawn outside the viewport on every side */
+  ure::uint_t               m_fallback_levels;   /* Ancestor levels searched for missing tiles */
+  const ure::uint_t         m_geometry;          /* Retained vertices in the TileBatch */
+  TileLevel*                m_overlay;           /* Level drawn over this one while zooming */
+  ure::float_t              m_overlay_opacity;
+};
+
+#endif // TILE_LEVEL_H
@@ -0,0 +1,79 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_PREFETCHER_H
+#define TILE_PREFETCHER_H
+
+#include <ure_utils.h>
+
+#include <chrono>
+
+#include <glm/glm.hpp>
+
+/**
+ * Predict where the viewport is going from recent input.
+ *
+ * Pan velocity is an exponential moving average of the translations applied to the
+ * model matrix, zoom direction is the sign of the last scroll. Both expire when the
+ * input stops, so an idle map does not prefetch anything.
+ * The outstanding budget caps prefetch downloads, visible tiles always go first.
+ */
+class TilePrefetcher
+{
+public:
+  using clock_t    = std::chrono::steady_clock;
+  using duration_t = clock_t::duration;
+
+  /**
+   * @param lookahead  how far in the future the viewport is predicted.
+   * @param budget     max prefetch downloads pending at the same time.
+   * @param visible    prefetch is suspended while more visible downloads than this are pending.
+   */
+  TilePrefetcher( duration_t lookahead = std::chrono::milliseconds(300), ure::uint_t budget = 8, ure::uint_t visible = 16 ) noexcept(true);
+
+  /**
+   * Model translation ( @p dx, @p dy ) applied by a pan at @p now.
+   */
+  ure::void_t   on_pan ( ure::float_t dx, ure::float_t dy, clock_t::time_point now = clock_t::now() ) noexcept(true);
+  /**
+   * Scroll at @p now, @p direction > 0 zooming in, < 0 zooming out.
+   */
+  ure::void_t   on_zoom( ure::int_t direction, clock_t::time_point now = clock_t::now() ) noexcept(true);
+
+  /**
+   * Translation expected on the model matrix within the lookahead time.
+   */
+  glm::vec2     predicted_offset( clock_t::time_point now = clock_t::now() ) const noexcept(true);
+  /**
+   * +1 or -1 while the user is zooming in or out, 0 otherwise.
+   */
+  ure::int_t    zoom_direction( clock_t::time_point now = clock_t::now() ) const noexcept(true);
+
+  /**
+   * Number of prefetch downloads that can be issued given the pending ones.
+   */
+  ure::uint_t   available( ure::uint_t pending, ure::uint_t pending_prefetch ) const noexcept(true);
+
+private:
+  const duration_t      m_lookahead;
+  const ure::uint_t     m_budget;
+  const ure::uint_t     m_visible;
+  glm::vec2             m_velocity;       /* Model units per second */
+  clock_t::time_point   m_last_pan;
+  ure::int_t            m_zoom;
+  clock_t::time_point   m_last_zoom;
+};
+
+#endif // TILE_PREFETCHER_H
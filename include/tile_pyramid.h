@@ -0,0 +1,53 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include "tile_image.h"
+#include "tile_key.h"
+
+/**
+ * Build a tile from its four children at the next zoom level.
+ *
+ * Each child is reduced to a quadrant of the parent with a 2x2 box filter, which
+ * for an exact 2:1 reduction is close to what the server renders and a fraction of
+ * the cost of a Lanczos kernel. Rows are filtered with SSE2 or NEON where available.
+ * Used at runtime to fill overview tiles from cached children, and by the
+ * tile_pyramid tool to pre-build packs for a region.
+ */
+class TilePyramid
+{
+public:
+  /**
+   * Child @p index of @p parent: 0 top-left, 1 top-right, 2 bottom-left, 3 bottom-right.
+   * Children come from the same source as @p parent.
+   */
+  static constexpr TileKey  child( const TileKey& parent, ure::uint_t index ) noexcept
+  { return TileKey{ parent.z + 1, parent.x * 2 + ( index & 1 ), parent.y * 2 + ( index >> 1 ), parent.source }; }
+
+  /**
+   * Downsample @p children, in child() order, to @p parent of the same size.
+   * Children must be RGBA8 with equal, even, sizes; the parent is RGBA8.
+   */
+  static ure::bool_t  downsample( const TileImage* const (&children)[4], TileImage& parent ) noexcept(true);
+
+  /**
+   * Average 2x2 blocks of two RGBA8 rows into @p count pixels of @p dst.
+   */
+  static ure::void_t  downsample_rows( const ure::byte_t* row0, const ure::byte_t* row1, ure::uint_t count, ure::byte_t* dst ) noexcept(true);
+};
+
+#endif // TILE_PYRAMID_H
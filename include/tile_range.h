@@ -0,0 +1,83 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_RANGE_H
+#define TILE_RANGE_H
+
+#include <ure_position.h>
+#include <ure_size.h>
+
+#include <glm/glm.hpp>
+
+/**
+ * Inclusive range of tile indexes [x0,x1] x [y0,y1] for a single zoom level.
+ * An empty range has x1 < x0 or y1 < y0.
+ */
+struct TileRange
+{
+  ure::int_t  x0;
+  ure::int_t  y0;
+  ure::int_t  x1;
+  ure::int_t  y1;
+
+  /***/
+  constexpr ure::bool_t empty() const noexcept
+  { return (x1 < x0) || (y1 < y0); }
+
+  /***/
+  constexpr ure::bool_t contains( ure::int_t x, ure::int_t y ) const noexcept
+  { return (x >= x0) && (x <= x1) && (y >= y0) && (y <= y1); }
+
+  /***/
+  constexpr ure::uint_t count() const noexcept
+  { return empty()?0:static_cast<ure::uint_t>(x1-x0+1)*static_cast<ure::uint_t>(y1-y0+1); }
+
+  /***/
+  constexpr ure::bool_t operator==( const TileRange& rhs ) const noexcept
+  { return (x0==rhs.x0) && (y0==rhs.y0) && (x1==rhs.x1) && (y1==rhs.y1); }
+};
+
+/**
+ * Bounding box in layer space of a viewport of @p viewport pixels, drawn with @p model.
+ * Return false, leaving @p min and @p max unchanged, if @p model can not be inverted.
+ */
+ure::bool_t  visible_area( const glm::mat4& model, const ure::Size& viewport, glm::vec2& min, glm::vec2& max ) noexcept(true);
+
+/**
+ * Compute the tiles of a zoom level that intersect the viewport.
+ *
+ * @param model      model matrix of the layer, including the orthographic projection
+ *                   and the translation applied while panning.
+ * @param viewport   size in pixels of the area the layer is rendered into.
+ * @param origin     position of tile (0,0) in layer coordinates.
+ * @param tile_size  size of a single tile in layer coordinates.
+ * @param max_tiles  number of tiles per side at this zoom level.
+ * @param margin     number of extra tiles to include on every side.
+ *
+ * The viewport corners are mapped back in layer space through the inverse of @p model,
+ * so cost is proportional to the visible area and not to the zoom level.
+ */
+TileRange  visible_tile_range( const glm::mat4& model, const ure::Size& viewport,
+                               const glm::vec2& origin, const glm::vec2& tile_size,
+                               ure::uint_t max_tiles, ure::int_t margin ) noexcept(true);
+
+/**
+ * Tiles of level @p zoom covering a longitude/latitude box in degrees, Web Mercator
+ * as used by OpenStreetMap. Latitudes are clamped to the +/-85.0511 projection limit.
+ */
+TileRange  geo_tile_range( ure::double_t west, ure::double_t south, ure::double_t east, ure::double_t north,
+                           ure::uint_t zoom ) noexcept(true);
+
+#endif // TILE_RANGE_H
@@ -0,0 +1,111 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_REQUESTS_H
+#define TILE_REQUESTS_H
+
+#include <ure_utils.h>
+
+#include "tile_key.h"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+/**
+ * Registry of tile downloads, shared by all TileLayer instances.
+ *
+ * Tiles are identified by TileKey, lookups do not allocate.
+ * A tile is fetched only when acquire() returns true, then stays pending until
+ * succeeded() or failed() is called from the ResourcesFetcherEvents callbacks.
+ * Failed tiles are retried with an exponential backoff, so that a tile server
+ * rate-limiting us is not hammered at frame rate.
+ *
+ * All methods are thread safe, fetcher callbacks are not invoked on the main thread.
+ */
+class TileRequests
+{
+public:
+  using clock_t    = std::chrono::steady_clock;
+  using duration_t = clock_t::duration;
+
+  /***/
+  TileRequests( duration_t min_backoff = std::chrono::milliseconds(500), duration_t max_backoff = std::chrono::seconds(60) ) noexcept(true);
+
+  /**
+   * Return true when the caller must issue the download for @p key.
+   * In that case the tile is marked as pending and further calls return false
+   * until the download completes or the retry delay after a failure expires.
+   * A visible request for a tile already pending as @p prefetch promotes it.
+   */
+  ure::bool_t   acquire  ( const TileKey& key, ure::bool_t prefetch = false, clock_t::time_point now = clock_t::now() ) noexcept(true);
+  /**
+   * Download completed, the tile is removed from the registry.
+   */
+  ure::void_t   succeeded( const TileKey& key ) noexcept(true);
+  /**
+   * Download failed, next attempt is delayed by min_backoff * 2^(failures-1)
+   * with up to 25% jitter, capped at max_backoff.
+   */
+  ure::void_t   failed   ( const TileKey& key, clock_t::time_point now = clock_t::now() ) noexcept(true);
+
+  /**
+   * Download withdrawn before being issued, the tile is removed from the registry
+   * without counting as a failure.
+   */
+  ure::void_t   cancel   ( const TileKey& key ) noexcept(true);
+
+  /**
+   * Forget failed tiles not requested again within max_backoff of their retry time,
+   * so that tiles left behind while panning do not stay in the registry forever.
+   * Scans at most once every min_backoff, meant to be called every frame.
+   */
+  ure::void_t   prune    ( clock_t::time_point now = clock_t::now() ) noexcept(true);
+
+  /**
+   * Number of downloads currently pending.
+   */
+  ure::uint_t   pending() const noexcept(true);
+  /**
+   * Number of pending downloads acquired for prefetching and not needed by a frame yet.
+   */
+  ure::uint_t   pending_prefetch() const noexcept(true);
+
+  /**
+   * Check if @p key has been acquired and not yet completed.
+   */
+  ure::bool_t   is_pending( const TileKey& key ) const noexcept(true);
+
+private:
+  struct entry_t
+  {
+    ure::bool_t           pending;
+    ure::bool_t           prefetch;
+    ure::uint_t           failures;
+    clock_t::time_point   retry_at;
+  };
+
+  const duration_t                            m_min_backoff;
+  const duration_t                            m_max_backoff;
+  mutable std::mutex                          m_mutex;
+  std::unordered_map<TileKey, entry_t>        m_entries;
+  ure::uint_t                                 m_pending;
+  ure::uint_t                                 m_pending_prefetch;
+  clock_t::time_point                         m_next_prune;
+  std::minstd_rand                            m_jitter;
+};
+
+#endif // TILE_REQUESTS_H
@@ -0,0 +1,159 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <ure_resources_fetcher_events.h>
+
+#include "tile_key.h"
+#include "tile_requests.h"
+#include "tile_url.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Priority queue of tile downloads in front of ure::ResourcesFetcher.
+ *
+ * Layers queue the tiles they miss, ordered by prefetch/visible, distance from the
+ * current zoom level and distance from the viewport centre. Every frame a queued tile
+ * must be requested again to stay in the queue: dispatch() cancels the ones that left
+ * the visible set, then hands the best ones to the fetcher within a per host limit.
+ * Downloads already handed to the fetcher can not be withdrawn, they simply complete.
+ * Resource name and URL are only generated when a download is dispatched.
+ *
+ * queue(), touch(), begin_frame() and dispatch() are meant for the main thread,
+ * completed() is called from fetcher callbacks; all of them are thread safe.
+ */
+class TileScheduler
+{
+public:
+  using clock_t   = std::chrono::steady_clock;
+  /** Issue a download, @p events must be notified on completion, possibly before returning */
+  using fetcher_t = std::function<ure::void_t( ure::ResourcesFetcherEvents& events, const std::string& name, const std::string& url )>;
+
+  struct stats_t
+  {
+    ure::uint_t     queued;           /* Current queue depth */
+    ure::uint_t     in_flight;        /* Handed to the fetcher and not completed */
+    std::uint64_t   dispatched;
+    std::uint64_t   cancelled;
+    ure::double_t   wait_avg_ms;      /* Time spent in queue before dispatch */
+    ure::double_t   wait_max_ms;
+  };
+
+  /**
+   * @param per_host  max downloads in flight towards the same host.
+   */
+  TileScheduler( TileRequests& requests, ure::uint_t per_host = 6 ) noexcept(true);
+
+  /**
+   * Queue a download acquired in TileRequests. @p distance is measured in tiles
+   * from the viewport centre, @p url and @p events must outlive the download.
+   */
+  ure::void_t   queue( const TileKey& key, const TileUrl& url, ure::float_t distance,
+                       ure::bool_t prefetch, ure::ResourcesFetcherEvents& events ) noexcept(true);
+  /**
+   * Tile still needed in this frame, keep it queued with an updated priority.
+   * Nothing happens if @p key is not queued.
+   */
+  ure::void_t   touch( const TileKey& key, ure::float_t distance, ure::bool_t prefetch ) noexcept(true);
+
+  /**
+   * Notify download completion, succeeded or not.
+   */
+  ure::void_t   completed( const TileKey& key ) noexcept(true);
+
+  /**
+   * Start a new frame for zoom level @p zoom.
+   */
+  ure::void_t   begin_frame( ure::uint_t zoom ) noexcept(true);
+  /**
+   * Cancel tiles not requested in this frame, prune expired failures from TileRequests
+   * and start the best queued downloads.
+   * Return the number of downloads started.
+   */
+  ure::uint_t   dispatch() noexcept(true);
+
+  /***/
+  stats_t       stats() const noexcept(true);
+
+  /**
+   * Replace ure::ResourcesFetcher, used to serve tiles from a local source.
+   * An empty @p fetcher restores the default.
+   */
+  ure::void_t   set_fetcher( fetcher_t fetcher ) noexcept(true);
+
+  /***/
+  ure::uint_t   per_host() const noexcept(true);
+  /**
+   * Change the max downloads in flight per host, downloads already in flight are not affected.
+   */
+  ure::void_t   set_per_host( ure::uint_t per_host ) noexcept(true);
+
+private:
+  struct entry_t
+  {
+    const TileUrl*            url;
+    ure::uint_t               host;
+    ure::float_t              distance;
+    ure::bool_t               prefetch;
+    std::uint64_t             frame;      /* Last frame the tile has been requested */
+    clock_t::time_point       queued_at;
+    ure::ResourcesFetcherEvents*  events;
+  };
+
+  struct fetch_t
+  {
+    TileKey                       key;
+    const TileUrl*                url;
+    ure::ResourcesFetcherEvents*  events;
+  };
+
+  /***/
+  ure::uint_t   host_id( const TileUrl& url ) noexcept(true);
+  /***/
+  ure::float_t  priority( const TileKey& key, const entry_t& entry ) const noexcept(true);
+
+private:
+  TileRequests&                               m_requests;
+  ure::uint_t                                 m_per_host;
+  mutable std::mutex                          m_mutex;
+  std::unordered_map<TileKey, entry_t>        m_queue;
+  std::unordered_map<TileKey, ure::uint_t>    m_in_flight;   /* Host of each download in flight */
+  std::unordered_map<std::string, ure::uint_t>
+                                              m_hosts;       /* Host name to host id */
+  std::vector<ure::uint_t>                    m_host_load;   /* Downloads in flight per host id */
+  std::vector<std::pair<ure::float_t, TileKey>>
+                                              m_order;       /* Dispatch order, reused every frame */
+  ure::uint_t                                 m_zoom;
+  std::vector<fetch_t>                        m_fetches;     /* Selected by dispatch(), main thread only */
+  std::string                                 m_name;        /* Reused buffers for the fetcher arguments */
+  std::string                                 m_url;
+  fetcher_t                                   m_fetcher;
+  std::uint64_t                               m_frame;
+  std::uint64_t                               m_dispatched;
+  std::uint64_t                               m_cancelled;
+  ure::double_t                               m_wait_total_ms;
+  ure::double_t                               m_wait_max_ms;
+};
+
+#endif // TILE_SCHEDULER_H
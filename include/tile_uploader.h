@@ -0,0 +1,89 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_UPLOADER_H
+#define TILE_UPLOADER_H
+
+#include <ure_utils.h>
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Stage tile pixels in a ring of pixel unpack buffers before they are copied to a
+ * texture, so that glTexSubImage2D returns without waiting for the transfer.
+ *
+ * Each upload writes the next buffer of the ring through glMapBufferRange, invalidating
+ * its previous content: the driver hands out fresh storage while earlier transfers
+ * are still in flight instead of stalling. GLES2 and GL 2 contexts have no mappable
+ * buffers, pixels are then passed to glTexSubImage2D from client memory.
+ * All methods must be called from the thread owning the GL context.
+ */
+class TileUploader
+{
+public:
+  /***/
+  TileUploader() noexcept(true);
+  /***/
+  ~TileUploader() noexcept(true);
+
+  /**
+   * Copy @p bytes of @p pixels for the next glTexSubImage2D or glCompressedTexSubImage2D
+   * and return the pointer to pass to it: an offset in the bound unpack buffer, or
+   * @p pixels when they can not be staged. end() must follow the texture call.
+   */
+  const void*   begin( const ure::byte_t* pixels, std::size_t bytes ) noexcept(true);
+  /**
+   * Unbind the unpack buffer bound by begin(), client memory is used again by other calls.
+   */
+  ure::void_t   end() noexcept(true);
+
+  /** True once the first begin() found mappable buffers */
+  ure::bool_t   streaming() const noexcept
+  { return m_streaming; }
+  /** Bytes staged in unpack buffers so far */
+  std::uint64_t streamed() const noexcept
+  { return m_streamed; }
+  /** Bytes passed from client memory so far */
+  std::uint64_t direct() const noexcept
+  { return m_direct; }
+
+  /**
+   * Delete the buffers, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /***/
+  struct buffer_t
+  {
+    GLuint        name;
+    std::size_t   size;           /* Bytes allocated */
+  };
+
+  /***/
+  ure::void_t   init() noexcept(true);
+
+private:
+  ure::bool_t                         m_checked;      /* Context capabilities queried */
+  ure::bool_t                         m_streaming;
+  ure::bool_t                         m_bound;        /* begin() left a buffer bound */
+  std::array<buffer_t, 4>             m_ring;         /* Reused every four uploads, about a frame worth of tiles */
+  std::size_t                         m_next;
+  std::uint64_t                       m_streamed;
+  std::uint64_t                       m_direct;
+};
+
+#endif // TILE_UPLOADER_H
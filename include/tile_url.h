@@ -0,0 +1,69 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_URL_H
+#define TILE_URL_H
+
+#include "tile_key.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Tile URL template compiled once, expanded for each download.
+ *
+ * Placeholders are either printf style "%u", assigned to z, x and y in this order,
+ * or named "{z}", "{x}" and "{y}". "%%" is a literal '%'.
+ * expand() writes in a caller provided string, once its capacity is large enough
+ * no further allocation happens.
+ */
+class TileUrl
+{
+public:
+  /***/
+  explicit TileUrl( const std::string& pattern ) noexcept(true);
+
+  /**
+   * Write the URL of @p key in @p out, previous content is replaced.
+   */
+  ure::void_t           expand( const TileKey& key, std::string& out ) const noexcept(true);
+
+  /***/
+  const std::string&    pattern() const noexcept
+  { return m_pattern; }
+  /** Host name, with port if any, used to limit concurrent downloads per server. */
+  const std::string&    host() const noexcept
+  { return m_host; }
+
+private:
+  enum class field_t : ure::uint_t { literal, z, x, y };
+
+  struct part_t
+  {
+    field_t         field;
+    std::size_t     offset;      /* Literal text in m_pattern */
+    std::size_t     length;
+  };
+
+  /***/
+  ure::void_t           add_literal( std::size_t offset, std::size_t length ) noexcept(true);
+
+private:
+  const std::string     m_pattern;
+  std::string           m_host;
+  std::vector<part_t>   m_parts;
+};
+
+#endif // TILE_URL_H
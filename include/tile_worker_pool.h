@@ -0,0 +1,232 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TILE_WORKER_POOL_H
+#define TILE_WORKER_POOL_H
+
+#include <ure_utils.h>
+
+#include "lockfree_queue.h"
+#include "metrics.h"
+#include "redraw_signal.h"
+#include "tile_requests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Worker threads and completion queue shared by TileDecoder and VectorTileDecoder.
+ *
+ * enqueue() hands a job to the first idle worker, the worker fills a result_t with the
+ * process function it got from the factory, pushes it to a lock-free queue and requests
+ * a redraw. drain() runs on the thread owning the GL context, passes every result to the
+ * upload function and completes its request in TileRequests.
+ * The factory runs once on each worker so that a process function can keep per-thread
+ * buffers. @p job_t and @p result_t carry a TileKey named key, result_t also a valid flag;
+ * the job is reset before its result is queued, releasing the payload it held.
+ */
+template<typename job_t, typename result_t>
+class TileWorkerPool
+{
+public:
+  using clock_t   = std::chrono::steady_clock;
+  using process_t = std::function<ure::bool_t( job_t&, result_t& )>;
+  using factory_t = std::function<process_t()>;
+
+  /**
+   * Outcome of the upload function passed to drain().
+   */
+  enum class upload_t
+  {
+    failed,       /* Request is failed */
+    cached,       /* Already loaded, request succeeded without an upload */
+    uploaded      /* Request succeeded */
+  };
+
+  /**
+   * @param workers  number of threads, 0 to use all but one hardware thread.
+   */
+  TileWorkerPool( TileRequests& requests, RedrawSignal& redraw, factory_t factory, ure::uint_t workers ) noexcept
+    : m_requests(requests), m_redraw(redraw), m_factory( std::move(factory) ), m_stop(false), m_results( 1024 ), m_pending(0)
+  {
+    if ( workers == 0 )
+    {
+      const ure::uint_t hw = std::thread::hardware_concurrency();
+
+      workers = std::max<ure::uint_t>( 1, ( hw > 1 ) ? hw - 1 : 1 );
+    }
+
+    m_workers.reserve( workers );
+
+    for ( ure::uint_t i = 0; i < workers; ++i )
+      m_workers.emplace_back( &TileWorkerPool::worker, this );
+  }
+
+  /***/
+  ~TileWorkerPool() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for ( auto& thread : m_workers )
+    {
+      if ( thread.joinable() )
+        thread.join();
+    }
+  }
+
+  TileWorkerPool( const TileWorkerPool& ) = delete;
+  TileWorkerPool& operator=( const TileWorkerPool& ) = delete;
+
+  /***/
+  void  enqueue( job_t&& job ) noexcept
+  {
+    ++m_pending;
+
+    {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_jobs.emplace_back( std::move(job) );
+    }
+    m_cv.notify_one();
+  }
+
+  /**
+   * Pass queued results to @p upload, at most @p max_count uploads and stopping once
+   * @p budget is elapsed or @p max_bytes have been reported by @p upload.
+   * The last result may exceed the byte budget. Invalid results fail their request
+   * without calling @p upload. Return the number of uploads.
+   *
+   * @param upload  upload_t( result_t& result, std::size_t& bytes ), adds the bytes copied.
+   */
+  template<typename upload_fn_t>
+  ure::uint_t   drain( ure::uint_t max_count, clock_t::duration budget, std::size_t max_bytes, upload_fn_t&& upload ) noexcept
+  {
+    MAP_METRICS_SCOPE( upload );
+
+    const clock_t::time_point  start    = clock_t::now();
+    ure::uint_t                uploaded = 0;
+    std::size_t                bytes    = 0;
+    result_ptr                 result;
+
+    while ( ( uploaded < max_count ) && ( bytes < max_bytes ) && ( clock_t::now() - start < budget ) && m_results.try_pop( result ) )
+    {
+      --m_pending;
+
+      const upload_t outcome = result->valid ? upload( *result, bytes ) : upload_t::failed;
+
+      if ( outcome == upload_t::failed )
+      {
+        m_requests.failed( result->key );
+        continue;
+      }
+
+      if ( outcome == upload_t::uploaded )
+        ++uploaded;
+
+      m_requests.succeeded( result->key );
+    }
+
+    MAP_METRICS_ADD( tiles_uploaded, uploaded );
+    MAP_METRICS_ADD( upload_bytes, bytes );
+
+    return uploaded;
+  }
+
+  /**
+   * Jobs enqueued and not yet drained.
+   */
+  ure::uint_t   pending() const noexcept
+  { return m_pending.load(); }
+  /**
+   * Results waiting for drain().
+   */
+  ure::uint_t   ready() const noexcept
+  { return static_cast<ure::uint_t>( m_results.size() ); }
+
+private:
+  using result_ptr = std::unique_ptr<result_t>;
+
+  /***/
+  void  worker() noexcept
+  {
+    const process_t process = m_factory();
+
+    for (;;)
+    {
+      job_t job;
+
+      {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        m_cv.wait( lock, [this]() { return m_stop || ( m_jobs.empty() == false ); } );
+
+        if ( m_stop )
+          return;
+
+        job = std::move( m_jobs.front() );
+        m_jobs.pop_front();
+      }
+
+      result_ptr result = std::make_unique<result_t>();
+
+      result->key   = job.key;
+      result->valid = process( job, *result );
+
+      // Release the payloads, or the pack mappings, before waiting for the main thread
+      job = job_t{};
+
+      // Main thread is behind, wait for room instead of dropping a result
+      while ( m_results.try_push( std::move(result) ) == false )
+      {
+        {
+          std::lock_guard<std::mutex> lock( m_mutex );
+          if ( m_stop )
+            return;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+      }
+
+      m_redraw.request();
+    }
+  }
+
+private:
+  TileRequests&                 m_requests;
+  RedrawSignal&                 m_redraw;
+  const factory_t               m_factory;
+
+  std::mutex                    m_mutex;           /* Protect m_jobs and m_stop */
+  std::condition_variable       m_cv;
+  std::deque<job_t>             m_jobs;
+  ure::bool_t                   m_stop;
+
+  LockFreeQueue<result_ptr>     m_results;         /* Workers to main thread */
+  std::atomic<ure::uint_t>      m_pending;
+  std::vector<std::thread>      m_workers;
+};
+
+#endif // TILE_WORKER_POOL_H
@@ -0,0 +1,37 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TRACK_LAYER_H
+#define TRACK_LAYER_H
+
+#include <widgets/ure_layer.h>
+
+#include "track_set.h"
+
+class TrackLayer : public ure::widgets::Layer, public TrackSet
+{
+public:
+  /***/
+  TrackLayer( ure::ViewPort& rViewPort, ure::uint_t tile_pixels ) noexcept(true);
+  /** */
+  ~TrackLayer() noexcept(true);
+
+/* Widget */
+protected:
+  /***/
+  virtual ure::bool_t  on_widget_draw( [[maybe_unused]] const ure::Recti& rect ) noexcept(true) override;
+};
+
+#endif // TRACK_LAYER_H
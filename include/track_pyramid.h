@@ -0,0 +1,127 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TRACK_PYRAMID_H
+#define TRACK_PYRAMID_H
+
+#include <ure_utils.h>
+
+#include "marker_index.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Polylines simplified once for every zoom level.
+ *
+ * Douglas-Peucker runs a single time per track and stores, for each vertex, the
+ * largest tolerance that still keeps it; a child never outlives its parent, so the
+ * vertices of a level are those above its tolerance and every level is a subset of
+ * the next one. Long tracks are cut in pieces simplified on worker threads.
+ *
+ * Each level is described by chunks of a bounded number of vertices with their
+ * bounds, for culling; vertices of a level are only produced on request, to fill a
+ * GPU buffer, so memory does not grow with the number of levels.
+ */
+class TrackPyramid
+{
+public:
+  /** Normalized Web Mercator coordinates, as markers */
+  using point_t  = MarkerIndex::point_t;
+  /***/
+  using bounds_t = MarkerIndex::bounds_t;
+  /***/
+  using track_t  = std::vector<point_t>;
+
+  /**
+   * Consecutive vertices of a track at a level, the last one is also the first one of
+   * the next chunk of the same track so that strips of adjacent chunks join.
+   */
+  struct chunk_t
+  {
+    std::uint32_t   first;      /* First vertex in the level vertices */
+    std::uint32_t   count;
+    std::uint32_t   track;
+    bounds_t        bounds;
+  };
+
+  /***/
+  struct level_t
+  {
+    ure::double_t         tolerance;  /* Normalized units */
+    std::uint32_t         vertices;
+    std::vector<chunk_t>  chunks;     /* Track order, then vertex order */
+  };
+
+  /***/
+  TrackPyramid() noexcept(true);
+
+  /**
+   * Append to @p tracks the tracks read from @p path, one "lon,lat" pair in degrees per
+   * line, an empty line starts a new track. Return false if the file can not be read.
+   */
+  static ure::bool_t  read_csv( const std::string& path, std::vector<track_t>& tracks ) noexcept(true);
+
+  /**
+   * Simplify @p tracks for levels 0 to @p levels - 1, keeping vertices farther than
+   * @p tolerance pixels from the simplified line. Tiles are @p tile_pixels wide.
+   * @p workers threads are used, 0 for one per hardware thread.
+   */
+  ure::void_t         build( std::vector<track_t>&& tracks, ure::uint_t levels, ure::uint_t tile_pixels,
+                             ure::float_t tolerance = 0.5f, ure::uint_t workers = 0 ) noexcept(true);
+
+  /***/
+  ure::uint_t         levels() const noexcept
+  { return static_cast<ure::uint_t>( m_levels.size() ); }
+  /** @p level must be below levels() */
+  const level_t&      level( ure::uint_t level ) const noexcept
+  { return m_levels[level]; }
+  /***/
+  const std::vector<track_t>&  tracks() const noexcept
+  { return m_tracks; }
+  /** Vertices of all the tracks */
+  std::size_t         vertices() const noexcept
+  { return m_importance.size(); }
+
+  /**
+   * Replace @p out with the vertices of @p level, in the order referenced by its chunks.
+   */
+  ure::void_t         vertices( ure::uint_t level, std::vector<point_t>& out ) const noexcept(true);
+
+private:
+  /** Simplify vertices [first, last] of @p track, both ends are kept */
+  ure::void_t         simplify( std::uint32_t track, std::uint32_t first, std::uint32_t last ) noexcept(true);
+  /** Chunks of level @p level, m_importance must be complete */
+  ure::void_t         split( ure::uint_t level ) noexcept(true);
+  /** Vertex @p i of @p track is part of a level with @p tolerance */
+  ure::bool_t         kept( std::uint32_t track, std::uint32_t i, ure::double_t tolerance ) const noexcept
+  { return m_importance[ m_offsets[track] + i ] > tolerance; }
+
+  /** Vertices per simplification task, ends of pieces are always kept */
+  static constexpr std::uint32_t  piece_size()
+  { return 1u << 16; }
+  /** Vertices per chunk */
+  static constexpr std::uint32_t  chunk_size()
+  { return 512; }
+
+private:
+  std::vector<track_t>        m_tracks;
+  std::vector<std::size_t>    m_offsets;      /* First vertex of each track in m_importance */
+  std::vector<ure::float_t>   m_importance;   /* Largest tolerance keeping each vertex, infinity for ends */
+  std::vector<level_t>        m_levels;
+};
+
+#endif // TRACK_PYRAMID_H
@@ -0,0 +1,133 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TRACK_SET_H
+#define TRACK_SET_H
+
+#include <ure_size.h>
+
+#include "track_pyramid.h"
+#include "vector_renderer.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Tracks drawn over the tiles of a zoom level, with the same model matrix.
+ *
+ * Segments of a level are uploaded once to a static buffer as independent lines, the
+ * first time the level is drawn, so that consecutive chunks are contiguous even across
+ * tracks. Chunks outside of the view are skipped and runs of visible chunks are drawn
+ * with a single call; runs are only computed again when the view changes.
+ * Levels beyond those of the pyramid draw the last one scaled.
+ */
+class TrackSet
+{
+public:
+  /***/
+  explicit TrackSet( ure::uint_t tile_pixels ) noexcept(true);
+
+  /**
+   * Directory containing DefaultSolid.vs/.fs.
+   */
+  ure::void_t       set_shaders_path( const std::string& path ) noexcept(true)
+  { m_renderer.set_shaders_path( path ); }
+
+  /**
+   * Replace the tracks, buffers of the previous ones are released by the next draw().
+   */
+  ure::void_t       set_tracks( TrackPyramid&& pyramid ) noexcept(true);
+  /***/
+  const TrackPyramid& tracks() const noexcept
+  { return m_pyramid; }
+
+  /**
+   * Line color and width in pixels.
+   */
+  ure::void_t       set_style( const glm::vec4& color, ure::float_t width ) noexcept(true);
+
+  /***/
+  ure::void_t       set_zoom( ure::word_t zoom ) noexcept(true);
+  /***/
+  constexpr ure::word_t zoom() const noexcept
+  { return m_zoom; }
+  /**
+   * Position of tile (0,0), as for the tile levels.
+   */
+  ure::void_t       set_origin( const glm::vec2& origin ) noexcept(true);
+  /**
+   * Model matrix of the level, mapping its pixels to clip space, and frame buffer size.
+   */
+  ure::void_t       set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true);
+
+  /**
+   * Upload the level if needed and draw its visible chunks. Return the number of draw calls.
+   */
+  ure::uint_t       draw() noexcept(true);
+
+  /** Lines of the last draw(), in vertices of the level drawn */
+  const std::vector<VectorRenderer::lines_t>&  lines() const noexcept
+  { return m_lines; }
+  /** Levels uploaded so far */
+  ure::uint_t       uploads() const noexcept
+  { return m_uploads; }
+
+  /**
+   * Release GL resources, must be called while the GL context is still valid.
+   */
+  ure::void_t       dispose() noexcept(true);
+
+private:
+  /** Pyramid level drawn at the current zoom */
+  ure::uint_t       level() const noexcept(true);
+  /** Size of level @p level in pixels */
+  ure::double_t     world( ure::uint_t level ) const noexcept(true);
+  /** Buffers no longer matching the tracks or the origin */
+  ure::void_t       release() noexcept(true);
+  /** Upload @p level if needed, false if it has no segment */
+  ure::bool_t       upload( ure::uint_t level ) noexcept(true);
+  /** Model matrix mapping pixels of @p level to clip space at the current zoom */
+  glm::mat4         model( ure::uint_t level ) const noexcept(true);
+  /** Lines of the chunks of @p level in the view of @p model */
+  ure::void_t       cull( ure::uint_t level, const glm::mat4& model ) noexcept(true);
+
+private:
+  /***/
+  struct buffer_t
+  {
+    GLuint                      vbo;
+    std::vector<std::uint32_t>  segments;     /* First segment of each chunk of the level */
+  };
+
+private:
+  const ure::uint_t         m_tile_pixels;
+  TrackPyramid              m_pyramid;
+  VectorRenderer            m_renderer;
+  glm::vec4                 m_color;
+  ure::float_t              m_width;            /* Pixels */
+  ure::word_t               m_zoom;
+  glm::vec2                 m_origin;
+  glm::mat4                 m_model;
+  ure::Size                 m_fb_size;
+  ure::bool_t               m_stale;            /* Tracks or origin changed, buffers must be uploaded again */
+  ure::bool_t               m_culled;           /* Lines match the current view */
+  ure::uint_t               m_uploads;
+  std::vector<buffer_t>     m_buffers;          /* One per level, no buffer until drawn */
+  std::vector<VectorRenderer::lines_t>  m_lines;
+};
+
+#endif // TRACK_SET_H
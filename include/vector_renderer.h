@@ -0,0 +1,92 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_RENDERER_H
+#define VECTOR_RENDERER_H
+
+#include "vector_tile_cache.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Draw vector tile buffers with the DefaultSolid shaders, one draw call per style
+ * group. Program and attribute state are set once per frame by begin(), every tile
+ * then only changes the MVP matrix and the group colors.
+ * All methods must be called from the thread owning the GL context.
+ */
+class VectorRenderer
+{
+public:
+  /** Vertices drawn as lines, two per segment */
+  struct lines_t
+  {
+    GLint     first;
+    GLsizei   count;
+  };
+
+  /***/
+  VectorRenderer() noexcept(true);
+  /***/
+  ~VectorRenderer() noexcept(true);
+
+  /**
+   * Directory containing DefaultSolid.vs/.fs, program is built on first begin().
+   */
+  ure::void_t   set_shaders_path( const std::string& path ) noexcept(true);
+
+  /**
+   * Bind program and blending, false if the program is not available.
+   */
+  ure::bool_t   begin() noexcept(true);
+  /**
+   * Draw @p buffer with @p mvp mapping tile units to clip space, @p opacity multiplies
+   * the style alpha. Return the number of draw calls.
+   */
+  ure::uint_t   draw( const VectorTileCache::buffer_t& buffer, const glm::mat4& mvp, ure::float_t opacity = 1.0f ) noexcept(true);
+  /**
+   * Draw @p lines of the vec2 vertices in @p vbo @p width pixels wide, the line width
+   * is restored afterwards. Return the number of draw calls.
+   */
+  ure::uint_t   draw( GLuint vbo, const std::vector<lines_t>& lines, const glm::mat4& mvp, const glm::vec4& color, ure::float_t width ) noexcept(true);
+  /**
+   * Restore the state changed by begin().
+   */
+  ure::void_t   end() noexcept(true);
+
+  /**
+   * Delete the program, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true);
+
+private:
+  /***/
+  ure::bool_t   init() noexcept(true);
+  /***/
+  GLuint        compile( GLenum type, const std::string& file ) noexcept(true);
+
+private:
+  std::string               m_shaders_path;
+  ure::bool_t               m_failed;          /* Do not try again to build a broken program */
+  GLuint                    m_program;
+  GLint                     m_a_point;
+  GLint                     m_u_mvp;
+  GLint                     m_u_color;
+  GLboolean                 m_blend;           /* Blending state before begin() */
+};
+
+#endif // VECTOR_RENDERER_H
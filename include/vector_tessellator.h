@@ -0,0 +1,87 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TESSELLATOR_H
+#define VECTOR_TESSELLATOR_H
+
+#include <ure_utils.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Turn vector tile geometries into triangle lists drawn with glDrawArrays().
+ *
+ * Polygons are triangulated by ear clipping, holes are first bridged to the exterior
+ * ring so that a single ring is clipped. Lines become one quad per segment, extended
+ * by half the width at both ends so that joints are covered without join geometry.
+ * Scratch buffers are kept between calls, an instance must not be shared by threads.
+ */
+class VectorTessellator
+{
+public:
+  /**
+   * Signed area of a ring, positive for exterior rings of vector tiles (clockwise with y down).
+   */
+  static ure::float_t  area( const glm::vec2* points, std::size_t count ) noexcept(true);
+
+  /**
+   * Append the triangles of a polygon: @p rings sizes in @p points, exterior ring first
+   * followed by its holes. Return false if the polygon could not be fully triangulated,
+   * triangles found so far are kept.
+   */
+  ure::bool_t   fill  ( const glm::vec2* points, const ure::uint_t* rings, std::size_t count, std::vector<glm::vec2>& triangles ) noexcept(true);
+
+  /**
+   * Append the triangles of a line @p width wide, @p closed for polygon rings.
+   */
+  ure::void_t   stroke( const glm::vec2* points, std::size_t count, ure::float_t width, ure::bool_t closed, std::vector<glm::vec2>& triangles ) const noexcept(true);
+
+private:
+  /**
+   * Append @p count points to m_ring skipping duplicates, with the requested orientation.
+   */
+  ure::void_t   add_ring( const glm::vec2* points, std::size_t count, ure::bool_t exterior ) noexcept(true);
+  struct hole_t
+  {
+    std::size_t     first;       /* In m_hole_points */
+    std::size_t     count;
+    ure::float_t    max_x;
+  };
+
+  /**
+   * Merge @p hole in m_ring through a bridge edge going back and forth to its rightmost vertex.
+   */
+  ure::void_t   bridge( const hole_t& hole ) noexcept(true);
+  /**
+   * Ear clipping of m_ring.
+   */
+  ure::bool_t   clip( std::vector<glm::vec2>& triangles ) noexcept(true);
+
+private:
+  std::vector<glm::vec2>    m_ring;      /* Exterior ring, holes are merged in it */
+  std::vector<glm::vec2>    m_hole_points;
+  std::vector<hole_t>       m_holes;
+  std::vector<glm::vec2>    m_merged;    /* Bridging output, swapped with m_ring */
+  std::vector<std::pair<ure::float_t, ure::uint_t>>
+                            m_candidates;/* Bridge ends sorted by distance */
+  std::vector<ure::uint_t>  m_prev;      /* Linked list of vertices not yet clipped */
+  std::vector<ure::uint_t>  m_next;
+};
+
+#endif // VECTOR_TESSELLATOR_H
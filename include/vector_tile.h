@@ -0,0 +1,118 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TILE_H
+#define VECTOR_TILE_H
+
+#include "mvt_reader.h"
+#include "vector_tessellator.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Colors and widths of vector tile layers, matched by layer name.
+ * Rules are drawn in order, the first one at the bottom.
+ */
+struct VectorStyle
+{
+  struct rule_t
+  {
+    std::string     layer;
+    glm::vec4       color;
+    ure::float_t    width;      /* Line width in tile pixels, 0 to fill polygons */
+  };
+
+  glm::vec4             background;   /* Drawn under every tile, hides parent tiles drawn as fallback */
+  std::vector<rule_t>   rules;
+
+  /**
+   * Light theme for the OpenMapTiles and Mapbox Streets schemas.
+   */
+  static VectorStyle    basic() noexcept(true);
+};
+
+/**
+ * Triangles of a single tile ready for upload, in tile units: [0,1] inside the tile,
+ * features from the tile buffer slightly outside.
+ */
+struct VectorTile
+{
+  struct group_t
+  {
+    glm::vec4       color;
+    ure::uint_t     first;      /* First vertex */
+    ure::uint_t     count;
+  };
+
+  std::vector<glm::vec2>  vertices;
+  std::vector<group_t>    groups;     /* One per style rule with geometry, in drawing order */
+
+  /***/
+  std::size_t   bytes() const noexcept
+  { return vertices.size() * sizeof(glm::vec2); }
+};
+
+/**
+ * Parse a Mapbox Vector Tile and build its VectorTile with a VectorStyle.
+ *
+ * Fill rules take polygons, line rules take lines and polygon outlines, points are
+ * not drawn. Buffers are reused between tiles, use one builder per thread.
+ */
+class VectorTileBuilder : private MvtReader::Handler
+{
+public:
+  /**
+   * @param tile_pixels  size of a tile on screen, line widths are relative to it.
+   */
+  VectorTileBuilder( const VectorStyle& style, ure::uint_t tile_pixels ) noexcept(true);
+
+  /**
+   * Build @p tile from the MVT in @p data, false if the tile is malformed.
+   */
+  ure::bool_t   build( const ure::byte_t* data, std::size_t length, VectorTile& tile ) noexcept(true);
+
+  /**
+   * Polygons of the last tile that could not be fully triangulated.
+   */
+  constexpr ure::uint_t  failures() const noexcept
+  { return m_failures; }
+
+/* MvtReader::Handler implementation */
+private:
+  /***/
+  virtual ure::bool_t  on_layer  ( std::string_view name, ure::uint_t extent ) noexcept(true) override;
+  /***/
+  virtual ure::void_t  on_feature( const MvtReader::feature_t& feature ) noexcept(true) override;
+
+private:
+  /***/
+  ure::void_t   fill( const MvtReader::feature_t& feature, std::vector<glm::vec2>& triangles ) noexcept(true);
+
+private:
+  const VectorStyle&                    m_style;
+  const ure::float_t                    m_tile_pixels;
+  MvtReader                             m_reader;
+  VectorTessellator                     m_tessellator;
+  std::vector<std::vector<glm::vec2>>   m_buckets;     /* Triangles of each rule, in tile units */
+  std::vector<ure::uint_t>              m_matches;     /* Rules of the current layer */
+  std::vector<ure::uint_t>              m_rings;       /* Ring sizes of the current polygon */
+  ure::float_t                          m_scale;       /* Layer units to tile units */
+  ure::uint_t                           m_failures;
+};
+
+#endif // VECTOR_TILE_H
@@ -0,0 +1,112 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TILE_CACHE_H
+#define VECTOR_TILE_CACHE_H
+
+#include <ure_texture.h>
+
+#include "lru_cache.h"
+#include "tile_key.h"
+#include "vector_tile.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Vertex buffers of vector tiles, one per tile, bounded by a budget in bytes.
+ *
+ * Same LruCache policy as TileCache. Geometry is uploaded once by insert() and drawn
+ * as it is in every following frame, pan and zoom only change the model matrix. Tiles
+ * without geometry are cached too, so that they are not fetched again.
+ * Buffers are created and deleted by insert(), begin_frame(), evict_level() and
+ * dispose(), which must be called from the thread owning the GL context; lookups
+ * are thread safe. Pointers returned by find() stay valid until one of those runs.
+ */
+class VectorTileCache
+{
+public:
+  struct buffer_t
+  {
+    GLuint                          vbo;        /* 0 if the tile has no geometry */
+    ure::uint_t                     vertices;
+    std::vector<VectorTile::group_t> groups;
+  };
+
+  /** Deletes the vertex buffer of an evicted tile */
+  struct release_t
+  {
+    ure::void_t   operator()( buffer_t& buffer ) const noexcept
+    {
+      if ( buffer.vbo != 0 )
+        glDeleteBuffers( 1, &buffer.vbo );
+    }
+  };
+
+  using entries_t = LruCache<buffer_t, release_t>;
+  using stats_t   = entries_t::stats_t;
+
+  /***/
+  explicit VectorTileCache( std::size_t budget ) noexcept(true);
+  /***/
+  ~VectorTileCache() noexcept(true);
+
+  /**
+   * Return the buffer of @p key, or nullptr if not loaded.
+   * Hits mark the entry as in use for the current frame.
+   */
+  const buffer_t*  find( const TileKey& key ) noexcept(true)
+  { return m_entries.find( key ); }
+  /**
+   * Same as find() but a miss is not counted, for fallback lookups that never fetch.
+   */
+  const buffer_t*  find_resident( const TileKey& key ) noexcept(true)
+  { return m_entries.find_resident( key ); }
+  /***/
+  ure::bool_t   contains( const TileKey& key ) const noexcept(true)
+  { return m_entries.contains( key ); }
+  /**
+   * Upload @p tile in a new vertex buffer and evict entries over budget.
+   * Return false if @p key is already in the cache or the buffer could not be created.
+   */
+  ure::bool_t   insert  ( const TileKey& key, const VectorTile& tile ) noexcept(true);
+
+  /**
+   * Release all tiles of zoom level @p z, except the ones used in the current frame.
+   */
+  ure::void_t   evict_level( ure::uint_t z ) noexcept(true)
+  { m_entries.evict_level( z ); }
+
+  /**
+   * Start a new frame, entries used in previous frames become evictable.
+   */
+  ure::void_t   begin_frame() noexcept(true)
+  { m_entries.begin_frame(); }
+
+  /***/
+  stats_t       stats() const noexcept(true)
+  { return m_entries.stats(); }
+
+  /**
+   * Delete all buffers, must be called while the GL context is still valid.
+   */
+  ure::void_t   dispose() noexcept(true)
+  { m_entries.clear(); }
+
+private:
+  entries_t             m_entries;
+};
+
+#endif // VECTOR_TILE_CACHE_H
@@ -0,0 +1,88 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TILE_CONTEXT_H
+#define VECTOR_TILE_CONTEXT_H
+
+#include "redraw_signal.h"
+#include "tile_disk_cache.h"
+#include "tile_requests.h"
+#include "tile_scheduler.h"
+#include "vector_renderer.h"
+#include "vector_tile.h"
+#include "vector_tile_cache.h"
+#include "vector_tile_decoder.h"
+
+#include <string>
+
+/**
+ * Counterpart of TileContext for vector tiles: style, vertex buffers cache, downloads
+ * bookkeeping and scheduling, disk cache of MVT payloads, decoder and renderer.
+ * The redraw signal is shared with the raster tiles, so that the map wakes up for
+ * both. Members are declared in dependency order so that the decoder threads stop
+ * before anything they use.
+ */
+class VectorTileContext
+{
+public:
+  /**
+   * @param tile_pixels  size of a tile on screen.
+   */
+  VectorTileContext( ure::uint_t tile_pixels, std::size_t cache_budget, RedrawSignal& redraw, const VectorStyle& style = VectorStyle::basic() ) noexcept(true);
+
+  /**
+   * Set shaders location and open the disk cache in @p cache_path.
+   */
+  ure::bool_t         initialize( const std::string& shaders_path, const std::string& cache_path ) noexcept(true);
+
+  /**
+   * Release GL resources, must be called before the GL context is destroyed.
+   */
+  ure::void_t         dispose() noexcept(true);
+
+  /***/
+  constexpr ure::uint_t  tile_pixels() const noexcept
+  { return m_tile_pixels; }
+
+  /***/
+  const VectorStyle&  style()     const noexcept { return m_style;     }
+  /***/
+  VectorTileCache&    cache()     noexcept { return m_cache;     }
+  /***/
+  TileRequests&       requests()  noexcept { return m_requests;  }
+  /***/
+  TileScheduler&      scheduler() noexcept { return m_scheduler; }
+  /***/
+  TileDiskCache&      disk()      noexcept { return m_disk;      }
+  /***/
+  VectorTileDecoder&  decoder()   noexcept { return m_decoder;   }
+  /***/
+  VectorRenderer&     renderer()  noexcept { return m_renderer;  }
+  /***/
+  RedrawSignal&       redraw()    noexcept { return m_redraw;    }
+
+private:
+  const ure::uint_t   m_tile_pixels;
+  const VectorStyle   m_style;
+  RedrawSignal&       m_redraw;
+  VectorTileCache     m_cache;
+  TileRequests        m_requests;
+  TileScheduler       m_scheduler;
+  TileDiskCache       m_disk;
+  VectorTileDecoder   m_decoder;
+  VectorRenderer      m_renderer;
+};
+
+#endif // VECTOR_TILE_CONTEXT_H
@@ -0,0 +1,107 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TILE_DECODER_H
+#define VECTOR_TILE_DECODER_H
+
+#include "redraw_signal.h"
+#include "tile_disk_cache.h"
+#include "tile_requests.h"
+#include "tile_worker_pool.h"
+#include "vector_tile.h"
+#include "vector_tile_cache.h"
+
+#include <chrono>
+
+/**
+ * Parse and triangulate vector tiles on a pool of worker threads.
+ *
+ * Same TileWorkerPool as TileDecoder: submit() queues a downloaded tile or a disk cache
+ * payload, workers build its VectorTile with their own VectorTileBuilder and hand it to
+ * the main thread, upload() creates the vertex buffers in the
+ * VectorTileCache and completes the request in TileRequests.
+ * Downloaded tiles that parse successfully are persisted in the TileDiskCache as they
+ * were received, MVT is smaller than the triangles built from it.
+ */
+class VectorTileDecoder
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * @param tile_pixels  size of a tile on screen, see VectorTileBuilder.
+   * @param workers      number of threads, 0 to use all but one hardware thread.
+   */
+  VectorTileDecoder( VectorTileCache& cache, TileRequests& requests, TileDiskCache& disk, RedrawSignal& redraw,
+                     const VectorStyle& style, ure::uint_t tile_pixels, ure::uint_t workers = 0 ) noexcept(true);
+  /***/
+  ~VectorTileDecoder() noexcept(true);
+
+  /**
+   * Queue downloaded @p data, copied before returning.
+   */
+  ure::void_t   submit( const TileKey& key, const ure::byte_t* data, ure::uint_t length ) noexcept(true);
+  /**
+   * Queue a payload found in the TileDiskCache, parsed straight from the mapped pack.
+   */
+  ure::void_t   submit( const TileKey& key, TileDiskCache::blob_t&& blob ) noexcept(true);
+
+  /**
+   * Upload built tiles, at most @p max_count of them and stopping once @p budget
+   * is elapsed. Return the number of tiles uploaded.
+   */
+  ure::uint_t   upload( ure::uint_t max_count, clock_t::duration budget ) noexcept(true);
+
+  /**
+   * Tiles submitted and not yet uploaded.
+   */
+  ure::uint_t   pending() const noexcept(true);
+  /**
+   * Tiles built and waiting for upload().
+   */
+  ure::uint_t   ready() const noexcept(true);
+
+private:
+  struct job_t
+  {
+    TileKey                   key;
+    TileDiskCache::blob_t     blob;            /* Owner is either a pack mapping or a download copy */
+    ure::bool_t               persist;         /* Store in the disk cache once parsed */
+  };
+
+  struct built_t
+  {
+    TileKey                   key;
+    VectorTile                tile;
+    ure::bool_t               valid;
+  };
+
+  using workers_t = TileWorkerPool<job_t, built_t>;
+
+  /**
+   * Worker step, build @p job in @p built with the thread @p builder and update the disk cache.
+   */
+  ure::bool_t   build( VectorTileBuilder& builder, job_t& job, built_t& built ) noexcept(true);
+
+private:
+  VectorTileCache&              m_cache;
+  TileDiskCache&                m_disk;
+  const VectorStyle&            m_style;
+  const ure::uint_t             m_tile_pixels;
+
+  workers_t                     m_workers;         /* Last, threads are joined before the members they use */
+};
+
+#endif // VECTOR_TILE_DECODER_H
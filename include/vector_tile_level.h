@@ -0,0 +1,140 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef VECTOR_TILE_LEVEL_H
+#define VECTOR_TILE_LEVEL_H
+
+#include <ure_resources_fetcher_events.h>
+
+#include "tile_range.h"
+#include "tile_url.h"
+#include "vector_tile_context.h"
+
+#include <vector>
+
+/**
+ * Vector tiles of a single zoom level, the counterpart of TileLevel: visible range
+ * selection, requests, fallback to other levels and drawing of the cached vertex
+ * buffers through the VectorRenderer.
+ *
+ * Tiles share the layer coordinates of raster tiles, a tile spans tile_pixels() units
+ * and its geometry, in tile units, is placed by the MVP matrix alone. Missing tiles
+ * are covered by their four children or by an ancestor, drawn before the tiles of
+ * this level which hide them with the style background.
+ *
+ * Independent from the widgets toolkit, VectorTileLayer puts it in the scene graph
+ * while the benchmark harness drives it directly.
+ */
+class VectorTileLevel : public ure::ResourcesFetcherEvents
+{
+public:
+  struct stats_t
+  {
+    ure::uint_t   tiles;          /* Tiles of this level drawn */
+    ure::uint_t   fallbacks;      /* Tiles of other levels drawn in place of missing ones */
+    ure::uint_t   draw_calls;
+  };
+
+  /***/
+  VectorTileLevel( VectorTileContext& tiles, ure::word_t zoom, const std::string& url ) noexcept(true);
+  /** */
+  virtual ~VectorTileLevel() noexcept(true);
+
+  /***/
+  constexpr ure::word_t  zoom() const
+  { return static_cast<ure::word_t>(m_zoom_level); }
+
+  /**
+   * Move to another zoom level, geometry of the previous one stays cached.
+   */
+  ure::void_t            set_zoom( ure::word_t zoom ) noexcept(true);
+
+  /**
+   * Update model matrix and viewport size used to select the visible tiles.
+   */
+  ure::void_t            set_view( const glm::mat4& model, const ure::Size& viewport ) noexcept(true);
+
+  /**
+   * Position of tile (0,0) in model coordinates.
+   */
+  ure::void_t            set_origin( const glm::vec2& origin ) noexcept(true)
+  { m_origin = origin; }
+
+  /**
+   * Number of tiles around the visible area that are also drawn and fetched.
+   */
+  constexpr ure::void_t  set_margin( ure::int_t margin )
+  { m_margin = margin; }
+
+  /**
+   * Number of ancestor levels searched for a loaded tile to draw while a tile is missing.
+   */
+  constexpr ure::void_t  set_fallback_levels( ure::uint_t levels )
+  { m_fallback_levels = levels; }
+
+  /**
+   * Range of tiles intersecting the viewport plus margin.
+   */
+  TileRange              visible_range() const noexcept(true);
+
+  /**
+   * Draw the visible tiles with @p opacity, filling missing ones from other levels,
+   * and request the missing ones.
+   */
+  stats_t                draw( ure::float_t opacity = 1.0f ) noexcept(true);
+
+/* ure::ResourcesFetcherEvents implementation */
+protected:  
+  /***/
+  virtual ure::void_t on_download_succeeded( [[maybe_unused]] std::string_view name, [[maybe_unused]] const std::type_info& type, [[maybe_unused]] const ure::byte_t* data, [[maybe_unused]] ure::uint_t length ) noexcept(true) override;
+  /***/
+  virtual ure::void_t on_download_failed   ( [[maybe_unused]] std::string_view name ) noexcept(true) override;
+
+private:
+  struct drawn_t
+  {
+    const VectorTileCache::buffer_t*  buffer;
+    glm::vec2                         position;   /* Top left corner in tiles of this level */
+    ure::float_t                      scale;      /* Tile size in tiles of this level */
+  };
+
+  /**
+   * Load @p key from the disk cache or queue its download, unless already requested.
+   */
+  ure::bool_t               request_tile( const TileKey& key, ure::float_t distance ) noexcept(true);
+  /**
+   * Queue the resident children of @p key for drawing, or draw its nearest resident
+   * ancestor right away. Return false if nothing has been found.
+   */
+  ure::bool_t               add_fallback( const TileKey& key, ure::float_t opacity, stats_t& stats ) noexcept(true);
+  /** MVP matrix of a tile at @p position with @p scale, in tiles of this level */
+  glm::mat4                 tile_mvp( const glm::vec2& position, ure::float_t scale ) const noexcept(true);
+
+private:
+  VectorTileContext&        m_tiles;             /* Cache, downloads and renderer shared with other levels */
+  const glm::vec2           m_extent;            /* Size of a tile in layer coordinates */
+  ure::int_t                m_zoom_level;
+  ure::uint_t               m_max_tiles;         /* Tiles per side */
+  const TileUrl             m_url;
+  glm::mat4                 m_model;             /* Model matrix of the scene node drawing this level */
+  ure::Size                 m_viewport;          /* Viewport size in pixels */
+  glm::vec2                 m_origin;            /* Position of tile (0,0) in model coordinates */
+  ure::int_t                m_margin;            /* Tiles drawn outside the viewport on every side */
+  ure::uint_t               m_fallback_levels;   /* Ancestor levels searched for missing tiles */
+  std::vector<drawn_t>      m_drawn;             /* Tiles drawn after the ancestors, reused every frame */
+  std::vector<TileKey>      m_ancestors;         /* Ancestors already drawn in this frame */
+};
+
+#endif // VECTOR_TILE_LEVEL_H
@@ -0,0 +1,23 @@
+#version 100
+
+precision mediump float;
+
+uniform   vec4      u_v4Color;
+uniform   vec4      u_v4ClusterColor;
+varying   vec2      v_v2Corner;
+varying   float     v_fCluster;
+
+void main()
+{
+  float d = length( v_v2Corner );
+
+  if ( d > 1.0 )
+    discard;
+
+  vec4  color = mix( u_v4Color, u_v4ClusterColor, v_fCluster );
+
+  // Darker outline, clusters get a wider one
+  color.rgb *= ( d > 0.8 - 0.15 * v_fCluster ) ? 0.6 : 1.0;
+
+  gl_FragColor = color;
+}
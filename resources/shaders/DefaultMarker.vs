@@ -0,0 +1,21 @@
+#version 100
+
+// Positions are level pixels, large values at deep zoom levels
+precision highp float;
+
+uniform   mat4  u_m4MVP;
+uniform   vec2  u_v2PixelSize;
+attribute vec2  a_v2Corner;
+attribute vec4  a_v4Instance;   // xy position, z radius in pixels, w 1 for clusters
+varying   vec2  v_v2Corner;
+varying   float v_fCluster;
+
+void main()
+{
+  vec4 centre  = u_m4MVP * vec4( a_v4Instance.xy, 0.0, 1.0 );
+
+  // Screen aligned quad, its size does not depend on the zoom
+  gl_Position  = centre + vec4( a_v2Corner * a_v4Instance.z * u_v2PixelSize * centre.w, 0.0, 0.0 );
+  v_v2Corner   = a_v2Corner;
+  v_fCluster   = a_v4Instance.w;
+}
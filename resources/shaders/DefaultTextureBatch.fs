@@ -0,0 +1,27 @@
+#version 100
+
+precision mediump float;
+
+varying   vec2      v_v2TexCoord;
+varying   float     v_fPage;
+varying   float     v_fOpacity;
+uniform   sampler2D u_2dPage0;
+uniform   sampler2D u_2dPage1;
+uniform   sampler2D u_2dPage2;
+uniform   sampler2D u_2dPage3;
+uniform   float     u_fOpacity;
+
+void main()
+{
+  // Sampler arrays can not be indexed dynamically in GLSL ES 1.00
+  if ( v_fPage < 0.5 )
+    gl_FragColor = texture2D(u_2dPage0, v_v2TexCoord);
+  else if ( v_fPage < 1.5 )
+    gl_FragColor = texture2D(u_2dPage1, v_v2TexCoord);
+  else if ( v_fPage < 2.5 )
+    gl_FragColor = texture2D(u_2dPage2, v_v2TexCoord);
+  else
+    gl_FragColor = texture2D(u_2dPage3, v_v2TexCoord);
+
+  gl_FragColor.a *= u_fOpacity * v_fOpacity;
+}
@@ -0,0 +1,22 @@
+#version 100
+
+precision mediump float;
+
+uniform   mat4  u_m4MVP;
+uniform   float u_afLayerOpacity[8];
+attribute vec2  a_v2Point;
+attribute vec2  a_v2TexCoord;
+attribute float a_fPage;
+attribute float a_fLayer;
+varying   vec2  v_v2TexCoord;
+varying   float v_fPage;
+varying   float v_fOpacity;
+
+void main()
+{
+  gl_Position  = u_m4MVP * vec4( a_v2Point, 0.0, 1.0 );
+  v_v2TexCoord = a_v2TexCoord;
+  v_fPage      = a_fPage;
+  // Uniform arrays can be indexed dynamically in vertex shaders only
+  v_fOpacity   = u_afLayerOpacity[ int( a_fLayer + 0.5 ) ];
+}
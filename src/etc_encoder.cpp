@@ -0,0 +1,270 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "etc_encoder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace
+{
+  // Intensity modifiers, the 2 bits index selects +small, +large, -small, -large
+  constexpr int  modifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+  struct fit_t
+  {
+    int             error;
+    ure::uint_t     table;
+    std::uint8_t    index[8];   /* Modifier index of each pixel of the sub-block */
+  };
+
+  inline int  clamp255( int v ) { return std::clamp( v, 0, 255 ); }
+
+  // Best table and modifiers for 8 pixels around @p base, error is the squared RGB distance
+  fit_t  fit( const ure::byte_t* const (&pixels)[8], const int (&base)[3] )
+  {
+    fit_t best{ INT_MAX, 0, {} };
+
+    for ( ure::uint_t table = 0; table < 8; ++table )
+    {
+      const int deltas[4] = { modifiers[table][0], modifiers[table][1], -modifiers[table][0], -modifiers[table][1] };
+      fit_t     current{ 0, table, {} };
+
+      for ( ure::uint_t p = 0; ( p < 8 ) && ( current.error < best.error ); ++p )
+      {
+        int best_error = INT_MAX;
+
+        for ( std::uint8_t m = 0; m < 4; ++m )
+        {
+          const int dr = clamp255( base[0] + deltas[m] ) - pixels[p][0];
+          const int dg = clamp255( base[1] + deltas[m] ) - pixels[p][1];
+          const int db = clamp255( base[2] + deltas[m] ) - pixels[p][2];
+          const int e  = dr * dr + dg * dg + db * db;
+
+          if ( e < best_error )
+          {
+            best_error          = e;
+            current.index[p]    = m;
+          }
+        }
+
+        current.error += best_error;
+      }
+
+      if ( current.error < best.error )
+        best = current;
+    }
+
+    return best;
+  }
+
+  inline int  expand4( int c ) { return ( c << 4 ) | c; }
+  inline int  expand5( int c ) { return ( c << 3 ) | ( c >> 2 ); }
+}
+
+ure::bool_t  EtcEncoder::encode_rgb8( const ure::byte_t* rgba, ure::uint_t width, ure::uint_t height, ure::byte_t* blocks ) noexcept(true)
+{
+  if ( ( width % 4 != 0 ) || ( height % 4 != 0 ) )
+    return false;
+
+  ure::byte_t pixels[16][4];
+
+  for ( ure::uint_t by = 0; by < height; by += 4 )
+  {
+    for ( ure::uint_t bx = 0; bx < width; bx += 4 )
+    {
+      for ( ure::uint_t y = 0; y < 4; ++y )
+        std::copy_n( rgba + ( std::size_t( by + y ) * width + bx ) * 4, 16, &pixels[y * 4][0] );
+
+      encode_block( pixels, blocks );
+      blocks += block_bytes;
+    }
+  }
+
+  return true;
+}
+
+ure::bool_t  EtcEncoder::decode_rgb8( const ure::byte_t* blocks, ure::uint_t width, ure::uint_t height, ure::byte_t* rgba ) noexcept(true)
+{
+  if ( ( width % 4 != 0 ) || ( height % 4 != 0 ) )
+    return false;
+
+  for ( ure::uint_t by = 0; by < height; by += 4 )
+  {
+    for ( ure::uint_t bx = 0; bx < width; bx += 4, blocks += block_bytes )
+    {
+      std::uint64_t bits = 0;
+      for ( ure::uint_t i = 0; i < block_bytes; ++i )
+        bits = ( bits << 8 ) | blocks[i];
+
+      const bool        differential = ( ( bits >> 33 ) & 1 ) != 0;
+      const bool        flip         = ( ( bits >> 32 ) & 1 ) != 0;
+      const ure::uint_t tables[2]    = { static_cast<ure::uint_t>( ( bits >> 37 ) & 7 ), static_cast<ure::uint_t>( ( bits >> 34 ) & 7 ) };
+      int               base[2][3];
+
+      for ( ure::uint_t c = 0; c < 3; ++c )
+      {
+        if ( differential )
+        {
+          const int first = static_cast<int>( ( bits >> ( 59 - c * 8 ) ) & 0x1F );
+          const int delta = static_cast<int>( ( bits >> ( 56 - c * 8 ) ) & 0x7 );
+
+          base[0][c] = expand5( first );
+          base[1][c] = expand5( ( first + ( ( delta < 4 ) ? delta : delta - 8 ) ) & 0x1F );
+        }
+        else
+        {
+          base[0][c] = expand4( static_cast<int>( ( bits >> ( 60 - c * 8 ) ) & 0xF ) );
+          base[1][c] = expand4( static_cast<int>( ( bits >> ( 56 - c * 8 ) ) & 0xF ) );
+        }
+      }
+
+      for ( ure::uint_t y = 0; y < 4; ++y )
+      {
+        ure::byte_t* dst = rgba + ( std::size_t( by + y ) * width + bx ) * 4;
+
+        for ( ure::uint_t x = 0; x < 4; ++x, dst += 4 )
+        {
+          const ure::uint_t s     = flip ? ( y / 2 ) : ( x / 2 );
+          const ure::uint_t pos   = x * 4 + y;
+          const ure::uint_t index = static_cast<ure::uint_t>( ( ( ( bits >> ( 16 + pos ) ) & 1 ) << 1 ) | ( ( bits >> pos ) & 1 ) );
+          const int         delta = ( index & 1 ) ? modifiers[tables[s]][1] : modifiers[tables[s]][0];
+          const int         value = ( index & 2 ) ? -delta : delta;
+
+          for ( ure::uint_t c = 0; c < 3; ++c )
+            dst[c] = static_cast<ure::byte_t>( clamp255( base[s][c] + value ) );
+
+          dst[3] = 0xFF;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+ure::void_t  EtcEncoder::encode_block( const ure::byte_t (&pixels)[16][4], ure::byte_t* block ) noexcept(true)
+{
+  std::uint64_t best_bits  = 0;
+  int           best_error = INT_MAX;
+
+  // flip 0: two 2x4 sub-blocks side by side, flip 1: two 4x2 sub-blocks stacked
+  for ( ure::uint_t flip = 0; flip < 2; ++flip )
+  {
+    const ure::byte_t*  sub[2][8];
+    ure::uint_t         positions[2][8];    /* x * 4 + y, the order of the index bits */
+    ure::uint_t         count[2] = { 0, 0 };
+
+    for ( ure::uint_t y = 0; y < 4; ++y )
+    {
+      for ( ure::uint_t x = 0; x < 4; ++x )
+      {
+        const ure::uint_t s = ( flip == 0 ) ? ( x / 2 ) : ( y / 2 );
+
+        sub[s][count[s]]       = pixels[y * 4 + x];
+        positions[s][count[s]] = x * 4 + y;
+        ++count[s];
+      }
+    }
+
+    // Sub-block averages
+    int average[2][3];
+
+    for ( ure::uint_t s = 0; s < 2; ++s )
+    {
+      for ( ure::uint_t c = 0; c < 3; ++c )
+      {
+        int sum = 0;
+        for ( ure::uint_t p = 0; p < 8; ++p )
+          sum += sub[s][p][c];
+
+        average[s][c] = ( sum + 4 ) / 8;
+      }
+    }
+
+    // Differential mode when the 5 bits colours are close enough, individual 4 bits otherwise
+    int  q5[2][3];
+    bool differential = true;
+
+    for ( ure::uint_t s = 0; s < 2; ++s )
+      for ( ure::uint_t c = 0; c < 3; ++c )
+        q5[s][c] = std::min( 31, ( average[s][c] * 31 + 127 ) / 255 );
+
+    for ( ure::uint_t c = 0; c < 3; ++c )
+      differential = differential && ( q5[1][c] - q5[0][c] >= -4 ) && ( q5[1][c] - q5[0][c] <= 3 );
+
+    int q[2][3];
+    int base[2][3];
+
+    for ( ure::uint_t s = 0; s < 2; ++s )
+    {
+      for ( ure::uint_t c = 0; c < 3; ++c )
+      {
+        q[s][c]    = differential ? q5[s][c] : std::min( 15, ( average[s][c] * 15 + 127 ) / 255 );
+        base[s][c] = differential ? expand5( q[s][c] ) : expand4( q[s][c] );
+      }
+    }
+
+    const fit_t fits[2] = { fit( sub[0], base[0] ), fit( sub[1], base[1] ) };
+    const int   error   = fits[0].error + fits[1].error;
+
+    if ( error >= best_error )
+      continue;
+
+    std::uint64_t bits = 0;
+
+    if ( differential )
+    {
+      for ( ure::uint_t c = 0; c < 3; ++c )
+      {
+        const std::uint64_t delta = static_cast<std::uint64_t>( ( q[1][c] - q[0][c] ) & 0x7 );
+
+        bits |= ( static_cast<std::uint64_t>( q[0][c] ) << ( 59 - c * 8 ) ) | ( delta << ( 56 - c * 8 ) );
+      }
+    }
+    else
+    {
+      for ( ure::uint_t c = 0; c < 3; ++c )
+        bits |= ( static_cast<std::uint64_t>( q[0][c] ) << ( 60 - c * 8 ) ) | ( static_cast<std::uint64_t>( q[1][c] ) << ( 56 - c * 8 ) );
+    }
+
+    bits |= static_cast<std::uint64_t>( fits[0].table ) << 37;
+    bits |= static_cast<std::uint64_t>( fits[1].table ) << 34;
+    bits |= static_cast<std::uint64_t>( differential ? 1 : 0 ) << 33;
+    bits |= static_cast<std::uint64_t>( flip ) << 32;
+
+    // Pixel indices: most significant bits in 31..16, least significant in 15..0
+    for ( ure::uint_t s = 0; s < 2; ++s )
+    {
+      for ( ure::uint_t p = 0; p < 8; ++p )
+      {
+        const std::uint64_t index = fits[s].index[p];
+        const ure::uint_t   pos   = positions[s][p];
+
+        bits |= ( ( index >> 1 ) & 1 ) << ( 16 + pos );
+        bits |= ( index & 1 ) << pos;
+      }
+    }
+
+    best_bits  = bits;
+    best_error = error;
+  }
+
+  // Blocks are stored big endian
+  for ( ure::uint_t i = 0; i < block_bytes; ++i )
+    block[i] = static_cast<ure::byte_t>( best_bits >> ( 56 - i * 8 ) );
+}
@@ -0,0 +1,424 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "heatmap_grid.h"
+#include "fixed_point.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define HEATMAP_GRID_SSE2
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+# define HEATMAP_GRID_NEON
+#endif
+
+namespace
+{
+  constexpr ure::uint_t     k_max_radius = 32;
+
+  /** Floor of log2( @p value ), 0 for 0 */
+  ure::uint_t    log2( ure::uint_t value ) noexcept
+  {
+    ure::uint_t shift = 0;
+
+    while ( ( value >> ( shift + 1 ) ) != 0 )
+      ++shift;
+
+    return shift;
+  }
+
+  /**
+   * Blue to red through cyan, green and yellow, transparent for empty cells and
+   * increasingly opaque with the density.
+   */
+  struct ramp_t
+  {
+    std::uint32_t   rgba[256];
+
+    ramp_t() noexcept
+    {
+      const ure::float_t stops[5][4] = {
+                                         { 0.0f,   0.0f, 1.0f, 0.35f },
+                                         { 0.0f,   1.0f, 1.0f, 0.55f },
+                                         { 0.0f,   1.0f, 0.0f, 0.65f },
+                                         { 1.0f,   1.0f, 0.0f, 0.75f },
+                                         { 1.0f,   0.0f, 0.0f, 0.85f }
+                                       };
+
+      for ( ure::uint_t i = 0; i < 256; ++i )
+      {
+        const ure::float_t  t = i / 255.0f * 4.0f;
+        const ure::uint_t   s = std::min( 3u, static_cast<ure::uint_t>( t ) );
+        const ure::float_t  f = t - s;
+        ure::byte_t         c[4];
+
+        for ( ure::uint_t k = 0; k < 4; ++k )
+          c[k] = static_cast<ure::byte_t>( 255.0f * ( stops[s][k] + ( stops[s + 1][k] - stops[s][k] ) * f ) + 0.5f );
+
+        // Fade in from fully transparent over the first stop
+        if ( i < 64 )
+          c[3] = static_cast<ure::byte_t>( c[3] * i / 64 );
+
+        std::memcpy( &rgba[i], c, 4 );
+      }
+    }
+  };
+
+  const ramp_t  k_ramp;
+
+  /**
+   * @p out[x] = sum of @p weights[k] * @p rows[k][x], for x in [0, @p count).
+   */
+  ure::void_t  weighted_sum( const ure::float_t* const* rows, const ure::float_t* weights, ure::uint_t taps,
+                             ure::uint_t count, ure::float_t* out ) noexcept
+  {
+    ure::uint_t x = 0;
+
+#if defined(HEATMAP_GRID_SSE2)
+    for ( ; x + 4 <= count; x += 4 )
+    {
+      __m128 sum = _mm_setzero_ps();
+
+      for ( ure::uint_t k = 0; k < taps; ++k )
+        sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( weights[k] ), _mm_loadu_ps( rows[k] + x ) ) );
+
+      _mm_storeu_ps( out + x, sum );
+    }
+#elif defined(HEATMAP_GRID_NEON)
+    for ( ; x + 4 <= count; x += 4 )
+    {
+      float32x4_t sum = vdupq_n_f32( 0.0f );
+
+      for ( ure::uint_t k = 0; k < taps; ++k )
+        sum = vmlaq_n_f32( sum, vld1q_f32( rows[k] + x ), weights[k] );
+
+      vst1q_f32( out + x, sum );
+    }
+#endif
+
+    for ( ; x < count; ++x )
+    {
+      ure::float_t sum = 0.0f;
+
+      for ( ure::uint_t k = 0; k < taps; ++k )
+        sum += weights[k] * rows[k][x];
+
+      out[x] = sum;
+    }
+  }
+}
+
+HeatmapGrid::HeatmapGrid( ure::uint_t tile_pixels ) noexcept(true)
+  : m_tile_shift( log2( tile_pixels ) ), m_cell_shift(2), m_radius(0), m_level(0), m_cell_x(0), m_cell_y(0),
+    m_width(0), m_height(0), m_scale(0.0f), m_dirty{ 1, 0 }
+{
+  set_style( 4, 4 );
+}
+
+ure::void_t   HeatmapGrid::set_style( ure::uint_t cell_pixels, ure::uint_t radius ) noexcept(true)
+{
+  m_cell_shift = log2( cell_pixels );
+  m_radius     = std::min( radius, k_max_radius );
+
+  // Gaussian with the radius at two standard deviations, the sum of counts is kept
+  const ure::double_t  sigma = std::max( 0.5, m_radius / 2.0 );
+  ure::double_t        total = 0.0;
+
+  m_kernel.resize( 2 * m_radius + 1 );
+
+  for ( ure::uint_t k = 0; k < m_kernel.size(); ++k )
+  {
+    const ure::double_t d = static_cast<ure::double_t>( k ) - m_radius;
+
+    m_kernel[k] = static_cast<ure::float_t>( std::exp( -d * d / ( 2.0 * sigma * sigma ) ) );
+    total      += m_kernel[k];
+  }
+
+  for ( ure::float_t& weight : m_kernel )
+    weight = static_cast<ure::float_t>( weight / total );
+
+  m_width  = 0;
+  m_height = 0;
+}
+
+ure::void_t   HeatmapGrid::add( const std::vector<point_t>& points ) noexcept(true)
+{
+  const std::size_t first = m_x.size();
+
+  m_x.resize( first + points.size() );
+  m_y.resize( first + points.size() );
+
+  for ( std::size_t i = 0; i < points.size(); ++i )
+  {
+    m_x[ first + i ] = FixedPoint::from_normalized( points[i].x );
+    m_y[ first + i ] = FixedPoint::from_normalized( points[i].y );
+  }
+
+  if ( ( m_width == 0 ) || ( m_height == 0 ) )
+    return;
+
+  const ure::uint_t  shift = this->shift();
+  ure::uint_t        rows[2];
+
+  bin( m_x.data() + first, m_y.data() + first, points.size(),
+       static_cast<std::uint32_t>( m_cell_x << shift ), static_cast<std::uint32_t>( m_cell_y << shift ),
+       shift, m_width, m_height, m_counts.data(), rows );
+
+  touch( rows );
+}
+
+ure::void_t   HeatmapGrid::reset( ure::uint_t level, std::int64_t cell_x, std::int64_t cell_y, ure::uint_t width, ure::uint_t height ) noexcept(true)
+{
+  // Cells must be at least two fixed point units, see bin()
+  level = std::min( level, 31 + m_cell_shift - m_tile_shift );
+
+  const ure::int_t    cells  = static_cast<ure::int_t>( m_tile_shift + level ) - static_cast<ure::int_t>( m_cell_shift );
+  const std::int64_t  world  = ( cells > 0 ) ? ( std::int64_t(1) << cells ) : 1;
+
+  // Fixed point coordinates do not wrap, the grid stays within the world
+  const std::int64_t  x0     = std::clamp<std::int64_t>( cell_x, 0, world );
+  const std::int64_t  y0     = std::clamp<std::int64_t>( cell_y, 0, world );
+  const std::int64_t  x1     = std::clamp<std::int64_t>( cell_x + width , x0, std::min<std::int64_t>( world, x0 + max_size() ) );
+  const std::int64_t  y1     = std::clamp<std::int64_t>( cell_y + height, y0, std::min<std::int64_t>( world, y0 + max_size() ) );
+
+  m_level  = level;
+  m_cell_x = x0;
+  m_cell_y = y0;
+  m_width  = static_cast<ure::uint_t>( x1 - x0 );
+  m_height = static_cast<ure::uint_t>( y1 - y0 );
+  m_scale  = 0.0f;
+  m_dirty[0] = 1;
+  m_dirty[1] = 0;
+
+  const std::size_t  size = std::size_t(m_width) * m_height;
+
+  m_counts.assign( size, 0 );
+  m_rows.assign( size, 0.0f );
+  m_density.assign( size, 0.0f );
+  m_pixels.assign( size * 4, 0 );
+  m_line.assign( m_width + 2 * m_radius, 0.0f );
+
+  if ( size == 0 )
+    return;
+
+  const ure::uint_t  shift = this->shift();
+  ure::uint_t        rows[2];
+
+  bin( m_x.data(), m_y.data(), m_x.size(),
+       static_cast<std::uint32_t>( m_cell_x << shift ), static_cast<std::uint32_t>( m_cell_y << shift ),
+       shift, m_width, m_height, m_counts.data(), rows );
+
+  // Empty rows are transparent as well, they must be uploaded once
+  m_dirty[0] = 0;
+  m_dirty[1] = m_height - 1;
+}
+
+ure::bool_t   HeatmapGrid::update( ure::uint_t& first, ure::uint_t& count ) noexcept(true)
+{
+  if ( ( m_width == 0 ) || ( m_dirty[0] > m_dirty[1] ) )
+    return false;
+
+  const ure::uint_t  changed_first = m_dirty[0];
+  const ure::uint_t  changed_last  = m_dirty[1];
+  const ure::uint_t  taps          = static_cast<ure::uint_t>( m_kernel.size() );
+
+  m_dirty[0] = 1;
+  m_dirty[1] = 0;
+
+  // Horizontal pass on rows whose counts changed, the kernel slides over a padded copy
+  std::vector<const ure::float_t*>  rows( taps );
+
+  for ( ure::uint_t y = changed_first; y <= changed_last; ++y )
+  {
+    const std::uint32_t* counts = m_counts.data() + std::size_t(y) * m_width;
+
+    for ( ure::uint_t x = 0; x < m_width; ++x )
+      m_line[ m_radius + x ] = static_cast<ure::float_t>( counts[x] );
+
+    for ( ure::uint_t k = 0; k < taps; ++k )
+      rows[k] = m_line.data() + k;
+
+    weighted_sum( rows.data(), m_kernel.data(), taps, m_width, m_rows.data() + std::size_t(y) * m_width );
+  }
+
+  // Vertical pass on every row within the radius of a changed one
+  const ure::uint_t  first_row = ( changed_first > m_radius ) ? changed_first - m_radius : 0;
+  const ure::uint_t  last_row  = std::min( m_height - 1, changed_last + m_radius );
+  ure::float_t       peak      = 0.0f;
+
+  for ( ure::uint_t y = first_row; y <= last_row; ++y )
+  {
+    const ure::uint_t  k0 = ( y < m_radius ) ? m_radius - y : 0;
+    const ure::uint_t  k1 = std::min( taps, m_height + m_radius - y );
+
+    for ( ure::uint_t k = k0; k < k1; ++k )
+      rows[k - k0] = m_rows.data() + std::size_t( y + k - m_radius ) * m_width;
+
+    ure::float_t* density = m_density.data() + std::size_t(y) * m_width;
+
+    weighted_sum( rows.data(), m_kernel.data() + k0, k1 - k0, m_width, density );
+
+    peak = std::max( peak, *std::max_element( density, density + m_width ) );
+  }
+
+  // Densities only grow, a new peak rescales the whole grid with some headroom
+  if ( peak > m_scale )
+  {
+    m_scale = peak * 1.25f;
+    first   = 0;
+    count   = m_height;
+  }
+  else
+  {
+    first   = first_row;
+    count   = last_row - first_row + 1;
+  }
+
+  colour( first, first + count );
+
+  return true;
+}
+
+ure::void_t   HeatmapGrid::bin( const std::uint32_t* x, const std::uint32_t* y, std::size_t count,
+                                std::uint32_t x0, std::uint32_t y0, ure::uint_t shift, ure::uint_t width, ure::uint_t height,
+                                std::uint32_t* cells, ure::uint_t (&rows)[2] ) noexcept(true)
+{
+  // Points left of or above the grid wrap to offsets beyond it, shift >= 1 keeps them positive
+  ure::uint_t  first = height;
+  ure::uint_t  last  = 0;
+  std::size_t  i     = 0;
+
+  const auto   add = [&]( std::uint32_t cx, std::uint32_t cy ) {
+    ++cells[ std::size_t(cy) * width + cx ];
+    first = std::min<ure::uint_t>( first, cy );
+    last  = std::max<ure::uint_t>( last , cy );
+  };
+
+#if defined(HEATMAP_GRID_SSE2)
+  const __m128i  vx0   = _mm_set1_epi32( static_cast<int>( x0 ) );
+  const __m128i  vy0   = _mm_set1_epi32( static_cast<int>( y0 ) );
+  const __m128i  vw    = _mm_set1_epi32( static_cast<int>( width  ) );
+  const __m128i  vh    = _mm_set1_epi32( static_cast<int>( height ) );
+  const __m128i  vs    = _mm_cvtsi32_si128( static_cast<int>( shift ) );
+
+  for ( ; i + 4 <= count; i += 4 )
+  {
+    const __m128i  cx = _mm_srl_epi32( _mm_sub_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( x + i ) ), vx0 ), vs );
+    const __m128i  cy = _mm_srl_epi32( _mm_sub_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( y + i ) ), vy0 ), vs );
+    const int      in = _mm_movemask_ps( _mm_castsi128_ps( _mm_and_si128( _mm_cmplt_epi32( cx, vw ), _mm_cmplt_epi32( cy, vh ) ) ) );
+
+    if ( in == 0 )
+      continue;
+
+    alignas(16) std::uint32_t  lx[4];
+    alignas(16) std::uint32_t  ly[4];
+
+    _mm_store_si128( reinterpret_cast<__m128i*>( lx ), cx );
+    _mm_store_si128( reinterpret_cast<__m128i*>( ly ), cy );
+
+    for ( ure::uint_t lane = 0; lane < 4; ++lane )
+    {
+      if ( in & ( 1 << lane ) )
+        add( lx[lane], ly[lane] );
+    }
+  }
+#elif defined(HEATMAP_GRID_NEON)
+  const uint32x4_t  vx0  = vdupq_n_u32( x0 );
+  const uint32x4_t  vy0  = vdupq_n_u32( y0 );
+  const uint32x4_t  vw   = vdupq_n_u32( width  );
+  const uint32x4_t  vh   = vdupq_n_u32( height );
+  const int32x4_t   vs   = vdupq_n_s32( -static_cast<std::int32_t>( shift ) );
+
+  for ( ; i + 4 <= count; i += 4 )
+  {
+    const uint32x4_t  cx = vshlq_u32( vsubq_u32( vld1q_u32( x + i ), vx0 ), vs );
+    const uint32x4_t  cy = vshlq_u32( vsubq_u32( vld1q_u32( y + i ), vy0 ), vs );
+    const uint32x4_t  in = vandq_u32( vcltq_u32( cx, vw ), vcltq_u32( cy, vh ) );
+    const uint32x2_t  any = vorr_u32( vget_low_u32( in ), vget_high_u32( in ) );
+
+    if ( ( vget_lane_u32( any, 0 ) | vget_lane_u32( any, 1 ) ) == 0 )
+      continue;
+
+    std::uint32_t  lx[4];
+    std::uint32_t  ly[4];
+    std::uint32_t  li[4];
+
+    vst1q_u32( lx, cx );
+    vst1q_u32( ly, cy );
+    vst1q_u32( li, in );
+
+    for ( ure::uint_t lane = 0; lane < 4; ++lane )
+    {
+      if ( li[lane] != 0 )
+        add( lx[lane], ly[lane] );
+    }
+  }
+#endif
+
+  for ( ; i < count; ++i )
+  {
+    const std::uint32_t  cx = ( x[i] - x0 ) >> shift;
+    const std::uint32_t  cy = ( y[i] - y0 ) >> shift;
+
+    if ( ( cx < width ) && ( cy < height ) )
+      add( cx, cy );
+  }
+
+  rows[0] = first;
+  rows[1] = last;
+}
+
+ure::uint_t   HeatmapGrid::shift() const noexcept(true)
+{
+  return 32 + m_cell_shift - m_tile_shift - m_level;
+}
+
+ure::void_t   HeatmapGrid::touch( const ure::uint_t (&rows)[2] ) noexcept(true)
+{
+  if ( rows[0] > rows[1] )
+    return;
+
+  if ( m_dirty[0] > m_dirty[1] )
+  {
+    m_dirty[0] = rows[0];
+    m_dirty[1] = rows[1];
+    return;
+  }
+
+  m_dirty[0] = std::min( m_dirty[0], rows[0] );
+  m_dirty[1] = std::max( m_dirty[1], rows[1] );
+}
+
+ure::void_t   HeatmapGrid::colour( ure::uint_t first, ure::uint_t last ) noexcept(true)
+{
+  const ure::float_t    inverse = ( m_scale > 0.0f ) ? 1.0f / m_scale : 0.0f;
+  const ure::float_t*   density = m_density.data() + std::size_t(first) * m_width;
+  ure::byte_t*          pixels  = m_pixels.data()  + std::size_t(first) * m_width * 4;
+  const std::size_t     size    = std::size_t( last - first ) * m_width;
+
+  // Square root spreads the ramp over sparse areas, hot spots would take all of it otherwise
+  for ( std::size_t i = 0; i < size; ++i, pixels += 4 )
+  {
+    const ure::float_t  t     = std::min( 1.0f, density[i] * inverse );
+    const ure::uint_t   index = static_cast<ure::uint_t>( std::sqrt( t ) * 255.0f );
+
+    std::memcpy( pixels, &k_ramp.rgba[index], 4 );
+  }
+}
@@ -0,0 +1,242 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "heatmap_renderer.h"
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+HeatmapRenderer::HeatmapRenderer() noexcept(true)
+  : m_shaders_path( "./resources/shaders/" ), m_failed(false), m_program(0),
+    m_a_point(-1), m_a_texcoord(-1), m_u_mvp(-1), m_u_texture(-1),
+    m_texture(0), m_vbo(0), m_width(0), m_height(0), m_uploaded(0)
+{
+}
+
+HeatmapRenderer::~HeatmapRenderer() noexcept(true)
+{
+  dispose();
+}
+
+ure::void_t   HeatmapRenderer::set_shaders_path( const std::string& path ) noexcept(true)
+{
+  m_shaders_path = path;
+}
+
+ure::bool_t   HeatmapRenderer::upload( const ure::byte_t* pixels, ure::uint_t width, ure::uint_t height, ure::uint_t first, ure::uint_t count ) noexcept(true)
+{
+  if ( init() == false )
+    return false;
+
+  if ( ( width == 0 ) || ( height == 0 ) )
+  {
+    m_width  = 0;
+    m_height = 0;
+    return true;
+  }
+
+  glBindTexture( GL_TEXTURE_2D, m_texture );
+
+  if ( ( width != m_width ) || ( height != m_height ) )
+  {
+    // RGBA rows are always 4 byte aligned, the default unpack alignment fits
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+
+    m_width     = width;
+    m_height    = height;
+    m_uploaded += std::uint64_t(width) * height * 4;
+  }
+  else if ( count > 0 )
+  {
+    const std::size_t offset = std::size_t(first) * width * 4;
+
+    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, static_cast<GLint>(first), static_cast<GLsizei>(width), static_cast<GLsizei>(count),
+                     GL_RGBA, GL_UNSIGNED_BYTE, pixels + offset );
+
+    m_uploaded += std::uint64_t(width) * count * 4;
+  }
+
+  glBindTexture( GL_TEXTURE_2D, 0 );
+
+  return true;
+}
+
+ure::uint_t   HeatmapRenderer::draw( const glm::mat4& mvp, const glm::vec2& min, const glm::vec2& max ) noexcept(true)
+{
+  if ( ( m_program == 0 ) || ( m_width == 0 ) || ( m_height == 0 ) )
+    return 0;
+
+  const vertex_t  quad[4] = {
+                              { min.x, min.y, 0.0f, 0.0f },
+                              { max.x, min.y, 1.0f, 0.0f },
+                              { min.x, max.y, 0.0f, 1.0f },
+                              { max.x, max.y, 1.0f, 1.0f }
+                            };
+
+  const GLboolean blend = glIsEnabled( GL_BLEND );
+  if ( blend == GL_FALSE )
+  {
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  }
+
+  glUseProgram( m_program );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+  glUniform1i( m_u_texture, 0 );
+
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, m_texture );
+
+  glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+  glBufferData( GL_ARRAY_BUFFER, sizeof(quad), quad, GL_DYNAMIC_DRAW );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_point)   , 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, x) ) );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_texcoord), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, u) ) );
+
+  glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glBindTexture( GL_TEXTURE_2D, 0 );
+  glUseProgram( 0 );
+
+  if ( blend == GL_FALSE )
+    glDisable( GL_BLEND );
+
+  return 1;
+}
+
+ure::void_t   HeatmapRenderer::dispose() noexcept(true)
+{
+  if ( m_program != 0 )
+    glDeleteProgram( m_program );
+  if ( m_texture != 0 )
+    glDeleteTextures( 1, &m_texture );
+  if ( m_vbo != 0 )
+    glDeleteBuffers( 1, &m_vbo );
+
+  m_program = 0;
+  m_texture = 0;
+  m_vbo     = 0;
+  m_width   = 0;
+  m_height  = 0;
+}
+
+ure::bool_t   HeatmapRenderer::init() noexcept(true)
+{
+  if ( m_program != 0 )
+    return true;
+
+  if ( m_failed )
+    return false;
+
+  m_failed = true;
+
+  GLuint vs = compile( GL_VERTEX_SHADER  , "DefaultTexture.vs" );
+  GLuint fs = compile( GL_FRAGMENT_SHADER, "DefaultTexture.fs" );
+
+  if ( ( vs == 0 ) || ( fs == 0 ) )
+  {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader( program, vs );
+  glAttachShader( program, fs );
+  glLinkProgram ( program );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &linked );
+  if ( linked != GL_TRUE )
+  {
+    ure::utils::log( "HeatmapRenderer: unable to link DefaultTexture program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_a_point    = glGetAttribLocation ( program, "a_v2Point"    );
+  m_a_texcoord = glGetAttribLocation ( program, "a_v2TexCoord" );
+  m_u_mvp      = glGetUniformLocation( program, "u_m4MVP"      );
+  m_u_texture  = glGetUniformLocation( program, "u_2dTexture"  );
+
+  if ( ( m_a_point < 0 ) || ( m_a_texcoord < 0 ) )
+  {
+    ure::utils::log( "HeatmapRenderer: missing attributes in DefaultTexture program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  // Cells are larger than pixels, linear filtering smooths their edges
+  glGenTextures( 1, &m_texture );
+  glBindTexture( GL_TEXTURE_2D, m_texture );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glBindTexture( GL_TEXTURE_2D, 0 );
+
+  glGenBuffers( 1, &m_vbo );
+
+  m_program = program;
+  m_failed  = false;
+
+  return true;
+}
+
+GLuint   HeatmapRenderer::compile( GLenum type, const std::string& file ) noexcept(true)
+{
+  std::ifstream      stream( m_shaders_path + file );
+  std::stringstream  source;
+
+  if ( !stream )
+  {
+    ure::utils::log( "HeatmapRenderer: unable to read shader [" + m_shaders_path + file + "]" );
+    return 0;
+  }
+
+  source << stream.rdbuf();
+
+  const std::string  text = source.str();
+  const GLchar*      ptr  = text.c_str();
+
+  GLuint shader = glCreateShader( type );
+  glShaderSource ( shader, 1, &ptr, nullptr );
+  glCompileShader( shader );
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+  if ( compiled != GL_TRUE )
+  {
+    GLchar  log[512] = { 0 };
+    glGetShaderInfoLog( shader, sizeof(log), nullptr, log );
+
+    ure::utils::log( "HeatmapRenderer: unable to compile [" + file + "]: " + log );
+    glDeleteShader( shader );
+    return 0;
+  }
+
+  return shader;
+}
@@ -0,0 +1,116 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "heatmap_set.h"
+#include "tile_range.h"
+
+#include <algorithm>
+#include <cmath>
+
+HeatmapSet::HeatmapSet( ure::uint_t tile_pixels ) noexcept(true)
+  : m_tile_pixels( std::max( 1u, tile_pixels ) ), m_grid( m_tile_pixels ), m_zoom(0),
+    m_origin(0.0f), m_model(1.0f), m_fb_size{0,0}, m_stale(true), m_resets(0)
+{
+}
+
+ure::void_t   HeatmapSet::set_style( ure::uint_t cell_pixels, ure::uint_t radius ) noexcept(true)
+{
+  m_grid.set_style( std::max( 1u, cell_pixels ), radius );
+  m_stale = true;
+}
+
+ure::void_t   HeatmapSet::set_zoom( ure::word_t zoom ) noexcept(true)
+{
+  m_zoom = zoom;
+}
+
+ure::void_t   HeatmapSet::set_origin( const glm::vec2& origin ) noexcept(true)
+{
+  m_origin = origin;
+}
+
+ure::void_t   HeatmapSet::set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true)
+{
+  m_model   = model;
+  m_fb_size = fb_size;
+}
+
+ure::uint_t   HeatmapSet::draw() noexcept(true)
+{
+  if ( m_grid.size() == 0 )
+    return 0;
+
+  std::int64_t  x0 = 0;
+  std::int64_t  y0 = 0;
+  std::int64_t  x1 = 0;
+  std::int64_t  y1 = 0;
+
+  if ( view_cells( x0, y0, x1, y1 ) == false )
+    return 0;
+
+  const ure::bool_t  inside = ( x0 >= m_grid.cell_x() ) && ( x1 <= m_grid.cell_x() + m_grid.width()  ) &&
+                              ( y0 >= m_grid.cell_y() ) && ( y1 <= m_grid.cell_y() + m_grid.height() );
+
+  if ( m_stale || ( m_grid.level() != m_zoom ) || ( inside == false ) )
+  {
+    // Half a viewport on every side, slow pans reuse the same grid for a while
+    const std::int64_t  dx = ( x1 - x0 + 1 ) / 2;
+    const std::int64_t  dy = ( y1 - y0 + 1 ) / 2;
+
+    m_grid.reset( m_zoom, x0 - dx, y0 - dy, static_cast<ure::uint_t>( x1 - x0 + 2 * dx ), static_cast<ure::uint_t>( y1 - y0 + 2 * dy ) );
+    m_stale = false;
+    ++m_resets;
+
+    if ( m_grid.width() == 0 )
+      m_renderer.upload( nullptr, 0, 0, 0, 0 );
+  }
+
+  ure::uint_t  first = 0;
+  ure::uint_t  count = 0;
+
+  if ( m_grid.update( first, count ) )
+    m_renderer.upload( m_grid.pixels().data(), m_grid.width(), m_grid.height(), first, count );
+
+  // Grid corner is far from tile (0,0) at deep levels, placed relative to the origin in double
+  const ure::double_t cell = static_cast<ure::double_t>( m_grid.cell_pixels() );
+  const glm::vec2     min( static_cast<ure::float_t>( m_origin.x + cell * m_grid.cell_x() ), static_cast<ure::float_t>( m_origin.y + cell * m_grid.cell_y() ) );
+  const glm::vec2     max( static_cast<ure::float_t>( min.x + cell * m_grid.width() ), static_cast<ure::float_t>( min.y + cell * m_grid.height() ) );
+
+  return m_renderer.draw( m_model, min, max );
+}
+
+ure::bool_t   HeatmapSet::view_cells( std::int64_t& x0, std::int64_t& y0, std::int64_t& x1, std::int64_t& y1 ) const noexcept(true)
+{
+  if ( ( m_fb_size.width == 0 ) || ( m_fb_size.height == 0 ) )
+    return false;
+
+  glm::vec2  min( 0.0f );
+  glm::vec2  max( 0.0f );
+
+  if ( visible_area( m_model, m_fb_size, min, max ) == false )
+    return false;
+
+  // Cells partially in view included, the grid is clamped to the world by reset()
+  const ure::double_t  cell  = m_grid.cell_pixels();
+  const ure::double_t  world = std::ldexp( static_cast<ure::double_t>( m_tile_pixels ), m_zoom ) / cell;
+
+  x0 = static_cast<std::int64_t>( std::floor( std::clamp( ( min.x - static_cast<ure::double_t>(m_origin.x) ) / cell, 0.0, world ) ) );
+  y0 = static_cast<std::int64_t>( std::floor( std::clamp( ( min.y - static_cast<ure::double_t>(m_origin.y) ) / cell, 0.0, world ) ) );
+  x1 = static_cast<std::int64_t>( std::ceil ( std::clamp( ( max.x - static_cast<ure::double_t>(m_origin.x) ) / cell, 0.0, world ) ) );
+  y1 = static_cast<std::int64_t>( std::ceil ( std::clamp( ( max.y - static_cast<ure::double_t>(m_origin.y) ) / cell, 0.0, world ) ) );
+
+  return ( x0 < x1 ) && ( y0 < y1 );
+}
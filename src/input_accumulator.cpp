@@ -0,0 +1,115 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "input_accumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /* A drag released after the cursor stood still this long does not throw the map */
+  constexpr std::chrono::milliseconds  release_expiry( 50 );
+  /* Weight of the newest sample in the velocity average */
+  constexpr ure::float_t               smoothing = 0.5f;
+}
+
+InputAccumulator::InputAccumulator( ure::float_t tau, ure::float_t min_speed ) noexcept(true)
+  : m_tau( std::max( tau, 1e-3f ) ), m_min_speed(min_speed),
+    m_pan( 0.0f ), m_sampled( 0.0f ), m_notches(0.0f), m_anchor( 0.0f ), m_velocity( 0.0f ),
+    m_dragging(false), m_moved_at(), m_sampled_at(), m_time()
+{
+}
+
+ure::void_t   InputAccumulator::grab( clock_t::time_point now ) noexcept(true)
+{
+  m_dragging   = true;
+  m_velocity   = glm::vec2( 0.0f );
+  m_sampled    = m_pan;
+  m_sampled_at = now;
+}
+
+ure::void_t   InputAccumulator::pan( const glm::vec2& delta, clock_t::time_point now ) noexcept(true)
+{
+  m_pan     += delta;
+  m_moved_at = now;
+}
+
+ure::void_t   InputAccumulator::scroll( ure::float_t notches, const glm::vec2& anchor ) noexcept(true)
+{
+  m_notches += notches;
+  m_anchor   = anchor;
+}
+
+ure::void_t   InputAccumulator::release( clock_t::time_point now ) noexcept(true)
+{
+  if ( m_dragging == false )
+    return;
+
+  sample( now );
+
+  m_dragging = false;
+  m_time     = now;
+
+  // Cursor stopped before the button was released, the drag ends where it is
+  if ( ( now - m_moved_at > release_expiry ) || ( glm::length( m_velocity ) < m_min_speed ) )
+    m_velocity = glm::vec2( 0.0f );
+}
+
+ure::bool_t   InputAccumulator::take( clock_t::time_point now, frame_t& frame ) noexcept(true)
+{
+  if ( m_dragging )
+    sample( now );
+
+  frame.pan     = m_pan;
+  frame.notches = m_notches;
+  frame.anchor  = m_anchor;
+
+  m_pan     = glm::vec2( 0.0f );
+  m_sampled = glm::vec2( 0.0f );
+  m_notches = 0.0f;
+
+  if ( coasting() && ( now > m_time ) )
+  {
+    // Exact integral of the decaying velocity over the frame, independent of the frame rate
+    const ure::float_t  dt    = std::chrono::duration<ure::float_t>( now - m_time ).count();
+    const ure::float_t  decay = std::exp( -dt / m_tau );
+
+    frame.pan  += m_velocity * ( m_tau * ( 1.0f - decay ) );
+    m_velocity *= decay;
+    m_time      = now;
+
+    if ( glm::length( m_velocity ) < m_min_speed )
+      m_velocity = glm::vec2( 0.0f );
+  }
+
+  return ( frame.pan.x != 0.0f ) || ( frame.pan.y != 0.0f ) || ( frame.notches != 0.0f );
+}
+
+ure::void_t   InputAccumulator::sample( clock_t::time_point now ) noexcept(true)
+{
+  const std::chrono::duration<ure::float_t> dt = now - m_sampled_at;
+
+  if ( dt.count() <= 0.0f )
+    return;
+
+  // Frames without drag events while dragging are samples too, the cursor is slowing down
+  const glm::vec2 sample = ( m_pan - m_sampled ) * ( 1.0f / dt.count() );
+
+  m_velocity   = m_velocity * ( 1.0f - smoothing ) + sample * smoothing;
+  m_sampled    = m_pan;
+  m_sampled_at = now;
+}
@@ -15,7 +15,11 @@
  *************************************************************************************************/
 
 #include "map.h"
+#include "heatmap_layer.h"
+#include "marker_layer.h"
 #include "tile_layer.h"
+#include "track_layer.h"
+#include "vector_tile_layer.h"
 
 #include <ure_utils.h>
 #include <ure_image.h>
@@ -24,12 +28,28 @@
 #include <ure_scene_graph.h>
 #include <ure_scene_layer_node.h>
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
 
 #include <core/utils.h>
   
 Map::Map( int argc, char** argv )
   : m_bFullScreen(false), m_position{0,0}, m_size{1024,768}, m_fb_size{0,0},
-    m_tile_size{256,256}, m_maxLevels( 19 ), m_curLevel(0)
+    m_tile_size{256,256}, m_tiles( m_tile_size, 128u << 20 ),
+    m_max_uploads(32), m_upload_budget(4000), m_upload_bytes(2u << 20), m_continuous(false), m_idle_wait(10), m_refresh_interval(1000), m_refresh_at{},
+    m_maxLevels( 19 ), m_curLevel(0), m_drawLevel(0), m_view( m_maxLevels ),
+    m_levelsWindow(2), m_layer_nodes(0), m_vector_node(nullptr), m_random_markers(0), m_random_tracks(0),
+    m_random_heatmap(0), m_heatmap_rate(0), m_heatmap_batches(0), m_heatmap_fed_at{}
+#if MAP_ENABLE_METRICS
+    , m_show_metrics(false)
+#endif
 {
   m_rc = std::make_unique<ure::ResourcesCollector>();
 
@@ -45,6 +65,28 @@ void Map::run()
 
 void Map::dispose()
 {
+  // GL objects owned by tiles must go while the context is still alive
+  m_tiles.dispose();
+
+  if ( m_vector != nullptr )
+    m_vector->dispose();
+
+  if ( m_track_layer != nullptr )
+    m_track_layer->TrackSet::dispose();
+
+  if ( m_heatmap_layer != nullptr )
+    m_heatmap_layer->HeatmapSet::dispose();
+
+  if ( m_marker_layer != nullptr )
+    m_marker_layer->MarkerSet::dispose();
+
+#if MAP_ENABLE_METRICS
+  m_metrics_overlay.dispose();
+
+  if ( ( m_metrics_dump.empty() == false ) && ( Metrics::instance().dump( m_metrics_dump ) == false ) )
+    ure::utils::log( "Unable to write metrics to [" + m_metrics_dump + "]" );
+#endif
+
   if ( m_pWindow != nullptr )
   {
     m_pWindow->destroy();
@@ -66,7 +108,98 @@ void Map::init( [[__maybe_unused__]] int argc, [[__maybe_unused__]] char** argv
 {
   const std::string sShadersPath( "./resources/shaders/" );
   const std::string sMediaPath  ( "./resources/media/" );
-  const std::string sTilesURL   ( "https://tile.openstreetmap.org/%u/%u/%u.png" ); 
+  std::string       sTilesURL   ( "https://tile.openstreetmap.org/%u/%u/%u.png" ); 
+  std::string       sCachePath  ( "./cache/tiles/" );
+  TileImage::format_t eTileFormat = TileImage::format_t::rgba8;
+  std::vector<std::pair<std::string, ure::float_t>> vOverlays;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string_view arg( argv[i] );
+
+    // Render every loop iteration instead of only when the view changes
+    if ( arg == "--continuous" )
+      m_continuous = true;
+
+    // Tiles from another server, e.g. the local tile_server: http://127.0.0.1:8080/{z}/{x}/{y}.png
+    // Disk cache is keyed by tile only, it is disabled to keep other tiles out of it
+    if ( ( arg == "--tiles-url" ) && ( i + 1 < argc ) )
+    {
+      sTilesURL = argv[++i];
+      sCachePath.clear();
+    }
+
+    // Tiles drawn over the base map, e.g. hillshade or labels, with an optional opacity: URL@0.5
+    // Disk cache tells sources apart by position only, it is disabled to keep other tiles out of it
+    if ( ( arg == "--overlay" ) && ( i + 1 < argc ) )
+    {
+      std::string         sURL( argv[++i] );
+      ure::float_t        fOpacity = 1.0f;
+      const std::size_t   at       = sURL.rfind( '@' );
+
+      if ( at != std::string::npos )
+      {
+        char*               end   = nullptr;
+        const ure::float_t  value = std::strtof( sURL.c_str() + at + 1, &end );
+
+        // Not an opacity, '@' belongs to the URL
+        if ( ( end != sURL.c_str() + at + 1 ) && ( *end == '\0' ) )
+        {
+          fOpacity = std::clamp( value, 0.0f, 1.0f );
+          sURL.resize( at );
+        }
+      }
+
+      vOverlays.emplace_back( std::move(sURL), fOpacity );
+      sCachePath.clear();
+    }
+
+    // Mapbox Vector Tiles drawn instead of raster tiles, e.g. http://127.0.0.1:8080/{z}/{x}/{y}.mvt
+    if ( ( arg == "--vector-url" ) && ( i + 1 < argc ) )
+      m_vector_url = argv[++i];
+
+    // Points of interest drawn over the tiles, one "lon,lat" pair per line
+    if ( ( arg == "--markers" ) && ( i + 1 < argc ) )
+      m_markers_path = argv[++i];
+
+    // Markers at random positions when no file is given, e.g. 1000000 to try clustering
+    if ( ( arg == "--random-markers" ) && ( i + 1 < argc ) )
+      m_random_markers = static_cast<ure::uint_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+
+    // Polylines drawn over the tiles, one "lon,lat" pair per line and an empty line between tracks
+    if ( ( arg == "--tracks" ) && ( i + 1 < argc ) )
+      m_tracks_path = argv[++i];
+
+    // Random walks when no file is given, e.g. 1000 tracks of 4096 vertices
+    if ( ( arg == "--random-tracks" ) && ( i + 1 < argc ) )
+      m_random_tracks = static_cast<ure::uint_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+
+    // Density of events drawn over the tiles, one "lon,lat" pair per line
+    if ( ( arg == "--heatmap" ) && ( i + 1 < argc ) )
+      m_heatmap_path = argv[++i];
+
+    // Events at random positions when no file is given, e.g. 1000000
+    if ( ( arg == "--random-heatmap" ) && ( i + 1 < argc ) )
+      m_random_heatmap = static_cast<ure::uint_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+
+    // Random events arriving while running, per second, e.g. 100000
+    if ( ( arg == "--heatmap-rate" ) && ( i + 1 < argc ) )
+      m_heatmap_rate = static_cast<ure::uint_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+
+    // Tiles stored as ETC2 on GLES3, RGB565 elsewhere: 4 to 8 times more resident tiles
+    if ( arg == "--compress-tiles" )
+      eTileFormat = TileImage::format_t::etc2_rgb8;
+
+#if MAP_ENABLE_METRICS
+    // Frame phases, cache and download metrics drawn over the map
+    if ( arg == "--metrics" )
+      m_show_metrics = true;
+
+    // Last frames metrics written on exit, CSV if the file name ends with .csv, JSON otherwise
+    if ( ( arg == "--metrics-dump" ) && ( i + 1 < argc ) )
+      m_metrics_dump = argv[++i];
+#endif
+  }
 
   ure::Application::initialize( core::unique_ptr<ure::ApplicationEvents>(this,false), sShadersPath );
 
@@ -129,11 +262,48 @@ void Map::init( [[__maybe_unused__]] int argc, [[__maybe_unused__]] char** argv
     return ;
   }
 
+#if MAP_ENABLE_METRICS
+  m_metrics_overlay.set_shaders_path( sShadersPath );
+#endif
+
+  if ( m_tiles.initialize( sShadersPath, sCachePath ) == false )
+  {
+    ure::utils::log( "Disk cache disabled, all tiles will be downloaded" );
+  }
+
+  eTileFormat = m_tiles.set_texture_format( eTileFormat );
+  ure::utils::log( core::utils::format( "Tile format:    [%s]", TileImage::name( eTileFormat ) ) );
+
+  // Base map first, overlays are stacked in command line order
+  m_tiles.add_source( sTilesURL );
+
+  for ( const auto& overlay : vOverlays )
+  {
+    if ( m_tiles.add_source( overlay.first, overlay.second ) == TileContext::max_sources() )
+    {
+      ure::utils::log( core::utils::format( "Too many tile sources, [%s] ignored", overlay.first.c_str() ) );
+      continue;
+    }
+
+    ure::utils::log( core::utils::format( "Overlay:        [%s] opacity %.2f", overlay.first.c_str(), overlay.second ) );
+  }
+
+  if ( m_vector_url.empty() == false )
+  {
+    m_vector = std::make_unique<VectorTileContext>( m_tile_size.width, 64u << 20, m_tiles.redraw() );
+
+    // Vector cache is keyed by tile only as well, kept apart from raster tiles
+    if ( m_vector->initialize( sShadersPath, "./cache/vector/" ) == false )
+      ure::utils::log( "Vector disk cache disabled, all vector tiles will be downloaded" );
+
+    ure::utils::log( core::utils::format( "Vector tiles:   [%s]", m_vector_url.c_str() ) );
+  }
+
   load_resources();
 
   add_camera();
 
-  add_zoom_levels( sTilesURL );
+  add_zoom_levels();
 }
 
 void Map::load_resources() noexcept(true)
@@ -166,98 +336,503 @@ void Map::add_camera() noexcept(true)
   }
 }
 
-void Map::add_zoom_levels( const std::string& url ) noexcept(true)
+void Map::add_zoom_levels() noexcept(true)
 {
-  for ( ure::int_t zl = 0; zl < max_levels(); zl++ )
+  //ure::float_t mx = m_size.width/2;
+  //ure::float_t my = m_size.height/2;
+  // Orthographic projection centred on the window, layers at its top left corner
+  m_view.reset( m_size, m_curLevel );
+  //glm::mat4 mModel = glm::mat4(1); //glm::ortho( -1.0f*mx, mx, my, -1.0f*my, 0.1f, 1000.0f );
+
+  // Levels are created on first use, only the table is allocated here
+  m_levels.assign( static_cast<std::size_t>(max_levels()), zoom_level_t{ nullptr, nullptr } );
+
+  m_drawLevel  = m_curLevel;
+
+  if ( m_vector != nullptr )
   {
-    std::shared_ptr<ure::widgets::Layer> layer = std::make_shared<TileLayer>( *m_pViewPort, m_tile_size, zl, url );
-    
-    m_pWindow->connect(layer->get_windows_events());
+    add_vector_layer();
+  }
+  else
+  {
+    TileLayer* layer = get_zoom_level( m_curLevel );
+    if ( layer != nullptr )
+    {
+      layer->set_visible( true );
+      layer->set_enabled( true );
+    }
+  }
 
-    layer->set_visible( (zl==0) );
-    layer->set_enabled( (zl==0) );
+  if ( ( m_tracks_path.empty() == false ) || ( m_random_tracks > 0 ) )
+    add_track_layer();
 
-    layer->set_position( -1.0f*m_size.width/2, -1.0f*m_size.height/2, true );
-    
-    auto texture = m_rc->find<ure::Texture>("0-0-0");
-    
-    if ( texture.has_value() )
-      layer->set_background( texture.value(), ure::widgets::Widget::BackgroundOptions::eboAsIs );
+  if ( ( m_heatmap_path.empty() == false ) || ( m_random_heatmap > 0 ) || ( m_heatmap_rate > 0 ) )
+    add_heatmap_layer();
 
-    ure::SceneLayerNode* pNode = new(std::nothrow) ure::SceneLayerNode( core::utils::format("Layer%d", zl ), layer );
-    
-    //ure::float_t mx = m_size.width/2;
-    //ure::float_t my = m_size.height/2;
-    glm::mat4 mModel =  glm::ortho( -1.0f*m_size.width/2, 1.0f*m_size.width/2, 1.0f*m_size.height/2, -1.0f*m_size.height/2 );
-    //glm::mat4 mModel = glm::mat4(1); //glm::ortho( -1.0f*mx, mx, my, -1.0f*my, 0.1f, 1000.0f );
+  if ( ( m_markers_path.empty() == false ) || ( m_random_markers > 0 ) )
+    add_marker_layer();
 
-    pNode->set_model_matrix( mModel );
-    pNode->get_model_matrix().translate( 0, 0, 0 );
+  update_view();
+}
+
+void Map::add_vector_layer() noexcept(true)
+{
+  std::shared_ptr<VectorTileLayer> layer = std::make_shared<VectorTileLayer>( *m_pViewPort, *m_vector, m_curLevel, m_vector_url );
+
+  m_pWindow->connect(layer->get_windows_events());
+
+  layer->set_position( -1.0f*m_size.width/2, -1.0f*m_size.height/2, true );
+  layer->set_origin( m_view.origin( m_curLevel ) );
+  layer->set_visible( true );
+  layer->set_enabled( true );
+
+  ure::SceneLayerNode* pNode = new(std::nothrow) ure::SceneLayerNode( core::utils::format("Layer%u", m_layer_nodes++ ), layer );
+  if ( pNode == nullptr )
+    return;
+
+  pNode->set_model_matrix( m_view.level_model( m_curLevel ) );
+
+  m_pViewPort->get_scene().add_scene_node( pNode );
+
+  m_vector_layer = std::move(layer);
+  m_vector_node  = pNode;
+}
+
+void Map::add_marker_layer() noexcept(true)
+{
+  std::vector<MarkerIndex::point_t> points;
 
-    m_pViewPort->get_scene().add_scene_node( pNode );  
+  if ( m_markers_path.empty() == false )
+  {
+    if ( MarkerIndex::read_csv( m_markers_path, points ) == false )
+      ure::utils::log( "Unable to read markers from [" + m_markers_path + "]" );
+  }
+  else
+  {
+    // Dense around a few places and sparse elsewhere, clusters show at every zoom
+    random_events( m_random_markers, 1, points );
   }
+
+  MarkerIndex index;
+  index.build( points );
+
+  ure::utils::log( core::utils::format( "Markers:        [%zu] %zu index nodes", index.size(), index.nodes() ) );
+
+  if ( index.empty() )
+    return;
+
+  std::shared_ptr<MarkerLayer> layer = std::make_shared<MarkerLayer>( *m_pViewPort, m_tile_size.width );
+
+  m_pWindow->connect(layer->get_windows_events());
+
+  layer->set_origin( m_view.origin( m_curLevel ) );
+  layer->set_markers( std::move(index) );
+  layer->set_visible( true );
+  layer->set_enabled( true );
+
+  m_marker_layer = std::move(layer);
 }
 
-/////////////////////////////////////////////////////
-// ure::WindowEvents implementation
-/////////////////////////////////////////////////////
+void Map::add_track_layer() noexcept(true)
+{
+  std::vector<TrackPyramid::track_t> tracks;
 
-ure::void_t  Map::on_mouse_scroll( [[maybe_unused]] ure::Window* pWindow, [[maybe_unused]] ure::double_t dOffsetX, [[maybe_unused]] ure::double_t dOffsetY ) noexcept 
+  if ( m_tracks_path.empty() == false )
+  {
+    if ( TrackPyramid::read_csv( m_tracks_path, tracks ) == false )
+      ure::utils::log( "Unable to read tracks from [" + m_tracks_path + "]" );
+  }
+  else
+  {
+    // Random walks with a slowly turning heading, as vehicles
+    std::mt19937                            rng( 2 );
+    std::uniform_real_distribution<double>  uniform( 0.0, 1.0 );
+    std::normal_distribution<double>        turn( 0.0, 0.2 );
+
+    tracks.resize( m_random_tracks );
+
+    for ( TrackPyramid::track_t& track : tracks )
+    {
+      TrackPyramid::point_t  point{ 0.25 + uniform( rng ) / 2.0, 0.25 + uniform( rng ) / 2.0 };
+      double                 heading = uniform( rng ) * 6.283185307179586;
+
+      track.reserve( 4096 );
+
+      for ( ure::uint_t i = 0; i < 4096; ++i )
+      {
+        track.push_back( point );
+
+        heading += turn( rng );
+        point.x += std::cos( heading ) * 2e-6;
+        point.y += std::sin( heading ) * 2e-6;
+      }
+    }
+  }
+
+  TrackPyramid pyramid;
+  pyramid.build( std::move(tracks), static_cast<ure::uint_t>( max_levels() ), m_tile_size.width );
+
+  ure::utils::log( core::utils::format( "Tracks:         [%zu] %zu vertices", pyramid.tracks().size(), pyramid.vertices() ) );
+
+  if ( pyramid.vertices() == 0 )
+    return;
+
+  std::shared_ptr<TrackLayer> layer = std::make_shared<TrackLayer>( *m_pViewPort, m_tile_size.width );
+
+  m_pWindow->connect(layer->get_windows_events());
+
+  layer->set_origin( m_view.origin( m_curLevel ) );
+  layer->set_tracks( std::move(pyramid) );
+  layer->set_visible( true );
+  layer->set_enabled( true );
+
+  m_track_layer = std::move(layer);
+}
+
+void Map::add_heatmap_layer() noexcept(true)
 {
-  ure::SceneLayerNode* current_layer_node = m_pViewPort->get_scene().get_scene_node<ure::SceneLayerNode>("SceneNode", core::utils::format("Layer%d", m_curLevel ) );
-  ure::SceneLayerNode* new_layer_node     = nullptr;
+  std::vector<HeatmapSet::point_t> points;
 
-  // Increase level
-  if ( dOffsetY > 0.0f )
+  if ( m_heatmap_path.empty() == false )
+  {
+    if ( MarkerIndex::read_csv( m_heatmap_path, points ) == false )
+      ure::utils::log( "Unable to read heatmap points from [" + m_heatmap_path + "]" );
+  }
+  else
   {
-    if ( m_curLevel < m_maxLevels )
-      ++m_curLevel;
+    random_events( m_random_heatmap, 3, points );
   }
 
-  // Decrease level
-  if ( dOffsetY < 0.0f )
+  std::shared_ptr<HeatmapLayer> layer = std::make_shared<HeatmapLayer>( *m_pViewPort, m_tile_size.width );
+
+  m_pWindow->connect(layer->get_windows_events());
+
+  layer->set_origin( m_view.origin( m_curLevel ) );
+  layer->add_points( points );
+  layer->set_visible( true );
+  layer->set_enabled( true );
+
+  ure::utils::log( core::utils::format( "Heatmap:        [%zu] points, %u more per second", layer->size(), m_heatmap_rate ) );
+
+  m_heatmap_layer  = std::move(layer);
+  m_heatmap_fed_at = RedrawSignal::clock_t::now();
+}
+
+void Map::feed_heatmap( const RedrawSignal::clock_t::time_point& now ) noexcept(true)
+{
+  if ( ( m_heatmap_layer == nullptr ) || ( m_heatmap_rate == 0 ) )
+    return;
+
+  // Batched a few times per second, the grid only updates the rows they touch
+  const auto  period  = std::chrono::milliseconds(100);
+  const auto  elapsed = std::chrono::duration_cast<std::chrono::microseconds>( now - m_heatmap_fed_at );
+
+  if ( elapsed >= period )
   {
-    if ( m_curLevel > 0 )
-      --m_curLevel;
+    std::vector<HeatmapSet::point_t> points;
+
+    random_events( static_cast<ure::uint_t>( elapsed.count() * m_heatmap_rate / 1000000 ), 4 + m_heatmap_batches++, points );
+
+    m_heatmap_layer->add_points( points );
+    m_heatmap_fed_at = now;
   }
 
-  new_layer_node = m_pViewPort->get_scene().get_scene_node<ure::SceneLayerNode>("SceneNode", core::utils::format("Layer%d", m_curLevel ) );
+  m_refresh_at = std::min( m_refresh_at, m_heatmap_fed_at + period );
+}
+
+void Map::random_events( ure::uint_t count, std::uint64_t seed, std::vector<MarkerIndex::point_t>& points ) noexcept(true)
+{
+  std::mt19937                            rng( static_cast<std::mt19937::result_type>( seed ) );
+  std::uniform_real_distribution<double>  uniform( 0.0, 1.0 );
+  std::normal_distribution<double>        spread( 0.0, 0.01 );
+
+  points.reserve( points.size() + count );
 
-  if ( current_layer_node )
+  for ( ure::uint_t i = 0; i < count; ++i )
   {
-    current_layer_node->get_object<TileLayer>()->set_enabled(false);
-    current_layer_node->get_object<TileLayer>()->set_visible(false);
+    if ( i % 4 == 0 )
+      points.push_back( MarkerIndex::point_t{ uniform( rng ), uniform( rng ) } );
+    else
+      points.push_back( MarkerIndex::point_t{ ( i % 16 ) / 16.0 + 0.03 + spread( rng ), ( i % 11 ) / 11.0 + 0.04 + spread( rng ) } );
   }
+}
+
+TileLayer* Map::get_zoom_level( ure::int_t zl ) noexcept(true)
+{
+  if ( ( zl < 0 ) || ( zl >= max_levels() ) )
+    return nullptr;
+
+  zoom_level_t& level = m_levels[zl];
 
-  if ( new_layer_node )
+  if ( level.layer != nullptr )
+    return level.layer.get();
+
+  // Recycle a level torn down before, layer and scene node are reused as they are
+  if ( m_spare_levels.empty() == false )
   {
-    new_layer_node->get_object<TileLayer>()->set_enabled(true);
-    new_layer_node->get_object<TileLayer>()->set_visible(true);
+    level = m_spare_levels.back();
+    m_spare_levels.pop_back();
+
+    level.layer->set_zoom( static_cast<ure::word_t>(zl) );
+    level.layer->set_overlay( nullptr, 0.0f );
+    level.layer->set_origin( m_view.origin( zl ) );
+    level.node->set_model_matrix( m_view.level_model( zl ) );
+
+    return level.layer.get();
   }
 
-  if ( ( current_layer_node ) && ( new_layer_node ) )
+  std::shared_ptr<TileLayer> layer = std::make_shared<TileLayer>( *m_pViewPort, m_tiles, zl );
+  
+  m_pWindow->connect(layer->get_windows_events());
+
+  layer->set_visible( false );
+  layer->set_enabled( false );
+
+  layer->set_position( -1.0f*m_size.width/2, -1.0f*m_size.height/2, true );
+  layer->set_origin( m_view.origin( zl ) );
+  
+  auto texture = m_rc->find<ure::Texture>("0-0-0");
+  
+  if ( texture.has_value() )
+    layer->set_background( texture.value(), ure::widgets::Widget::BackgroundOptions::eboAsIs );
+
+  // Node names are not used for lookups, a sequence number keeps them unique
+  ure::SceneLayerNode* pNode = new(std::nothrow) ure::SceneLayerNode( core::utils::format("Layer%u", m_layer_nodes++ ), layer );
+  if ( pNode == nullptr )
+    return nullptr;
+
+  pNode->set_model_matrix( m_view.level_model( zl ) );
+
+  m_pViewPort->get_scene().add_scene_node( pNode );  
+
+  level = zoom_level_t{ std::move(layer), pNode };
+
+  return level.layer.get();
+}
+
+void Map::trim_zoom_levels() noexcept(true)
+{
+  for ( ure::int_t zl = 0; zl < max_levels(); ++zl )
   {
-    new_layer_node->get_model_matrix() = current_layer_node->get_model_matrix();
+    zoom_level_t& level = m_levels[zl];
+
+    if ( ( level.layer == nullptr ) || ( std::abs( zl - m_curLevel ) <= m_levelsWindow ) )
+      continue;
+
+    level.layer->set_visible( false );
+    level.layer->set_enabled( false );
+
+    m_tiles.cache().evict_level( static_cast<ure::uint_t>(zl) );
+
+    m_spare_levels.push_back( level );
+    level = zoom_level_t{ nullptr, nullptr };
+  }
+}
+
+void Map::prefetch() noexcept(true)
+{
+  // Vector tiles are small, only the visible ones are requested
+  if ( m_levels.empty() || ( m_vector_layer != nullptr ) )
+    return;
+
+  MAP_METRICS_SCOPE( prefetch );
+
+  TileRequests&   requests = m_tiles.requests();
+  const auto      now      = TilePrefetcher::clock_t::now();
+  ure::uint_t     budget   = m_prefetcher.available( requests.pending(), requests.pending_prefetch() );
+
+  if ( budget == 0 )
+    return;
+
+  // Where panning is heading on the current level
+  const glm::vec2 offset = m_prefetcher.predicted_offset( now );
+
+  if ( ( offset.x != 0.0f ) || ( offset.y != 0.0f ) )
+  {
+    TileLayer* layer = m_levels[m_curLevel].layer.get();
+
+    if ( layer != nullptr )
+      budget -= layer->prefetch( m_view.level_model( m_curLevel, offset ), m_fb_size, budget );
+  }
+
+  // Level the user is scrolling to, with the current view
+  const ure::int_t direction = m_prefetcher.zoom_direction( now );
+  const ure::int_t next      = m_curLevel + direction;
+
+  if ( ( direction != 0 ) && ( budget > 0 ) && ( next >= 0 ) && ( next < max_levels() ) )
+  {
+    TileLayer* layer = get_zoom_level( next );
+
+    if ( layer != nullptr )
+    {
+      // Levels out of the drawn pair keep the local origin they were last drawn with
+      layer->set_origin( m_view.origin( next ) );
+      layer->prefetch( m_view.level_model( next ), m_fb_size, budget );
+    }
+  }
+}
+
+#if MAP_ENABLE_METRICS
+void Map::update_metrics() noexcept(true)
+{
+  // Nothing goes through the raster tiles in vector mode
+  if ( m_vector != nullptr )
+  {
+    const VectorTileCache::stats_t  cache     = m_vector->cache().stats();
+    const TileScheduler::stats_t    scheduler = m_vector->scheduler().stats();
+
+    MAP_METRICS_TOTAL( cache_hits,      cache.hits   );
+    MAP_METRICS_TOTAL( cache_misses,    cache.misses );
+    MAP_METRICS_SET  ( queue_depth,     scheduler.queued    );
+    MAP_METRICS_SET  ( in_flight,       scheduler.in_flight );
+    MAP_METRICS_SET  ( decoder_pending, m_vector->decoder().pending() );
+    MAP_METRICS_SET  ( cache_tiles,     cache.entries );
+    MAP_METRICS_SET  ( gpu_bytes,       cache.bytes   );
+    return;
+  }
+
+  const TileCache::stats_t      cache     = m_tiles.cache().stats();
+  const TileScheduler::stats_t  scheduler = m_tiles.scheduler().stats();
+
+  MAP_METRICS_TOTAL( cache_hits,      cache.hits   );
+  MAP_METRICS_TOTAL( cache_misses,    cache.misses );
+  MAP_METRICS_SET  ( queue_depth,     scheduler.queued    );
+  MAP_METRICS_SET  ( in_flight,       scheduler.in_flight );
+  MAP_METRICS_SET  ( decoder_pending, m_tiles.decoder().pending() );
+  MAP_METRICS_SET  ( cache_tiles,     cache.entries );
+  MAP_METRICS_SET  ( gpu_bytes,       cache.bytes   );
+}
+#endif
+
+void Map::update_view() noexcept(true)
+{
+  if ( m_levels.empty() )
+    return;
+
+  const MapView::levels_t  levels = m_view.levels();
+
+  // Overlays follow the level drawn, whatever draws the tiles. Local origins move while
+  // panning, they are set together with the model matrices
+  if ( m_track_layer != nullptr )
+  {
+    m_track_layer->set_zoom( static_cast<ure::word_t>(levels.draw) );
+    m_track_layer->set_origin( m_view.origin( levels.draw ) );
+    m_track_layer->set_view( m_view.level_model( levels.draw ), m_fb_size );
+  }
+
+  if ( m_heatmap_layer != nullptr )
+  {
+    m_heatmap_layer->set_zoom( static_cast<ure::word_t>(levels.draw) );
+    m_heatmap_layer->set_origin( m_view.origin( levels.draw ) );
+    m_heatmap_layer->set_view( m_view.level_model( levels.draw ), m_fb_size );
+  }
+
+  if ( m_marker_layer != nullptr )
+  {
+    m_marker_layer->set_zoom( static_cast<ure::word_t>(levels.draw) );
+    m_marker_layer->set_origin( m_view.origin( levels.draw ) );
+    m_marker_layer->set_view( m_view.level_model( levels.draw ), m_fb_size );
   }
 
-  printf("scroll current level [%d] %f  %f \n", m_curLevel, dOffsetX, dOffsetY );
+  // A single vector layer follows the level drawn, tiles of levels left behind are released
+  if ( m_vector_layer != nullptr )
+  {
+    if ( levels.current != m_curLevel )
+    {
+      for ( ure::int_t zl = 0; zl < max_levels(); ++zl )
+      {
+        if ( std::abs( zl - levels.current ) > m_levelsWindow )
+          m_vector->cache().evict_level( static_cast<ure::uint_t>(zl) );
+      }
+    }
+
+    m_curLevel  = levels.current;
+    m_drawLevel = levels.draw;
+
+    const glm::mat4 model = m_view.level_model( m_drawLevel );
+
+    m_vector_layer->set_zoom( static_cast<ure::word_t>(m_drawLevel) );
+    m_vector_layer->set_origin( m_view.origin( m_drawLevel ) );
+    m_vector_layer->set_view( model, m_fb_size );
+
+    if ( m_vector_node != nullptr )
+      m_vector_node->set_model_matrix( model );
+
+    return;
+  }
+
+  TileLayer*               blend  = ( ( levels.fade > 0.0f ) && ( levels.fade < 1.0f ) ) ? get_zoom_level( levels.upper ) : nullptr;
+
+  m_curLevel = levels.current;
+
+  if ( levels.draw != m_drawLevel )
+  {
+    const zoom_level_t& previous = m_levels[m_drawLevel];
+
+    if ( previous.layer != nullptr )
+    {
+      previous.layer->set_overlay( nullptr, 0.0f );
+      previous.layer->set_enabled(false);
+      previous.layer->set_visible(false);
+    }
+
+    m_drawLevel = levels.draw;
+  }
+
+  TileLayer* layer = get_zoom_level( m_drawLevel );
+
+  if ( layer != nullptr )
+  {
+    layer->set_enabled(true);
+    layer->set_visible(true);
+    layer->set_overlay( blend, levels.fade );
+  }
+
+  trim_zoom_levels();
+
+  // Levels in use only differ by the scale applied to the same tiles geometry
+  for ( ure::int_t zl : { levels.lower, levels.upper } )
+  {
+    const zoom_level_t& level = m_levels[zl];
+
+    if ( level.layer == nullptr )
+      continue;
+
+    const glm::mat4 model = m_view.level_model( zl );
+
+    level.node->set_model_matrix( model );
+    level.layer->set_origin( m_view.origin( zl ) );
+    level.layer->set_view( model, m_fb_size );
+  }
+}
+
+/////////////////////////////////////////////////////
+// ure::WindowEvents implementation
+/////////////////////////////////////////////////////
+
+ure::void_t  Map::on_mouse_scroll( [[maybe_unused]] ure::Window* pWindow, [[maybe_unused]] ure::double_t dOffsetX, [[maybe_unused]] ure::double_t dOffsetY ) noexcept 
+{
+  if ( m_levels.empty() )
+    return;
+
+  // Zoom is centred on the cursor, applied and animated by on_run()
+  const glm::vec2 anchor( m_mouse_last_pos.x - m_size.width/2.0, m_mouse_last_pos.y - m_size.height/2.0 );
+
+  m_input.scroll( static_cast<ure::float_t>(dOffsetY), anchor );
+
+  m_tiles.redraw().request();
 }
 
 ure::void_t Map::on_mouse_move( [[maybe_unused]] ure::Window* pWindow, [[maybe_unused]] ure::double_t x, [[maybe_unused]] ure::double_t y ) noexcept 
 {
-  if ( m_move_map )
+  // Several events may arrive per frame, on_run() moves the map once by their sum
+  if ( m_move_map && ( m_levels.empty() == false ) )
   {
-    ure::Position_d  _delta_pos = m_mouse_last_pos - ure::Position_d( x, y );
-    
-    ure::SceneLayerNode* _tile_layer = m_pViewPort->get_scene().get_scene_node<ure::SceneLayerNode>("SceneNode", core::utils::format("Layer%d", m_curLevel ) );
-    
-    _tile_layer->get_model_matrix().translate( -1.0f*_delta_pos.x, -1.0f*_delta_pos.y, 0 );
-    
-    printf( "delta x:%f delta y:%f\n", _delta_pos.x, _delta_pos.y );
+    m_input.pan( glm::vec2( x - m_mouse_last_pos.x, y - m_mouse_last_pos.y ) );
+
+    m_tiles.redraw().request();
   }
   m_mouse_last_pos = { x, y };
-  printf( "x:%f y:%f\n", x, y );
-  
 }
 
 ure::void_t Map::on_mouse_button_pressed( [[maybe_unused]] ure::Window* pWindow, [[maybe_unused]] ure::WindowEvents::mouse_button_t button, [[maybe_unused]] ure::int_t mods ) noexcept 
@@ -265,7 +840,9 @@ ure::void_t Map::on_mouse_button_pressed( [[maybe_unused]] ure::Window* pWindow,
   switch (button)
   {
     case ure::WindowEvents::mouse_button_t::BUTTON_LEFT:
-      m_move_map  = true;
+      m_move_map        = true;
+      m_mouse_press_pos = m_mouse_last_pos;
+      m_input.grab();
     break;
   
     default:
@@ -278,7 +855,28 @@ ure::void_t Map::on_mouse_button_released( [[maybe_unused]] ure::Window* pWindow
   switch (button)
   {
     case ure::WindowEvents::mouse_button_t::BUTTON_LEFT:
+    {
       m_move_map  = false;
+      m_input.release();
+
+      // Momentum is applied by on_run()
+      if ( m_input.coasting() )
+        m_tiles.redraw().request();
+
+      // A click, not the end of a pan, hits the markers drawn under the cursor
+      const ure::double_t dx = m_mouse_last_pos.x - m_mouse_press_pos.x;
+      const ure::double_t dy = m_mouse_last_pos.y - m_mouse_press_pos.y;
+
+      if ( ( m_marker_layer != nullptr ) && ( dx * dx + dy * dy <= 16.0 ) )
+      {
+        const std::optional<MarkerIndex::cluster_t> hit = m_marker_layer->pick( glm::vec2( m_mouse_last_pos.x, m_mouse_last_pos.y ), m_size );
+
+        if ( hit.has_value() && ( hit->count == 1 ) )
+          ure::utils::log( core::utils::format( "Marker %u", hit->id ) );
+        else if ( hit.has_value() )
+          ure::utils::log( core::utils::format( "Cluster of %u markers, first %u", hit->count, hit->id ) );
+      }
+    }
     break;
   
     default:
@@ -317,7 +915,40 @@ ure::void_t Map::on_run() noexcept(true)
     ure::Application::get_instance()->exit(true);
   }
 
+  const ure::Size  fb_size = m_fb_size;
+
   m_pWindow->get_framebuffer_size( m_fb_size );
+
+  if ( ( fb_size.width != m_fb_size.width ) || ( fb_size.height != m_fb_size.height ) )
+  {
+    update_view();
+
+    m_tiles.redraw().request();
+  }
+
+  RedrawSignal&                            redraw = m_tiles.redraw();
+  const RedrawSignal::clock_t::time_point  now    = RedrawSignal::clock_t::now();
+
+  // Idle map: nothing is drawn until input, a decoded tile or a resize requests it.
+  // Waiting is bounded so that input keeps being polled, ure has no blocking event wait.
+  if ( ( m_continuous == false ) && ( redraw.consume() == false ) && ( now < m_refresh_at ) )
+  {
+    redraw.wait( m_idle_wait );
+
+    m_pWindow->process_message();
+
+    ure::Application::get_instance()->poll_events();
+    return;
+  }
+
+  // No refresh needed unless this frame misses tiles, see below
+  m_refresh_at = RedrawSignal::clock_t::time_point::max();
+
+  // Values of the previous frame are complete, this one is timed until on_run() returns
+  MAP_METRICS_END_FRAME();
+  MAP_METRICS_SCOPE( frame );
+
+  const std::uint64_t misses = m_tiles.cache().stats().misses + ( ( m_vector != nullptr ) ? m_vector->cache().stats().misses : 0 );
     
   ///////////////
   m_pViewPort->set_area( 0, 0, m_fb_size.width, m_fb_size.height );
@@ -326,18 +957,133 @@ ure::void_t Map::on_run() noexcept(true)
   // Update background color
   m_pViewPort->get_scene().set_background( 0.2f, 0.2f, 0.2f, 0.0f );
 
+  // Textures not drawn from now on can be evicted, queued downloads not requested again are cancelled
+  m_tiles.cache().begin_frame();
+  m_tiles.scheduler().begin_frame( m_curLevel );
+
+  if ( m_vector != nullptr )
+  {
+    m_vector->cache().begin_frame();
+    m_vector->scheduler().begin_frame( m_curLevel );
+  }
+
+  // Input since the last frame moves the view once, whatever the number of events
+  ure::bool_t               moved = false;
+  InputAccumulator::frame_t input;
+
+  if ( m_input.take( now, input ) )
+  {
+    if ( ( input.pan.x != 0.0f ) || ( input.pan.y != 0.0f ) )
+    {
+      m_view.pan( input.pan );
+      m_prefetcher.on_pan( input.pan.x, input.pan.y, now );
+      moved = true;
+    }
+
+    if ( input.notches != 0.0f )
+    {
+      m_prefetcher.on_zoom( ( input.notches > 0.0f ) ? 1 : -1, now );
+      m_view.zoom_by( input.notches, input.anchor, now );
+    }
+  }
+
+  // Momentum keeps requesting frames until it stops
+  if ( m_input.coasting() )
+    redraw.request();
+
+  // Zoom animation only changes model matrices, next frame is requested until it ends
+  if ( m_view.animate( now ) )
+  {
+    moved = true;
+    redraw.request();
+  }
+
+  if ( moved )
+    update_view();
+
+  // Events arrived since the last frame, the heatmap uploads only the rows they touch
+  feed_heatmap( now );
+
+  // Tiles decoded by worker threads become textures, bounded in count, bytes and time to keep
+  // frame time stable: compressed tiles are smaller, more of them fit in a frame
+  const TileDecoder::clock_t::time_point  upload_start = TileDecoder::clock_t::now();
+
+  m_tiles.decoder().upload( m_max_uploads, m_upload_budget, m_upload_bytes );
+
+  // Upload budget exhausted, remaining tiles go in the next frame
+  if ( m_tiles.decoder().ready() > 0 )
+    redraw.request();
+
+  // Vector tiles geometry becomes vertex buffers, in what is left of the time budget
+  if ( m_vector != nullptr )
+  {
+    const TileDecoder::clock_t::duration  spent = TileDecoder::clock_t::now() - upload_start;
+
+    m_vector->decoder().upload( m_max_uploads, ( spent < m_upload_budget ) ? m_upload_budget - spent : TileDecoder::clock_t::duration::zero() );
+
+    if ( m_vector->decoder().ready() > 0 )
+      redraw.request();
+  }
+
   ///////////////
-  m_pViewPort->clear_buffer( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT );
+  {
+    MAP_METRICS_SCOPE( clear );
+    m_pViewPort->clear_buffer( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT );
+  }
 
   ///////////////
-  m_pViewPort->render();
+  {
+    MAP_METRICS_SCOPE( render );
+    m_pViewPort->render();
+
+    // Outside of the scene graph, levels created on demand would otherwise be drawn over the overlays
+    if ( m_track_layer != nullptr )
+      m_track_layer->TrackSet::draw();
+
+    if ( m_heatmap_layer != nullptr )
+      m_heatmap_layer->HeatmapSet::draw();
+
+    if ( m_marker_layer != nullptr )
+      m_marker_layer->MarkerSet::draw();
+  }
+
+  // Visible tiles have been requested while rendering, spare capacity goes to prefetch
+  prefetch();
+
+  // Best queued downloads are handed to the fetcher
+  m_tiles.scheduler().dispatch();
+
+  if ( m_vector != nullptr )
+    m_vector->scheduler().dispatch();
+
+  // Tiles missing from this frame may be waiting for a retry after a failure,
+  // come back later even if nothing else happens
+  if ( m_tiles.cache().stats().misses + ( ( m_vector != nullptr ) ? m_vector->cache().stats().misses : 0 ) != misses )
+    m_refresh_at = now + m_refresh_interval;
+
+#if MAP_ENABLE_METRICS
+  update_metrics();
+
+  // Over the map, refreshed a few times per second even when the map is idle
+  if ( m_show_metrics )
+  {
+    m_metrics_overlay.draw( m_fb_size );
+    m_refresh_at = std::min( m_refresh_at, now + std::chrono::milliseconds(250) );
+  }
+#endif
 
   ///////////////
-  m_pWindow->swap_buffers();
+  {
+    MAP_METRICS_SCOPE( swap );
+    m_pWindow->swap_buffers();
+  }
   
   ///////////////
   // Will process messages that requires to be executed on main thread.
-  m_pWindow->process_message();
+  {
+    MAP_METRICS_SCOPE( process_message );
+    m_pWindow->process_message();
+  }
 
   ure::Application::get_instance()->poll_events();  
 }
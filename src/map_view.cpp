@@ -0,0 +1,131 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "map_view.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+MapView::MapView( ure::int_t max_levels, ure::float_t step, ure::float_t tau ) noexcept(true)
+  : m_max_levels( std::max( 1, max_levels ) ), m_step(step), m_tau( std::max( tau, 1e-3f ) ),
+    m_projection(1.0f), m_centre(0.0), m_zoom(0.0f), m_target(0.0f), m_anchor(0.0f), m_time{}
+{
+}
+
+ure::void_t   MapView::reset( const ure::Size& size, ure::int_t level ) noexcept(true)
+{
+  m_projection = glm::ortho( -1.0f*size.width/2, 1.0f*size.width/2, 1.0f*size.height/2, -1.0f*size.height/2 );
+  m_zoom       = static_cast<ure::float_t>( std::clamp( level, 0, m_max_levels - 1 ) );
+  m_target     = m_zoom;
+
+  // Tile (0,0) at the top left corner of the window
+  centre_on( glm::dvec2( size.width / 2.0, size.height / 2.0 ) );
+}
+
+glm::dvec2    MapView::centre() const noexcept(true)
+{
+  return m_centre * std::exp2( static_cast<ure::double_t>(m_zoom) );
+}
+
+ure::void_t   MapView::centre_on( const glm::dvec2& pixel ) noexcept(true)
+{
+  m_centre = pixel / std::exp2( static_cast<ure::double_t>(m_zoom) );
+}
+
+ure::void_t   MapView::pan( const glm::vec2& delta ) noexcept(true)
+{
+  // Map follows the cursor, the centre moves the other way
+  m_centre -= glm::dvec2( delta ) / std::exp2( static_cast<ure::double_t>(m_zoom) );
+}
+
+ure::bool_t   MapView::zoom_by( ure::float_t notches, const glm::vec2& anchor, clock_t::time_point now ) noexcept(true)
+{
+  const ure::float_t target = std::clamp( m_target + notches * m_step, 0.0f, static_cast<ure::float_t>( m_max_levels - 1 ) );
+
+  if ( target == m_target )
+    return false;
+
+  // Animation restarts from the current zoom
+  if ( animating() == false )
+    m_time = now;
+
+  m_target = target;
+  m_anchor = anchor;
+
+  return true;
+}
+
+ure::bool_t   MapView::animate( clock_t::time_point now ) noexcept(true)
+{
+  if ( animating() == false )
+    return false;
+
+  // Exponential approach, frame rate independent
+  const ure::float_t  dt   = std::chrono::duration<ure::float_t>( now - m_time ).count();
+  const ure::float_t  step = 1.0f - std::exp( -dt / m_tau );
+  ure::float_t        zoom = m_zoom + ( m_target - m_zoom ) * std::clamp( step, 0.0f, 1.0f );
+
+  if ( std::abs( m_target - zoom ) < 1e-3f )
+    zoom = m_target;
+
+  // Point under the anchor stays still: centre' = centre + anchor * ( 2^-zoom - 2^-zoom' )
+  const glm::dvec2 anchor( m_anchor );
+
+  m_centre += anchor / std::exp2( static_cast<ure::double_t>(m_zoom) ) - anchor / std::exp2( static_cast<ure::double_t>(zoom) );
+  m_zoom    = zoom;
+  m_time   = now;
+
+  return true;
+}
+
+MapView::levels_t   MapView::levels() const noexcept(true)
+{
+  // Upper level fades in over the lower one in the middle of each zoom step,
+  // close to integer values a single level is drawn
+  const ure::int_t    last  = m_max_levels - 1;
+  const ure::int_t    lower = std::clamp( static_cast<ure::int_t>( std::floor( m_zoom ) ), 0, last );
+  const ure::int_t    upper = std::min( lower + 1, last );
+  const ure::float_t  fade  = ( upper > lower ) ? glm::smoothstep( 0.25f, 0.75f, m_zoom - static_cast<ure::float_t>(lower) ) : 0.0f;
+
+  return levels_t{ lower, upper, fade, ( fade >= 1.0f ) ? upper : lower, ( fade >= 0.5f ) ? upper : lower };
+}
+
+glm::vec2   MapView::origin( ure::int_t zl ) const noexcept(true)
+{
+  // A multiple of local_extent(), exact in float at any level
+  return glm::vec2( -local( zl ) );
+}
+
+glm::dvec2  MapView::local( ure::int_t zl ) const noexcept(true)
+{
+  const glm::dvec2  centre = m_centre * std::exp2( static_cast<ure::double_t>(zl) );
+
+  return glm::floor( centre / local_extent() ) * local_extent();
+}
+
+glm::mat4   MapView::level_model( ure::int_t zl, const glm::vec2& pan ) const noexcept(true)
+{
+  // Tiles of level zl are laid out at 1:1 scale from origin( zl ), the zoom is a scale around it.
+  // Screen position of the local origin is the difference of two large values, taken in double.
+  const ure::double_t scale  = std::exp2( static_cast<ure::double_t>(m_zoom) - zl );
+  const glm::dvec2    offset = local( zl ) * scale - centre();
+
+  glm::mat4 model = glm::translate( m_projection, glm::vec3( glm::vec2( offset ) + pan, 0.0f ) );
+
+  return glm::scale( model, glm::vec3( static_cast<ure::float_t>(scale), static_cast<ure::float_t>(scale), 1.0f ) );
+}
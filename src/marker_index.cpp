@@ -0,0 +1,342 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "marker_index.h"
+#include "fixed_point.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+  constexpr ure::uint_t     k_leaf_size  = 32;    /* Markers above which a cell is split */
+  constexpr ure::uint_t     k_max_depth  = 24;    /* About 2.4 m at the equator */
+
+  /** Spread the bits of @p value over the even bits of the result */
+  std::uint64_t  spread( std::uint32_t value ) noexcept
+  {
+    std::uint64_t x = value;
+
+    x = ( x | ( x << 16 ) ) & 0x0000FFFF0000FFFFull;
+    x = ( x | ( x <<  8 ) ) & 0x00FF00FF00FF00FFull;
+    x = ( x | ( x <<  4 ) ) & 0x0F0F0F0F0F0F0F0Full;
+    x = ( x | ( x <<  2 ) ) & 0x3333333333333333ull;
+    x = ( x | ( x <<  1 ) ) & 0x5555555555555555ull;
+
+    return x;
+  }
+
+  /** Morton code, x on even bits and y on odd ones */
+  std::uint64_t  morton( std::uint32_t x, std::uint32_t y ) noexcept
+  {
+    return spread( x ) | ( spread( y ) << 1 );
+  }
+
+  /**
+   * Clustering cell as a power of two of fixed point units, aligned with the quadtree
+   * cells; -1 when markers are not merged.
+   */
+  std::int32_t  cell_shift( ure::double_t cell ) noexcept
+  {
+    const ure::double_t fixed = cell * FixedPoint::scale;
+
+    if ( ( fixed < 1.0 ) || std::isnan( fixed ) )
+      return -1;
+
+    return std::min( 32, static_cast<std::int32_t>( std::floor( std::log2( fixed ) ) ) );
+  }
+}
+
+MarkerIndex::MarkerIndex() noexcept(true)
+{
+}
+
+MarkerIndex::point_t   MarkerIndex::project( ure::double_t lon, ure::double_t lat ) noexcept(true)
+{
+  constexpr ure::double_t  pi      = 3.14159265358979323846;
+  constexpr ure::double_t  max_lat = 85.0511287798066;
+
+  const ure::double_t  phi = std::clamp( lat, -max_lat, max_lat ) * pi / 180.0;
+
+  return point_t{ ( lon + 180.0 ) / 360.0, 0.5 - std::log( std::tan( pi / 4.0 + phi / 2.0 ) ) / ( 2.0 * pi ) };
+}
+
+ure::bool_t   MarkerIndex::read_csv( const std::string& path, std::vector<point_t>& points ) noexcept(true)
+{
+  std::ifstream  file( path );
+  if ( !file )
+    return false;
+
+  std::string  line;
+
+  while ( std::getline( file, line ) )
+  {
+    const char*          text = line.c_str();
+    char*                end  = nullptr;
+    const ure::double_t  lon  = std::strtod( text, &end );
+
+    if ( ( end == text ) || ( *end != ',' ) )
+      continue;
+
+    text = end + 1;
+
+    const ure::double_t  lat  = std::strtod( text, &end );
+
+    if ( ( end == text ) || std::isnan( lon ) || std::isnan( lat ) )
+      continue;
+
+    points.push_back( project( lon, lat ) );
+  }
+
+  return true;
+}
+
+ure::float_t   MarkerIndex::radius_scale( ure::uint_t count ) noexcept(true)
+{
+  if ( count <= 1 )
+    return 1.0f;
+
+  return std::min( max_radius_scale(), 1.25f + 0.25f * std::log2( static_cast<ure::float_t>( count ) ) );
+}
+
+ure::void_t   MarkerIndex::build( const std::vector<point_t>& points ) noexcept(true)
+{
+  m_x.clear();
+  m_y.clear();
+  m_id.clear();
+  m_nodes.clear();
+
+  // Identifiers and node ranges are 32 bits
+  const std::size_t count = std::min<std::size_t>( points.size(), 0xFFFFFFFFu );
+
+  if ( count == 0 )
+    return;
+
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> order( count );
+
+  for ( std::size_t i = 0; i < count; ++i )
+    order[i] = { morton( FixedPoint::from_normalized( points[i].x ), FixedPoint::from_normalized( points[i].y ) ), static_cast<std::uint32_t>(i) };
+
+  std::sort( order.begin(), order.end() );
+
+  std::vector<std::uint64_t> codes( count );
+
+  m_x.resize( count );
+  m_y.resize( count );
+  m_id.resize( count );
+
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    const point_t& point = points[ order[i].second ];
+
+    codes[i] = order[i].first;
+    m_x[i]   = FixedPoint::from_normalized( point.x );
+    m_y[i]   = FixedPoint::from_normalized( point.y );
+    m_id[i]  = order[i].second;
+  }
+
+  m_nodes.reserve( count / ( k_leaf_size / 4 ) + 1 );
+
+  build( codes, 0, static_cast<std::uint32_t>(count), 0 );
+}
+
+std::int32_t   MarkerIndex::build( const std::vector<std::uint64_t>& codes, std::uint32_t first, std::uint32_t last, ure::uint_t depth ) noexcept(true)
+{
+  const std::int32_t index = static_cast<std::int32_t>( m_nodes.size() );
+
+  m_nodes.push_back( node_t{ first, last - first, 0, 0, { -1, -1, -1, -1 } } );
+
+  if ( ( last - first <= k_leaf_size ) || ( depth == k_max_depth ) )
+  {
+    std::uint64_t sum_x = 0;
+    std::uint64_t sum_y = 0;
+
+    for ( std::uint32_t i = first; i < last; ++i )
+    {
+      sum_x += m_x[i];
+      sum_y += m_y[i];
+    }
+
+    m_nodes[index].sum_x = sum_x;
+    m_nodes[index].sum_y = sum_y;
+
+    return index;
+  }
+
+  // Two bits per level, the quadrant of a marker at this depth
+  const ure::uint_t    shift  = 62 - 2 * depth;
+  const std::uint64_t  prefix = ( depth == 0 ) ? 0 : ( ( codes[first] >> ( shift + 2 ) ) << ( shift + 2 ) );
+  std::uint32_t        begin  = first;
+
+  for ( std::uint32_t q = 0; q < 4; ++q )
+  {
+    const std::uint32_t end = ( q == 3 ) ? last : static_cast<std::uint32_t>(
+                                std::lower_bound( codes.begin() + begin, codes.begin() + last, prefix | ( static_cast<std::uint64_t>( q + 1 ) << shift ) ) - codes.begin() );
+
+    if ( end > begin )
+    {
+      const std::int32_t child = build( codes, begin, end, depth + 1 );
+
+      // Vector may have grown, no reference is kept across the call
+      m_nodes[index].child[q] = child;
+      m_nodes[index].sum_x   += m_nodes[child].sum_x;
+      m_nodes[index].sum_y   += m_nodes[child].sum_y;
+    }
+
+    begin = end;
+  }
+
+  return index;
+}
+
+ure::void_t   MarkerIndex::query( const bounds_t& bounds, ure::double_t cell, std::vector<cluster_t>& out ) const noexcept(true)
+{
+  if ( m_nodes.empty() || ( bounds.min_x >= bounds.max_x ) || ( bounds.min_y >= bounds.max_y ) )
+    return;
+
+  const bounds_t fixed{ bounds.min_x * FixedPoint::scale, bounds.min_y * FixedPoint::scale, bounds.max_x * FixedPoint::scale, bounds.max_y * FixedPoint::scale };
+
+  query( 0, 0, 0, 0, fixed, cell_shift( cell ), out );
+}
+
+std::optional<MarkerIndex::cluster_t>   MarkerIndex::pick( const point_t& point, ure::double_t radius, ure::double_t cell ) const noexcept(true)
+{
+  const ure::double_t       reach = radius * max_radius_scale();
+  std::vector<cluster_t>    found;
+
+  query( bounds_t{ point.x - reach, point.y - reach, point.x + reach, point.y + reach }, cell, found );
+
+  std::optional<cluster_t>  best;
+  ure::double_t             best_distance = 0.0;
+
+  for ( const cluster_t& cluster : found )
+  {
+    const ure::double_t dx       = cluster.x - point.x;
+    const ure::double_t dy       = cluster.y - point.y;
+    const ure::double_t distance = dx * dx + dy * dy;
+    const ure::double_t limit    = radius * radius_scale( cluster.count );
+
+    if ( ( distance <= limit * limit ) && ( ( best.has_value() == false ) || ( distance < best_distance ) ) )
+    {
+      best          = cluster;
+      best_distance = distance;
+    }
+  }
+
+  return best;
+}
+
+ure::void_t   MarkerIndex::query( std::int32_t index, ure::uint_t depth, std::uint64_t x0, std::uint64_t y0,
+                                  const bounds_t& bounds, std::int32_t shift, std::vector<cluster_t>& out ) const noexcept(true)
+{
+  const node_t&        node = m_nodes[index];
+  const std::uint64_t  size = 1ull << ( 32 - depth );
+
+  if ( ( static_cast<ure::double_t>( x0 ) >= bounds.max_x ) || ( static_cast<ure::double_t>( x0 + size ) <= bounds.min_x ) ||
+       ( static_cast<ure::double_t>( y0 ) >= bounds.max_y ) || ( static_cast<ure::double_t>( y0 + size ) <= bounds.min_y ) )
+    return;
+
+  const auto inside = [&bounds]( std::uint32_t x, std::uint32_t y ) {
+    return ( x >= bounds.min_x ) && ( x < bounds.max_x ) && ( y >= bounds.min_y ) && ( y < bounds.max_y );
+  };
+
+  if ( node.count == 1 )
+  {
+    if ( inside( m_x[node.first], m_y[node.first] ) )
+      out.push_back( marker( node.first ) );
+    return;
+  }
+
+  // Whole cell within the clustering distance, its sums give the centroid
+  if ( ( shift >= 0 ) && ( 32 - depth <= static_cast<ure::uint_t>(shift) ) )
+  {
+    out.push_back( cluster_t{ ( static_cast<ure::double_t>( node.sum_x ) / node.count + 0.5 ) / FixedPoint::scale,
+                              ( static_cast<ure::double_t>( node.sum_y ) / node.count + 0.5 ) / FixedPoint::scale,
+                              node.count, m_id[node.first] } );
+    return;
+  }
+
+  if ( ( node.child[0] < 0 ) && ( node.child[1] < 0 ) && ( node.child[2] < 0 ) && ( node.child[3] < 0 ) )
+  {
+    const std::uint32_t last = node.first + node.count;
+
+    // Leaf larger than the clustering cell, markers of the same cell are contiguous in Morton order
+    for ( std::uint32_t i = node.first; i < last; )
+    {
+      std::uint32_t  j     = i + 1;
+      std::uint64_t  sum_x = m_x[i];
+      std::uint64_t  sum_y = m_y[i];
+
+      if ( shift >= 0 )
+      {
+        const std::uint64_t cx = static_cast<std::uint64_t>( m_x[i] ) >> shift;
+        const std::uint64_t cy = static_cast<std::uint64_t>( m_y[i] ) >> shift;
+
+        for ( ; ( j < last ) && ( ( static_cast<std::uint64_t>( m_x[j] ) >> shift ) == cx ) && ( ( static_cast<std::uint64_t>( m_y[j] ) >> shift ) == cy ); ++j )
+        {
+          sum_x += m_x[j];
+          sum_y += m_y[j];
+        }
+      }
+
+      const std::uint32_t count = j - i;
+
+      if ( count == 1 )
+      {
+        if ( inside( m_x[i], m_y[i] ) )
+          out.push_back( marker( i ) );
+      }
+      else
+      {
+        // Same rule as nodes, the cell of the cluster intersects the bounds
+        const std::uint64_t cx = ( static_cast<std::uint64_t>( m_x[i] ) >> shift ) << shift;
+        const std::uint64_t cy = ( static_cast<std::uint64_t>( m_y[i] ) >> shift ) << shift;
+        const std::uint64_t cs = 1ull << shift;
+
+        if ( ( static_cast<ure::double_t>( cx ) >= bounds.max_x ) || ( static_cast<ure::double_t>( cx + cs ) <= bounds.min_x ) ||
+             ( static_cast<ure::double_t>( cy ) >= bounds.max_y ) || ( static_cast<ure::double_t>( cy + cs ) <= bounds.min_y ) )
+        {
+          i = j;
+          continue;
+        }
+
+        out.push_back( cluster_t{ ( static_cast<ure::double_t>( sum_x ) / count + 0.5 ) / FixedPoint::scale,
+                                  ( static_cast<ure::double_t>( sum_y ) / count + 0.5 ) / FixedPoint::scale,
+                                  count, m_id[i] } );
+      }
+
+      i = j;
+    }
+
+    return;
+  }
+
+  const std::uint64_t half = size / 2;
+
+  for ( std::uint32_t q = 0; q < 4; ++q )
+  {
+    if ( node.child[q] >= 0 )
+      query( node.child[q], depth + 1, x0 + ( q & 1 ) * half, y0 + ( q >> 1 ) * half, bounds, shift, out );
+  }
+}
+
+MarkerIndex::cluster_t   MarkerIndex::marker( std::uint32_t index ) const noexcept(true)
+{
+  return cluster_t{ ( m_x[index] + 0.5 ) / FixedPoint::scale, ( m_y[index] + 0.5 ) / FixedPoint::scale, 1, m_id[index] };
+}
@@ -0,0 +1,297 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "marker_renderer.h"
+
+#include <ure_utils.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+  /** glDrawArraysInstanced and glVertexAttribDivisor are core in GLES 3.0 and GL 3.3 */
+  ure::bool_t  instancing_supported() noexcept
+  {
+    const char* version = reinterpret_cast<const char*>( glGetString( GL_VERSION ) );
+    if ( version == nullptr )
+      return false;
+
+    int major = 0;
+    int minor = 0;
+
+    if ( std::strncmp( version, "OpenGL ES", 9 ) == 0 )
+      return ( std::sscanf( version, "OpenGL ES %d.%d", &major, &minor ) == 2 ) && ( major >= 3 );
+
+    return ( std::sscanf( version, "%d.%d", &major, &minor ) == 2 ) && ( ( major > 3 ) || ( ( major == 3 ) && ( minor >= 3 ) ) );
+  }
+
+  /** Unit quad as a triangle strip, and as two triangles for expanded quads */
+  const glm::vec2       k_strip[4]     = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f } };
+  constexpr ure::uint_t k_triangles[6] = { 0, 1, 2, 2, 1, 3 };
+}
+
+MarkerRenderer::MarkerRenderer() noexcept(true)
+  : m_shaders_path( "./resources/shaders/" ), m_failed(false), m_instanced(false), m_program(0),
+    m_a_corner(-1), m_a_instance(-1), m_u_mvp(-1), m_u_pixel(-1), m_u_color(-1), m_u_cluster_color(-1),
+    m_corners(0), m_vbo(0), m_vbo_size(0), m_count(0),
+    m_color( 0.90f, 0.25f, 0.20f, 0.95f ), m_cluster_color( 0.15f, 0.45f, 0.85f, 0.90f )
+{
+}
+
+MarkerRenderer::~MarkerRenderer() noexcept(true)
+{
+  dispose();
+}
+
+ure::void_t   MarkerRenderer::set_shaders_path( const std::string& path ) noexcept(true)
+{
+  m_shaders_path = path;
+}
+
+ure::void_t   MarkerRenderer::set_colors( const glm::vec4& marker, const glm::vec4& cluster ) noexcept(true)
+{
+  m_color         = marker;
+  m_cluster_color = cluster;
+}
+
+ure::bool_t   MarkerRenderer::upload( const std::vector<instance_t>& instances ) noexcept(true)
+{
+  m_count = 0;
+
+  if ( init() == false )
+    return false;
+
+  const void*  data  = instances.data();
+  std::size_t  bytes = instances.size() * sizeof(instance_t);
+
+  if ( m_instanced == false )
+  {
+    m_vertices.resize( instances.size() * 6 );
+
+    for ( std::size_t i = 0; i < instances.size(); ++i )
+    {
+      for ( ure::uint_t v = 0; v < 6; ++v )
+        m_vertices[ i * 6 + v ] = vertex_t{ k_strip[ k_triangles[v] ], instances[i] };
+    }
+
+    data  = m_vertices.data();
+    bytes = m_vertices.size() * sizeof(vertex_t);
+  }
+
+  if ( bytes == 0 )
+    return true;
+
+  if ( m_vbo == 0 )
+    glGenBuffers( 1, &m_vbo );
+
+  glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+
+  // Grow only, markers in view change with every pan
+  if ( bytes > m_vbo_size )
+  {
+    m_vbo_size = bytes + bytes / 2;
+    glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_vbo_size), nullptr, GL_DYNAMIC_DRAW );
+  }
+
+  glBufferSubData( GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), data );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+  m_count = static_cast<ure::uint_t>( instances.size() );
+
+  return true;
+}
+
+ure::uint_t   MarkerRenderer::draw( const glm::mat4& mvp, const ure::Size& fb_size ) noexcept(true)
+{
+  if ( ( m_count == 0 ) || ( m_program == 0 ) || ( fb_size.width == 0 ) || ( fb_size.height == 0 ) )
+    return 0;
+
+  const GLboolean blend = glIsEnabled( GL_BLEND );
+  if ( blend == GL_FALSE )
+  {
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  }
+
+  glUseProgram( m_program );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+  // Clip space units per pixel, radii do not depend on the zoom
+  glUniform2f( m_u_pixel, 2.0f / fb_size.width, 2.0f / fb_size.height );
+  glUniform4f( m_u_color, m_color.x, m_color.y, m_color.z, m_color.w );
+  glUniform4f( m_u_cluster_color, m_cluster_color.x, m_cluster_color.y, m_cluster_color.z, m_cluster_color.w );
+
+  const GLuint corner   = static_cast<GLuint>(m_a_corner);
+  const GLuint instance = static_cast<GLuint>(m_a_instance);
+
+  glEnableVertexAttribArray( corner );
+  glEnableVertexAttribArray( instance );
+
+  if ( m_instanced )
+  {
+    glBindBuffer( GL_ARRAY_BUFFER, m_corners );
+    glVertexAttribPointer( corner, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr );
+
+    glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+    glVertexAttribPointer( instance, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t), nullptr );
+    glVertexAttribDivisor( instance, 1 );
+
+    glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_count) );
+
+    // Divisors are attribute state, other programs use the same locations
+    glVertexAttribDivisor( instance, 0 );
+  }
+  else
+  {
+    glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+    glVertexAttribPointer( corner  , 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, corner) ) );
+    glVertexAttribPointer( instance, 4, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, instance) ) );
+
+    glDrawArrays( GL_TRIANGLES, 0, static_cast<GLsizei>( m_count * 6 ) );
+  }
+
+  glDisableVertexAttribArray( corner );
+  glDisableVertexAttribArray( instance );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glUseProgram( 0 );
+
+  if ( blend == GL_FALSE )
+    glDisable( GL_BLEND );
+
+  return 1;
+}
+
+ure::void_t   MarkerRenderer::dispose() noexcept(true)
+{
+  if ( m_program != 0 )
+    glDeleteProgram( m_program );
+  if ( m_corners != 0 )
+    glDeleteBuffers( 1, &m_corners );
+  if ( m_vbo != 0 )
+    glDeleteBuffers( 1, &m_vbo );
+
+  m_program  = 0;
+  m_corners  = 0;
+  m_vbo      = 0;
+  m_vbo_size = 0;
+  m_count    = 0;
+}
+
+ure::bool_t   MarkerRenderer::init() noexcept(true)
+{
+  if ( m_program != 0 )
+    return true;
+
+  if ( m_failed )
+    return false;
+
+  m_failed = true;
+
+  GLuint vs = compile( GL_VERTEX_SHADER  , "DefaultMarker.vs" );
+  GLuint fs = compile( GL_FRAGMENT_SHADER, "DefaultMarker.fs" );
+
+  if ( ( vs == 0 ) || ( fs == 0 ) )
+  {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader( program, vs );
+  glAttachShader( program, fs );
+  glLinkProgram ( program );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &linked );
+  if ( linked != GL_TRUE )
+  {
+    ure::utils::log( "MarkerRenderer: unable to link DefaultMarker program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_a_corner        = glGetAttribLocation ( program, "a_v2Corner"         );
+  m_a_instance      = glGetAttribLocation ( program, "a_v4Instance"       );
+  m_u_mvp           = glGetUniformLocation( program, "u_m4MVP"            );
+  m_u_pixel         = glGetUniformLocation( program, "u_v2PixelSize"      );
+  m_u_color         = glGetUniformLocation( program, "u_v4Color"          );
+  m_u_cluster_color = glGetUniformLocation( program, "u_v4ClusterColor"   );
+
+  if ( ( m_a_corner < 0 ) || ( m_a_instance < 0 ) )
+  {
+    ure::utils::log( "MarkerRenderer: missing attributes in DefaultMarker program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_instanced = instancing_supported();
+
+  if ( m_instanced )
+  {
+    glGenBuffers( 1, &m_corners );
+    glBindBuffer( GL_ARRAY_BUFFER, m_corners );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(k_strip), k_strip, GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  }
+
+  m_program = program;
+  m_failed  = false;
+
+  return true;
+}
+
+GLuint   MarkerRenderer::compile( GLenum type, const std::string& file ) noexcept(true)
+{
+  std::ifstream      stream( m_shaders_path + file );
+  std::stringstream  source;
+
+  if ( !stream )
+  {
+    ure::utils::log( "MarkerRenderer: unable to read shader [" + m_shaders_path + file + "]" );
+    return 0;
+  }
+
+  source << stream.rdbuf();
+
+  const std::string  text = source.str();
+  const GLchar*      ptr  = text.c_str();
+
+  GLuint shader = glCreateShader( type );
+  glShaderSource ( shader, 1, &ptr, nullptr );
+  glCompileShader( shader );
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+  if ( compiled != GL_TRUE )
+  {
+    GLchar  log[512] = { 0 };
+    glGetShaderInfoLog( shader, sizeof(log), nullptr, log );
+
+    ure::utils::log( "MarkerRenderer: unable to compile [" + file + "]: " + log );
+    glDeleteShader( shader );
+    return 0;
+  }
+
+  return shader;
+}
@@ -0,0 +1,162 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "marker_set.h"
+#include "tile_range.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+MarkerSet::MarkerSet( ure::uint_t tile_pixels ) noexcept(true)
+  : m_tile_pixels( std::max( 1u, tile_pixels ) ), m_radius(6.0f), m_cluster_distance(48.0f), m_zoom(0),
+    m_origin(0.0f), m_model(1.0f), m_fb_size{0,0}, m_dirty(true), m_queried{ 0.0, 0.0, 0.0, 0.0 }, m_queries(0)
+{
+}
+
+ure::void_t   MarkerSet::set_markers( MarkerIndex&& index ) noexcept(true)
+{
+  m_index = std::move(index);
+  m_dirty = true;
+}
+
+ure::void_t   MarkerSet::set_style( ure::float_t radius, ure::float_t cluster_distance ) noexcept(true)
+{
+  m_radius           = std::max( 1.0f, radius );
+  m_cluster_distance = std::max( 0.0f, cluster_distance );
+  m_dirty            = true;
+}
+
+ure::void_t   MarkerSet::set_zoom( ure::word_t zoom ) noexcept(true)
+{
+  if ( zoom == m_zoom )
+    return;
+
+  m_zoom  = zoom;
+  m_dirty = true;
+}
+
+ure::void_t   MarkerSet::set_origin( const glm::vec2& origin ) noexcept(true)
+{
+  if ( origin == m_origin )
+    return;
+
+  m_origin = origin;
+  m_dirty  = true;
+}
+
+ure::void_t   MarkerSet::set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true)
+{
+  m_model   = model;
+  m_fb_size = fb_size;
+}
+
+std::optional<MarkerIndex::cluster_t>   MarkerSet::pick( const glm::vec2& point, const ure::Size& size ) const noexcept(true)
+{
+  if ( m_index.empty() || ( size.width == 0 ) || ( size.height == 0 ) )
+    return std::nullopt;
+
+  const glm::vec4  ndc( 2.0f * point.x / size.width - 1.0f, 1.0f - 2.0f * point.y / size.height, 0.0f, 1.0f );
+  const glm::vec4  pt = glm::inverse( m_model ) * ndc;
+
+  // Window pixels per level pixel
+  const ure::double_t  scale = std::abs( m_model[0][0] ) * size.width / 2.0;
+
+  if ( ( pt.w == 0.0f ) || ( scale <= 0.0 ) )
+    return std::nullopt;
+
+  const ure::double_t  world = this->world();
+  const MarkerIndex::point_t  position{ ( pt.x / pt.w - static_cast<ure::double_t>(m_origin.x) ) / world,
+                                        ( pt.y / pt.w - static_cast<ure::double_t>(m_origin.y) ) / world };
+
+  return m_index.pick( position, m_radius / scale / world, m_cluster_distance / world );
+}
+
+ure::uint_t   MarkerSet::draw() noexcept(true)
+{
+  if ( m_index.empty() )
+    return 0;
+
+  const MarkerIndex::bounds_t view = view_bounds();
+
+  if ( ( view.min_x >= view.max_x ) || ( view.min_y >= view.max_y ) )
+    return 0;
+
+  if ( m_dirty || ( view.min_x < m_queried.min_x ) || ( view.min_y < m_queried.min_y ) ||
+                  ( view.max_x > m_queried.max_x ) || ( view.max_y > m_queried.max_y ) )
+  {
+    refresh( view );
+  }
+
+  return m_renderer.draw( m_model, m_fb_size );
+}
+
+ure::double_t   MarkerSet::world() const noexcept(true)
+{
+  return std::ldexp( static_cast<ure::double_t>( m_tile_pixels ), m_zoom );
+}
+
+MarkerIndex::bounds_t   MarkerSet::view_bounds() const noexcept(true)
+{
+  const MarkerIndex::bounds_t  none{ 0.0, 0.0, 0.0, 0.0 };
+
+  if ( ( m_fb_size.width == 0 ) || ( m_fb_size.height == 0 ) )
+    return none;
+
+  glm::vec2  min( 0.0f );
+  glm::vec2  max( 0.0f );
+
+  if ( visible_area( m_model, m_fb_size, min, max ) == false )
+    return none;
+
+  // Discs centred outside of the view may still cover part of it
+  const ure::double_t  scale  = std::abs( m_model[0][0] ) * m_fb_size.width / 2.0;
+  const ure::double_t  margin = ( scale > 0.0 ) ? m_radius * MarkerIndex::max_radius_scale() / scale : 0.0;
+  const ure::double_t  world  = this->world();
+
+  return MarkerIndex::bounds_t{ ( min.x - margin - m_origin.x ) / world, ( min.y - margin - m_origin.y ) / world,
+                                ( max.x + margin - m_origin.x ) / world, ( max.y + margin - m_origin.y ) / world };
+}
+
+ure::void_t   MarkerSet::refresh( const MarkerIndex::bounds_t& view ) noexcept(true)
+{
+  // Half a viewport on every side, slow pans reuse the same markers for a while
+  const ure::double_t  dx = ( view.max_x - view.min_x ) / 2.0;
+  const ure::double_t  dy = ( view.max_y - view.min_y ) / 2.0;
+  const ure::double_t  world = this->world();
+
+  m_queried = MarkerIndex::bounds_t{ view.min_x - dx, view.min_y - dy, view.max_x + dx, view.max_y + dy };
+  m_dirty   = false;
+  ++m_queries;
+
+  m_visible.clear();
+  m_index.query( m_queried, m_cluster_distance / world, m_visible );
+
+  m_instances.resize( m_visible.size() );
+
+  for ( std::size_t i = 0; i < m_visible.size(); ++i )
+  {
+    const MarkerIndex::cluster_t& cluster = m_visible[i];
+
+    m_instances[i] = MarkerRenderer::instance_t{
+                       glm::vec2( static_cast<ure::float_t>( m_origin.x + cluster.x * world ), static_cast<ure::float_t>( m_origin.y + cluster.y * world ) ),
+                       m_radius * MarkerIndex::radius_scale( cluster.count ),
+                       ( cluster.count > 1 ) ? 1.0f : 0.0f
+                     };
+  }
+
+  m_renderer.upload( m_instances );
+}
@@ -0,0 +1,195 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "metrics.h"
+
+#if MAP_ENABLE_METRICS
+
+#include <algorithm>
+
+namespace
+{
+  const char* const  timer_names[]   = { "frame", "clear", "render", "swap", "process_message", "upload", "prefetch", "dispatch", "decode" };
+  const char* const  counter_names[] = { "cache_hits", "cache_misses", "tiles_uploaded", "upload_bytes", "downloads_dispatched" };
+  const char* const  gauge_names[]   = { "queue_depth", "in_flight", "decoder_pending", "cache_tiles", "gpu_bytes" };
+
+  static_assert( std::size( timer_names   ) == Metrics::timers   );
+  static_assert( std::size( counter_names ) == Metrics::counters );
+  static_assert( std::size( gauge_names   ) == Metrics::gauges   );
+
+  // Weight of the last frame in the moving averages, about one second at 60 fps
+  constexpr ure::double_t  average_weight = 1.0 / 60.0;
+}
+
+Metrics&  Metrics::instance() noexcept(true)
+{
+  static Metrics metrics( 600 );
+
+  return metrics;
+}
+
+Metrics::Metrics( std::size_t history ) noexcept(true)
+  : m_totals{}, m_values{}, m_average_ms{}, m_last{}, m_history( history ), m_next(0), m_frames(0)
+{
+  for ( std::atomic<std::uint64_t>& count : m_counts )
+    count.store( 0 );
+}
+
+ure::void_t  Metrics::total( counter_t counter, std::uint64_t value ) noexcept(true)
+{
+  std::uint64_t& last = m_totals[ static_cast<std::size_t>(counter) ];
+
+  // Totals never go back, a reset source starts over from its new value
+  add( counter, ( value >= last ) ? value - last : value );
+
+  last = value;
+}
+
+ure::void_t  Metrics::end_frame() noexcept(true)
+{
+  frame_t& frame = m_history[m_next];
+
+  frame.index = m_frames++;
+
+  for ( std::size_t i = 0; i < timers; ++i )
+  {
+    frame.ms[i]      = static_cast<ure::double_t>( m_timers[i].ns.exchange( 0, std::memory_order_relaxed ) ) / 1.0e6;
+    frame.samples[i] = m_timers[i].samples.exchange( 0, std::memory_order_relaxed );
+
+    m_average_ms[i] += ( frame.ms[i] - m_average_ms[i] ) * ( ( frame.index == 0 ) ? 1.0 : average_weight );
+  }
+
+  for ( std::size_t i = 0; i < counters; ++i )
+    frame.counts[i] = m_counts[i].exchange( 0, std::memory_order_relaxed );
+
+  frame.values = m_values;
+
+  m_last = frame;
+  m_next = ( m_next + 1 ) % m_history.size();
+}
+
+ure::double_t  Metrics::max_ms( timer_t timer ) const noexcept(true)
+{
+  const std::size_t  frames = static_cast<std::size_t>( std::min<std::uint64_t>( m_frames, m_history.size() ) );
+  ure::double_t      result = 0.0;
+
+  for ( std::size_t i = 0; i < frames; ++i )
+    result = std::max( result, m_history[i].ms[ static_cast<std::size_t>(timer) ] );
+
+  return result;
+}
+
+ure::bool_t  Metrics::dump( const std::string& path ) const noexcept(true)
+{
+  std::FILE* file = std::fopen( path.c_str(), "w" );
+  if ( file == nullptr )
+    return false;
+
+  const ure::bool_t csv  = ( path.size() >= 4 ) && ( path.compare( path.size() - 4, 4, ".csv" ) == 0 );
+  ure::bool_t       done = csv ? dump_csv( file ) : dump_json( file );
+
+  done = ( std::fclose( file ) == 0 ) && done;
+
+  return done;
+}
+
+ure::bool_t  Metrics::dump_csv( std::FILE* file ) const noexcept(true)
+{
+  std::fprintf( file, "frame" );
+
+  for ( const char* name : timer_names   ) std::fprintf( file, ",%s_ms,%s_samples", name, name );
+  for ( const char* name : counter_names ) std::fprintf( file, ",%s", name );
+  for ( const char* name : gauge_names   ) std::fprintf( file, ",%s", name );
+
+  std::fprintf( file, "\n" );
+
+  // Oldest first, the ring is full once more frames than its size have been closed
+  const std::size_t size  = m_history.size();
+  const std::size_t count = static_cast<std::size_t>( std::min<std::uint64_t>( m_frames, size ) );
+  const std::size_t first = ( m_frames > size ) ? m_next : 0;
+
+  for ( std::size_t n = 0; n < count; ++n )
+  {
+    const frame_t& frame = m_history[ ( first + n ) % size ];
+
+    std::fprintf( file, "%llu", static_cast<unsigned long long>( frame.index ) );
+
+    for ( std::size_t i = 0; i < timers;   ++i ) std::fprintf( file, ",%.4f,%u", frame.ms[i], frame.samples[i] );
+    for ( std::size_t i = 0; i < counters; ++i ) std::fprintf( file, ",%llu", static_cast<unsigned long long>( frame.counts[i] ) );
+    for ( std::size_t i = 0; i < gauges;   ++i ) std::fprintf( file, ",%.0f", frame.values[i] );
+
+    std::fprintf( file, "\n" );
+  }
+
+  return std::ferror( file ) == 0;
+}
+
+ure::bool_t  Metrics::dump_json( std::FILE* file ) const noexcept(true)
+{
+  const std::size_t size  = m_history.size();
+  const std::size_t count = static_cast<std::size_t>( std::min<std::uint64_t>( m_frames, size ) );
+  const std::size_t first = ( m_frames > size ) ? m_next : 0;
+
+  std::fprintf( file, "{\n  \"frames\": [" );
+
+  for ( std::size_t n = 0; n < count; ++n )
+  {
+    const frame_t& frame = m_history[ ( first + n ) % size ];
+
+    std::fprintf( file, "%s\n    { \"frame\": %llu, \"ms\": {", ( n > 0 ) ? "," : "", static_cast<unsigned long long>( frame.index ) );
+
+    for ( std::size_t i = 0; i < timers; ++i )
+      std::fprintf( file, "%s \"%s\": %.4f", ( i > 0 ) ? "," : "", timer_names[i], frame.ms[i] );
+
+    std::fprintf( file, " }, \"samples\": {" );
+
+    for ( std::size_t i = 0; i < timers; ++i )
+      std::fprintf( file, "%s \"%s\": %u", ( i > 0 ) ? "," : "", timer_names[i], frame.samples[i] );
+
+    std::fprintf( file, " }, \"counters\": {" );
+
+    for ( std::size_t i = 0; i < counters; ++i )
+      std::fprintf( file, "%s \"%s\": %llu", ( i > 0 ) ? "," : "", counter_names[i], static_cast<unsigned long long>( frame.counts[i] ) );
+
+    std::fprintf( file, " }, \"gauges\": {" );
+
+    for ( std::size_t i = 0; i < gauges; ++i )
+      std::fprintf( file, "%s \"%s\": %.0f", ( i > 0 ) ? "," : "", gauge_names[i], frame.values[i] );
+
+    std::fprintf( file, " } }" );
+  }
+
+  std::fprintf( file, "\n  ]\n}\n" );
+
+  return std::ferror( file ) == 0;
+}
+
+const char*  Metrics::name( timer_t timer ) noexcept
+{
+  return timer_names[ static_cast<std::size_t>(timer) ];
+}
+
+const char*  Metrics::name( counter_t counter ) noexcept
+{
+  return counter_names[ static_cast<std::size_t>(counter) ];
+}
+
+const char*  Metrics::name( gauge_t gauge ) noexcept
+{
+  return gauge_names[ static_cast<std::size_t>(gauge) ];
+}
+
+#endif // MAP_ENABLE_METRICS
@@ -0,0 +1,429 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "metrics_overlay.h"
+
+#if MAP_ENABLE_METRICS
+
+#include <ure_utils.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+  constexpr ure::uint_t  glyph_width   = 8;
+  constexpr ure::uint_t  glyph_height  = 12;
+  constexpr ure::uint_t  glyph_columns = 16;
+  constexpr ure::uint_t  glyph_rows    = 6;     /* ASCII 32 to 127 */
+  constexpr ure::uint_t  font_width    = glyph_width  * glyph_columns;
+  constexpr ure::uint_t  font_height   = glyph_height * glyph_rows;
+
+  constexpr ure::float_t margin        = 8.0f;  /* Pixels from the viewport corner */
+  constexpr ure::float_t scale         = 1.0f;
+
+  // One byte per glyph row, most significant bit on the left.
+  // Rasterized from DejaVu Sans Mono at 11 pixels.
+  const ure::byte_t  font[95][glyph_height] = {
+    { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },   // ' '
+    { 0x00,0x10,0x10,0x10,0x10,0x10,0x10,0x00,0x10,0x00,0x00,0x00 },   // '!'
+    { 0x00,0x28,0x28,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },   // '"'
+    { 0x00,0x14,0x24,0x7E,0x28,0x28,0xFC,0x48,0x50,0x00,0x00,0x00 },   // '#'
+    { 0x00,0x10,0x3C,0x50,0x50,0x38,0x14,0x14,0x78,0x10,0x10,0x00 },   // '$'
+    { 0x00,0xE0,0xA0,0xE4,0x18,0x20,0xDC,0x14,0x1C,0x00,0x00,0x00 },   // '%'
+    { 0x00,0x38,0x20,0x20,0x30,0x5A,0x4A,0x44,0x3E,0x00,0x00,0x00 },   // '&'
+    { 0x00,0x10,0x10,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },   // '''
+    { 0x10,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x10,0x00,0x00 },   // '('
+    { 0x20,0x20,0x10,0x10,0x10,0x10,0x10,0x10,0x20,0x20,0x00,0x00 },   // ')'
+    { 0x00,0x10,0x54,0x38,0x38,0x54,0x10,0x00,0x00,0x00,0x00,0x00 },   // '*'
+    { 0x00,0x00,0x00,0x10,0x10,0x7C,0x10,0x10,0x00,0x00,0x00,0x00 },   // '+'
+    { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x10,0x20,0x00,0x00 },   // ','
+    { 0x00,0x00,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x00,0x00,0x00 },   // '-'
+    { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x10,0x00,0x00,0x00 },   // '.'
+    { 0x00,0x04,0x08,0x08,0x10,0x10,0x10,0x20,0x20,0x40,0x00,0x00 },   // '/'
+    { 0x00,0x3C,0x66,0x42,0x4A,0x42,0x42,0x66,0x3C,0x00,0x00,0x00 },   // '0'
+    { 0x00,0x70,0x10,0x10,0x10,0x10,0x10,0x10,0x7C,0x00,0x00,0x00 },   // '1'
+    { 0x00,0x3C,0x42,0x02,0x06,0x0C,0x18,0x20,0x7E,0x00,0x00,0x00 },   // '2'
+    { 0x00,0x3C,0x42,0x02,0x3C,0x06,0x02,0x42,0x3C,0x00,0x00,0x00 },   // '3'
+    { 0x00,0x0C,0x0C,0x14,0x24,0x64,0x7E,0x04,0x04,0x00,0x00,0x00 },   // '4'
+    { 0x00,0x7C,0x40,0x40,0x7C,0x06,0x02,0x02,0x7C,0x00,0x00,0x00 },   // '5'
+    { 0x00,0x1E,0x20,0x40,0x5C,0x62,0x42,0x42,0x3C,0x00,0x00,0x00 },   // '6'
+    { 0x00,0x7E,0x04,0x04,0x08,0x08,0x10,0x10,0x20,0x00,0x00,0x00 },   // '7'
+    { 0x00,0x3C,0x42,0x42,0x3C,0x42,0x42,0x42,0x3C,0x00,0x00,0x00 },   // '8'
+    { 0x00,0x3C,0x42,0x42,0x42,0x3E,0x02,0x04,0x78,0x00,0x00,0x00 },   // '9'
+    { 0x00,0x00,0x00,0x10,0x10,0x00,0x00,0x10,0x10,0x00,0x00,0x00 },   // ':'
+    { 0x00,0x00,0x00,0x10,0x10,0x00,0x00,0x10,0x10,0x20,0x00,0x00 },   // ';'
+    { 0x00,0x00,0x00,0x02,0x1C,0x60,0x38,0x06,0x00,0x00,0x00,0x00 },   // '<'
+    { 0x00,0x00,0x00,0x00,0xFC,0x00,0xFC,0x00,0x00,0x00,0x00,0x00 },   // '='
+    { 0x00,0x00,0x00,0x40,0x38,0x06,0x1C,0x60,0x00,0x00,0x00,0x00 },   // '>'
+    { 0x00,0x38,0x04,0x0C,0x18,0x10,0x10,0x00,0x10,0x00,0x00,0x00 },   // '?'
+    { 0x00,0x1C,0x26,0x42,0x4E,0x52,0x52,0x4E,0x60,0x20,0x1C,0x00 },   // '@'
+    { 0x00,0x18,0x18,0x18,0x24,0x24,0x3C,0x42,0x42,0x00,0x00,0x00 },   // 'A'
+    { 0x00,0x7C,0x42,0x42,0x7C,0x42,0x42,0x42,0x7C,0x00,0x00,0x00 },   // 'B'
+    { 0x00,0x1C,0x22,0x40,0x40,0x40,0x40,0x22,0x1C,0x00,0x00,0x00 },   // 'C'
+    { 0x00,0x78,0x44,0x42,0x42,0x42,0x42,0x44,0x78,0x00,0x00,0x00 },   // 'D'
+    { 0x00,0x7E,0x40,0x40,0x7E,0x40,0x40,0x40,0x7E,0x00,0x00,0x00 },   // 'E'
+    { 0x00,0x7E,0x40,0x40,0x7E,0x40,0x40,0x40,0x40,0x00,0x00,0x00 },   // 'F'
+    { 0x00,0x1C,0x22,0x40,0x40,0x46,0x42,0x22,0x1C,0x00,0x00,0x00 },   // 'G'
+    { 0x00,0x42,0x42,0x42,0x7E,0x42,0x42,0x42,0x42,0x00,0x00,0x00 },   // 'H'
+    { 0x00,0x7C,0x10,0x10,0x10,0x10,0x10,0x10,0x7C,0x00,0x00,0x00 },   // 'I'
+    { 0x00,0x1C,0x04,0x04,0x04,0x04,0x04,0x44,0x38,0x00,0x00,0x00 },   // 'J'
+    { 0x00,0x44,0x48,0x50,0x60,0x50,0x48,0x44,0x42,0x00,0x00,0x00 },   // 'K'
+    { 0x00,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x7E,0x00,0x00,0x00 },   // 'L'
+    { 0x00,0x42,0x66,0x66,0x5A,0x5A,0x42,0x42,0x42,0x00,0x00,0x00 },   // 'M'
+    { 0x00,0x42,0x62,0x52,0x52,0x4A,0x4A,0x46,0x42,0x00,0x00,0x00 },   // 'N'
+    { 0x00,0x3C,0x66,0x42,0x42,0x42,0x42,0x66,0x3C,0x00,0x00,0x00 },   // 'O'
+    { 0x00,0x7C,0x42,0x42,0x42,0x7C,0x40,0x40,0x40,0x00,0x00,0x00 },   // 'P'
+    { 0x00,0x3C,0x66,0x42,0x42,0x42,0x42,0x66,0x3C,0x06,0x00,0x00 },   // 'Q'
+    { 0x00,0x7C,0x42,0x42,0x42,0x7C,0x44,0x42,0x41,0x00,0x00,0x00 },   // 'R'
+    { 0x00,0x3C,0x42,0x40,0x78,0x06,0x02,0x42,0x3C,0x00,0x00,0x00 },   // 'S'
+    { 0x00,0xFE,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },   // 'T'
+    { 0x00,0x42,0x42,0x42,0x42,0x42,0x42,0x42,0x3C,0x00,0x00,0x00 },   // 'U'
+    { 0x00,0x42,0x42,0x24,0x24,0x24,0x18,0x18,0x18,0x00,0x00,0x00 },   // 'V'
+    { 0x00,0x82,0x92,0x92,0xAA,0x6C,0x6C,0x44,0x44,0x00,0x00,0x00 },   // 'W'
+    { 0x00,0x42,0x24,0x24,0x18,0x18,0x24,0x24,0x42,0x00,0x00,0x00 },   // 'X'
+    { 0x00,0xC6,0x44,0x28,0x38,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },   // 'Y'
+    { 0x00,0x7E,0x04,0x04,0x08,0x10,0x30,0x20,0x7E,0x00,0x00,0x00 },   // 'Z'
+    { 0x30,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x30,0x00,0x00 },   // '['
+    { 0x00,0x40,0x20,0x20,0x10,0x10,0x10,0x08,0x08,0x04,0x00,0x00 },   // backslash
+    { 0x30,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x30,0x00,0x00 },   // ']'
+    { 0x00,0x30,0x48,0x84,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },   // '^'
+    { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFE },   // '_'
+    { 0x10,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },   // '`'
+    { 0x00,0x00,0x00,0x78,0x04,0x3C,0x44,0x44,0x3C,0x00,0x00,0x00 },   // 'a'
+    { 0x40,0x40,0x40,0x78,0x44,0x44,0x44,0x44,0x78,0x00,0x00,0x00 },   // 'b'
+    { 0x00,0x00,0x00,0x3C,0x60,0x40,0x40,0x60,0x3C,0x00,0x00,0x00 },   // 'c'
+    { 0x04,0x04,0x04,0x3C,0x44,0x44,0x44,0x44,0x3C,0x00,0x00,0x00 },   // 'd'
+    { 0x00,0x00,0x00,0x38,0x44,0x7C,0x40,0x40,0x3C,0x00,0x00,0x00 },   // 'e'
+    { 0x0C,0x10,0x10,0x7C,0x10,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },   // 'f'
+    { 0x00,0x00,0x00,0x3C,0x44,0x44,0x44,0x44,0x3C,0x04,0x38,0x00 },   // 'g'
+    { 0x40,0x40,0x40,0x58,0x64,0x44,0x44,0x44,0x44,0x00,0x00,0x00 },   // 'h'
+    { 0x10,0x00,0x00,0x70,0x10,0x10,0x10,0x10,0x7C,0x00,0x00,0x00 },   // 'i'
+    { 0x10,0x00,0x00,0x70,0x10,0x10,0x10,0x10,0x10,0x10,0x60,0x00 },   // 'j'
+    { 0x40,0x40,0x40,0x48,0x50,0x60,0x50,0x48,0x44,0x00,0x00,0x00 },   // 'k'
+    { 0xE0,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x18,0x00,0x00,0x00 },   // 'l'
+    { 0x00,0x00,0x00,0x7C,0x54,0x54,0x54,0x54,0x54,0x00,0x00,0x00 },   // 'm'
+    { 0x00,0x00,0x00,0x58,0x64,0x44,0x44,0x44,0x44,0x00,0x00,0x00 },   // 'n'
+    { 0x00,0x00,0x00,0x38,0x44,0x44,0x44,0x44,0x38,0x00,0x00,0x00 },   // 'o'
+    { 0x00,0x00,0x00,0x78,0x44,0x44,0x44,0x44,0x78,0x40,0x40,0x00 },   // 'p'
+    { 0x00,0x00,0x00,0x3C,0x44,0x44,0x44,0x44,0x3C,0x04,0x04,0x00 },   // 'q'
+    { 0x00,0x00,0x00,0x3C,0x24,0x20,0x20,0x20,0x20,0x00,0x00,0x00 },   // 'r'
+    { 0x00,0x00,0x00,0x3C,0x40,0x70,0x0C,0x04,0x78,0x00,0x00,0x00 },   // 's'
+    { 0x00,0x20,0x20,0xF8,0x20,0x20,0x20,0x20,0x38,0x00,0x00,0x00 },   // 't'
+    { 0x00,0x00,0x00,0x44,0x44,0x44,0x44,0x44,0x3C,0x00,0x00,0x00 },   // 'u'
+    { 0x00,0x00,0x00,0x44,0x44,0x28,0x28,0x28,0x10,0x00,0x00,0x00 },   // 'v'
+    { 0x00,0x00,0x00,0x82,0x82,0x54,0x54,0x28,0x28,0x00,0x00,0x00 },   // 'w'
+    { 0x00,0x00,0x00,0x6C,0x28,0x10,0x10,0x28,0x6C,0x00,0x00,0x00 },   // 'x'
+    { 0x00,0x00,0x00,0x44,0x48,0x28,0x28,0x30,0x10,0x20,0x60,0x00 },   // 'y'
+    { 0x00,0x00,0x00,0x7C,0x08,0x18,0x30,0x20,0x7C,0x00,0x00,0x00 },   // 'z'
+    { 0x1C,0x10,0x10,0x10,0x60,0x10,0x10,0x10,0x10,0x1C,0x00,0x00 },   // '{'
+    { 0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x00 },   // '|'
+    { 0x70,0x10,0x10,0x10,0x0C,0x10,0x10,0x10,0x10,0x70,0x00,0x00 },   // '}'
+    { 0x00,0x00,0x00,0x00,0x00,0x70,0x0E,0x00,0x00,0x00,0x00,0x00 },   // '~'
+  };
+}
+
+MetricsOverlay::MetricsOverlay() noexcept(true)
+  : m_shaders_path( "./resources/shaders/" ), m_failed(false), m_program(0), m_font(0), m_vbo(0),
+    m_a_point(-1), m_a_texcoord(-1), m_u_mvp(-1), m_u_texture(-1), m_u_color(-1), m_count(0), m_refresh_at{}
+{
+}
+
+MetricsOverlay::~MetricsOverlay() noexcept(true)
+{
+}
+
+ure::void_t   MetricsOverlay::set_shaders_path( const std::string& path ) noexcept(true)
+{
+  m_shaders_path = path;
+}
+
+ure::void_t   MetricsOverlay::draw( const ure::Size& size ) noexcept(true)
+{
+  if ( init() == false )
+    return;
+
+  const clock_t::time_point now = clock_t::now();
+
+  // Values change every frame, text is only refreshed as fast as it can be read
+  if ( now >= m_refresh_at )
+  {
+    format();
+    build();
+
+    m_refresh_at = now + std::chrono::milliseconds(250);
+  }
+
+  if ( m_count == 0 )
+    return;
+
+  // Pixel coordinates, origin in the top left corner
+  const glm::mat4 mvp = glm::ortho( 0.0f, static_cast<ure::float_t>(size.width), static_cast<ure::float_t>(size.height), 0.0f, -1.0f, 1.0f );
+
+  const GLboolean blend = glIsEnabled( GL_BLEND );
+  if ( blend == GL_FALSE )
+    glEnable( GL_BLEND );
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+  glUseProgram( m_program );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+  glUniform4f( m_u_color, 1.0f, 1.0f, 0.3f, 1.0f );
+  glUniform1i( m_u_texture, 0 );
+
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, m_font );
+
+  glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_point)   , 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, x) ) );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_texcoord), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offsetof(vertex_t, u) ) );
+
+  glDrawArrays( GL_TRIANGLES, 0, m_count );
+
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glBindTexture( GL_TEXTURE_2D, 0 );
+  glUseProgram( 0 );
+
+  if ( blend == GL_FALSE )
+    glDisable( GL_BLEND );
+}
+
+ure::void_t   MetricsOverlay::dispose() noexcept(true)
+{
+  if ( m_program != 0 )
+    glDeleteProgram( m_program );
+  if ( m_font != 0 )
+    glDeleteTextures( 1, &m_font );
+  if ( m_vbo != 0 )
+    glDeleteBuffers( 1, &m_vbo );
+
+  m_program = 0;
+  m_font    = 0;
+  m_vbo     = 0;
+  m_count   = 0;
+}
+
+ure::void_t   MetricsOverlay::format() noexcept(true)
+{
+  using timer_t   = Metrics::timer_t;
+  using counter_t = Metrics::counter_t;
+  using gauge_t   = Metrics::gauge_t;
+
+  const Metrics&          metrics = Metrics::instance();
+  const Metrics::frame_t& last    = metrics.last();
+
+  auto avg     = [&metrics]( timer_t t ) { return metrics.average_ms( t ); };
+  auto count   = [&last]( counter_t c ) { return static_cast<unsigned long long>( last.counts[ static_cast<std::size_t>(c) ] ); };
+  auto value   = [&last]( gauge_t g ) { return last.values[ static_cast<std::size_t>(g) ]; };
+
+  const ure::uint_t   decoded = last.samples[ static_cast<std::size_t>(timer_t::decode) ];
+  const ure::double_t decode  = ( decoded > 0 ) ? last.ms[ static_cast<std::size_t>(timer_t::decode) ] / decoded : 0.0;
+
+  char buffer[512];
+
+  std::snprintf( buffer, sizeof(buffer),
+                 "frame    %6.2f ms  max %6.2f\n"
+                 "clear    %6.2f  render %6.2f\n"
+                 "swap     %6.2f  events %6.2f\n"
+                 "upload   %6.2f  fetch  %6.2f\n"
+                 "decode   %6.2f ms/tile  %u\n"
+                 "cache    %llu hits  %llu misses\n"
+                 "queue    %.0f  in flight %.0f\n"
+                 "decoding %.0f  uploaded %llu  %llu KB\n"
+                 "gpu      %.1f MB  %.0f tiles",
+                 avg( timer_t::frame ), metrics.max_ms( timer_t::frame ),
+                 avg( timer_t::clear ), avg( timer_t::render ),
+                 avg( timer_t::swap  ), avg( timer_t::process_message ),
+                 avg( timer_t::upload ), avg( timer_t::prefetch ) + avg( timer_t::dispatch ),
+                 decode, decoded,
+                 count( counter_t::cache_hits ), count( counter_t::cache_misses ),
+                 value( gauge_t::queue_depth ), value( gauge_t::in_flight ),
+                 value( gauge_t::decoder_pending ), count( counter_t::tiles_uploaded ), count( counter_t::upload_bytes ) / 1024,
+                 value( gauge_t::gpu_bytes ) / ( 1024.0 * 1024.0 ), value( gauge_t::cache_tiles ) );
+
+  m_text = buffer;
+}
+
+ure::void_t   MetricsOverlay::build() noexcept(true)
+{
+  const ure::float_t  w   = glyph_width  * scale;
+  const ure::float_t  h   = glyph_height * scale;
+  ure::float_t        x   = margin;
+  ure::float_t        y   = margin;
+
+  m_vertices.clear();
+
+  for ( const char c : m_text )
+  {
+    if ( c == '\n' )
+    {
+      x  = margin;
+      y += h;
+      continue;
+    }
+
+    const ure::uint_t glyph = ( ( c >= 32 ) && ( c < 127 ) ) ? static_cast<ure::uint_t>( c - 32 ) : ( '?' - 32 );
+
+    if ( glyph != 0 )
+    {
+      const ure::float_t u0 = static_cast<ure::float_t>( ( glyph % glyph_columns ) * glyph_width  ) / font_width;
+      const ure::float_t v0 = static_cast<ure::float_t>( ( glyph / glyph_columns ) * glyph_height ) / font_height;
+      const ure::float_t u1 = u0 + static_cast<ure::float_t>( glyph_width  ) / font_width;
+      const ure::float_t v1 = v0 + static_cast<ure::float_t>( glyph_height ) / font_height;
+
+      m_vertices.push_back( vertex_t{ x    , y    , u0, v0 } );
+      m_vertices.push_back( vertex_t{ x + w, y    , u1, v0 } );
+      m_vertices.push_back( vertex_t{ x    , y + h, u0, v1 } );
+      m_vertices.push_back( vertex_t{ x    , y + h, u0, v1 } );
+      m_vertices.push_back( vertex_t{ x + w, y    , u1, v0 } );
+      m_vertices.push_back( vertex_t{ x + w, y + h, u1, v1 } );
+    }
+
+    x += w;
+  }
+
+  m_count = static_cast<GLsizei>( m_vertices.size() );
+
+  glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+  glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( m_vertices.size() * sizeof(vertex_t) ), m_vertices.data(), GL_DYNAMIC_DRAW );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+ure::bool_t   MetricsOverlay::init() noexcept(true)
+{
+  if ( m_program != 0 )
+    return true;
+
+  if ( m_failed )
+    return false;
+
+  m_failed = true;
+
+  GLuint vs = compile( GL_VERTEX_SHADER  , "DefaultText.vs" );
+  GLuint fs = compile( GL_FRAGMENT_SHADER, "DefaultText.fs" );
+
+  if ( ( vs == 0 ) || ( fs == 0 ) )
+  {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader( program, vs );
+  glAttachShader( program, fs );
+  glLinkProgram ( program );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &linked );
+  if ( linked != GL_TRUE )
+  {
+    ure::utils::log( "MetricsOverlay: unable to link DefaultText program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_a_point    = glGetAttribLocation ( program, "a_v2Point"    );
+  m_a_texcoord = glGetAttribLocation ( program, "a_v2TexCoord" );
+  m_u_mvp      = glGetUniformLocation( program, "u_m4MVP"      );
+  m_u_texture  = glGetUniformLocation( program, "u_2dTexture"  );
+  m_u_color    = glGetUniformLocation( program, "u_v4Color"    );
+
+  if ( ( m_a_point < 0 ) || ( m_a_texcoord < 0 ) )
+  {
+    ure::utils::log( "MetricsOverlay: missing attributes in DefaultText program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  /////////////////
+  // Expand the 1 bit font to an alpha texture
+  std::vector<ure::byte_t> pixels( font_width * font_height, 0 );
+
+  for ( ure::uint_t glyph = 0; glyph < 95; ++glyph )
+  {
+    const ure::uint_t x0 = ( glyph % glyph_columns ) * glyph_width;
+    const ure::uint_t y0 = ( glyph / glyph_columns ) * glyph_height;
+
+    for ( ure::uint_t row = 0; row < glyph_height; ++row )
+      for ( ure::uint_t bit = 0; bit < glyph_width; ++bit )
+        pixels[ ( y0 + row ) * font_width + x0 + bit ] = ( font[glyph][row] & ( 0x80 >> bit ) ) ? 0xFF : 0x00;
+  }
+
+  glGenTextures( 1, &m_font );
+  glBindTexture( GL_TEXTURE_2D, m_font );
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_ALPHA, font_width, font_height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data() );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+  glBindTexture( GL_TEXTURE_2D, 0 );
+
+  glGenBuffers( 1, &m_vbo );
+
+  m_program = program;
+  m_failed  = false;
+
+  return true;
+}
+
+GLuint   MetricsOverlay::compile( GLenum type, const std::string& file ) noexcept(true)
+{
+  std::ifstream      stream( m_shaders_path + file );
+  std::stringstream  source;
+
+  if ( !stream )
+  {
+    ure::utils::log( "MetricsOverlay: unable to read shader [" + m_shaders_path + file + "]" );
+    return 0;
+  }
+
+  source << stream.rdbuf();
+
+  const std::string  text = source.str();
+  const GLchar*      ptr  = text.c_str();
+
+  GLuint shader = glCreateShader( type );
+  glShaderSource ( shader, 1, &ptr, nullptr );
+  glCompileShader( shader );
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+  if ( compiled != GL_TRUE )
+  {
+    GLchar  log[512] = { 0 };
+    glGetShaderInfoLog( shader, sizeof(log), nullptr, log );
+
+    ure::utils::log( "MetricsOverlay: unable to compile [" + file + "]: " + log );
+    glDeleteShader( shader );
+    return 0;
+  }
+
+  return shader;
+}
+
+#endif // MAP_ENABLE_METRICS
@@ -0,0 +1,267 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "mvt_reader.h"
+
+#include <cstdint>
+
+namespace
+{
+  // Protobuf wire types used by the vector tile schema
+  enum wire_t : std::uint32_t
+  {
+    wire_varint  = 0,
+    wire_fixed64 = 1,
+    wire_bytes   = 2,
+    wire_fixed32 = 5
+  };
+
+  /**
+   * Cursor over a protobuf message, every read fails once the end or a malformed field is reached.
+   */
+  class Message
+  {
+  public:
+    Message( const ure::byte_t* data, std::size_t length ) noexcept
+      : m_ptr( data ), m_end( data + length ), m_field( 0 ), m_wire( 0 )
+    {}
+
+    /** Move to the next field, false at the end */
+    bool  next() noexcept
+    {
+      std::uint64_t tag = 0;
+
+      if ( ( m_ptr >= m_end ) || ( varint( tag ) == false ) )
+        return false;
+
+      m_field = static_cast<std::uint32_t>( tag >> 3 );
+      m_wire  = static_cast<std::uint32_t>( tag & 7 );
+
+      return true;
+    }
+
+    std::uint32_t field() const noexcept { return m_field; }
+    std::uint32_t wire()  const noexcept { return m_wire;  }
+
+    bool  varint( std::uint64_t& value ) noexcept
+    {
+      value = 0;
+
+      for ( std::uint32_t shift = 0; ( shift < 64 ) && ( m_ptr < m_end ); shift += 7 )
+      {
+        const ure::byte_t byte = *m_ptr++;
+
+        value |= std::uint64_t( byte & 0x7F ) << shift;
+
+        if ( ( byte & 0x80 ) == 0 )
+          return true;
+      }
+
+      return false;
+    }
+
+    /** Length delimited payload of the current field */
+    bool  bytes( Message& payload ) noexcept
+    {
+      std::uint64_t length = 0;
+
+      if ( ( varint( length ) == false ) || ( length > static_cast<std::uint64_t>( m_end - m_ptr ) ) )
+        return false;
+
+      payload = Message( m_ptr, static_cast<std::size_t>(length) );
+      m_ptr  += length;
+
+      return true;
+    }
+
+    bool  skip() noexcept
+    {
+      std::uint64_t value = 0;
+      Message       payload( nullptr, 0 );
+
+      switch ( m_wire )
+      {
+        case wire_varint:  return varint( value );
+        case wire_bytes:   return bytes( payload );
+        case wire_fixed64: return advance( 8 );
+        case wire_fixed32: return advance( 4 );
+        default:           return false;
+      }
+    }
+
+    bool  at_end() const noexcept { return m_ptr >= m_end; }
+
+    const ure::byte_t* data() const noexcept { return m_ptr; }
+    std::size_t        size() const noexcept { return static_cast<std::size_t>( m_end - m_ptr ); }
+
+  private:
+    bool  advance( std::size_t count ) noexcept
+    {
+      if ( count > size() )
+        return false;
+
+      m_ptr += count;
+      return true;
+    }
+
+  private:
+    const ure::byte_t*  m_ptr;
+    const ure::byte_t*  m_end;
+    std::uint32_t       m_field;
+    std::uint32_t       m_wire;
+  };
+
+  inline std::int32_t  zigzag( std::uint64_t value ) noexcept
+  { return static_cast<std::int32_t>( ( value >> 1 ) ^ ( ~( value & 1 ) + 1 ) ); }
+
+  // Command integers of the geometry encoding
+  constexpr std::uint32_t  cmd_move_to    = 1;
+  constexpr std::uint32_t  cmd_line_to    = 2;
+  constexpr std::uint32_t  cmd_close_path = 7;
+
+  bool  decode_geometry( Message geometry, MvtReader::feature_t& feature ) noexcept
+  {
+    std::int32_t x = 0;
+    std::int32_t y = 0;
+
+    while ( geometry.at_end() == false )
+    {
+      std::uint64_t command = 0;
+      if ( geometry.varint( command ) == false )
+        return false;
+
+      const std::uint32_t id    = static_cast<std::uint32_t>( command & 7 );
+      const std::uint32_t count = static_cast<std::uint32_t>( command >> 3 );
+
+      if ( id == cmd_close_path )
+        continue;   // Rings are implicitly closed
+
+      if ( ( id != cmd_move_to ) && ( id != cmd_line_to ) )
+        return false;
+
+      for ( std::uint32_t i = 0; i < count; ++i )
+      {
+        std::uint64_t dx = 0;
+        std::uint64_t dy = 0;
+
+        if ( ( geometry.varint( dx ) == false ) || ( geometry.varint( dy ) == false ) )
+          return false;
+
+        x += zigzag( dx );
+        y += zigzag( dy );
+
+        // Every MoveTo starts a ring or a line, points of a multi point share one part
+        if ( ( id == cmd_move_to ) && ( ( feature.type != MvtReader::geometry_t::point ) || feature.parts.empty() ) )
+          feature.parts.push_back( static_cast<ure::uint_t>( feature.points.size() ) );
+
+        feature.points.emplace_back( static_cast<ure::float_t>(x), static_cast<ure::float_t>(y) );
+      }
+    }
+
+    return true;
+  }
+}
+
+ure::bool_t  MvtReader::parse( const ure::byte_t* data, std::size_t length, Handler& handler ) noexcept(true)
+{
+  // Gzip magic, the payload has not been inflated by the fetcher
+  if ( ( length >= 2 ) && ( data[0] == 0x1F ) && ( data[1] == 0x8B ) )
+    return false;
+
+  Message tile( data, length );
+
+  while ( tile.next() )
+  {
+    // Tile.layers = 3, everything else is skipped
+    Message layer( nullptr, 0 );
+
+    if ( ( tile.field() != 3 ) || ( tile.wire() != wire_bytes ) )
+    {
+      if ( tile.skip() == false )
+        return false;
+      continue;
+    }
+
+    if ( tile.bytes( layer ) == false )
+      return false;
+
+    // Name and extent may follow the features, read them first
+    std::string_view name;
+    std::uint64_t    extent = 4096;
+
+    for ( Message fields = layer; fields.next(); )
+    {
+      Message payload( nullptr, 0 );
+
+      if ( ( fields.field() == 1 ) && ( fields.wire() == wire_bytes ) && fields.bytes( payload ) )
+        name = std::string_view( reinterpret_cast<const char*>( payload.data() ), payload.size() );
+      else if ( ( fields.field() == 5 ) && ( fields.wire() == wire_varint ) && fields.varint( extent ) )
+        continue;
+      else if ( fields.skip() == false )
+        return false;
+    }
+
+    if ( ( extent == 0 ) || ( handler.on_layer( name, static_cast<ure::uint_t>(extent) ) == false ) )
+      continue;
+
+    // Layer.features = 2
+    for ( Message fields = layer; fields.next(); )
+    {
+      Message feature( nullptr, 0 );
+
+      if ( ( fields.field() != 2 ) || ( fields.wire() != wire_bytes ) )
+      {
+        if ( fields.skip() == false )
+          return false;
+        continue;
+      }
+
+      if ( fields.bytes( feature ) == false )
+        return false;
+
+      m_feature.type = geometry_t::unknown;
+      m_feature.points.clear();
+      m_feature.parts.clear();
+
+      // Feature.type = 3, Feature.geometry = 4, type usually comes first but is not required to
+      Message geometry( nullptr, 0 );
+      bool    has_geometry = false;
+
+      while ( feature.next() )
+      {
+        std::uint64_t type = 0;
+
+        if ( ( feature.field() == 3 ) && ( feature.wire() == wire_varint ) && feature.varint( type ) )
+          m_feature.type = ( type <= 3 ) ? static_cast<geometry_t>(type) : geometry_t::unknown;
+        else if ( ( feature.field() == 4 ) && ( feature.wire() == wire_bytes ) && feature.bytes( geometry ) )
+          has_geometry = true;
+        else if ( feature.skip() == false )
+          return false;
+      }
+
+      if ( ( has_geometry == false ) || ( m_feature.type == geometry_t::unknown ) )
+        continue;
+
+      if ( decode_geometry( geometry, m_feature ) == false )
+        return false;
+
+      handler.on_feature( m_feature );
+    }
+  }
+
+  // A truncated field stops next() before the end
+  return tile.at_end();
+}
@@ -0,0 +1,49 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "redraw_signal.h"
+
+RedrawSignal::RedrawSignal() noexcept(true)
+  : m_dirty(true)
+{
+}
+
+ure::void_t   RedrawSignal::request() noexcept(true)
+{
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_dirty = true;
+  }
+  m_cv.notify_all();
+}
+
+ure::bool_t   RedrawSignal::consume() noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  const ure::bool_t dirty = m_dirty;
+
+  m_dirty = false;
+
+  return dirty;
+}
+
+ure::bool_t   RedrawSignal::wait( duration_t timeout ) noexcept(true)
+{
+  std::unique_lock<std::mutex> lock( m_mutex );
+
+  return m_cv.wait_for( lock, timeout, [this]() { return m_dirty; } );
+}
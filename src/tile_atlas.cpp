@@ -0,0 +1,252 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_atlas.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Core in OpenGL ES 3.0 and OpenGL 4.3, not always exposed by the loader headers
+#ifndef GL_COMPRESSED_RGB8_ETC2
+# define GL_COMPRESSED_RGB8_ETC2  0x9274
+#endif
+
+TileAtlas::TileAtlas( const ure::Size& tile_size, ure::uint_t page_size ) noexcept(true)
+  : m_tile_size(tile_size), m_format(TileImage::format_t::rgba8), m_page_size(page_size), m_columns(0), m_rows(0)
+{
+}
+
+TileAtlas::~TileAtlas() noexcept(true)
+{
+  dispose();
+}
+
+ure::bool_t   TileAtlas::set_format( TileImage::format_t format ) noexcept(true)
+{
+  if ( ( m_pages.empty() == false ) || ( format == TileImage::format_t::encoded ) )
+    return false;
+
+  // Compressed blocks are 4x4 pixels, slots must start on a block boundary
+  if ( ( format == TileImage::format_t::etc2_rgb8 ) && ( ( m_tile_size.width % 4 != 0 ) || ( m_tile_size.height % 4 != 0 ) ) )
+    return false;
+
+  m_format = format;
+
+  return true;
+}
+
+TileImage::format_t   TileAtlas::supported( TileImage::format_t requested ) noexcept(true)
+{
+  if ( requested != TileImage::format_t::etc2_rgb8 )
+    return requested;
+
+  const char* version = reinterpret_cast<const char*>( glGetString( GL_VERSION ) );
+  if ( version == nullptr )
+    return TileImage::format_t::rgb565;
+
+  int major = 0;
+  int minor = 0;
+
+  // "OpenGL ES 3.2 ..." or "4.6.0 ..." on desktop profiles
+  if ( std::strncmp( version, "OpenGL ES", 9 ) == 0 )
+  {
+    if ( ( std::sscanf( version, "OpenGL ES %d.%d", &major, &minor ) == 2 ) && ( major >= 3 ) )
+      return requested;
+  }
+  else if ( ( std::sscanf( version, "%d.%d", &major, &minor ) == 2 ) && ( ( major > 4 ) || ( ( major == 4 ) && ( minor >= 3 ) ) ) )
+  {
+    return requested;
+  }
+
+  return TileImage::format_t::rgb565;
+}
+
+TileAtlas::slot_t   TileAtlas::allocate() noexcept(true)
+{
+  // Fill lower pages first, so that they are more likely to be shared in a draw call
+  for ( ure::uint_t page = 0; page < m_pages.size(); ++page )
+  {
+    std::vector<ure::uint_t>& free = m_pages[page].free;
+
+    if ( free.empty() == false )
+    {
+      const ure::uint_t index = free.back();
+      free.pop_back();
+      return slot_t{ page, index };
+    }
+  }
+
+  if ( add_page() == false )
+    return slot_t{};
+
+  const ure::uint_t page  = pages() - 1;
+  const ure::uint_t index = m_pages[page].free.back();
+
+  m_pages[page].free.pop_back();
+
+  return slot_t{ page, index };
+}
+
+ure::void_t   TileAtlas::release( const slot_t& slot ) noexcept(true)
+{
+  if ( ( slot.valid() == false ) || ( slot.page >= m_pages.size() ) )
+    return;
+
+  m_pages[slot.page].free.push_back( slot.index );
+}
+
+ure::bool_t   TileAtlas::upload( const slot_t& slot, const TileImage& image ) noexcept(true)
+{
+  if ( ( slot.valid() == false ) || ( slot.page >= m_pages.size() ) )
+    return false;
+
+  if ( ( image.width != m_tile_size.width ) || ( image.height != m_tile_size.height ) || ( image.format != m_format ) || ( image.pixels.size() < image.bytes() ) )
+    return false;
+
+  const GLint   x = static_cast<GLint>( ( slot.index % m_columns ) * m_tile_size.width  );
+  const GLint   y = static_cast<GLint>( ( slot.index / m_columns ) * m_tile_size.height );
+  const GLsizei w = static_cast<GLsizei>(image.width);
+  const GLsizei h = static_cast<GLsizei>(image.height);
+
+  glBindTexture  ( GL_TEXTURE_2D, m_pages[slot.page].texture );
+
+  const void*   pixels = m_uploader.begin( image.pixels.data(), image.bytes() );
+
+  switch ( m_format )
+  {
+    case TileImage::format_t::etc2_rgb8:
+      glCompressedTexSubImage2D( GL_TEXTURE_2D, 0, x, y, w, h, GL_COMPRESSED_RGB8_ETC2, static_cast<GLsizei>(image.bytes()), pixels );
+    break;
+
+    case TileImage::format_t::rgb565:
+      glPixelStorei  ( GL_UNPACK_ALIGNMENT, 2 );
+      glTexSubImage2D( GL_TEXTURE_2D, 0, x, y, w, h, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels );
+    break;
+
+    default:
+      glPixelStorei  ( GL_UNPACK_ALIGNMENT, 1 );
+      glTexSubImage2D( GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+    break;
+  }
+
+  m_uploader.end();
+  glBindTexture  ( GL_TEXTURE_2D, 0 );
+
+  return true;
+}
+
+glm::vec4   TileAtlas::uv( const slot_t& slot ) const noexcept(true)
+{
+  return uv( slot, glm::vec4( 0.0f, 0.0f, 1.0f, 1.0f ) );
+}
+
+glm::vec4   TileAtlas::uv( const slot_t& slot, const glm::vec4& sub ) const noexcept(true)
+{
+  const ure::float_t size  = static_cast<ure::float_t>(m_page_size);
+  const ure::float_t w     = static_cast<ure::float_t>(m_tile_size.width);
+  const ure::float_t h     = static_cast<ure::float_t>(m_tile_size.height);
+  const ure::float_t x     = static_cast<ure::float_t>( slot.index % m_columns ) * w;
+  const ure::float_t y     = static_cast<ure::float_t>( slot.index / m_columns ) * h;
+
+  return glm::vec4( ( x + sub.x * w + 0.5f ) / size, ( y + sub.y * h + 0.5f ) / size,
+                    ( x + sub.z * w - 0.5f ) / size, ( y + sub.w * h - 0.5f ) / size );
+}
+
+GLuint   TileAtlas::page_texture( ure::uint_t page ) const noexcept(true)
+{
+  return ( page < m_pages.size() ) ? m_pages[page].texture : 0;
+}
+
+ure::void_t   TileAtlas::dispose() noexcept(true)
+{
+  for ( const page_t& page : m_pages )
+  {
+    glDeleteTextures( 1, &page.texture );
+  }
+
+  m_pages.clear();
+  m_uploader.dispose();
+}
+
+ure::bool_t   TileAtlas::add_page() noexcept(true)
+{
+  if ( m_pages.empty() )
+  {
+    // First page, fit the requested size in what the driver supports
+    GLint max_size = 0;
+    glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+
+    if ( max_size > 0 )
+      m_page_size = std::min( m_page_size, static_cast<ure::uint_t>(max_size) );
+
+    m_page_size = std::max( { m_page_size, m_tile_size.width, m_tile_size.height } );
+    m_columns   = m_page_size / m_tile_size.width;
+    m_rows      = m_page_size / m_tile_size.height;
+  }
+
+  page_t page{ 0, {} };
+
+  glGenTextures( 1, &page.texture );
+  if ( page.texture == 0 )
+    return false;
+
+  glBindTexture  ( GL_TEXTURE_2D, page.texture );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+  const GLsizei size = static_cast<GLsizei>(m_page_size);
+
+  switch ( m_format )
+  {
+    case TileImage::format_t::etc2_rgb8:
+    {
+      // Compressed storage can not be allocated without data, start from black blocks
+      const std::vector<ure::byte_t> blocks( TileImage::size( m_format, m_page_size, m_page_size ), 0 );
+
+      glCompressedTexImage2D( GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB8_ETC2, size, size, 0, static_cast<GLsizei>(blocks.size()), blocks.data() );
+    }
+    break;
+
+    case TileImage::format_t::rgb565:
+      glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, nullptr );
+    break;
+
+    default:
+      glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    break;
+  }
+
+  glBindTexture  ( GL_TEXTURE_2D, 0 );
+
+  if ( glGetError() == GL_OUT_OF_MEMORY )
+  {
+    glDeleteTextures( 1, &page.texture );
+    return false;
+  }
+
+  // Slots are handed out from the back, keep low indexes first
+  page.free.resize( slots_per_page() );
+  for ( ure::uint_t i = 0; i < page.free.size(); ++i )
+    page.free[i] = slots_per_page() - 1 - i;
+
+  m_pages.push_back( std::move(page) );
+
+  return true;
+}
@@ -0,0 +1,388 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_batch.h"
+
+#include <ure_utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+TileBatch::TileBatch() noexcept(true)
+  : m_shaders_path( "./resources/shaders/" ), m_failed(false), m_program(0), m_ibo(0),
+    m_a_point(-1), m_a_texcoord(-1), m_a_page(-1), m_a_layer(-1), m_u_mvp(-1), m_u_pages{ -1, -1, -1, -1 }, m_u_opacity(-1),
+    m_u_layer_opacity(-1)
+{
+  std::fill( std::begin(m_layer_opacity), std::end(m_layer_opacity), 1.0f );
+}
+
+TileBatch::~TileBatch() noexcept(true)
+{
+  dispose();
+}
+
+ure::void_t   TileBatch::set_shaders_path( const std::string& path ) noexcept(true)
+{
+  m_shaders_path = path;
+}
+
+ure::uint_t   TileBatch::create_geometry() noexcept(true)
+{
+  m_geometries.emplace_back( geometry_t{ 0, 0, {}, {}, 0 } );
+
+  return static_cast<ure::uint_t>( m_geometries.size() - 1 );
+}
+
+ure::void_t   TileBatch::clear() noexcept(true)
+{
+  m_quads.clear();
+}
+
+ure::void_t   TileBatch::add( const glm::vec4& rect, const glm::vec4& uv, ure::uint_t page, ure::uint_t layer ) noexcept(true)
+{
+  m_quads.emplace_back( quad_t{ rect, uv, page, std::min( layer, max_layers() - 1 ) } );
+}
+
+ure::void_t   TileBatch::set_layer_opacity( ure::uint_t layer, ure::float_t opacity ) noexcept(true)
+{
+  if ( layer < max_layers() )
+    m_layer_opacity[layer] = std::clamp( opacity, 0.0f, 1.0f );
+}
+
+ure::bool_t   TileBatch::commit( ure::uint_t geometry ) noexcept(true)
+{
+  if ( ( geometry >= m_geometries.size() ) || ( init() == false ) )
+    return false;
+
+  geometry_t& target = m_geometries[geometry];
+
+  // Same tiles in the same slots, vertices in the buffer are still valid
+  if ( ( target.vbo != 0 ) && ( target.quads == m_quads ) )
+    return false;
+
+  target.quads.assign( m_quads.begin(), m_quads.end() );
+
+  /////////////////
+  // Counting sort of quads by layer, then by group of pages bound together.
+  // Quads of a layer do not overlap, their order within the layer does not matter.
+  ure::uint_t groups = 0;
+  ure::uint_t layers = 0;
+  for ( const quad_t& quad : m_quads )
+  {
+    groups = std::max( groups, quad.page / max_pages() + 1 );
+    layers = std::max( layers, quad.layer + 1 );
+  }
+
+  const ure::uint_t bins = groups * layers;
+
+  m_bins.assign( bins + 1, 0 );
+  for ( const quad_t& quad : m_quads )
+    ++m_bins[ quad.layer * groups + quad.page / max_pages() + 1 ];
+
+  for ( ure::uint_t b = 1; b <= bins; ++b )
+    m_bins[b] += m_bins[b-1];
+
+  m_order.resize( m_quads.size() );
+  m_fill.assign( m_bins.begin(), m_bins.end() );
+
+  for ( ure::uint_t i = 0; i < m_quads.size(); ++i )
+    m_order[ m_fill[ m_quads[i].layer * groups + m_quads[i].page / max_pages() ]++ ] = i;
+
+  // Consecutive layers bound to the same pages share a draw call
+  target.runs.clear();
+  target.layers = layers;
+
+  for ( ure::uint_t b = 0; b < bins; ++b )
+  {
+    const ure::uint_t count = m_bins[b+1] - m_bins[b];
+
+    if ( count == 0 )
+      continue;
+
+    if ( ( target.runs.empty() == false ) && ( target.runs.back().group == b % groups ) )
+      target.runs.back().count += count;
+    else
+      target.runs.push_back( run_t{ m_bins[b], count, b % groups } );
+  }
+
+  /////////////////
+  // Interleaved vertices, same corner order as Widget::draw_rect()
+  m_vertices.resize( m_quads.size() * 4 );
+
+  vertex_t* vertex = m_vertices.data();
+  for ( ure::uint_t i : m_order )
+  {
+    const quad_t&       q     = m_quads[i];
+    const ure::float_t  page  = static_cast<ure::float_t>( q.page % max_pages() );
+    const ure::float_t  layer = static_cast<ure::float_t>( q.layer );
+
+    *vertex++ = vertex_t{ q.rect.x, q.rect.w, q.uv.x, q.uv.w, page, layer };
+    *vertex++ = vertex_t{ q.rect.z, q.rect.w, q.uv.z, q.uv.w, page, layer };
+    *vertex++ = vertex_t{ q.rect.x, q.rect.y, q.uv.x, q.uv.y, page, layer };
+    *vertex++ = vertex_t{ q.rect.z, q.rect.y, q.uv.z, q.uv.y, page, layer };
+  }
+
+  if ( target.vbo == 0 )
+    glGenBuffers( 1, &target.vbo );
+
+  const std::size_t bytes = m_vertices.size() * sizeof(vertex_t);
+
+  glBindBuffer( GL_ARRAY_BUFFER, target.vbo );
+  if ( bytes > target.vbo_size )
+  {
+    // Grow with some headroom, so that small pans do not reallocate
+    target.vbo_size = bytes + bytes / 2;
+    glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(target.vbo_size), nullptr, GL_DYNAMIC_DRAW );
+  }
+  if ( bytes > 0 )
+    glBufferSubData( GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), m_vertices.data() );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+  return true;
+}
+
+TileBatch::stats_t   TileBatch::draw( ure::uint_t geometry, const TileAtlas& atlas, const glm::mat4& mvp, ure::float_t opacity ) noexcept(true)
+{
+  if ( geometry >= m_geometries.size() )
+    return stats_t{ 0, 0 };
+
+  const geometry_t& source = m_geometries[geometry];
+  stats_t           stats{ static_cast<ure::uint_t>(source.quads.size()), 0 };
+
+  if ( source.quads.empty() || ( source.vbo == 0 ) || ( opacity <= 0.0f ) || ( init() == false ) )
+    return stats;
+
+  // Translucent layers are blended over the ones drawn before, so are stacked layers
+  ure::bool_t translucent = ( opacity < 1.0f ) || ( source.layers > 1 );
+  for ( ure::uint_t layer = 0; ( layer < source.layers ) && ( translucent == false ); ++layer )
+    translucent = ( m_layer_opacity[layer] < 1.0f );
+
+  const GLboolean blend = glIsEnabled( GL_BLEND );
+  if ( translucent && ( blend == GL_FALSE ) )
+  {
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  }
+
+  glBindBuffer( GL_ARRAY_BUFFER, source.vbo );
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+
+  /////////////////
+  glUseProgram( m_program );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+  glUniform1f( m_u_opacity, opacity );
+  glUniform1fv( m_u_layer_opacity, static_cast<GLsizei>( max_layers() ), m_layer_opacity );
+
+  for ( ure::uint_t unit = 0; unit < max_pages(); ++unit )
+    glUniform1i( m_u_pages[unit], static_cast<GLint>(unit) );
+
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_page)     );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_layer)    );
+
+  for ( const run_t& run : source.runs )
+  {
+    ure::uint_t first = run.first;
+    ure::uint_t last  = run.first + run.count;
+
+    for ( ure::uint_t unit = 0; unit < max_pages(); ++unit )
+    {
+      glActiveTexture( GL_TEXTURE0 + unit );
+      glBindTexture  ( GL_TEXTURE_2D, atlas.page_texture( run.group * max_pages() + unit ) );
+    }
+
+    // 16 bits indexes, large groups are split and attributes rebased
+    while ( first < last )
+    {
+      const ure::uint_t  count  = std::min( last - first, max_quads );
+      const std::size_t  offset = std::size_t(first) * 4 * sizeof(vertex_t);
+
+      glVertexAttribPointer( static_cast<GLuint>(m_a_point)   , 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offset + offsetof(vertex_t, x)    ) );
+      glVertexAttribPointer( static_cast<GLuint>(m_a_texcoord), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offset + offsetof(vertex_t, u)    ) );
+      glVertexAttribPointer( static_cast<GLuint>(m_a_page)    , 1, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offset + offsetof(vertex_t, page) ) );
+      glVertexAttribPointer( static_cast<GLuint>(m_a_layer)   , 1, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<const void*>( offset + offsetof(vertex_t, layer) ) );
+
+      glDrawElements( GL_TRIANGLES, static_cast<GLsizei>(count * 6), GL_UNSIGNED_SHORT, nullptr );
+
+      ++stats.draw_calls;
+      first += count;
+    }
+  }
+
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_point)    );
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_texcoord) );
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_page)     );
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_layer)    );
+
+  for ( ure::uint_t unit = max_pages(); unit > 0; --unit )
+  {
+    glActiveTexture( GL_TEXTURE0 + unit - 1 );
+    glBindTexture  ( GL_TEXTURE_2D, 0 );
+  }
+
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glUseProgram( 0 );
+
+  if ( translucent && ( blend == GL_FALSE ) )
+    glDisable( GL_BLEND );
+
+  return stats;
+}
+
+ure::void_t   TileBatch::dispose() noexcept(true)
+{
+  if ( m_program != 0 )
+    glDeleteProgram( m_program );
+  if ( m_ibo != 0 )
+    glDeleteBuffers( 1, &m_ibo );
+
+  for ( geometry_t& geometry : m_geometries )
+  {
+    if ( geometry.vbo != 0 )
+      glDeleteBuffers( 1, &geometry.vbo );
+
+    geometry = geometry_t{ 0, 0, {}, {}, 0 };
+  }
+
+  m_program  = 0;
+  m_ibo      = 0;
+}
+
+ure::bool_t   TileBatch::init() noexcept(true)
+{
+  if ( m_program != 0 )
+    return true;
+
+  if ( m_failed )
+    return false;
+
+  m_failed = true;
+
+  GLuint vs = compile( GL_VERTEX_SHADER  , "DefaultTextureBatch.vs" );
+  GLuint fs = compile( GL_FRAGMENT_SHADER, "DefaultTextureBatch.fs" );
+
+  if ( ( vs == 0 ) || ( fs == 0 ) )
+  {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader( program, vs );
+  glAttachShader( program, fs );
+  glLinkProgram ( program );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &linked );
+  if ( linked != GL_TRUE )
+  {
+    ure::utils::log( "TileBatch: unable to link DefaultTextureBatch program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_a_point    = glGetAttribLocation ( program, "a_v2Point"    );
+  m_a_texcoord = glGetAttribLocation ( program, "a_v2TexCoord" );
+  m_a_page     = glGetAttribLocation ( program, "a_fPage"      );
+  m_a_layer    = glGetAttribLocation ( program, "a_fLayer"     );
+  m_u_mvp      = glGetUniformLocation( program, "u_m4MVP"      );
+  m_u_opacity  = glGetUniformLocation( program, "u_fOpacity"   );
+  m_u_layer_opacity = glGetUniformLocation( program, "u_afLayerOpacity" );
+
+  for ( ure::uint_t unit = 0; unit < max_pages(); ++unit )
+  {
+    const std::string name = "u_2dPage" + std::to_string(unit);
+    m_u_pages[unit] = glGetUniformLocation( program, name.c_str() );
+  }
+
+  if ( ( m_a_point < 0 ) || ( m_a_texcoord < 0 ) || ( m_a_page < 0 ) || ( m_a_layer < 0 ) )
+  {
+    ure::utils::log( "TileBatch: missing attributes in DefaultTextureBatch program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  /////////////////
+  // Two triangles per quad, shared by every draw call
+  std::vector<GLushort> indices( max_quads * 6 );
+
+  for ( ure::uint_t q = 0; q < max_quads; ++q )
+  {
+    const GLushort base = static_cast<GLushort>( q * 4 );
+
+    indices[q*6+0] = base + 0;
+    indices[q*6+1] = base + 1;
+    indices[q*6+2] = base + 2;
+    indices[q*6+3] = base + 2;
+    indices[q*6+4] = base + 1;
+    indices[q*6+5] = base + 3;
+  }
+
+  glGenBuffers( 1, &m_ibo );
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+  glBufferData( GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>( indices.size() * sizeof(GLushort) ), indices.data(), GL_STATIC_DRAW );
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+  m_program = program;
+  m_failed  = false;
+
+  return true;
+}
+
+GLuint   TileBatch::compile( GLenum type, const std::string& file ) noexcept(true)
+{
+  std::ifstream      stream( m_shaders_path + file );
+  std::stringstream  source;
+
+  if ( !stream )
+  {
+    ure::utils::log( "TileBatch: unable to read shader [" + m_shaders_path + file + "]" );
+    return 0;
+  }
+
+  source << stream.rdbuf();
+
+  const std::string  text = source.str();
+  const GLchar*      ptr  = text.c_str();
+
+  GLuint shader = glCreateShader( type );
+  glShaderSource ( shader, 1, &ptr, nullptr );
+  glCompileShader( shader );
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+  if ( compiled != GL_TRUE )
+  {
+    GLchar  log[512] = { 0 };
+    glGetShaderInfoLog( shader, sizeof(log), nullptr, log );
+
+    ure::utils::log( "TileBatch: unable to compile [" + file + "]: " + log );
+    glDeleteShader( shader );
+    return 0;
+  }
+
+  return shader;
+}
@@ -0,0 +1,43 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_cache.h"
+
+TileCache::TileCache( TileAtlas& atlas, std::size_t budget ) noexcept(true)
+  : m_entries( budget, release_t{ &atlas } )
+{
+}
+
+std::optional<TileCache::slot_t>   TileCache::find( const TileKey& key ) noexcept(true)
+{
+  const slot_t* slot = m_entries.find( key );
+
+  return ( slot != nullptr ) ? std::optional<slot_t>( *slot ) : std::nullopt;
+}
+
+std::optional<TileCache::slot_t>   TileCache::find_resident( const TileKey& key ) noexcept(true)
+{
+  const slot_t* slot = m_entries.find_resident( key );
+
+  return ( slot != nullptr ) ? std::optional<slot_t>( *slot ) : std::nullopt;
+}
+
+ure::bool_t   TileCache::insert( const TileKey& key, const slot_t& slot, std::size_t bytes ) noexcept(true)
+{
+  slot_t copy = slot;
+
+  return m_entries.insert( key, std::move(copy), bytes );
+}
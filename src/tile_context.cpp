@@ -0,0 +1,57 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_context.h"
+
+TileContext::TileContext( const ure::Size& tile_size, std::size_t cache_budget ) noexcept(true)
+  : m_tile_size(tile_size), m_atlas(tile_size), m_cache( m_atlas, cache_budget ), m_scheduler( m_requests ),
+    m_decoder( m_atlas, m_cache, m_requests, m_disk, m_redraw, tile_bytes() )
+{
+}
+
+ure::bool_t   TileContext::initialize( const std::string& shaders_path, const std::string& cache_path ) noexcept(true)
+{
+  m_batch.set_shaders_path( shaders_path );
+
+  return m_disk.open( cache_path );
+}
+
+TileImage::format_t   TileContext::set_texture_format( TileImage::format_t requested ) noexcept(true)
+{
+  if ( m_atlas.set_format( TileAtlas::supported( requested ) ) )
+    m_decoder.set_format( m_atlas.format(), tile_bytes() );
+
+  return m_atlas.format();
+}
+
+ure::uint_t   TileContext::add_source( const std::string& url, ure::float_t opacity ) noexcept(true)
+{
+  if ( m_sources.size() >= max_sources() )
+    return max_sources();
+
+  const ure::uint_t source = static_cast<ure::uint_t>( m_sources.size() );
+
+  m_sources.emplace_back( url );
+  m_batch.set_layer_opacity( source, opacity );
+
+  return source;
+}
+
+ure::void_t   TileContext::dispose() noexcept(true)
+{
+  m_batch.dispose();
+  m_atlas.dispose();
+}
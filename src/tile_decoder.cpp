@@ -0,0 +1,173 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_decoder.h"
+#include "tile_pyramid.h"
+#include "metrics.h"
+
+#include <algorithm>
+
+TileDecoder::TileDecoder( TileAtlas& atlas, TileCache& cache, TileRequests& requests, TileDiskCache& disk, RedrawSignal& redraw, std::size_t tile_bytes, ure::uint_t workers ) noexcept(true)
+  : m_atlas(atlas), m_cache(cache), m_disk(disk), m_tile_bytes(tile_bytes), m_format(TileImage::format_t::rgba8),
+    m_workers( requests, redraw,
+               [this]() -> workers_t::process_t
+               { return [this]( job_t& job, decoded_t& tile ) { return decode( job, tile ); }; },
+               workers )
+{
+}
+
+TileDecoder::~TileDecoder() noexcept(true)
+{
+}
+
+ure::void_t   TileDecoder::set_format( TileImage::format_t format, std::size_t tile_bytes ) noexcept(true)
+{
+  m_format     = format;
+  m_tile_bytes = tile_bytes;
+}
+
+ure::void_t   TileDecoder::submit( const TileKey& key, const ure::byte_t* data, ure::uint_t length ) noexcept(true)
+{
+  auto copy = std::make_shared<std::vector<ure::byte_t>>( data, data + length );
+
+  TileDiskCache::blob_t blob{ copy, copy->data(), length };
+
+  m_workers.enqueue( job_t{ key, std::move(blob), {}, true } );
+}
+
+ure::void_t   TileDecoder::submit( const TileKey& key, TileDiskCache::blob_t&& blob ) noexcept(true)
+{
+  m_workers.enqueue( job_t{ key, std::move(blob), {}, false } );
+}
+
+ure::void_t   TileDecoder::submit( const TileKey& key, std::vector<TileDiskCache::blob_t>&& children ) noexcept(true)
+{
+  m_workers.enqueue( job_t{ key, TileDiskCache::blob_t{}, std::move(children), false } );
+}
+
+ure::uint_t   TileDecoder::upload( ure::uint_t max_count, clock_t::duration budget, std::size_t max_bytes ) noexcept(true)
+{
+  // A tile larger than the byte budget is still uploaded
+  return m_workers.drain( max_count, budget, max_bytes, [this]( decoded_t& tile, std::size_t& bytes )
+  {
+    if ( m_cache.contains( tile.key ) )
+      return workers_t::upload_t::cached;
+
+    const TileAtlas::slot_t slot = m_atlas.allocate();
+
+    if ( m_atlas.upload( slot, tile.image ) == false )
+    {
+      // Out of GPU memory or unexpected tile size
+      m_atlas.release( slot );
+      return workers_t::upload_t::failed;
+    }
+
+    if ( m_cache.insert( tile.key, slot, m_tile_bytes ) == false )
+      m_atlas.release( slot );
+
+    bytes += tile.image.bytes();
+
+    return workers_t::upload_t::uploaded;
+  } );
+}
+
+ure::uint_t   TileDecoder::pending() const noexcept(true)
+{
+  return m_workers.pending();
+}
+
+ure::uint_t   TileDecoder::ready() const noexcept(true)
+{
+  return m_workers.ready();
+}
+
+ure::bool_t   TileDecoder::decode( job_t& job, decoded_t& tile ) noexcept(true)
+{
+  const TileImage::format_t format = m_format.load();
+
+  ure::bool_t valid = false;
+
+  {
+    MAP_METRICS_SCOPE( decode );
+
+    valid = job.children.empty() ? read( job.blob, tile.image ) : build( job.children, tile.image );
+
+    // Decoded images are RGBA8, stored pixels may come from a run with another format
+    if ( valid && ( tile.image.format != format ) )
+      valid = tile.image.expand() && tile.image.convert( format );
+  }
+
+  // Compressing costs more than decoding, keep the result instead of the encoded image.
+  // Uncompressed formats are larger than the encoded image, that one is kept.
+  const ure::bool_t transcoded = valid && ( format == TileImage::format_t::etc2_rgb8 ) && ( job.blob.format != format );
+
+  if ( transcoded )
+  {
+    m_disk.store( job.key, tile.image.pixels.data(), static_cast<ure::uint_t>( tile.image.bytes() ), format );
+  }
+  else if ( valid && job.persist )
+  {
+    m_disk.store( job.key, job.blob.data, job.blob.length );
+  }
+  else if ( ( valid == false ) && ( job.persist == false ) )
+  {
+    // Corrupted cache entries, next attempt goes to the network
+    m_disk.erase( job.key );
+
+    for ( ure::uint_t i = 0; i < job.children.size(); ++i )
+      m_disk.erase( TilePyramid::child( job.key, i ) );
+  }
+
+  return valid;
+}
+
+ure::bool_t   TileDecoder::read( const TileDiskCache::blob_t& blob, TileImage& image ) const noexcept(true)
+{
+  if ( blob.format == TileImage::format_t::encoded )
+    return TileImage::decode( blob.data, blob.length, image );
+
+  const ure::Size&  size = m_atlas.tile_size();
+
+  // Pixels written with another tile size can not be used
+  if ( blob.length != TileImage::size( blob.format, size.width, size.height ) )
+    return false;
+
+  image.width  = size.width;
+  image.height = size.height;
+  image.format = blob.format;
+  image.pixels.assign( blob.data, blob.data + blob.length );
+
+  return true;
+}
+
+ure::bool_t   TileDecoder::build( const std::vector<TileDiskCache::blob_t>& children, TileImage& image ) const noexcept(true)
+{
+  if ( children.size() != 4 )
+    return false;
+
+  TileImage         decoded[4];
+  const TileImage*  sources[4];
+
+  for ( ure::uint_t i = 0; i < 4; ++i )
+  {
+    if ( ( read( children[i], decoded[i] ) == false ) || ( decoded[i].expand() == false ) )
+      return false;
+
+    sources[i] = &decoded[i];
+  }
+
+  return TilePyramid::downsample( sources, image );
+}
@@ -0,0 +1,463 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_disk_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+/**
+ * Read-only view of a whole pack data file.
+ * Mapped in memory on POSIX systems, loaded in a buffer elsewhere.
+ */
+class TileDiskCache::Mapping
+{
+public:
+  /**
+   * Map at least @p capacity bytes, pages past the end of the file become readable as it
+   * grows. Loaded buffers hold the current file only.
+   */
+  explicit Mapping( const std::filesystem::path& path, std::uint64_t capacity = 0 ) noexcept(true)
+    : m_data(nullptr), m_size(0)
+  {
+#if defined(_WIN32)
+    std::ifstream file( path, std::ios::binary );
+    if ( file )
+    {
+      m_buffer.assign( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+      m_data = reinterpret_cast<const ure::byte_t*>(m_buffer.data());
+      m_size = m_buffer.size();
+    }
+#else
+    const int fd = ::open( path.c_str(), O_RDONLY );
+    if ( fd < 0 )
+      return;
+
+    struct stat st;
+    if ( ( ::fstat( fd, &st ) == 0 ) && ( std::max<std::uint64_t>( st.st_size, capacity ) > 0 ) )
+    {
+      const std::uint64_t size = std::max<std::uint64_t>( st.st_size, capacity );
+
+      void* addr = ::mmap( nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_SHARED, fd, 0 );
+      if ( addr != MAP_FAILED )
+      {
+        m_data = static_cast<const ure::byte_t*>(addr);
+        m_size = size;
+      }
+    }
+
+    ::close( fd );
+#endif
+  }
+
+  /***/
+  ~Mapping() noexcept(true)
+  {
+#if !defined(_WIN32)
+    if ( m_data != nullptr )
+      ::munmap( const_cast<ure::byte_t*>(m_data), static_cast<std::size_t>(m_size) );
+#endif
+  }
+
+  Mapping( const Mapping& ) = delete;
+  Mapping& operator=( const Mapping& ) = delete;
+
+  /***/
+  constexpr const ure::byte_t*  data() const noexcept
+  { return m_data; }
+  /***/
+  constexpr std::uint64_t       size() const noexcept
+  { return m_size; }
+
+private:
+  const ure::byte_t*  m_data;
+  std::uint64_t       m_size;
+#if defined(_WIN32)
+  std::vector<char>   m_buffer;
+#endif
+};
+
+TileDiskCache::TileDiskCache( std::uint64_t max_bytes, std::uint64_t pack_bytes ) noexcept(true)
+  : m_max_bytes(max_bytes), m_pack_bytes( std::min( pack_bytes, max_bytes ) ), m_size(0), m_open(false),
+    m_active(nullptr), m_active_id(0)
+{
+}
+
+TileDiskCache::~TileDiskCache() noexcept(true)
+{
+  close();
+}
+
+ure::bool_t   TileDiskCache::open( const std::filesystem::path& path ) noexcept(true)
+{
+  close();
+
+  // No location, cache disabled
+  if ( path.empty() )
+    return false;
+
+  std::lock_guard<std::mutex> write( m_write_mutex );
+
+  ure::uint_t next = 0;
+
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    std::error_code ec;
+
+    std::filesystem::create_directories( path, ec );
+    if ( ec )
+    {
+      ure::utils::log( "TileDiskCache: unable to create [" + path.string() + "]" );
+      return false;
+    }
+
+    m_path = path;
+
+    // Pack ids are sequential, load them oldest first so that newer records win
+    std::vector<ure::uint_t> ids;
+
+    for ( const auto& entry : std::filesystem::directory_iterator( m_path, ec ) )
+    {
+      if ( entry.path().extension() != ".idx" )
+        continue;
+
+      const std::string name = entry.path().stem().string();
+      ure::uint_t       id   = 0;
+
+      if ( std::sscanf( name.c_str(), "pack-%06u", &id ) == 1 )
+        ids.push_back( id );
+    }
+
+    std::sort( ids.begin(), ids.end() );
+
+    for ( ure::uint_t id : ids )
+      load_pack( id );
+
+    // Always append to a fresh pack, the last one may end with a partial payload
+    next = ids.empty() ? 0 : ids.back() + 1;
+  }
+
+  if ( open_active( next ) == false )
+  {
+    ure::utils::log( "TileDiskCache: unable to open pack in [" + m_path.string() + "]" );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_packs.clear();
+    m_index.clear();
+    m_size = 0;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_open = true;
+
+  while ( ( m_size > m_max_bytes ) && ( m_packs.size() > 1 ) )
+    drop_oldest();
+
+  return true;
+}
+
+ure::void_t   TileDiskCache::close() noexcept(true)
+{
+  std::lock_guard<std::mutex> write( m_write_mutex );
+
+  seal_active();
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_packs.clear();
+  m_index.clear();
+  m_size = 0;
+  m_open = false;
+}
+
+ure::bool_t   TileDiskCache::is_open() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_open;
+}
+
+std::optional<TileDiskCache::blob_t>   TileDiskCache::find( const TileKey& key ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  if ( m_open == false )
+    return std::nullopt;
+
+  auto it = m_index.find( key );
+  if ( it == m_index.end() )
+    return std::nullopt;
+
+  const location_t& loc  = it->second;
+  auto              pack = m_packs.find( loc.pack );
+  if ( pack == m_packs.end() )
+    return std::nullopt;
+
+  const std::uint64_t end = loc.offset + loc.length;
+
+  // The active pack is mapped up to its capacity and read as it grows, it is mapped again
+  // only when a payload ends past it. Blobs already returned keep the previous mapping alive.
+  if ( ( pack->second.mapping == nullptr ) || ( pack->second.mapping->size() < end ) )
+  {
+    const std::uint64_t capacity = ( ( m_active != nullptr ) && ( loc.pack == m_active_id ) ) ? std::max( end, m_pack_bytes ) : 0;
+
+    pack->second.mapping = std::make_shared<const Mapping>( pack_path( loc.pack, "dat" ), capacity );
+  }
+
+  const std::shared_ptr<const Mapping>& mapping = pack->second.mapping;
+
+  if ( ( mapping->data() == nullptr ) || ( mapping->size() < end ) )
+    return std::nullopt;
+
+  return blob_t{ mapping, mapping->data() + loc.offset, loc.length, loc.format };
+}
+
+ure::bool_t   TileDiskCache::store( const TileKey& key, const ure::byte_t* data, ure::uint_t length, TileImage::format_t format ) noexcept(true)
+{
+  if ( ( data == nullptr ) || ( length == 0 ) )
+    return false;
+
+  // Writers queue here, readers only wait for the record to be published below
+  std::lock_guard<std::mutex> write( m_write_mutex );
+
+  if ( m_active == nullptr )
+    return false;
+
+  if ( ( m_active->size > 0 ) && ( m_active->size + length > m_pack_bytes ) )
+  {
+    const ure::uint_t next = m_active_id + 1;
+
+    seal_active();
+
+    if ( open_active( next ) == false )
+      return false;
+  }
+
+  pack_t&        active = *m_active;
+  const record_t record{ key.packed(), active.size, length, static_cast<std::uint32_t>(format) | ( key.source << 8 ) };
+
+  // Payload first, a record is written only for complete payloads
+  ure::bool_t done = ( std::fwrite( data, 1, length, active.data ) == length ) && ( std::fflush( active.data ) == 0 );
+  done = done && ( std::fwrite( &record, sizeof(record), 1, active.index ) == 1 ) && ( std::fflush( active.index ) == 0 );
+
+  if ( done == false )
+  {
+    // Part of the payload or of the record may have reached the files, later records would
+    // point at the wrong bytes: the pack is truncated to its records and a new one is used
+    const ure::uint_t next = m_active_id + 1;
+
+    seal_active();
+    open_active( next );
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  active.size    += length;
+  active.indexed += sizeof(record);
+  m_size         += length;
+
+  m_index.insert_or_assign( key, location_t{ m_active_id, record.offset, length, format } );
+
+  while ( ( m_size > m_max_bytes ) && ( m_packs.size() > 1 ) )
+    drop_oldest();
+
+  return true;
+}
+
+ure::void_t   TileDiskCache::erase( const TileKey& key ) noexcept(true)
+{
+  std::lock_guard<std::mutex> write( m_write_mutex );
+
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if ( m_index.erase( key ) == 0 )
+      return;
+  }
+
+  if ( m_active == nullptr )
+    return;
+
+  // Tombstone, without it load_pack() would bring the entry back on the next start
+  const record_t record{ key.packed(), 0, 0, key.source << 8 };
+
+  if ( ( std::fwrite( &record, sizeof(record), 1, m_active->index ) != 1 ) || ( std::fflush( m_active->index ) != 0 ) )
+  {
+    const ure::uint_t next = m_active_id + 1;
+
+    seal_active();
+    open_active( next );
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_active->indexed += sizeof(record);
+}
+
+std::uint64_t   TileDiskCache::size() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_size;
+}
+
+std::filesystem::path   TileDiskCache::pack_path( ure::uint_t pack, const char* ext ) const noexcept(true)
+{
+  char name[32];
+
+  std::snprintf( name, sizeof(name), "pack-%06u.%s", pack, ext );
+
+  return m_path / name;
+}
+
+ure::bool_t   TileDiskCache::load_pack( ure::uint_t pack ) noexcept(true)
+{
+  std::error_code     ec;
+  const std::uint64_t size = std::filesystem::file_size( pack_path( pack, "dat" ), ec );
+  if ( ec )
+    return false;
+
+  std::ifstream idx( pack_path( pack, "idx" ), std::ios::binary );
+  if ( !idx )
+    return false;
+
+  record_t record;
+
+  while ( idx.read( reinterpret_cast<char*>(&record), sizeof(record) ) )
+  {
+    TileKey key = TileKey::unpack( record.key );
+    key.source  = record.format >> 8;
+
+    // Tombstone of an entry that could not be decoded
+    if ( record.length == 0 )
+    {
+      m_index.erase( key );
+      continue;
+    }
+
+    // Records past the end of data belong to a truncated pack
+    if ( record.offset + record.length > size )
+      continue;
+
+    // Unknown formats come from a newer version, they can not be used
+    const std::uint32_t format = record.format & 0xFF;
+
+    if ( format > static_cast<std::uint32_t>( TileImage::format_t::etc2_rgb8 ) )
+      continue;
+
+    m_index.insert_or_assign( key, location_t{ pack, record.offset, record.length, static_cast<TileImage::format_t>(format) } );
+  }
+
+  m_packs.emplace( pack, pack_t{ size, 0, nullptr, nullptr, nullptr } );
+  m_size += size;
+
+  return true;
+}
+
+ure::bool_t   TileDiskCache::open_active( ure::uint_t pack ) noexcept(true)
+{
+  // Create both files empty, kept open for appending until the pack is sealed
+  std::FILE* dat = std::fopen( pack_path( pack, "dat" ).string().c_str(), "wb" );
+  std::FILE* idx = std::fopen( pack_path( pack, "idx" ).string().c_str(), "wb" );
+
+  if ( ( dat == nullptr ) || ( idx == nullptr ) )
+  {
+    if ( dat != nullptr )
+      std::fclose( dat );
+    if ( idx != nullptr )
+      std::fclose( idx );
+
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_active    = &m_packs.insert_or_assign( pack, pack_t{ 0, 0, nullptr, dat, idx } ).first->second;
+  m_active_id = pack;
+
+  return true;
+}
+
+ure::void_t   TileDiskCache::seal_active() noexcept(true)
+{
+  if ( m_active == nullptr )
+    return;
+
+  std::fclose( m_active->data );
+  std::fclose( m_active->index );
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  std::error_code ec;
+
+  // Drop an empty active pack instead of leaving empty files behind, a pack holding
+  // only tombstones is kept or the erased entries would come back on the next open()
+  if ( ( m_active->size == 0 ) && ( m_active->indexed == 0 ) )
+  {
+    std::filesystem::remove( pack_path( m_active_id, "dat" ), ec );
+    std::filesystem::remove( pack_path( m_active_id, "idx" ), ec );
+
+    m_packs.erase( m_active_id );
+  }
+  else
+  {
+    // Bytes of a failed write are not referenced by any record, drop them
+    std::filesystem::resize_file( pack_path( m_active_id, "dat" ), m_active->size,    ec );
+    std::filesystem::resize_file( pack_path( m_active_id, "idx" ), m_active->indexed, ec );
+
+    m_active->data  = nullptr;
+    m_active->index = nullptr;
+  }
+
+  m_active = nullptr;
+}
+
+ure::void_t   TileDiskCache::drop_oldest() noexcept(true)
+{
+  auto oldest = m_packs.begin();
+
+  for ( auto it = m_index.begin(); it != m_index.end(); )
+  {
+    if ( it->second.pack == oldest->first )
+      it = m_index.erase( it );
+    else
+      ++it;
+  }
+
+  // Blobs in use keep the mapping, unlinking the files is safe on POSIX
+  std::error_code ec;
+
+  std::filesystem::remove( pack_path( oldest->first, "dat" ), ec );
+  std::filesystem::remove( pack_path( oldest->first, "idx" ), ec );
+
+  m_size -= oldest->second.size;
+  m_packs.erase( oldest );
+}
@@ -0,0 +1,157 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_image.h"
+#include "etc_encoder.h"
+
+#include <ure_image.h>
+
+#include <cstdint>
+#include <cstring>
+
+ure::bool_t TileImage::decode( const ure::byte_t* data, ure::uint_t length, TileImage& image ) noexcept(true)
+{
+  ure::Image  decoded;
+
+  if ( decoded.create( ure::Image::loader_t::eStb, data, length ) == false )
+    return false;
+
+  const ure::uint_t   channels = decoded.get_channels();
+  const ure::byte_t*  src      = decoded.get_data();
+
+  if ( ( src == nullptr ) || ( channels == 0 ) || ( channels > 4 ) )
+    return false;
+
+  image.width  = decoded.get_width();
+  image.height = decoded.get_height();
+  image.format = format_t::rgba8;
+  image.pixels.resize( image.bytes() );
+
+  const std::size_t   count = std::size_t(image.width) * image.height;
+  ure::byte_t*        dst   = image.pixels.data();
+
+  // Gray, gray+alpha, RGB and RGBA sources are all expanded to RGBA
+  for ( std::size_t i = 0; i < count; ++i, src += channels, dst += 4 )
+  {
+    switch ( channels )
+    {
+      case 1: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 0xFF;   break;
+      case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+      case 3: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 0xFF; break;
+      default:
+              dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; break;
+    }
+  }
+
+  return true;
+}
+
+ure::bool_t TileImage::convert( format_t target ) noexcept(true)
+{
+  if ( format != format_t::rgba8 )
+    return ( format == target );
+
+  if ( target == format_t::rgb565 )
+  {
+    const std::size_t count = std::size_t(width) * height;
+    ure::byte_t*      data  = pixels.data();
+
+    // Packed in place, the destination never overtakes the source
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      const ure::byte_t*  src   = data + i * 4;
+      const std::uint16_t pixel = static_cast<std::uint16_t>( ( ( src[0] & 0xF8 ) << 8 ) | ( ( src[1] & 0xFC ) << 3 ) | ( src[2] >> 3 ) );
+
+      std::memcpy( data + i * 2, &pixel, sizeof(pixel) );
+    }
+  }
+  else if ( target == format_t::etc2_rgb8 )
+  {
+    std::vector<ure::byte_t> blocks( size( target, width, height ) );
+
+    if ( EtcEncoder::encode_rgb8( pixels.data(), width, height, blocks.data() ) == false )
+      return false;
+
+    pixels.swap( blocks );
+  }
+  else if ( target != format_t::rgba8 )
+  {
+    return false;
+  }
+
+  format = target;
+  pixels.resize( bytes() );
+
+  return true;
+}
+
+ure::bool_t TileImage::expand() noexcept(true)
+{
+  if ( ( format == format_t::encoded ) || ( pixels.size() < bytes() ) )
+    return false;
+
+  const std::size_t count = std::size_t(width) * height;
+
+  if ( format == format_t::rgb565 )
+  {
+    pixels.resize( count * 4 );
+
+    ure::byte_t* data = pixels.data();
+
+    // Expanded in place from the last pixel, the destination never overtakes the source
+    for ( std::size_t i = count; i-- > 0; )
+    {
+      std::uint16_t pixel;
+      std::memcpy( &pixel, data + i * 2, sizeof(pixel) );
+
+      const ure::uint_t r = ( pixel >> 11 ) & 0x1F;
+      const ure::uint_t g = ( pixel >>  5 ) & 0x3F;
+      const ure::uint_t b =   pixel         & 0x1F;
+      ure::byte_t*      dst = data + i * 4;
+
+      dst[0] = static_cast<ure::byte_t>( ( r << 3 ) | ( r >> 2 ) );
+      dst[1] = static_cast<ure::byte_t>( ( g << 2 ) | ( g >> 4 ) );
+      dst[2] = static_cast<ure::byte_t>( ( b << 3 ) | ( b >> 2 ) );
+      dst[3] = 0xFF;
+    }
+  }
+  else if ( format == format_t::etc2_rgb8 )
+  {
+    std::vector<ure::byte_t> rgba( count * 4 );
+
+    if ( EtcEncoder::decode_rgb8( pixels.data(), width, height, rgba.data() ) == false )
+      return false;
+
+    pixels.swap( rgba );
+  }
+
+  format = format_t::rgba8;
+
+  return true;
+}
+
+const char*  TileImage::name( format_t format ) noexcept(true)
+{
+  switch ( format )
+  {
+    case format_t::encoded:   return "encoded";
+    case format_t::rgba8:     return "rgba8";
+    case format_t::rgb565:    return "rgb565";
+    case format_t::etc2_rgb8: return "etc2";
+  }
+
+  return "unknown";
+}
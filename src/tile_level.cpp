@@ -0,0 +1,318 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_level.h"
+#include "tile_pyramid.h"
+
+#include "ure_resources_fetcher.h"
+
+
+#include <core/utils.h>
+  
+TileLevel::TileLevel( TileContext& tiles, ure::word_t zoom ) noexcept(true)
+  : m_tiles(tiles), m_tile_size( tiles.tile_size() ), 
+    m_zoom_level( zoom ), m_max_tiles( 1u << zoom ),
+    m_tile_area( m_tile_size.width*m_max_tiles, m_tile_size.height*m_max_tiles ),
+    m_model(1.0f), m_viewport{0,0}, m_origin(0.0f), m_margin(1), m_fallback_levels(3),
+    m_geometry( tiles.batch().create_geometry() ), m_overlay(nullptr), m_overlay_opacity(0.0f)
+{
+}
+
+TileLevel::~TileLevel() noexcept(true)
+{
+
+}
+
+ure::void_t  TileLevel::set_zoom( ure::word_t zoom ) noexcept(true)
+{
+  m_zoom_level = zoom;
+  m_max_tiles  = 1u << zoom;
+  m_tile_area  = ure::Size( m_tile_size.width*m_max_tiles, m_tile_size.height*m_max_tiles );
+}
+
+ure::void_t  TileLevel::set_view( const glm::mat4& model, const ure::Size& viewport ) noexcept(true)
+{
+  m_model    = model;
+  m_viewport = viewport;
+}
+
+ure::void_t  TileLevel::set_overlay( TileLevel* overlay, ure::float_t opacity ) noexcept(true)
+{
+  m_overlay         = ( overlay != this ) ? overlay : nullptr;
+  m_overlay_opacity = opacity;
+}
+
+TileRange    TileLevel::visible_range() const noexcept(true)
+{
+  return visible_tile_range( m_model, m_viewport, m_origin, tile_extent(), m_max_tiles, m_margin );
+}
+
+ure::uint_t  TileLevel::prefetch( const glm::mat4& model, const ure::Size& viewport, ure::uint_t budget ) noexcept(true)
+{
+  if ( budget == 0 )
+    return 0;
+
+  const TileRange predicted = visible_tile_range( model, viewport, m_origin, tile_extent(), m_max_tiles, 0 );
+  const glm::vec2 centre    = glm::vec2( predicted.x0 + predicted.x1, predicted.y0 + predicted.y1 ) * 0.5f;
+  ure::uint_t     issued    = 0;
+
+  for ( ure::int_t y = predicted.y0; ( y <= predicted.y1 ) && ( issued < budget ); ++y )
+  {
+    for ( ure::int_t x = predicted.x0; ( x <= predicted.x1 ) && ( issued < budget ); ++x )
+    {
+      for ( ure::uint_t source = 0; ( source < m_tiles.sources() ) && ( issued < budget ); ++source )
+      {
+        if ( m_tiles.source_opacity( source ) <= 0.0f )
+          continue;
+
+        // Tiles already requested by draw_tiles() keep their visible priority
+        const TileKey key{ static_cast<ure::uint_t>(m_zoom_level), static_cast<ure::uint_t>(x), static_cast<ure::uint_t>(y), source };
+
+        if ( m_tiles.cache().contains( key ) )
+          continue;
+
+        if ( request_tile( key, true, glm::length( glm::vec2( x, y ) - centre ) ) )
+          ++issued;
+      }
+    }
+  }
+
+  return issued;
+}
+
+glm::vec2    TileLevel::tile_extent() const noexcept(true)
+{
+  // Scale between levels is applied by the model matrix, see Map::level_model()
+  return glm::vec2( m_tile_size.width, m_tile_size.height );
+}
+
+ure::void_t  TileLevel::draw() noexcept(true)
+{ 
+  draw_tiles( 1.0f );
+
+  if ( ( m_overlay != nullptr ) && ( m_overlay_opacity > 0.0f ) )
+    m_overlay->draw_tiles( m_overlay_opacity );
+}
+
+ure::void_t  TileLevel::draw_tiles( ure::float_t opacity ) noexcept(true)
+{
+  const TileRange range = visible_range();
+
+  if ( range.empty() )
+    return;
+
+  // Default Vertices coordinates 
+  const glm::vec2 origin = m_origin;
+  const glm::vec2 extent = tile_extent();
+
+  TileAtlas&      atlas  = m_tiles.atlas();
+  TileBatch&      batch  = m_tiles.batch();
+
+  // Tiles closer to the centre of the viewport are downloaded first
+  const glm::vec2 centre = glm::vec2( range.x0 + range.x1, range.y0 + range.y1 ) * 0.5f;
+
+  batch.clear();
+
+  // Sources go to their own layer of the same batch, drawn at once in stacking order
+  for ( ure::uint_t source = 0; source < m_tiles.sources(); ++source )
+  {
+    if ( m_tiles.source_opacity( source ) <= 0.0f )
+      continue;
+
+    for ( ure::int_t y = range.y0; y <= range.y1; ++y )
+    {
+      for ( ure::int_t x = range.x0; x <= range.x1; ++x )
+      {
+        const TileKey key{ static_cast<ure::uint_t>(m_zoom_level), static_cast<ure::uint_t>(x), static_cast<ure::uint_t>(y), source };
+
+        std::optional<TileAtlas::slot_t> slot = m_tiles.cache().find( key );
+
+        const ure::float_t left   = origin.x + extent.x * x;
+        const ure::float_t top    = origin.y + extent.y * y;
+        const glm::vec4    quad( left, top, left + extent.x, top + extent.y );
+
+        if ( slot.has_value() == false )
+        {
+          request_tile( key, false, glm::length( glm::vec2( x, y ) - centre ) );
+
+          // Fill the hole with tiles of other levels until this one is loaded
+          add_fallback( key, quad );
+        }
+        else
+        {
+          batch.add( quad, atlas.uv( slot.value() ), slot->page, source );
+        }
+      }
+    }
+  }
+
+  // Unchanged tiles keep their vertices, pan and zoom only change the model matrix
+  batch.commit( m_geometry );
+
+  // Projection and camera view are identity (see Map::init()), model matrix is the full MVP
+  batch.draw( m_geometry, atlas, m_model, opacity );
+}
+
+
+ure::bool_t  TileLevel::request_tile( const TileKey& key, ure::bool_t prefetch, ure::float_t distance ) noexcept(true)
+{
+  // Already queued, in flight or waiting for the retry delay after a failure.
+  // A queued tile must be touched every frame, otherwise the scheduler drops it.
+  if ( m_tiles.requests().acquire( key, prefetch ) == false )
+  {
+    m_tiles.scheduler().touch( key, distance, prefetch );
+    return false;
+  }
+
+  // Tiles already seen in previous runs do not need the network, unless they were
+  // stored already transcoded to a lossy format different from the current one
+  std::optional<TileDiskCache::blob_t> blob = m_tiles.disk().find( key );
+  if ( blob.has_value() && ( ( blob->format == TileImage::format_t::encoded ) || ( blob->format == TileImage::format_t::rgba8 ) ||
+                             ( blob->format == m_tiles.decoder().format() ) ) )
+  {
+    m_tiles.decoder().submit( key, std::move(blob.value()) );
+    return true;
+  }
+
+  // Overview tiles of an area browsed at the next level do not need the network either
+  if ( build_from_children( key ) )
+    return true;
+
+  // Name and URL are generated by the scheduler when the download is dispatched
+  m_tiles.scheduler().queue( key, m_tiles.source_url( key.source ), distance, prefetch, *this );
+
+  return true;
+}
+
+ure::bool_t  TileLevel::build_from_children( const TileKey& key ) noexcept(true)
+{
+  std::vector<TileDiskCache::blob_t> children;
+
+  for ( ure::uint_t i = 0; i < 4; ++i )
+  {
+    std::optional<TileDiskCache::blob_t> blob = m_tiles.disk().find( TilePyramid::child( key, i ) );
+    if ( blob.has_value() == false )
+      return false;
+
+    if ( children.empty() )
+      children.reserve( 4 );
+
+    children.emplace_back( std::move(blob.value()) );
+  }
+
+  m_tiles.decoder().submit( key, std::move(children) );
+
+  return true;
+}
+
+ure::bool_t  TileLevel::add_fallback( const TileKey& key, const glm::vec4& quad ) noexcept(true)
+{
+  TileCache&  cache = m_tiles.cache();
+  TileAtlas&  atlas = m_tiles.atlas();
+  TileBatch&  batch = m_tiles.batch();
+
+  // Children are sharper, they are typically available right after zooming out.
+  // All four are required, quads of a source must not overlap since batch order is by atlas page.
+  if ( ( m_fallback_levels > 0 ) && ( key.z + 1 < 32 ) )
+  {
+    std::optional<TileAtlas::slot_t> children[4];
+    ure::bool_t                      complete = true;
+
+    for ( ure::uint_t i = 0; ( i < 4 ) && complete; ++i )
+    {
+      children[i] = cache.find_resident( TilePyramid::child( key, i ) );
+      complete    = children[i].has_value();
+    }
+
+    if ( complete )
+    {
+      const ure::float_t cx = ( quad.x + quad.z ) / 2;
+      const ure::float_t cy = ( quad.y + quad.w ) / 2;
+
+      batch.add( glm::vec4( quad.x, quad.y, cx    , cy     ), atlas.uv( children[0].value() ), children[0]->page, key.source );
+      batch.add( glm::vec4( cx    , quad.y, quad.z, cy     ), atlas.uv( children[1].value() ), children[1]->page, key.source );
+      batch.add( glm::vec4( quad.x, cy    , cx    , quad.w ), atlas.uv( children[2].value() ), children[2]->page, key.source );
+      batch.add( glm::vec4( cx    , cy    , quad.z, quad.w ), atlas.uv( children[3].value() ), children[3]->page, key.source );
+
+      return true;
+    }
+  }
+
+  // Nearest loaded ancestor, the tile maps to a 1/2^k sub-rectangle of it
+  for ( ure::uint_t k = 1; ( k <= m_fallback_levels ) && ( k <= key.z ); ++k )
+  {
+    std::optional<TileAtlas::slot_t> parent = cache.find_resident( TileKey{ key.z - k, key.x >> k, key.y >> k, key.source } );
+
+    if ( parent.has_value() == false )
+      continue;
+
+    const ure::uint_t   mask = ( 1u << k ) - 1;
+    const ure::float_t  f    = 1.0f / static_cast<ure::float_t>( 1u << k );
+    const ure::float_t  sx   = static_cast<ure::float_t>( key.x & mask ) * f;
+    const ure::float_t  sy   = static_cast<ure::float_t>( key.y & mask ) * f;
+
+    batch.add( quad, atlas.uv( parent.value(), glm::vec4( sx, sy, sx + f, sy + f ) ), parent->page, key.source );
+
+    return true;
+  }
+
+  return false;
+}
+
+/////////////////////////////////////////////////////
+// ure::ResourcesFetcherEvents implementation
+/////////////////////////////////////////////////////
+
+ure::void_t TileLevel::on_download_succeeded( [[maybe_unused]] std::string_view name, [[maybe_unused]] const std::type_info& type, [[maybe_unused]] const ure::byte_t* data, [[maybe_unused]] ure::uint_t length ) noexcept(true)
+{
+  std::optional<TileKey> key = TileKey::parse( name );
+
+  // Not a tile name, nothing has been acquired for it
+  if ( key.has_value() == false )
+    return;
+
+  // A download slot is free, next frame dispatches the following one
+  m_tiles.scheduler().completed( key.value() );
+  m_tiles.redraw().request();
+
+  if ( m_tiles.cache().contains( key.value() ) == false )
+  {
+    if ( typeid(ure::Texture) == type )
+    {
+      // Request stays pending until the decoded tile is in the atlas
+      m_tiles.decoder().submit( key.value(), data, length );
+      return;
+    }
+    else
+    {
+      // @todo
+    }
+  }
+
+  m_tiles.requests().succeeded( key.value() );
+}
+
+ure::void_t TileLevel::on_download_failed   ( [[maybe_unused]] std::string_view name ) noexcept(true)
+{
+  std::optional<TileKey> key = TileKey::parse( name );
+
+  if ( key.has_value() == false )
+    return;
+
+  m_tiles.scheduler().completed( key.value() );
+  m_tiles.requests().failed( key.value() );
+  m_tiles.redraw().request();
+}
@@ -0,0 +1,79 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_prefetcher.h"
+
+namespace
+{
+  /* Input older than this is not representative of the current movement */
+  constexpr std::chrono::milliseconds  pan_expiry ( 150  );
+  constexpr std::chrono::milliseconds  zoom_expiry( 1000 );
+  /* Weight of the newest sample in the velocity average */
+  constexpr ure::float_t               smoothing  = 0.3f;
+}
+
+TilePrefetcher::TilePrefetcher( duration_t lookahead, ure::uint_t budget, ure::uint_t visible ) noexcept(true)
+  : m_lookahead(lookahead), m_budget(budget), m_visible(visible), m_velocity( 0.0f, 0.0f ), m_last_pan(), m_zoom(0), m_last_zoom()
+{
+}
+
+ure::void_t   TilePrefetcher::on_pan( ure::float_t dx, ure::float_t dy, clock_t::time_point now ) noexcept(true)
+{
+  const std::chrono::duration<ure::float_t> dt = now - m_last_pan;
+
+  m_last_pan = now;
+
+  // First sample after a pause, no reliable interval to derive a speed from
+  if ( ( dt > pan_expiry ) || ( dt.count() <= 0.0f ) )
+  {
+    m_velocity = glm::vec2( 0.0f, 0.0f );
+    return;
+  }
+
+  const glm::vec2 sample( dx / dt.count(), dy / dt.count() );
+
+  m_velocity = m_velocity * ( 1.0f - smoothing ) + sample * smoothing;
+}
+
+ure::void_t   TilePrefetcher::on_zoom( ure::int_t direction, clock_t::time_point now ) noexcept(true)
+{
+  m_zoom      = ( direction > 0 ) ? 1 : ( ( direction < 0 ) ? -1 : 0 );
+  m_last_zoom = now;
+}
+
+glm::vec2     TilePrefetcher::predicted_offset( clock_t::time_point now ) const noexcept(true)
+{
+  if ( now - m_last_pan > pan_expiry )
+    return glm::vec2( 0.0f, 0.0f );
+
+  const std::chrono::duration<ure::float_t> lookahead = m_lookahead;
+
+  return m_velocity * lookahead.count();
+}
+
+ure::int_t    TilePrefetcher::zoom_direction( clock_t::time_point now ) const noexcept(true)
+{
+  return ( now - m_last_zoom > zoom_expiry ) ? 0 : m_zoom;
+}
+
+ure::uint_t   TilePrefetcher::available( ure::uint_t pending, ure::uint_t pending_prefetch ) const noexcept(true)
+{
+  // Visible downloads are backing up, the connection is needed for them
+  if ( pending - pending_prefetch >= m_visible )
+    return 0;
+
+  return ( pending_prefetch < m_budget ) ? m_budget - pending_prefetch : 0;
+}
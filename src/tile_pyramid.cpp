@@ -0,0 +1,103 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_pyramid.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define TILE_PYRAMID_SSE2
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+# define TILE_PYRAMID_NEON
+#endif
+
+ure::bool_t  TilePyramid::downsample( const TileImage* const (&children)[4], TileImage& parent ) noexcept(true)
+{
+  const TileImage* first = children[0];
+
+  if ( ( first == nullptr ) || ( first->width % 2 != 0 ) || ( first->height % 2 != 0 ) )
+    return false;
+
+  for ( const TileImage* child : children )
+  {
+    if ( ( child == nullptr ) || ( child->format != TileImage::format_t::rgba8 ) ||
+         ( child->width != first->width ) || ( child->height != first->height ) || ( child->pixels.size() < child->bytes() ) )
+      return false;
+  }
+
+  parent.width  = first->width;
+  parent.height = first->height;
+  parent.format = TileImage::format_t::rgba8;
+  parent.pixels.resize( parent.bytes() );
+
+  const ure::uint_t half   = parent.width / 2;
+  const std::size_t stride = std::size_t(parent.width) * 4;
+
+  for ( ure::uint_t index = 0; index < 4; ++index )
+  {
+    const ure::byte_t*  src = children[index]->pixels.data();
+    ure::byte_t*        dst = parent.pixels.data() + ( index >> 1 ) * ( parent.height / 2 ) * stride + ( index & 1 ) * half * 4;
+
+    for ( ure::uint_t y = 0; y < parent.height / 2; ++y, src += 2 * stride, dst += stride )
+      downsample_rows( src, src + stride, half, dst );
+  }
+
+  return true;
+}
+
+ure::void_t  TilePyramid::downsample_rows( const ure::byte_t* row0, const ure::byte_t* row1, ure::uint_t count, ure::byte_t* dst ) noexcept(true)
+{
+  ure::uint_t i = 0;
+
+#if defined(TILE_PYRAMID_SSE2)
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi16( 2 );
+
+  // 4 source pixels per row, 2 destination pixels per iteration
+  for ( ; i + 2 <= count; i += 2, row0 += 16, row1 += 16, dst += 8 )
+  {
+    const __m128i a   = _mm_loadu_si128( reinterpret_cast<const __m128i*>(row0) );
+    const __m128i b   = _mm_loadu_si128( reinterpret_cast<const __m128i*>(row1) );
+
+    // Vertical sums of pixels 0,1 and 2,3 as 16 bits channels
+    const __m128i lo  = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+    const __m128i hi  = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+
+    // Horizontal sums, pixel 0+1 in the low half of lo, 2+3 in the low half of hi
+    const __m128i sum = _mm_unpacklo_epi64( _mm_add_epi16( lo, _mm_srli_si128( lo, 8 ) ), _mm_add_epi16( hi, _mm_srli_si128( hi, 8 ) ) );
+    const __m128i avg = _mm_srli_epi16( _mm_add_epi16( sum, round ), 2 );
+
+    _mm_storel_epi64( reinterpret_cast<__m128i*>(dst), _mm_packus_epi16( avg, avg ) );
+  }
+#elif defined(TILE_PYRAMID_NEON)
+  // 4 source pixels per row, split in even and odd pixels, 2 destination pixels per iteration
+  for ( ; i + 2 <= count; i += 2, row0 += 16, row1 += 16, dst += 8 )
+  {
+    const uint32x2x2_t a   = vld2_u32( reinterpret_cast<const uint32_t*>(row0) );
+    const uint32x2x2_t b   = vld2_u32( reinterpret_cast<const uint32_t*>(row1) );
+    const uint16x8_t   sum = vaddq_u16( vaddl_u8( vreinterpret_u8_u32( a.val[0] ), vreinterpret_u8_u32( a.val[1] ) ),
+                                        vaddl_u8( vreinterpret_u8_u32( b.val[0] ), vreinterpret_u8_u32( b.val[1] ) ) );
+
+    vst1_u8( dst, vrshrn_n_u16( sum, 2 ) );
+  }
+#endif
+
+  for ( ; i < count; ++i, row0 += 8, row1 += 8, dst += 4 )
+  {
+    for ( ure::uint_t c = 0; c < 4; ++c )
+      dst[c] = static_cast<ure::byte_t>( ( row0[c] + row0[c + 4] + row1[c] + row1[c + 4] + 2 ) >> 2 );
+  }
+}
@@ -0,0 +1,129 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_range.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  constexpr ure::double_t  pi      = 3.14159265358979323846;
+  constexpr ure::double_t  max_lat = 85.0511287798;     /* Web Mercator latitude limit */
+}
+
+ure::bool_t  visible_area( const glm::mat4& model, const ure::Size& viewport, glm::vec2& min, glm::vec2& max ) noexcept(true)
+{
+  const glm::mat4  inverse = glm::inverse( model );
+
+  // Viewport corners in pixels are mapped to NDC, then back to layer space.
+  const ure::float_t  corners[4][2] = {
+                                        { 0.0f                             , 0.0f                              },
+                                        { static_cast<ure::float_t>(viewport.width), 0.0f                      },
+                                        { 0.0f                             , static_cast<ure::float_t>(viewport.height) },
+                                        { static_cast<ure::float_t>(viewport.width), static_cast<ure::float_t>(viewport.height) }
+                                      };
+
+  ure::float_t  min_x = std::numeric_limits<ure::float_t>::max();
+  ure::float_t  min_y = std::numeric_limits<ure::float_t>::max();
+  ure::float_t  max_x = std::numeric_limits<ure::float_t>::lowest();
+  ure::float_t  max_y = std::numeric_limits<ure::float_t>::lowest();
+
+  for ( const auto& corner : corners )
+  {
+    const glm::vec4  ndc( 2.0f * corner[0] / viewport.width - 1.0f, 1.0f - 2.0f * corner[1] / viewport.height, 0.0f, 1.0f );
+    const glm::vec4  pt = inverse * ndc;
+
+    if ( pt.w == 0.0f )
+      return false;
+
+    min_x = std::min( min_x, pt.x / pt.w );
+    max_x = std::max( max_x, pt.x / pt.w );
+    min_y = std::min( min_y, pt.y / pt.w );
+    max_y = std::max( max_y, pt.y / pt.w );
+  }
+
+  min = glm::vec2( min_x, min_y );
+  max = glm::vec2( max_x, max_y );
+
+  return true;
+}
+
+TileRange  visible_tile_range( const glm::mat4& model, const ure::Size& viewport,
+                               const glm::vec2& origin, const glm::vec2& tile_size,
+                               ure::uint_t max_tiles, ure::int_t margin ) noexcept(true)
+{
+  const TileRange  none{ 0, 0, -1, -1 };
+
+  if ( (viewport.width == 0) || (viewport.height == 0) || (max_tiles == 0) )
+    return none;
+
+  if ( (tile_size.x <= 0.0f) || (tile_size.y <= 0.0f) )
+    return none;
+
+  glm::vec2  min( 0.0f );
+  glm::vec2  max( 0.0f );
+
+  if ( visible_area( model, viewport, min, max ) == false )
+    return none;
+
+  // Clamp in floating point first, far away views would overflow the integer cast.
+  const ure::float_t  limit   = static_cast<ure::float_t>(max_tiles);
+  auto                to_tile = [limit]( ure::float_t value, ure::float_t size ) -> ure::int_t {
+                                  return static_cast<ure::int_t>( std::floor( std::clamp( value / size, -1.0f, limit ) ) );
+                                };
+
+  const ure::int_t  last = static_cast<ure::int_t>(max_tiles) - 1;
+
+  TileRange  range{
+                    to_tile( min.x - origin.x, tile_size.x ) - margin,
+                    to_tile( min.y - origin.y, tile_size.y ) - margin,
+                    to_tile( max.x - origin.x, tile_size.x ) + margin,
+                    to_tile( max.y - origin.y, tile_size.y ) + margin
+                  };
+
+  range.x0 = std::clamp( range.x0, 0, last + 1 );
+  range.y0 = std::clamp( range.y0, 0, last + 1 );
+  range.x1 = std::clamp( range.x1, -1, last );
+  range.y1 = std::clamp( range.y1, -1, last );
+
+  return range;
+}
+
+TileRange  geo_tile_range( ure::double_t west, ure::double_t south, ure::double_t east, ure::double_t north,
+                           ure::uint_t zoom ) noexcept(true)
+{
+  const ure::double_t n    = std::ldexp( 1.0, static_cast<int>(zoom) );
+  const ure::int_t    last = static_cast<ure::int_t>(n) - 1;
+
+  auto column = [n]( ure::double_t lon ) {
+    return std::floor( ( std::clamp( lon, -180.0, 180.0 ) + 180.0 ) / 360.0 * n );
+  };
+  // Rows grow southward
+  auto row    = [n]( ure::double_t lat ) {
+    const ure::double_t rad = std::clamp( lat, -max_lat, max_lat ) * pi / 180.0;
+    return std::floor( ( 1.0 - std::log( std::tan( rad ) + 1.0 / std::cos( rad ) ) / pi ) / 2.0 * n );
+  };
+
+  if ( ( west > east ) || ( south > north ) )
+    return TileRange{ 0, 0, -1, -1 };
+
+  return TileRange{ std::clamp( static_cast<ure::int_t>( column( west  ) ), 0, last ),
+                    std::clamp( static_cast<ure::int_t>( row   ( north ) ), 0, last ),
+                    std::clamp( static_cast<ure::int_t>( column( east  ) ), 0, last ),
+                    std::clamp( static_cast<ure::int_t>( row   ( south ) ), 0, last ) };
+}
@@ -0,0 +1,158 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_requests.h"
+
+#include <algorithm>
+
+TileRequests::TileRequests( duration_t min_backoff, duration_t max_backoff ) noexcept(true)
+  : m_min_backoff( min_backoff ), m_max_backoff( std::max( min_backoff, max_backoff ) ), m_pending(0), m_pending_prefetch(0),
+    m_next_prune( clock_t::now() )
+{
+}
+
+ure::bool_t   TileRequests::acquire( const TileKey& key, ure::bool_t prefetch, clock_t::time_point now ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_entries.find( key );
+  if ( it == m_entries.end() )
+  {
+    m_entries.emplace( key, entry_t{ true, prefetch, 0, now } );
+    ++m_pending;
+    if ( prefetch )
+      ++m_pending_prefetch;
+    return true;
+  }
+
+  entry_t& entry = it->second;
+
+  // A prefetched tile is now needed by a frame, it no longer uses the prefetch budget
+  if ( entry.pending && entry.prefetch && ( prefetch == false ) )
+  {
+    entry.prefetch = false;
+    --m_pending_prefetch;
+  }
+
+  if ( entry.pending || ( now < entry.retry_at ) )
+    return false;
+
+  entry.pending  = true;
+  entry.prefetch = prefetch;
+  ++m_pending;
+  if ( prefetch )
+    ++m_pending_prefetch;
+
+  return true;
+}
+
+ure::void_t   TileRequests::succeeded( const TileKey& key ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_entries.find( key );
+  if ( it == m_entries.end() )
+    return;
+
+  if ( it->second.pending )
+  {
+    --m_pending;
+    if ( it->second.prefetch )
+      --m_pending_prefetch;
+  }
+
+  m_entries.erase( it );
+}
+
+ure::void_t   TileRequests::cancel( const TileKey& key ) noexcept(true)
+{
+  // Same bookkeeping as a completed download, a failure count from earlier attempts is dropped
+  succeeded( key );
+}
+
+ure::void_t   TileRequests::failed( const TileKey& key, clock_t::time_point now ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_entries.find( key );
+  if ( it == m_entries.end() )
+    return;
+
+  entry_t& entry = it->second;
+
+  if ( entry.pending )
+  {
+    entry.pending = false;
+    --m_pending;
+    if ( entry.prefetch )
+      --m_pending_prefetch;
+  }
+
+  ++entry.failures;
+
+  // min_backoff * 2^(failures-1), shift bounded to avoid overflow on long outages
+  const ure::uint_t  shift = std::min<ure::uint_t>( entry.failures - 1, 16 );
+  duration_t         delay = std::min( m_min_backoff * (1 << shift), m_max_backoff );
+
+  // Up to 25% of jitter, layers failing together should not retry together
+  std::uniform_int_distribution<duration_t::rep>  jitter( 0, delay.count() / 4 );
+  delay += duration_t( jitter( m_jitter ) );
+
+  entry.retry_at = now + delay;
+}
+
+ure::void_t   TileRequests::prune( clock_t::time_point now ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  if ( now < m_next_prune )
+    return;
+
+  m_next_prune = now + m_min_backoff;
+
+  // Tiles still visible are acquired again as soon as retry_at expires and keep their
+  // failure count, the grace period only lets go of the ones nobody asks for anymore
+  for ( auto it = m_entries.begin(); it != m_entries.end(); )
+  {
+    if ( ( it->second.pending == false ) && ( now >= it->second.retry_at + m_max_backoff ) )
+      it = m_entries.erase( it );
+    else
+      ++it;
+  }
+}
+
+ure::uint_t   TileRequests::pending() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_pending;
+}
+
+ure::uint_t   TileRequests::pending_prefetch() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_pending_prefetch;
+}
+
+ure::bool_t   TileRequests::is_pending( const TileKey& key ) const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_entries.find( key );
+
+  return ( it != m_entries.end() ) && it->second.pending;
+}
@@ -0,0 +1,217 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_scheduler.h"
+#include "metrics.h"
+
+#include <ure_resources_fetcher.h>
+#include <ure_texture.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+TileScheduler::TileScheduler( TileRequests& requests, ure::uint_t per_host ) noexcept(true)
+  : m_requests(requests), m_per_host( std::max<ure::uint_t>( 1, per_host ) ), m_zoom(0), m_frame(0),
+    m_dispatched(0), m_cancelled(0), m_wait_total_ms(0.0), m_wait_max_ms(0.0)
+{
+}
+
+ure::void_t   TileScheduler::queue( const TileKey& key, const TileUrl& url, ure::float_t distance,
+                                    ure::bool_t prefetch, ure::ResourcesFetcherEvents& events ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  const ure::uint_t host = host_id( url );
+
+  m_queue.insert_or_assign( key, entry_t{ &url, host, distance, prefetch, m_frame, clock_t::now(), &events } );
+}
+
+ure::void_t   TileScheduler::touch( const TileKey& key, ure::float_t distance, ure::bool_t prefetch ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_queue.find( key );
+  if ( it == m_queue.end() )
+    return;
+
+  entry_t& entry = it->second;
+
+  // Same tile requested as visible and as prefetch in one frame, visible wins
+  if ( entry.frame == m_frame )
+  {
+    entry.distance = std::min( entry.distance, distance );
+    entry.prefetch = entry.prefetch && prefetch;
+  }
+  else
+  {
+    entry.distance = distance;
+    entry.prefetch = prefetch;
+  }
+
+  entry.frame = m_frame;
+}
+
+ure::void_t   TileScheduler::completed( const TileKey& key ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  auto it = m_in_flight.find( key );
+  if ( it == m_in_flight.end() )
+    return;
+
+  --m_host_load[it->second];
+  m_in_flight.erase( it );
+}
+
+ure::void_t   TileScheduler::begin_frame( ure::uint_t zoom ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_zoom = zoom;
+  ++m_frame;
+}
+
+ure::uint_t   TileScheduler::dispatch() noexcept(true)
+{
+  MAP_METRICS_SCOPE( dispatch );
+
+  m_fetches.clear();
+
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_order.clear();
+
+    for ( auto it = m_queue.begin(); it != m_queue.end(); )
+    {
+      // Not requested by this frame, the tile left the visible or predicted area
+      if ( it->second.frame != m_frame )
+      {
+        m_requests.cancel( it->first );
+        it = m_queue.erase( it );
+        ++m_cancelled;
+        continue;
+      }
+
+      m_order.emplace_back( priority( it->first, it->second ), it->first );
+      ++it;
+    }
+
+    std::sort( m_order.begin(), m_order.end(), []( const auto& lhs, const auto& rhs ) { return lhs.first < rhs.first; } );
+
+    const clock_t::time_point now = clock_t::now();
+
+    // Failed tiles that left the view are not cancelled, drop them once their backoff is over
+    m_requests.prune( now );
+
+    for ( const auto& [prio, key] : m_order )
+    {
+      auto       it   = m_queue.find( key );
+      entry_t&   entry = it->second;
+
+      if ( m_host_load[entry.host] >= m_per_host )
+        continue;
+
+      const ure::double_t wait_ms = std::chrono::duration<ure::double_t, std::milli>( now - entry.queued_at ).count();
+
+      m_wait_total_ms += wait_ms;
+      m_wait_max_ms    = std::max( m_wait_max_ms, wait_ms );
+      ++m_dispatched;
+
+      ++m_host_load[entry.host];
+      m_in_flight.insert_or_assign( key, entry.host );
+
+      m_fetches.push_back( fetch_t{ key, entry.url, entry.events } );
+      m_queue.erase( it );
+    }
+  }
+
+  // Outside the lock, the fetcher may report a failure synchronously
+  for ( const fetch_t& fetch : m_fetches )
+  {
+    char name[TileKey::name_size];
+
+    m_name.assign( fetch.key.name( name ) );
+    fetch.url->expand( fetch.key, m_url );
+
+    if ( m_fetcher )
+    {
+      m_fetcher( *fetch.events, m_name, m_url );
+      continue;
+    }
+
+    ure::ResourcesFetcher::get_instance()->fetch( *fetch.events, m_name, typeid(ure::Texture), m_url, 
+                                                  ure::ResourcesFetcher::customer_request_t::Get,
+                                                  ure::ResourcesFetcher::http_headers_t{},
+                                                  std::string{}
+                                                );
+  }
+
+  MAP_METRICS_ADD( downloads_dispatched, m_fetches.size() );
+
+  return static_cast<ure::uint_t>( m_fetches.size() );
+}
+
+TileScheduler::stats_t   TileScheduler::stats() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return stats_t{ static_cast<ure::uint_t>( m_queue.size() ), static_cast<ure::uint_t>( m_in_flight.size() ),
+                  m_dispatched, m_cancelled,
+                  ( m_dispatched > 0 ) ? m_wait_total_ms / static_cast<ure::double_t>(m_dispatched) : 0.0,
+                  m_wait_max_ms };
+}
+
+ure::void_t   TileScheduler::set_fetcher( fetcher_t fetcher ) noexcept(true)
+{
+  m_fetcher = std::move(fetcher);
+}
+
+ure::uint_t   TileScheduler::per_host() const noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  return m_per_host;
+}
+
+ure::void_t   TileScheduler::set_per_host( ure::uint_t per_host ) noexcept(true)
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+
+  m_per_host = std::max<ure::uint_t>( 1, per_host );
+}
+
+ure::uint_t   TileScheduler::host_id( const TileUrl& url ) noexcept(true)
+{
+  auto it = m_hosts.find( url.host() );
+  if ( it != m_hosts.end() )
+    return it->second;
+
+  const ure::uint_t id = static_cast<ure::uint_t>( m_host_load.size() );
+
+  m_hosts.emplace( url.host(), id );
+  m_host_load.push_back( 0 );
+
+  return id;
+}
+
+ure::float_t  TileScheduler::priority( const TileKey& key, const entry_t& entry ) const noexcept(true)
+{
+  // Lower first: visible before prefetch, current level before others, centre before borders
+  const ure::float_t zoom_distance = static_cast<ure::float_t>( std::abs( static_cast<ure::int_t>(key.z) - static_cast<ure::int_t>(m_zoom) ) );
+
+  return ( entry.prefetch ? 1.0e6f : 0.0f ) + zoom_distance * 1.0e4f + entry.distance;
+}
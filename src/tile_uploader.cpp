@@ -0,0 +1,125 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_uploader.h"
+
+#include <cstdio>
+#include <cstring>
+
+TileUploader::TileUploader() noexcept(true)
+  : m_checked(false), m_streaming(false), m_bound(false), m_ring{}, m_next(0), m_streamed(0), m_direct(0)
+{
+}
+
+TileUploader::~TileUploader() noexcept(true)
+{
+  dispose();
+}
+
+const void*   TileUploader::begin( const ure::byte_t* pixels, std::size_t bytes ) noexcept(true)
+{
+  init();
+
+  if ( ( m_streaming == false ) || ( bytes == 0 ) )
+  {
+    m_direct += bytes;
+    return pixels;
+  }
+
+  buffer_t& buffer = m_ring[m_next];
+
+  m_next = ( m_next + 1 ) % m_ring.size();
+
+  if ( buffer.name == 0 )
+    glGenBuffers( 1, &buffer.name );
+
+  glBindBuffer( GL_PIXEL_UNPACK_BUFFER, buffer.name );
+
+  if ( buffer.size < bytes )
+  {
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW );
+    buffer.size = bytes;
+  }
+
+  // Invalidated, a transfer still reading the previous content does not block the mapping
+  void* staged = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+
+  if ( staged == nullptr )
+  {
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    m_direct += bytes;
+    return pixels;
+  }
+
+  std::memcpy( staged, pixels, bytes );
+
+  // Content lost while mapped, e.g. on a display mode switch, pixels come from client memory instead
+  if ( glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER ) == GL_FALSE )
+  {
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    m_direct += bytes;
+    return pixels;
+  }
+
+  m_bound     = true;
+  m_streamed += bytes;
+
+  return nullptr;
+}
+
+ure::void_t   TileUploader::end() noexcept(true)
+{
+  if ( m_bound == false )
+    return;
+
+  glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+  m_bound = false;
+}
+
+ure::void_t   TileUploader::dispose() noexcept(true)
+{
+  for ( buffer_t& buffer : m_ring )
+  {
+    if ( buffer.name != 0 )
+      glDeleteBuffers( 1, &buffer.name );
+
+    buffer = buffer_t{ 0, 0 };
+  }
+
+  m_next  = 0;
+  m_bound = false;
+}
+
+ure::void_t   TileUploader::init() noexcept(true)
+{
+  if ( m_checked )
+    return;
+
+  m_checked = true;
+
+  // glMapBufferRange is core in OpenGL ES 3.0 and OpenGL 3.0
+  const char* version = reinterpret_cast<const char*>( glGetString( GL_VERSION ) );
+  if ( version == nullptr )
+    return;
+
+  int major = 0;
+  int minor = 0;
+
+  if ( std::strncmp( version, "OpenGL ES", 9 ) == 0 )
+    m_streaming = ( std::sscanf( version, "OpenGL ES %d.%d", &major, &minor ) == 2 ) && ( major >= 3 );
+  else
+    m_streaming = ( std::sscanf( version, "%d.%d", &major, &minor ) == 2 ) && ( major >= 3 );
+}
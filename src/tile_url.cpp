@@ -0,0 +1,118 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "tile_url.h"
+
+#include <charconv>
+
+TileUrl::TileUrl( const std::string& pattern ) noexcept(true)
+  : m_pattern(pattern)
+{
+  const field_t  positional[3] = { field_t::z, field_t::x, field_t::y };
+  std::size_t    next          = 0;
+  std::size_t    start         = 0;
+  std::size_t    i             = 0;
+
+  while ( i < m_pattern.size() )
+  {
+    if ( ( m_pattern[i] == '%' ) && ( i + 1 < m_pattern.size() ) )
+    {
+      if ( m_pattern[i+1] == '%' )
+      {
+        // Keep the first '%' with the literal text before it, skip the second one
+        add_literal( start, i + 1 - start );
+        i    += 2;
+        start = i;
+        continue;
+      }
+
+      if ( ( m_pattern[i+1] == 'u' ) && ( next < 3 ) )
+      {
+        add_literal( start, i - start );
+        m_parts.push_back( part_t{ positional[next++], 0, 0 } );
+        i    += 2;
+        start = i;
+        continue;
+      }
+    }
+
+    if ( ( m_pattern[i] == '{' ) && ( i + 2 < m_pattern.size() ) && ( m_pattern[i+2] == '}' ) )
+    {
+      const char name  = m_pattern[i+1];
+      field_t    field = field_t::literal;
+
+      if ( name == 'z' )
+        field = field_t::z;
+      else if ( name == 'x' )
+        field = field_t::x;
+      else if ( name == 'y' )
+        field = field_t::y;
+
+      if ( field != field_t::literal )
+      {
+        add_literal( start, i - start );
+        m_parts.push_back( part_t{ field, 0, 0 } );
+        i    += 3;
+        start = i;
+        continue;
+      }
+    }
+
+    ++i;
+  }
+
+  add_literal( start, m_pattern.size() - start );
+
+  // scheme://host[:port]/path, the host part is everything up to the first '/'
+  std::size_t begin = m_pattern.find( "://" );
+  begin = ( begin == std::string::npos ) ? 0 : begin + 3;
+
+  const std::size_t end = m_pattern.find_first_of( "/%{", begin );
+
+  m_host = m_pattern.substr( begin, ( end == std::string::npos ) ? std::string::npos : end - begin );
+}
+
+ure::void_t   TileUrl::expand( const TileKey& key, std::string& out ) const noexcept(true)
+{
+  char  digits[10];
+
+  out.clear();
+
+  for ( const part_t& part : m_parts )
+  {
+    ure::uint_t value = 0;
+
+    switch ( part.field )
+    {
+      case field_t::literal:
+        out.append( m_pattern, part.offset, part.length );
+        continue;
+      case field_t::z: value = key.z; break;
+      case field_t::x: value = key.x; break;
+      case field_t::y: value = key.y; break;
+    }
+
+    const char* last = std::to_chars( digits, digits + sizeof(digits), value ).ptr;
+
+    out.append( digits, static_cast<std::size_t>( last - digits ) );
+  }
+}
+
+ure::void_t   TileUrl::add_literal( std::size_t offset, std::size_t length ) noexcept(true)
+{
+  if ( length > 0 )
+    m_parts.push_back( part_t{ field_t::literal, offset, length } );
+}
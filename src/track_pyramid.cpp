@@ -0,0 +1,299 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "track_pyramid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <utility>
+
+namespace
+{
+  /** Squared distance from @p p to segment @p a @p b */
+  ure::double_t  distance2( const TrackPyramid::point_t& p, const TrackPyramid::point_t& a, const TrackPyramid::point_t& b ) noexcept
+  {
+    const ure::double_t  dx  = b.x - a.x;
+    const ure::double_t  dy  = b.y - a.y;
+    const ure::double_t  len = dx * dx + dy * dy;
+    ure::double_t        t   = 0.0;
+
+    if ( len > 0.0 )
+      t = std::clamp( ( ( p.x - a.x ) * dx + ( p.y - a.y ) * dy ) / len, 0.0, 1.0 );
+
+    const ure::double_t  ex  = a.x + t * dx - p.x;
+    const ure::double_t  ey  = a.y + t * dy - p.y;
+
+    return ex * ex + ey * ey;
+  }
+
+  /** Run @p task( i ) for i in [0, count) on @p workers threads */
+  template<typename task_t>
+  ure::void_t  parallel_for( std::size_t count, ure::uint_t workers, const task_t& task ) noexcept(true)
+  {
+    std::atomic<std::size_t>  next( 0 );
+    std::vector<std::thread>  threads;
+
+    const auto run = [&next, count, &task]() {
+      for ( std::size_t i = next++; i < count; i = next++ )
+        task( i );
+    };
+
+    workers = static_cast<ure::uint_t>( std::min<std::size_t>( workers, count ) );
+
+    for ( ure::uint_t i = 1; i < workers; ++i )
+      threads.emplace_back( run );
+
+    run();
+
+    for ( auto& thread : threads )
+      thread.join();
+  }
+}
+
+TrackPyramid::TrackPyramid() noexcept(true)
+{
+}
+
+ure::bool_t   TrackPyramid::read_csv( const std::string& path, std::vector<track_t>& tracks ) noexcept(true)
+{
+  std::ifstream  file( path );
+  if ( !file )
+    return false;
+
+  std::string  line;
+  track_t      track;
+
+  while ( std::getline( file, line ) )
+  {
+    if ( line.find_first_not_of( " \t\r" ) == std::string::npos )
+    {
+      if ( track.empty() == false )
+        tracks.push_back( std::move(track) );
+
+      track = track_t{};
+      continue;
+    }
+
+    const char*          text = line.c_str();
+    char*                end  = nullptr;
+    const ure::double_t  lon  = std::strtod( text, &end );
+
+    if ( ( end == text ) || ( *end != ',' ) )
+      continue;
+
+    text = end + 1;
+
+    const ure::double_t  lat  = std::strtod( text, &end );
+
+    if ( ( end == text ) || std::isnan( lon ) || std::isnan( lat ) )
+      continue;
+
+    track.push_back( MarkerIndex::project( lon, lat ) );
+  }
+
+  if ( track.empty() == false )
+    tracks.push_back( std::move(track) );
+
+  return true;
+}
+
+ure::void_t   TrackPyramid::build( std::vector<track_t>&& tracks, ure::uint_t levels, ure::uint_t tile_pixels,
+                                   ure::float_t tolerance, ure::uint_t workers ) noexcept(true)
+{
+  if ( workers == 0 )
+    workers = std::max( 1u, std::thread::hardware_concurrency() );
+
+  m_tracks = std::move(tracks);
+  m_offsets.clear();
+  m_levels.clear();
+
+  // Chunks address vertices with 32 bits, tracks beyond that are dropped
+  std::size_t total = 0;
+
+  for ( std::size_t t = 0; t < m_tracks.size(); ++t )
+  {
+    if ( total + m_tracks[t].size() > 0xFFFFFFFFu )
+    {
+      m_tracks.resize( t );
+      break;
+    }
+
+    m_offsets.push_back( total );
+    total += m_tracks[t].size();
+  }
+
+  m_importance.assign( total, std::numeric_limits<ure::float_t>::infinity() );
+
+  // Pieces of long tracks are simplified on their own, their ends are kept
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> pieces;
+
+  for ( std::uint32_t t = 0; t < m_tracks.size(); ++t )
+  {
+    const std::uint32_t size = static_cast<std::uint32_t>( m_tracks[t].size() );
+
+    for ( std::uint32_t first = 0; first + 1 < size; first += piece_size() )
+      pieces.emplace_back( t, first );
+  }
+
+  parallel_for( pieces.size(), workers, [this, &pieces]( std::size_t i ) {
+    const std::uint32_t track = pieces[i].first;
+    const std::uint32_t first = pieces[i].second;
+    const std::uint32_t last  = std::min<std::uint32_t>( first + piece_size(), static_cast<std::uint32_t>( m_tracks[track].size() ) - 1 );
+
+    simplify( track, first, last );
+  } );
+
+  m_levels.resize( levels );
+
+  for ( ure::uint_t level = 0; level < levels; ++level )
+    m_levels[level].tolerance = tolerance / std::ldexp( static_cast<ure::double_t>( std::max( 1u, tile_pixels ) ), static_cast<int>(level) );
+
+  parallel_for( m_levels.size(), workers, [this]( std::size_t level ) {
+    split( static_cast<ure::uint_t>(level) );
+  } );
+}
+
+ure::void_t   TrackPyramid::vertices( ure::uint_t level, std::vector<point_t>& out ) const noexcept(true)
+{
+  out.clear();
+
+  if ( level >= m_levels.size() )
+    return;
+
+  const ure::double_t tolerance = m_levels[level].tolerance;
+
+  out.reserve( m_levels[level].vertices );
+
+  for ( std::uint32_t t = 0; t < m_tracks.size(); ++t )
+  {
+    const track_t& track = m_tracks[t];
+
+    if ( track.size() < 2 )
+      continue;
+
+    for ( std::uint32_t i = 0; i < track.size(); ++i )
+    {
+      if ( kept( t, i, tolerance ) )
+        out.push_back( track[i] );
+    }
+  }
+}
+
+ure::void_t   TrackPyramid::simplify( std::uint32_t track, std::uint32_t first, std::uint32_t last ) noexcept(true)
+{
+  const track_t&  points     = m_tracks[track];
+  ure::float_t*   importance = m_importance.data() + m_offsets[track];
+
+  struct range_t
+  {
+    std::uint32_t  first;
+    std::uint32_t  last;
+    ure::float_t   limit;     /* Importance of the vertex that split the parent range */
+  };
+
+  std::vector<range_t> stack;
+
+  stack.push_back( range_t{ first, last, std::numeric_limits<ure::float_t>::infinity() } );
+
+  while ( stack.empty() == false )
+  {
+    const range_t range = stack.back();
+    stack.pop_back();
+
+    if ( range.last - range.first < 2 )
+      continue;
+
+    std::uint32_t  split = range.first + 1;
+    ure::double_t  max   = -1.0;
+
+    for ( std::uint32_t i = range.first + 1; i < range.last; ++i )
+    {
+      const ure::double_t d = distance2( points[i], points[range.first], points[range.last] );
+
+      if ( d > max )
+      {
+        max   = d;
+        split = i;
+      }
+    }
+
+    // Children never outlive their parent, levels are nested
+    const ure::float_t value = std::min( range.limit, static_cast<ure::float_t>( std::sqrt( max ) ) );
+
+    importance[split] = value;
+
+    stack.push_back( range_t{ range.first, split, value } );
+    stack.push_back( range_t{ split, range.last, value } );
+  }
+}
+
+ure::void_t   TrackPyramid::split( ure::uint_t index ) noexcept(true)
+{
+  level_t&             level     = m_levels[index];
+  const ure::double_t  tolerance = level.tolerance;
+  std::uint32_t        vertex    = 0;
+
+  level.chunks.clear();
+
+  const auto extend = []( chunk_t& chunk, const point_t& point ) {
+    chunk.bounds.min_x = std::min( chunk.bounds.min_x, point.x );
+    chunk.bounds.min_y = std::min( chunk.bounds.min_y, point.y );
+    chunk.bounds.max_x = std::max( chunk.bounds.max_x, point.x );
+    chunk.bounds.max_y = std::max( chunk.bounds.max_y, point.y );
+    ++chunk.count;
+  };
+
+  const bounds_t  empty{ std::numeric_limits<ure::double_t>::max(), std::numeric_limits<ure::double_t>::max(),
+                         std::numeric_limits<ure::double_t>::lowest(), std::numeric_limits<ure::double_t>::lowest() };
+
+  for ( std::uint32_t t = 0; t < m_tracks.size(); ++t )
+  {
+    const track_t& track = m_tracks[t];
+
+    if ( track.size() < 2 )
+      continue;
+
+    const std::uint32_t  last  = static_cast<std::uint32_t>( track.size() ) - 1;
+    chunk_t              chunk{ vertex, 0, t, empty };
+
+    for ( std::uint32_t i = 0; i <= last; ++i )
+    {
+      if ( kept( t, i, tolerance ) == false )
+        continue;
+
+      extend( chunk, track[i] );
+      ++vertex;
+
+      // Next chunk starts from the same vertex, strips of adjacent chunks join
+      if ( ( chunk.count == chunk_size() ) && ( i < last ) )
+      {
+        level.chunks.push_back( chunk );
+
+        chunk = chunk_t{ vertex - 1, 0, t, empty };
+        extend( chunk, track[i] );
+      }
+    }
+
+    level.chunks.push_back( chunk );
+  }
+
+  level.vertices = vertex;
+}
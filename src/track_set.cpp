@@ -0,0 +1,233 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "track_set.h"
+#include "tile_range.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+TrackSet::TrackSet( ure::uint_t tile_pixels ) noexcept(true)
+  : m_tile_pixels( std::max( 1u, tile_pixels ) ), m_color( 0.85f, 0.10f, 0.55f, 0.85f ), m_width(3.0f), m_zoom(0),
+    m_origin(0.0f), m_model(1.0f), m_fb_size{0,0}, m_stale(true), m_culled(false), m_uploads(0)
+{
+}
+
+ure::void_t   TrackSet::set_tracks( TrackPyramid&& pyramid ) noexcept(true)
+{
+  m_pyramid = std::move(pyramid);
+  m_stale   = true;
+  m_culled  = false;
+}
+
+ure::void_t   TrackSet::set_style( const glm::vec4& color, ure::float_t width ) noexcept(true)
+{
+  m_color  = color;
+  m_width  = std::max( 1.0f, width );
+  m_culled = false;
+}
+
+ure::void_t   TrackSet::set_zoom( ure::word_t zoom ) noexcept(true)
+{
+  if ( zoom == m_zoom )
+    return;
+
+  m_zoom   = zoom;
+  m_culled = false;
+}
+
+ure::void_t   TrackSet::set_origin( const glm::vec2& origin ) noexcept(true)
+{
+  if ( origin == m_origin )
+    return;
+
+  m_origin = origin;
+  m_stale  = true;
+  m_culled = false;
+}
+
+ure::void_t   TrackSet::set_view( const glm::mat4& model, const ure::Size& fb_size ) noexcept(true)
+{
+  if ( ( model == m_model ) && ( fb_size.width == m_fb_size.width ) && ( fb_size.height == m_fb_size.height ) )
+    return;
+
+  m_model   = model;
+  m_fb_size = fb_size;
+  m_culled  = false;
+}
+
+ure::uint_t   TrackSet::draw() noexcept(true)
+{
+  if ( m_stale )
+    release();
+
+  if ( ( m_pyramid.levels() == 0 ) || ( m_fb_size.width == 0 ) || ( m_fb_size.height == 0 ) )
+    return 0;
+
+  const ure::uint_t  level = this->level();
+
+  if ( upload( level ) == false )
+    return 0;
+
+  const glm::mat4  model = this->model( level );
+
+  if ( m_culled == false )
+    cull( level, model );
+
+  if ( m_lines.empty() || ( m_renderer.begin() == false ) )
+    return 0;
+
+  const ure::uint_t draw_calls = m_renderer.draw( m_buffers[level].vbo, m_lines, model, m_color, m_width );
+
+  m_renderer.end();
+
+  return draw_calls;
+}
+
+ure::void_t   TrackSet::dispose() noexcept(true)
+{
+  release();
+
+  m_renderer.dispose();
+}
+
+ure::uint_t   TrackSet::level() const noexcept(true)
+{
+  return std::min<ure::uint_t>( m_zoom, m_pyramid.levels() - 1 );
+}
+
+ure::double_t   TrackSet::world( ure::uint_t level ) const noexcept(true)
+{
+  return std::ldexp( static_cast<ure::double_t>( m_tile_pixels ), static_cast<int>( level ) );
+}
+
+ure::void_t   TrackSet::release() noexcept(true)
+{
+  for ( buffer_t& buffer : m_buffers )
+  {
+    if ( buffer.vbo != 0 )
+      glDeleteBuffers( 1, &buffer.vbo );
+  }
+
+  m_buffers.assign( m_pyramid.levels(), buffer_t{ 0, {} } );
+  m_lines.clear();
+  m_stale  = false;
+  m_culled = false;
+}
+
+ure::bool_t   TrackSet::upload( ure::uint_t level ) noexcept(true)
+{
+  buffer_t& buffer = m_buffers[level];
+
+  if ( buffer.vbo != 0 )
+    return true;
+
+  std::vector<TrackPyramid::point_t>  points;
+  m_pyramid.vertices( level, points );
+
+  const std::vector<TrackPyramid::chunk_t>& chunks = m_pyramid.level( level ).chunks;
+
+  // Two vertices per segment in pixels of the level, as tiles and markers
+  const ure::double_t     world = this->world( level );
+  std::vector<glm::vec2>  vertices;
+
+  vertices.reserve( 2 * points.size() );
+  buffer.segments.resize( chunks.size() );
+
+  for ( std::size_t c = 0; c < chunks.size(); ++c )
+  {
+    buffer.segments[c] = static_cast<std::uint32_t>( vertices.size() / 2 );
+
+    for ( std::uint32_t i = chunks[c].first; i + 1 < chunks[c].first + chunks[c].count; ++i )
+    {
+      for ( std::uint32_t v = i; v <= i + 1; ++v )
+      {
+        vertices.emplace_back( static_cast<ure::float_t>( m_origin.x + points[v].x * world ),
+                               static_cast<ure::float_t>( m_origin.y + points[v].y * world ) );
+      }
+    }
+  }
+
+  if ( vertices.empty() )
+    return false;
+
+  glGenBuffers( 1, &buffer.vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, buffer.vbo );
+  glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( vertices.size() * sizeof(glm::vec2) ), vertices.data(), GL_STATIC_DRAW );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+  ++m_uploads;
+
+  return true;
+}
+
+glm::mat4   TrackSet::model( ure::uint_t level ) const noexcept(true)
+{
+  if ( level == m_zoom )
+    return m_model;
+
+  // Pixels of the zoom level are those of the coarser level scaled around tile (0,0)
+  const ure::float_t  scale = static_cast<ure::float_t>( std::ldexp( 1.0, m_zoom - static_cast<int>( level ) ) );
+
+  return glm::translate( m_model, glm::vec3( m_origin, 0.0f ) ) *
+         glm::scale( glm::mat4(1.0f), glm::vec3( scale, scale, 1.0f ) ) *
+         glm::translate( glm::mat4(1.0f), glm::vec3( -m_origin, 0.0f ) );
+}
+
+ure::void_t   TrackSet::cull( ure::uint_t level, const glm::mat4& model ) noexcept(true)
+{
+  m_lines.clear();
+  m_culled = true;
+
+  glm::vec2  min( 0.0f );
+  glm::vec2  max( 0.0f );
+
+  if ( visible_area( model, m_fb_size, min, max ) == false )
+    return;
+
+  // Lines crossing the border are as wide as on screen
+  const ure::double_t  scale  = std::abs( model[0][0] ) * m_fb_size.width / 2.0;
+  const ure::double_t  margin = ( scale > 0.0 ) ? m_width / scale : 0.0;
+  const ure::double_t  world  = this->world( level );
+
+  const TrackPyramid::bounds_t  view{ ( min.x - margin - m_origin.x ) / world, ( min.y - margin - m_origin.y ) / world,
+                                      ( max.x + margin - m_origin.x ) / world, ( max.y + margin - m_origin.y ) / world };
+
+  const std::vector<TrackPyramid::chunk_t>& chunks   = m_pyramid.level( level ).chunks;
+  const std::vector<std::uint32_t>&         segments = m_buffers[level].segments;
+
+  for ( std::size_t c = 0; c < chunks.size(); ++c )
+  {
+    const TrackPyramid::chunk_t& chunk = chunks[c];
+
+    if ( ( chunk.count < 2 ) ||
+         ( chunk.bounds.max_x < view.min_x ) || ( chunk.bounds.min_x > view.max_x ) ||
+         ( chunk.bounds.max_y < view.min_y ) || ( chunk.bounds.min_y > view.max_y ) )
+      continue;
+
+    const GLint    first = static_cast<GLint>( 2 * segments[c] );
+    const GLsizei  count = static_cast<GLsizei>( 2 * ( chunk.count - 1 ) );
+
+    // Visible neighbours are contiguous whatever their track, a single draw call
+    if ( ( m_lines.empty() == false ) && ( m_lines.back().first + m_lines.back().count == first ) )
+      m_lines.back().count += count;
+    else
+      m_lines.push_back( VectorRenderer::lines_t{ first, count } );
+  }
+}
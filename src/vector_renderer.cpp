@@ -0,0 +1,210 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_renderer.h"
+
+#include <ure_utils.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+VectorRenderer::VectorRenderer() noexcept(true)
+  : m_shaders_path( "./resources/shaders/" ), m_failed(false), m_program(0),
+    m_a_point(-1), m_u_mvp(-1), m_u_color(-1), m_blend(GL_FALSE)
+{
+}
+
+VectorRenderer::~VectorRenderer() noexcept(true)
+{
+  dispose();
+}
+
+ure::void_t   VectorRenderer::set_shaders_path( const std::string& path ) noexcept(true)
+{
+  m_shaders_path = path;
+}
+
+ure::bool_t   VectorRenderer::begin() noexcept(true)
+{
+  if ( init() == false )
+    return false;
+
+  // Styles and overlays may be translucent
+  m_blend = glIsEnabled( GL_BLEND );
+  if ( m_blend == GL_FALSE )
+  {
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  }
+
+  glUseProgram( m_program );
+  glEnableVertexAttribArray( static_cast<GLuint>(m_a_point) );
+
+  return true;
+}
+
+ure::uint_t   VectorRenderer::draw( const VectorTileCache::buffer_t& buffer, const glm::mat4& mvp, ure::float_t opacity ) noexcept(true)
+{
+  if ( ( buffer.vbo == 0 ) || ( opacity <= 0.0f ) || ( m_program == 0 ) )
+    return 0;
+
+  ure::uint_t draw_calls = 0;
+
+  glBindBuffer( GL_ARRAY_BUFFER, buffer.vbo );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_point), 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+
+  for ( const VectorTile::group_t& group : buffer.groups )
+  {
+    glUniform4f( m_u_color, group.color.x, group.color.y, group.color.z, group.color.w * opacity );
+    glDrawArrays( GL_TRIANGLES, static_cast<GLint>(group.first), static_cast<GLsizei>(group.count) );
+
+    ++draw_calls;
+  }
+
+  return draw_calls;
+}
+
+ure::uint_t   VectorRenderer::draw( GLuint vbo, const std::vector<lines_t>& lines, const glm::mat4& mvp, const glm::vec4& color, ure::float_t width ) noexcept(true)
+{
+  if ( ( vbo == 0 ) || lines.empty() || ( color.w <= 0.0f ) || ( m_program == 0 ) )
+    return 0;
+
+  glBindBuffer( GL_ARRAY_BUFFER, vbo );
+  glVertexAttribPointer( static_cast<GLuint>(m_a_point), 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr );
+  glUniformMatrix4fv( m_u_mvp, 1, GL_FALSE, glm::value_ptr(mvp) );
+  glUniform4f( m_u_color, color.x, color.y, color.z, color.w );
+  // Widths above the supported range are clamped by the driver
+  glLineWidth( width );
+
+  for ( const lines_t& range : lines )
+    glDrawArrays( GL_LINES, range.first, range.count );
+
+  glLineWidth( 1.0f );
+
+  return static_cast<ure::uint_t>( lines.size() );
+}
+
+ure::void_t   VectorRenderer::end() noexcept(true)
+{
+  if ( m_program == 0 )
+    return;
+
+  glDisableVertexAttribArray( static_cast<GLuint>(m_a_point) );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glUseProgram( 0 );
+
+  if ( m_blend == GL_FALSE )
+    glDisable( GL_BLEND );
+}
+
+ure::void_t   VectorRenderer::dispose() noexcept(true)
+{
+  if ( m_program != 0 )
+    glDeleteProgram( m_program );
+
+  m_program = 0;
+}
+
+ure::bool_t   VectorRenderer::init() noexcept(true)
+{
+  if ( m_program != 0 )
+    return true;
+
+  if ( m_failed )
+    return false;
+
+  m_failed = true;
+
+  GLuint vs = compile( GL_VERTEX_SHADER  , "DefaultSolid.vs" );
+  GLuint fs = compile( GL_FRAGMENT_SHADER, "DefaultSolid.fs" );
+
+  if ( ( vs == 0 ) || ( fs == 0 ) )
+  {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return false;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader( program, vs );
+  glAttachShader( program, fs );
+  glLinkProgram ( program );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &linked );
+  if ( linked != GL_TRUE )
+  {
+    ure::utils::log( "VectorRenderer: unable to link DefaultSolid program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_a_point  = glGetAttribLocation ( program, "a_v2Point" );
+  m_u_mvp    = glGetUniformLocation( program, "u_m4MVP"   );
+  m_u_color  = glGetUniformLocation( program, "u_v4Color" );
+
+  if ( m_a_point < 0 )
+  {
+    ure::utils::log( "VectorRenderer: missing attributes in DefaultSolid program" );
+    glDeleteProgram( program );
+    return false;
+  }
+
+  m_program = program;
+  m_failed  = false;
+
+  return true;
+}
+
+GLuint   VectorRenderer::compile( GLenum type, const std::string& file ) noexcept(true)
+{
+  std::ifstream      stream( m_shaders_path + file );
+  std::stringstream  source;
+
+  if ( !stream )
+  {
+    ure::utils::log( "VectorRenderer: unable to read shader [" + m_shaders_path + file + "]" );
+    return 0;
+  }
+
+  source << stream.rdbuf();
+
+  const std::string  text = source.str();
+  const GLchar*      ptr  = text.c_str();
+
+  GLuint shader = glCreateShader( type );
+  glShaderSource ( shader, 1, &ptr, nullptr );
+  glCompileShader( shader );
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+  if ( compiled != GL_TRUE )
+  {
+    GLchar  log[512] = { 0 };
+    glGetShaderInfoLog( shader, sizeof(log), nullptr, log );
+
+    ure::utils::log( "VectorRenderer: unable to compile [" + file + "]: " + log );
+    glDeleteShader( shader );
+    return 0;
+  }
+
+  return shader;
+}
@@ -0,0 +1,340 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tessellator.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+  // Tile coordinates reach a few thousands, products do not fit a float mantissa
+  inline ure::double_t  cross( const glm::vec2& a, const glm::vec2& b, const glm::vec2& c ) noexcept
+  {
+    return ( ure::double_t(b.x) - a.x ) * ( ure::double_t(c.y) - a.y ) - ( ure::double_t(b.y) - a.y ) * ( ure::double_t(c.x) - a.x );
+  }
+
+  /** @p p inside or on the border of triangle abc, which has a positive area */
+  inline ure::bool_t  in_triangle( const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& p ) noexcept
+  {
+    return ( cross( a, b, p ) >= 0.0 ) && ( cross( b, c, p ) >= 0.0 ) && ( cross( c, a, p ) >= 0.0 );
+  }
+
+  /** @p p on segment ab, strictly between its ends */
+  inline ure::bool_t  on_segment( const glm::vec2& a, const glm::vec2& b, const glm::vec2& p ) noexcept
+  {
+    return ( cross( a, b, p ) == 0.0 ) && ( p != a ) && ( p != b ) &&
+           ( std::min( a.x, b.x ) <= p.x ) && ( p.x <= std::max( a.x, b.x ) ) &&
+           ( std::min( a.y, b.y ) <= p.y ) && ( p.y <= std::max( a.y, b.y ) );
+  }
+
+  /** Segments share a point other than the ends of ab */
+  inline ure::bool_t  blocks( const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& d ) noexcept
+  {
+    const ure::double_t abc = cross( a, b, c );
+    const ure::double_t abd = cross( a, b, d );
+    const ure::double_t cda = cross( c, d, a );
+    const ure::double_t cdb = cross( c, d, b );
+
+    const ure::bool_t crossing = ( ( ( abc > 0.0 ) && ( abd < 0.0 ) ) || ( ( abc < 0.0 ) && ( abd > 0.0 ) ) ) &&
+                                 ( ( ( cda > 0.0 ) && ( cdb < 0.0 ) ) || ( ( cda < 0.0 ) && ( cdb > 0.0 ) ) );
+
+    return crossing || on_segment( a, b, c ) || on_segment( a, b, d );
+  }
+
+  /** Segment @p a @p b meets an edge of the closed ring elsewhere than at its ends */
+  ure::bool_t  blocked_by_ring( const glm::vec2& a, const glm::vec2& b, const glm::vec2* ring, std::size_t count ) noexcept
+  {
+    for ( std::size_t i = 0, j = count - 1; i < count; j = i++ )
+    {
+      if ( blocks( a, b, ring[j], ring[i] ) )
+        return true;
+    }
+
+    return false;
+  }
+
+  /** Direction from @p v to @p p lies inside the polygon interior angle at @p v */
+  inline ure::bool_t  locally_inside( const glm::vec2& prev, const glm::vec2& v, const glm::vec2& next, const glm::vec2& p ) noexcept
+  {
+    return ( cross( prev, v, next ) > 0.0 ) ? ( ( cross( v, p, next ) <= 0.0 ) && ( cross( v, prev, p ) <= 0.0 ) )
+                                            : ( ( cross( v, p, prev ) >  0.0 ) || ( cross( v, next, p ) >  0.0 ) );
+  }
+}
+
+ure::float_t  VectorTessellator::area( const glm::vec2* points, std::size_t count ) noexcept(true)
+{
+  ure::double_t sum = 0.0;
+
+  for ( std::size_t i = 0, j = ( count > 0 ) ? count - 1 : 0; i < count; j = i++ )
+    sum += ure::double_t(points[j].x) * points[i].y - ure::double_t(points[i].x) * points[j].y;
+
+  return static_cast<ure::float_t>( sum * 0.5 );
+}
+
+ure::bool_t   VectorTessellator::fill( const glm::vec2* points, const ure::uint_t* rings, std::size_t count, std::vector<glm::vec2>& triangles ) noexcept(true)
+{
+  m_ring.clear();
+  m_hole_points.clear();
+  m_holes.clear();
+
+  if ( count == 0 )
+    return true;
+
+  add_ring( points, rings[0], true );
+
+  // Degenerate exterior ring, nothing to draw
+  if ( m_ring.size() < 3 )
+    return true;
+
+  // Holes wait in m_hole_points until bridged
+  std::size_t offset = rings[0];
+
+  for ( std::size_t r = 1; r < count; offset += rings[r++] )
+  {
+    const std::size_t first = m_ring.size();
+
+    add_ring( points + offset, rings[r], false );
+
+    const std::size_t size = m_ring.size() - first;
+
+    if ( size >= 3 )
+    {
+      ure::float_t max_x = m_ring[first].x;
+      for ( std::size_t i = first + 1; i < m_ring.size(); ++i )
+        max_x = std::max( max_x, m_ring[i].x );
+
+      m_holes.push_back( hole_t{ m_hole_points.size(), size, max_x } );
+      m_hole_points.insert( m_hole_points.end(), m_ring.begin() + first, m_ring.end() );
+    }
+
+    m_ring.resize( first );
+  }
+
+  // Rightmost holes first, a bridge then never crosses a hole not yet merged
+  std::sort( m_holes.begin(), m_holes.end(), []( const hole_t& lhs, const hole_t& rhs ) { return lhs.max_x > rhs.max_x; } );
+
+  for ( const hole_t& hole : m_holes )
+    bridge( hole );
+
+  return clip( triangles );
+}
+
+ure::void_t   VectorTessellator::stroke( const glm::vec2* points, std::size_t count, ure::float_t width, ure::bool_t closed, std::vector<glm::vec2>& triangles ) const noexcept(true)
+{
+  if ( ( count < 2 ) || ( width <= 0.0f ) )
+    return;
+
+  const ure::float_t half     = width * 0.5f;
+  const std::size_t  segments = closed ? count : count - 1;
+
+  for ( std::size_t i = 0; i < segments; ++i )
+  {
+    const glm::vec2&   p0     = points[i];
+    const glm::vec2&   p1     = points[ ( i + 1 < count ) ? i + 1 : 0 ];
+    const glm::vec2    d      = p1 - p0;
+    const ure::float_t length = glm::length( d );
+
+    if ( length <= 0.0f )
+      continue;
+
+    const glm::vec2    along  = d * ( half / length );
+    const glm::vec2    normal( -along.y, along.x );
+    const glm::vec2    a      = p0 - along;
+    const glm::vec2    b      = p1 + along;
+
+    triangles.push_back( a + normal );
+    triangles.push_back( a - normal );
+    triangles.push_back( b + normal );
+    triangles.push_back( b + normal );
+    triangles.push_back( a - normal );
+    triangles.push_back( b - normal );
+  }
+}
+
+ure::void_t   VectorTessellator::add_ring( const glm::vec2* points, std::size_t count, ure::bool_t exterior ) noexcept(true)
+{
+  const std::size_t first = m_ring.size();
+
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    if ( ( m_ring.size() == first ) || ( m_ring.back() != points[i] ) )
+      m_ring.push_back( points[i] );
+  }
+
+  // Closing point repeated by some encoders
+  if ( ( m_ring.size() - first > 1 ) && ( m_ring.back() == m_ring[first] ) )
+    m_ring.pop_back();
+
+  // Clipping expects positive exterior rings and negative holes, whatever the encoder did
+  const ure::float_t signed_area = area( m_ring.data() + first, m_ring.size() - first );
+
+  if ( ( signed_area > 0.0f ) != exterior )
+    std::reverse( m_ring.begin() + first, m_ring.end() );
+}
+
+ure::void_t   VectorTessellator::bridge( const hole_t& ring ) noexcept(true)
+{
+  const std::size_t  count = ring.count;
+  const glm::vec2*   hole  = m_hole_points.data() + ring.first;
+
+  // Rightmost hole vertex, connected to an exterior vertex on its right
+  std::size_t m = 0;
+  for ( std::size_t i = 1; i < count; ++i )
+  {
+    if ( hole[i].x > hole[m].x )
+      m = i;
+  }
+
+  const glm::vec2  anchor = hole[m];
+  const glm::vec2& before = hole[ ( m + count - 1 ) % count ];
+  const glm::vec2& after  = hole[ ( m + 1 ) % count ];
+  const std::size_t size  = m_ring.size();
+
+  // Candidates closest first, every copy of a vertex left by previous bridges is a candidate
+  m_candidates.clear();
+
+  for ( std::size_t i = 0; i < size; ++i )
+  {
+    if ( m_ring[i].x >= anchor.x )
+    {
+      const glm::vec2 d = m_ring[i] - anchor;
+      m_candidates.emplace_back( d.x * d.x + d.y * d.y, static_cast<ure::uint_t>(i) );
+    }
+  }
+
+  std::sort( m_candidates.begin(), m_candidates.end() );
+
+  for ( const auto& candidate : m_candidates )
+  {
+    const std::size_t  v      = candidate.second;
+    const glm::vec2    target = m_ring[v];
+
+    // The bridge must leave both rings towards the interior and meet no other edge
+    if ( ( locally_inside( m_ring[ ( v + size - 1 ) % size ], target, m_ring[ ( v + 1 ) % size ], anchor ) == false ) ||
+         ( locally_inside( before, anchor, after, target ) == false ) ||
+         blocked_by_ring( anchor, target, m_ring.data(), size ) || blocked_by_ring( anchor, target, hole, count ) )
+      continue;
+
+    // Exterior up to v, the whole hole from m back to m, then v again and the rest of the exterior
+    m_merged.clear();
+    m_merged.insert( m_merged.end(), m_ring.begin(), m_ring.begin() + v + 1 );
+
+    for ( std::size_t i = 0; i <= count; ++i )
+      m_merged.push_back( hole[ ( m + i ) % count ] );
+
+    m_merged.insert( m_merged.end(), m_ring.begin() + v, m_ring.end() );
+
+    m_ring.swap( m_merged );
+    return;
+  }
+
+  // Not reachable, the hole is filled
+}
+
+ure::bool_t   VectorTessellator::clip( std::vector<glm::vec2>& triangles ) noexcept(true)
+{
+  const ure::uint_t count = static_cast<ure::uint_t>( m_ring.size() );
+
+  m_prev.resize( count );
+  m_next.resize( count );
+
+  for ( ure::uint_t i = 0; i < count; ++i )
+  {
+    m_prev[i] = ( i > 0 ) ? i - 1 : count - 1;
+    m_next[i] = ( i + 1 < count ) ? i + 1 : 0;
+  }
+
+  ure::uint_t  remaining = count;
+  ure::uint_t  vertex    = 0;
+  ure::uint_t  stalled   = 0;       /* Vertices visited since the last one removed */
+  ure::bool_t  forced    = false;   /* No ear left, self intersecting input */
+
+  while ( remaining > 3 )
+  {
+    const ure::uint_t  prev = m_prev[vertex];
+    const ure::uint_t  next = m_next[vertex];
+    const glm::vec2&   a    = m_ring[prev];
+    const glm::vec2&   b    = m_ring[vertex];
+    const glm::vec2&   c    = m_ring[next];
+    const ure::double_t turn = cross( a, b, c );
+
+    // Spikes and repeated points have no area. Straight vertices are kept, the ring may touch
+    // itself there through a bridge, they only go when nothing else can be clipped.
+    const ure::double_t forward = ( ure::double_t(b.x) - a.x ) * ( ure::double_t(c.x) - b.x ) + ( ure::double_t(b.y) - a.y ) * ( ure::double_t(c.y) - b.y );
+
+    ure::bool_t remove = ( a == b ) || ( b == c ) || ( ( turn == 0.0 ) && ( ( forward < 0.0 ) || ( stalled > remaining ) ) );
+    ure::bool_t ear    = false;
+
+    if ( turn > 0.0 )
+    {
+      ear = true;
+
+      for ( ure::uint_t p = m_next[next]; ear && ( p != prev ); p = m_next[p] )
+      {
+        const glm::vec2& point = m_ring[p];
+
+        // Bridges duplicate vertices, copies of the triangle corners do not count
+        if ( ( point != a ) && ( point != b ) && ( point != c ) && in_triangle( a, b, c, point ) )
+          ear = false;
+      }
+
+      ear = ear || ( stalled > remaining );
+    }
+
+    if ( ear )
+    {
+      triangles.push_back( a );
+      triangles.push_back( b );
+      triangles.push_back( c );
+
+      forced = forced || ( stalled > remaining );
+      remove = true;
+    }
+
+    if ( remove )
+    {
+      m_next[prev] = next;
+      m_prev[next] = prev;
+      --remaining;
+
+      vertex  = prev;
+      stalled = 0;
+      continue;
+    }
+
+    vertex = next;
+
+    // Neither an ear nor a convex vertex left, give up on the rest of the polygon
+    if ( ++stalled > 2 * remaining )
+      return false;
+  }
+
+  if ( remaining == 3 )
+  {
+    const ure::uint_t prev = m_prev[vertex];
+    const ure::uint_t next = m_next[vertex];
+
+    if ( cross( m_ring[prev], m_ring[vertex], m_ring[next] ) > 0.0 )
+    {
+      triangles.push_back( m_ring[prev] );
+      triangles.push_back( m_ring[vertex] );
+      triangles.push_back( m_ring[next] );
+    }
+  }
+
+  return forced == false;
+}
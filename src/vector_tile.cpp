@@ -0,0 +1,162 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile.h"
+
+VectorStyle   VectorStyle::basic() noexcept(true)
+{
+  VectorStyle style;
+
+  style.background = glm::vec4( 0.95f, 0.94f, 0.91f, 1.0f );
+  style.rules      = {
+    { "landcover"     , glm::vec4( 0.85f, 0.92f, 0.80f, 1.0f ), 0.0f },
+    { "landuse"       , glm::vec4( 0.92f, 0.90f, 0.86f, 1.0f ), 0.0f },
+    { "park"          , glm::vec4( 0.78f, 0.89f, 0.72f, 1.0f ), 0.0f },
+    { "water"         , glm::vec4( 0.67f, 0.80f, 0.92f, 1.0f ), 0.0f },
+    { "waterway"      , glm::vec4( 0.67f, 0.80f, 0.92f, 1.0f ), 1.5f },
+    { "building"      , glm::vec4( 0.85f, 0.82f, 0.78f, 1.0f ), 0.0f },
+    { "transportation", glm::vec4( 0.72f, 0.70f, 0.67f, 1.0f ), 1.5f },
+    { "road"          , glm::vec4( 0.72f, 0.70f, 0.67f, 1.0f ), 1.5f },
+    { "boundary"      , glm::vec4( 0.60f, 0.50f, 0.65f, 1.0f ), 1.0f },
+    { "admin"         , glm::vec4( 0.60f, 0.50f, 0.65f, 1.0f ), 1.0f }
+  };
+
+  return style;
+}
+
+VectorTileBuilder::VectorTileBuilder( const VectorStyle& style, ure::uint_t tile_pixels ) noexcept(true)
+  : m_style(style), m_tile_pixels( static_cast<ure::float_t>(tile_pixels) ),
+    m_buckets( style.rules.size() ), m_scale(1.0f), m_failures(0)
+{
+}
+
+ure::bool_t   VectorTileBuilder::build( const ure::byte_t* data, std::size_t length, VectorTile& tile ) noexcept(true)
+{
+  tile.vertices.clear();
+  tile.groups.clear();
+
+  for ( std::vector<glm::vec2>& bucket : m_buckets )
+    bucket.clear();
+
+  m_failures = 0;
+
+  if ( m_reader.parse( data, length, *this ) == false )
+    return false;
+
+  std::size_t total = ( m_style.background.a > 0.0f ) ? 6 : 0;
+  for ( const std::vector<glm::vec2>& bucket : m_buckets )
+    total += bucket.size();
+
+  tile.vertices.reserve( total );
+
+  if ( m_style.background.a > 0.0f )
+  {
+    tile.vertices.insert( tile.vertices.end(), { { 0.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 0.0f },
+                                                 { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f } } );
+    tile.groups.push_back( VectorTile::group_t{ m_style.background, 0, 6 } );
+  }
+
+  for ( std::size_t r = 0; r < m_buckets.size(); ++r )
+  {
+    if ( m_buckets[r].empty() )
+      continue;
+
+    tile.groups.push_back( VectorTile::group_t{ m_style.rules[r].color,
+                                                static_cast<ure::uint_t>( tile.vertices.size() ),
+                                                static_cast<ure::uint_t>( m_buckets[r].size() ) } );
+
+    tile.vertices.insert( tile.vertices.end(), m_buckets[r].begin(), m_buckets[r].end() );
+  }
+
+  return true;
+}
+
+ure::void_t   VectorTileBuilder::fill( const MvtReader::feature_t& feature, std::vector<glm::vec2>& triangles ) noexcept(true)
+{
+  // A multi polygon is a sequence of exterior rings, each followed by its holes
+  std::size_t first = 0;
+
+  m_rings.clear();
+
+  for ( std::size_t part = 0; part < feature.parts.size(); ++part )
+  {
+    const ure::uint_t  size     = static_cast<ure::uint_t>( feature.part_size( part ) );
+    const ure::bool_t  exterior = VectorTessellator::area( feature.points.data() + feature.parts[part], size ) > 0.0f;
+
+    if ( exterior && ( m_rings.empty() == false ) )
+    {
+      if ( m_tessellator.fill( feature.points.data() + first, m_rings.data(), m_rings.size(), triangles ) == false )
+        ++m_failures;
+
+      m_rings.clear();
+    }
+
+    if ( m_rings.empty() )
+      first = feature.parts[part];
+
+    m_rings.push_back( size );
+  }
+
+  if ( ( m_rings.empty() == false ) && ( m_tessellator.fill( feature.points.data() + first, m_rings.data(), m_rings.size(), triangles ) == false ) )
+    ++m_failures;
+}
+
+/////////////////////////////////////////////////////
+// MvtReader::Handler implementation
+/////////////////////////////////////////////////////
+
+ure::bool_t   VectorTileBuilder::on_layer( std::string_view name, ure::uint_t extent ) noexcept(true)
+{
+  m_matches.clear();
+
+  for ( std::size_t r = 0; r < m_style.rules.size(); ++r )
+  {
+    if ( m_style.rules[r].layer == name )
+      m_matches.push_back( static_cast<ure::uint_t>(r) );
+  }
+
+  m_scale = 1.0f / static_cast<ure::float_t>(extent);
+
+  return m_matches.empty() == false;
+}
+
+ure::void_t   VectorTileBuilder::on_feature( const MvtReader::feature_t& feature ) noexcept(true)
+{
+  for ( ure::uint_t r : m_matches )
+  {
+    const VectorStyle::rule_t&  rule    = m_style.rules[r];
+    std::vector<glm::vec2>&     bucket  = m_buckets[r];
+    const std::size_t           start   = bucket.size();
+
+    if ( ( rule.width <= 0.0f ) && ( feature.type == MvtReader::geometry_t::polygon ) )
+    {
+      fill( feature, bucket );
+    }
+    else if ( ( rule.width > 0.0f ) && ( feature.type != MvtReader::geometry_t::point ) )
+    {
+      // Width in layer units, the tile spans m_tile_pixels on screen
+      const ure::float_t width  = rule.width / ( m_tile_pixels * m_scale );
+      const ure::bool_t  closed = ( feature.type == MvtReader::geometry_t::polygon );
+
+      for ( std::size_t part = 0; part < feature.parts.size(); ++part )
+        m_tessellator.stroke( feature.points.data() + feature.parts[part], feature.part_size( part ), width, closed, bucket );
+    }
+
+    // Layers may have different extents, vertices leave the builder in tile units
+    for ( std::size_t i = start; i < bucket.size(); ++i )
+      bucket[i] *= m_scale;
+  }
+}
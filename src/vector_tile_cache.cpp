@@ -0,0 +1,60 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile_cache.h"
+
+VectorTileCache::VectorTileCache( std::size_t budget ) noexcept(true)
+  : m_entries( budget, release_t{} )
+{
+}
+
+VectorTileCache::~VectorTileCache() noexcept(true)
+{
+  dispose();
+}
+
+ure::bool_t   VectorTileCache::insert( const TileKey& key, const VectorTile& tile ) noexcept(true)
+{
+  if ( contains( key ) )
+    return false;
+
+  buffer_t buffer{ 0, static_cast<ure::uint_t>( tile.vertices.size() ), tile.groups };
+
+  // Static geometry, written once and drawn until evicted
+  if ( tile.vertices.empty() == false )
+  {
+    glGenBuffers( 1, &buffer.vbo );
+    glBindBuffer( GL_ARRAY_BUFFER, buffer.vbo );
+    glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( tile.bytes() ), tile.vertices.data(), GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    if ( glGetError() == GL_OUT_OF_MEMORY )
+    {
+      glDeleteBuffers( 1, &buffer.vbo );
+      return false;
+    }
+  }
+
+  const std::size_t bytes = tile.bytes() + tile.groups.size() * sizeof(VectorTile::group_t);
+
+  if ( m_entries.insert( key, std::move(buffer), bytes ) == false )
+  {
+    release_t()( buffer );
+    return false;
+  }
+
+  return true;
+}
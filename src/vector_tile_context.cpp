@@ -0,0 +1,36 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile_context.h"
+
+VectorTileContext::VectorTileContext( ure::uint_t tile_pixels, std::size_t cache_budget, RedrawSignal& redraw, const VectorStyle& style ) noexcept(true)
+  : m_tile_pixels(tile_pixels), m_style(style), m_redraw(redraw), m_cache( cache_budget ), m_scheduler( m_requests ),
+    m_decoder( m_cache, m_requests, m_disk, m_redraw, m_style, tile_pixels )
+{
+}
+
+ure::bool_t   VectorTileContext::initialize( const std::string& shaders_path, const std::string& cache_path ) noexcept(true)
+{
+  m_renderer.set_shaders_path( shaders_path );
+
+  return m_disk.open( cache_path );
+}
+
+ure::void_t   VectorTileContext::dispose() noexcept(true)
+{
+  m_renderer.dispose();
+  m_cache.dispose();
+}
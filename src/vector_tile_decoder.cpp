@@ -0,0 +1,102 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile_decoder.h"
+#include "metrics.h"
+
+#include <limits>
+#include <memory>
+
+VectorTileDecoder::VectorTileDecoder( VectorTileCache& cache, TileRequests& requests, TileDiskCache& disk, RedrawSignal& redraw,
+                                      const VectorStyle& style, ure::uint_t tile_pixels, ure::uint_t workers ) noexcept(true)
+  : m_cache(cache), m_disk(disk), m_style(style), m_tile_pixels(tile_pixels),
+    m_workers( requests, redraw,
+               [this]() -> workers_t::process_t
+               {
+                 // Parser and tessellator buffers grow to the largest tile seen by this thread
+                 auto builder = std::make_shared<VectorTileBuilder>( m_style, m_tile_pixels );
+
+                 return [this, builder]( job_t& job, built_t& built ) { return build( *builder, job, built ); };
+               },
+               workers )
+{
+}
+
+VectorTileDecoder::~VectorTileDecoder() noexcept(true)
+{
+}
+
+ure::void_t   VectorTileDecoder::submit( const TileKey& key, const ure::byte_t* data, ure::uint_t length ) noexcept(true)
+{
+  auto copy = std::make_shared<std::vector<ure::byte_t>>( data, data + length );
+
+  TileDiskCache::blob_t blob{ copy, copy->data(), length };
+
+  m_workers.enqueue( job_t{ key, std::move(blob), true } );
+}
+
+ure::void_t   VectorTileDecoder::submit( const TileKey& key, TileDiskCache::blob_t&& blob ) noexcept(true)
+{
+  m_workers.enqueue( job_t{ key, std::move(blob), false } );
+}
+
+ure::uint_t   VectorTileDecoder::upload( ure::uint_t max_count, clock_t::duration budget ) noexcept(true)
+{
+  return m_workers.drain( max_count, budget, std::numeric_limits<std::size_t>::max(), [this]( built_t& built, std::size_t& )
+  {
+    if ( m_cache.contains( built.key ) )
+      return workers_t::upload_t::cached;
+
+    // Out of GPU memory
+    if ( m_cache.insert( built.key, built.tile ) == false )
+      return workers_t::upload_t::failed;
+
+    return workers_t::upload_t::uploaded;
+  } );
+}
+
+ure::uint_t   VectorTileDecoder::pending() const noexcept(true)
+{
+  return m_workers.pending();
+}
+
+ure::uint_t   VectorTileDecoder::ready() const noexcept(true)
+{
+  return m_workers.ready();
+}
+
+ure::bool_t   VectorTileDecoder::build( VectorTileBuilder& builder, job_t& job, built_t& built ) noexcept(true)
+{
+  ure::bool_t valid = false;
+
+  {
+    MAP_METRICS_SCOPE( decode );
+
+    valid = builder.build( job.blob.data, job.blob.length, built.tile );
+  }
+
+  if ( valid && job.persist )
+  {
+    m_disk.store( job.key, job.blob.data, job.blob.length );
+  }
+  else if ( ( valid == false ) && ( job.persist == false ) )
+  {
+    // Corrupted cache entry, next attempt goes to the network
+    m_disk.erase( job.key );
+  }
+
+  return valid;
+}
@@ -0,0 +1,34 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile_layer.h"
+
+VectorTileLayer::VectorTileLayer( ure::ViewPort& rViewPort, VectorTileContext& tiles, ure::word_t zoom, const std::string& url ) noexcept(true)
+  : ure::widgets::Layer( rViewPort ), VectorTileLevel( tiles, zoom, url )
+{
+}
+
+VectorTileLayer::~VectorTileLayer() noexcept(true)
+{
+
+}
+
+bool     VectorTileLayer::on_widget_draw( [[maybe_unused]] const ure::Recti& rect ) noexcept(true) 
+{ 
+  VectorTileLevel::draw();
+
+  return true; 
+}
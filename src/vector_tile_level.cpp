@@ -0,0 +1,222 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+#include "vector_tile_level.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+VectorTileLevel::VectorTileLevel( VectorTileContext& tiles, ure::word_t zoom, const std::string& url ) noexcept(true)
+  : m_tiles(tiles), m_extent( static_cast<ure::float_t>( tiles.tile_pixels() ) ),
+    m_zoom_level( zoom ), m_max_tiles( 1u << zoom ),
+    m_url(url), m_model(1.0f), m_viewport{0,0}, m_origin(0.0f), m_margin(1), m_fallback_levels(3)
+{
+}
+
+VectorTileLevel::~VectorTileLevel() noexcept(true)
+{
+
+}
+
+ure::void_t  VectorTileLevel::set_zoom( ure::word_t zoom ) noexcept(true)
+{
+  m_zoom_level = zoom;
+  m_max_tiles  = 1u << zoom;
+}
+
+ure::void_t  VectorTileLevel::set_view( const glm::mat4& model, const ure::Size& viewport ) noexcept(true)
+{
+  m_model    = model;
+  m_viewport = viewport;
+}
+
+TileRange    VectorTileLevel::visible_range() const noexcept(true)
+{
+  return visible_tile_range( m_model, m_viewport, m_origin, m_extent, m_max_tiles, m_margin );
+}
+
+glm::mat4    VectorTileLevel::tile_mvp( const glm::vec2& position, ure::float_t scale ) const noexcept(true)
+{
+  // Projection and camera view are identity (see Map::init()), model matrix is the full MVP
+  const glm::vec2 corner = m_origin + m_extent * position;
+  const glm::vec2 size   = m_extent * scale;
+
+  return glm::scale( glm::translate( m_model, glm::vec3( corner, 0.0f ) ), glm::vec3( size.x, size.y, 1.0f ) );
+}
+
+VectorTileLevel::stats_t  VectorTileLevel::draw( ure::float_t opacity ) noexcept(true)
+{
+  stats_t         stats{ 0, 0, 0 };
+  const TileRange range = visible_range();
+
+  if ( range.empty() || ( m_tiles.renderer().begin() == false ) )
+    return stats;
+
+  VectorTileCache&  cache    = m_tiles.cache();
+  VectorRenderer&   renderer = m_tiles.renderer();
+
+  // Tiles closer to the centre of the viewport are downloaded first
+  const glm::vec2 centre = glm::vec2( range.x0 + range.x1, range.y0 + range.y1 ) * 0.5f;
+
+  m_drawn.clear();
+  m_ancestors.clear();
+
+  // Ancestors are drawn while walking the range, tiles of this level and children afterwards on top of them
+  for ( ure::int_t y = range.y0; y <= range.y1; ++y )
+  {
+    for ( ure::int_t x = range.x0; x <= range.x1; ++x )
+    {
+      const TileKey key{ static_cast<ure::uint_t>(m_zoom_level), static_cast<ure::uint_t>(x), static_cast<ure::uint_t>(y) };
+
+      const VectorTileCache::buffer_t* buffer = cache.find( key );
+
+      if ( buffer == nullptr )
+      {
+        request_tile( key, glm::length( glm::vec2( x, y ) - centre ) );
+
+        add_fallback( key, opacity, stats );
+        continue;
+      }
+
+      m_drawn.push_back( drawn_t{ buffer, glm::vec2( x, y ), 1.0f } );
+      ++stats.tiles;
+    }
+  }
+
+  for ( const drawn_t& drawn : m_drawn )
+    stats.draw_calls += renderer.draw( *drawn.buffer, tile_mvp( drawn.position, drawn.scale ), opacity );
+
+  renderer.end();
+
+  return stats;
+}
+
+ure::bool_t  VectorTileLevel::request_tile( const TileKey& key, ure::float_t distance ) noexcept(true)
+{
+  // Already queued, in flight or waiting for the retry delay after a failure.
+  // A queued tile must be touched every frame, otherwise the scheduler drops it.
+  if ( m_tiles.requests().acquire( key ) == false )
+  {
+    m_tiles.scheduler().touch( key, distance, false );
+    return false;
+  }
+
+  // Tiles already seen in previous runs are parsed again, geometry is not persisted
+  std::optional<TileDiskCache::blob_t> blob = m_tiles.disk().find( key );
+  if ( blob.has_value() )
+  {
+    m_tiles.decoder().submit( key, std::move(blob.value()) );
+    return true;
+  }
+
+  // Name and URL are generated by the scheduler when the download is dispatched
+  m_tiles.scheduler().queue( key, m_url, distance, false, *this );
+
+  return true;
+}
+
+ure::bool_t  VectorTileLevel::add_fallback( const TileKey& key, ure::float_t opacity, stats_t& stats ) noexcept(true)
+{
+  VectorTileCache&  cache = m_tiles.cache();
+
+  // Children are sharper, they are typically available right after zooming out.
+  // All four are required, the background of a single child would hide an ancestor.
+  if ( ( m_fallback_levels > 0 ) && ( key.z + 1 < 32 ) )
+  {
+    const VectorTileCache::buffer_t* children[4];
+    ure::bool_t                      complete = true;
+
+    for ( ure::uint_t i = 0; ( i < 4 ) && complete; ++i )
+    {
+      children[i] = cache.find_resident( TileKey{ key.z + 1, key.x * 2 + ( i & 1 ), key.y * 2 + ( i >> 1 ) } );
+      complete    = ( children[i] != nullptr );
+    }
+
+    if ( complete )
+    {
+      for ( ure::uint_t i = 0; i < 4; ++i )
+        m_drawn.push_back( drawn_t{ children[i], glm::vec2( key.x + ( i & 1 ) * 0.5f, key.y + ( i >> 1 ) * 0.5f ), 0.5f } );
+
+      stats.fallbacks += 4;
+      return true;
+    }
+  }
+
+  // Nearest loaded ancestor, drawn once even if it covers several missing tiles
+  for ( ure::uint_t k = 1; ( k <= m_fallback_levels ) && ( k <= key.z ); ++k )
+  {
+    const TileKey parent{ key.z - k, key.x >> k, key.y >> k };
+
+    if ( std::find( m_ancestors.begin(), m_ancestors.end(), parent ) != m_ancestors.end() )
+      return true;
+
+    const VectorTileCache::buffer_t* buffer = cache.find_resident( parent );
+
+    if ( buffer == nullptr )
+      continue;
+
+    const ure::float_t scale = static_cast<ure::float_t>( 1u << k );
+
+    m_ancestors.push_back( parent );
+
+    stats.draw_calls += m_tiles.renderer().draw( *buffer, tile_mvp( glm::vec2( parent.x, parent.y ) * scale, scale ), opacity );
+    ++stats.fallbacks;
+
+    return true;
+  }
+
+  return false;
+}
+
+/////////////////////////////////////////////////////
+// ure::ResourcesFetcherEvents implementation
+/////////////////////////////////////////////////////
+
+ure::void_t VectorTileLevel::on_download_succeeded( [[maybe_unused]] std::string_view name, [[maybe_unused]] const std::type_info& type, [[maybe_unused]] const ure::byte_t* data, [[maybe_unused]] ure::uint_t length ) noexcept(true)
+{
+  std::optional<TileKey> key = TileKey::parse( name );
+
+  // Not a tile name, nothing has been acquired for it
+  if ( key.has_value() == false )
+    return;
+
+  m_tiles.scheduler().completed( key.value() );
+  m_tiles.redraw().request();
+
+  // Payload is handed over as it was received whatever the resource type, the scheduler
+  // tags every download as a texture
+  if ( m_tiles.cache().contains( key.value() ) == false )
+  {
+    // Request stays pending until the tile geometry is uploaded
+    m_tiles.decoder().submit( key.value(), data, length );
+    return;
+  }
+
+  m_tiles.requests().succeeded( key.value() );
+}
+
+ure::void_t VectorTileLevel::on_download_failed   ( [[maybe_unused]] std::string_view name ) noexcept(true)
+{
+  std::optional<TileKey> key = TileKey::parse( name );
+
+  if ( key.has_value() == false )
+    return;
+
+  m_tiles.scheduler().completed( key.value() );
+  m_tiles.requests().failed( key.value() );
+  m_tiles.redraw().request();
+}
@@ -0,0 +1,175 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * InputAccumulator: drag and wheel events summed per frame, momentum after a release
+ * independent of the frame rate, and no momentum when the cursor stopped first.
+ */
+
+#include "test.h"
+
+#include "input_accumulator.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+  using namespace std::chrono_literals;
+
+  using clock_t = InputAccumulator::clock_t;
+
+  ure::bool_t  near( ure::float_t a, ure::float_t b, ure::float_t epsilon )
+  { return std::abs( a - b ) <= epsilon; }
+
+  /**
+   * Drag at @p speed pixels per second for @p duration, one event per millisecond and
+   * a frame every 16 ms. Return the time of the last frame and the pan of all frames.
+   */
+  clock_t::time_point  drag( InputAccumulator& input, clock_t::time_point now, const glm::vec2& speed, clock_t::duration duration, glm::vec2& moved )
+  {
+    InputAccumulator::frame_t frame;
+
+    input.grab( now );
+    moved = glm::vec2( 0.0f );
+
+    for ( clock_t::duration t = 1ms; t <= duration; t += 1ms )
+    {
+      input.pan( speed * 0.001f, now + t );
+
+      if ( ( t % 16ms == 0ms ) || ( t == duration ) )
+      {
+        if ( input.take( now + t, frame ) )
+          moved += frame.pan;
+      }
+    }
+
+    return now + duration;
+  }
+
+  void  test_sum()
+  {
+    InputAccumulator          input;
+    InputAccumulator::frame_t frame;
+    const clock_t::time_point now = clock_t::now();
+
+    CHECK( input.take( now, frame ) == false );
+
+    input.grab( now );
+    input.pan( glm::vec2( 3.0f, 0.0f ), now );
+    input.pan( glm::vec2( 2.0f, 1.0f ), now );
+    input.scroll( 1.0f, glm::vec2( 10.0f, 20.0f ) );
+    input.scroll( 0.5f, glm::vec2( 30.0f, 40.0f ) );
+
+    CHECK( input.take( now + 1ms, frame ) );
+    CHECK( frame.pan == glm::vec2( 5.0f, 1.0f ) );
+    CHECK( frame.notches == 1.5f );
+    CHECK( frame.anchor == glm::vec2( 30.0f, 40.0f ) );
+
+    // Totals are taken once, holding the button does not move the map
+    CHECK( input.take( now + 2ms, frame ) == false );
+    CHECK( frame.notches == 0.0f );
+    CHECK( input.coasting() == false );
+  }
+
+  void  test_momentum()
+  {
+    const ure::float_t        tau = 0.325f;
+    InputAccumulator          input( tau, 20.0f );
+    InputAccumulator::frame_t frame;
+    clock_t::time_point       now = clock_t::now();
+
+    glm::vec2  moved;
+
+    now = drag( input, now, glm::vec2( 1000.0f, 0.0f ), 160ms, moved );
+
+    CHECK( near( moved.x, 160.0f, 1e-2f ) && ( moved.y == 0.0f ) );
+
+    input.release( now );
+
+    // Velocity averaged over the last frames of the drag
+    CHECK( input.coasting() );
+    CHECK( near( input.velocity().x, 1000.0f, 50.0f ) );
+
+    const ure::float_t  velocity = input.velocity().x;
+
+    // Total distance is velocity * tau, whatever the frame rate
+    ure::float_t  travelled = 0.0f;
+
+    for ( ure::uint_t i = 1; ( i < 600 ) && input.coasting(); ++i )
+    {
+      CHECK( input.take( now + i * 16667us, frame ) );
+      CHECK( frame.pan.y == 0.0f );
+
+      travelled += frame.pan.x;
+    }
+
+    CHECK( input.coasting() == false );
+    CHECK( near( travelled, velocity * tau, velocity * tau * 0.03f ) );
+    CHECK( input.take( now + 20s, frame ) == false );
+
+    // Same throw taken at 30 Hz
+    InputAccumulator  slow( tau, 20.0f );
+
+    now = drag( slow, now, glm::vec2( 1000.0f, 0.0f ), 160ms, moved );
+    slow.release( now );
+
+    ure::float_t  slow_travelled = 0.0f;
+
+    for ( ure::uint_t i = 1; ( i < 300 ) && slow.coasting(); ++i )
+    {
+      slow.take( now + i * 33333us, frame );
+      slow_travelled += frame.pan.x;
+    }
+
+    CHECK( near( slow_travelled, travelled, travelled * 0.02f ) );
+
+    // Grabbing the map stops the momentum
+    now = drag( slow, now + 10s, glm::vec2( 0.0f, 500.0f ), 160ms, moved );
+    slow.release( now );
+    CHECK( slow.coasting() );
+
+    slow.grab( now + 16ms );
+    CHECK( slow.coasting() == false );
+    CHECK( slow.take( now + 32ms, frame ) == false );
+  }
+
+  void  test_stopped()
+  {
+    InputAccumulator          input;
+    InputAccumulator::frame_t frame;
+    clock_t::time_point       now = clock_t::now();
+    glm::vec2                 moved;
+
+    now = drag( input, now, glm::vec2( 1000.0f, 0.0f ), 160ms, moved );
+
+    // Cursor stood still before the release, the map stays where it is
+    input.take( now + 100ms, frame );
+    input.release( now + 100ms );
+
+    CHECK( input.coasting() == false );
+    CHECK( input.take( now + 200ms, frame ) == false );
+  }
+}
+
+int main()
+{
+  test_sum();
+  test_momentum();
+  test_stopped();
+
+  return test_result( "input_accumulator_test" );
+}
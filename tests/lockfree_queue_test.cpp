@@ -0,0 +1,126 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * LockFreeQueue: capacity, FIFO order, full and empty queues, and no item lost or
+ * duplicated with several producers and consumers.
+ */
+
+#include "test.h"
+
+#include "lockfree_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  void  test_single_thread()
+  {
+    LockFreeQueue<int>  queue( 5 );
+    int                 value = 0;
+
+    CHECK( queue.capacity() == 8 );
+    CHECK( queue.try_pop( value ) == false );
+
+    for ( int i = 0; i < 8; ++i )
+      CHECK( queue.try_push( int(i) ) );
+
+    CHECK( queue.try_push( 8 ) == false );
+    CHECK( queue.size() == 8 );
+
+    for ( int i = 0; i < 8; ++i )
+    {
+      CHECK( queue.try_pop( value ) );
+      CHECK( value == i );
+    }
+
+    CHECK( queue.try_pop( value ) == false );
+
+    // Cursors wrap around the cells
+    for ( int lap = 0; lap < 100; ++lap )
+    {
+      CHECK( queue.try_push( int(lap) ) );
+      CHECK( queue.try_pop( value ) && ( value == lap ) );
+    }
+  }
+
+  void  test_threads()
+  {
+    constexpr int           producers = 4;
+    constexpr int           consumers = 4;
+    constexpr std::uint64_t items     = 100000;
+
+    LockFreeQueue<std::uint64_t>  queue( 256 );
+    std::atomic<std::uint64_t>    popped( 0 );
+    std::atomic<std::uint64_t>    sum( 0 );
+    std::vector<std::thread>      threads;
+
+    for ( int p = 0; p < producers; ++p )
+    {
+      threads.emplace_back( [&queue, p]()
+      {
+        for ( std::uint64_t i = 0; i < items; ++i )
+        {
+          std::uint64_t value = p * items + i + 1;
+
+          while ( queue.try_push( std::move(value) ) == false )
+            std::this_thread::yield();
+        }
+      } );
+    }
+
+    for ( int c = 0; c < consumers; ++c )
+    {
+      threads.emplace_back( [&queue, &popped, &sum]()
+      {
+        std::uint64_t value = 0;
+
+        while ( popped.load() < producers * items )
+        {
+          if ( queue.try_pop( value ) )
+          {
+            sum += value;
+            ++popped;
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+        }
+      } );
+    }
+
+    for ( auto& thread : threads )
+      thread.join();
+
+    const std::uint64_t count = producers * items;
+
+    CHECK( popped.load() == count );
+    CHECK( sum.load() == count * ( count + 1 ) / 2 );
+    CHECK( queue.size() == 0 );
+  }
+}
+
+int main()
+{
+  test_single_thread();
+  test_threads();
+
+  return test_result( "lockfree_queue_test" );
+}
@@ -0,0 +1,156 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * LruCache: LRU order, budget, entries used in the current frame kept over budget,
+ * release hook and statistics.
+ */
+
+#include "test.h"
+
+#include "lru_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+  /** Record the released payloads */
+  struct release_t
+  {
+    std::vector<int>*  released;
+
+    void  operator()( int value ) const noexcept
+    { released->push_back( value ); }
+  };
+
+  using cache_t = LruCache<int, release_t>;
+
+  ure::bool_t  released( const std::vector<int>& values, int value )
+  { return std::find( values.begin(), values.end(), value ) != values.end(); }
+
+  void  test_lru_order()
+  {
+    std::vector<int>  values;
+    cache_t           cache( 3, release_t{ &values } );
+
+    CHECK( cache.insert( TileKey{ 1, 0, 0 }, 10, 1 ) );
+    CHECK( cache.insert( TileKey{ 1, 1, 0 }, 11, 1 ) );
+    CHECK( cache.insert( TileKey{ 1, 0, 1 }, 12, 1 ) );
+    CHECK( cache.insert( TileKey{ 1, 0, 0 }, 13, 1 ) == false );
+
+    cache.begin_frame();
+
+    // Oldest entry used again, the second one becomes the least recently used
+    const int* value = cache.find( TileKey{ 1, 0, 0 } );
+
+    CHECK( ( value != nullptr ) && ( *value == 10 ) );
+    CHECK( cache.insert( TileKey{ 1, 1, 1 }, 14, 1 ) );
+
+    CHECK( values.size() == 1 );
+    CHECK( released( values, 11 ) );
+    CHECK( cache.contains( TileKey{ 1, 1, 0 } ) == false );
+    CHECK( cache.contains( TileKey{ 1, 0, 0 } ) );
+    CHECK( cache.find( TileKey{ 1, 1, 0 } ) == nullptr );
+
+    const cache_t::stats_t stats = cache.stats();
+
+    CHECK( stats.hits == 1 );
+    CHECK( stats.misses == 1 );
+    CHECK( stats.evictions == 1 );
+    CHECK( stats.entries == 3 );
+    CHECK( stats.bytes == 3 );
+  }
+
+  void  test_current_frame()
+  {
+    std::vector<int>  values;
+    cache_t           cache( 2, release_t{ &values } );
+
+    // Entries used in this frame are still visible, the cache grows over budget
+    for ( ure::uint_t x = 0; x < 4; ++x )
+      CHECK( cache.insert( TileKey{ 2, x, 0 }, static_cast<int>(x), 1 ) );
+
+    CHECK( values.empty() );
+    CHECK( cache.stats().bytes == 4 );
+
+    // Next frame releases the entries over budget
+    cache.begin_frame();
+    CHECK( values.size() == 2 );
+
+    // Fallback lookups do not count misses
+    CHECK( cache.find_resident( TileKey{ 2, 9, 9 } ) == nullptr );
+    CHECK( cache.stats().misses == 0 );
+    CHECK( cache.stats().bytes == 2 );
+  }
+
+  void  test_evict_level_and_clear()
+  {
+    std::vector<int>  values;
+    cache_t           cache( 100, release_t{ &values } );
+
+    CHECK( cache.insert( TileKey{ 3, 0, 0 }, 30, 10 ) );
+    CHECK( cache.insert( TileKey{ 4, 0, 0 }, 40, 10 ) );
+    CHECK( cache.insert( TileKey{ 4, 1, 0 }, 41, 10 ) );
+
+    // Used in the current frame, kept
+    cache.evict_level( 4 );
+    CHECK( values.empty() );
+
+    cache.begin_frame();
+    cache.find( TileKey{ 4, 1, 0 } );
+    cache.evict_level( 4 );
+
+    CHECK( values.size() == 1 );
+    CHECK( released( values, 40 ) );
+    CHECK( cache.contains( TileKey{ 3, 0, 0 } ) );
+
+    // Smaller budget releases what is not used in the current frame
+    values.clear();
+    cache.set_budget( 5 );
+    CHECK( cache.budget() == 5 );
+    CHECK( released( values, 30 ) );
+    CHECK( cache.contains( TileKey{ 4, 1, 0 } ) );
+
+    values.clear();
+    cache.clear();
+    CHECK( released( values, 41 ) );
+    CHECK( cache.stats().entries == 0 );
+    CHECK( cache.stats().bytes == 0 );
+  }
+
+  void  test_sources()
+  {
+    std::vector<int>  values;
+    cache_t           cache( 100, release_t{ &values } );
+
+    // Same tile of two stacked sources
+    CHECK( cache.insert( TileKey{ 5, 3, 4, 0 }, 1, 1 ) );
+    CHECK( cache.insert( TileKey{ 5, 3, 4, 1 }, 2, 1 ) );
+    CHECK( *cache.find( TileKey{ 5, 3, 4, 1 } ) == 2 );
+    CHECK( *cache.find( TileKey{ 5, 3, 4, 0 } ) == 1 );
+  }
+}
+
+int main()
+{
+  test_lru_order();
+  test_current_frame();
+  test_evict_level_and_clear();
+  test_sources();
+
+  return test_result( "lru_cache_test" );
+}
@@ -0,0 +1,176 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * MapView: centre and pan in double, local origins, projection of level pixels to the
+ * window at deep levels, zoom animation around its anchor and the levels to draw.
+ */
+
+#include "test.h"
+
+#include "map_view.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+  using namespace std::chrono_literals;
+
+  const ure::Size  k_size = { 1024, 768 };
+
+  ure::bool_t  near( ure::double_t a, ure::double_t b, ure::double_t epsilon )
+  { return std::abs( a - b ) <= epsilon; }
+
+  /** Window position of @p pixel of level @p zl, counted from tile (0,0), as drawn */
+  glm::vec2  window( const MapView& view, ure::int_t zl, const glm::dvec2& pixel )
+  {
+    // Layers add origin() to the position of their tiles, the vertices stay small
+    const glm::vec2  local = glm::vec2( pixel + glm::dvec2( view.origin( zl ) ) );
+    const glm::vec4  clip  = view.level_model( zl ) * glm::vec4( local.x, local.y, 0.0f, 1.0f );
+
+    return glm::vec2( ( clip.x / clip.w + 1.0f ) / 2.0f * k_size.width, ( 1.0f - clip.y / clip.w ) / 2.0f * k_size.height );
+  }
+
+  void  test_reset()
+  {
+    MapView  view( 19 );
+
+    view.reset( k_size, 3 );
+
+    CHECK( view.zoom() == 3.0f );
+    CHECK( view.animating() == false );
+
+    // Tile (0,0) at the top left corner of the window
+    CHECK( view.centre() == glm::dvec2( 512.0, 384.0 ) );
+
+    const glm::vec2 corner = window( view, 3, glm::dvec2( 0.0 ) );
+
+    CHECK( near( corner.x, 0.0, 1e-3 ) && near( corner.y, 0.0, 1e-3 ) );
+
+    const MapView::levels_t levels = view.levels();
+
+    CHECK( ( levels.lower == 3 ) && ( levels.upper == 4 ) && ( levels.draw == 3 ) && ( levels.current == 3 ) && ( levels.fade == 0.0f ) );
+
+    // Levels are clamped
+    view.reset( k_size, 40 );
+    CHECK( view.zoom() == 18.0f );
+    CHECK( view.levels().upper == 18 );
+  }
+
+  void  test_pan()
+  {
+    MapView  view( 19 );
+
+    view.reset( k_size, 5 );
+    view.pan( glm::vec2( 10.0f, -20.0f ) );
+
+    // Map follows the cursor
+    CHECK( view.centre() == glm::dvec2( 502.0, 404.0 ) );
+
+    const glm::vec2 corner = window( view, 5, glm::dvec2( 0.0 ) );
+
+    CHECK( near( corner.x, 10.0, 1e-3 ) && near( corner.y, -20.0, 1e-3 ) );
+  }
+
+  void  test_deep_levels()
+  {
+    MapView  view( 20 );
+
+    view.reset( k_size, 18 );
+
+    // Level 18 is 2^26 pixels wide, float steps are 4 pixels at its far end
+    const ure::double_t  world = std::ldexp( 256.0, 18 );
+    const glm::dvec2     point( world * 0.987654321, world * 0.123456789 );
+
+    view.centre_on( point );
+
+    CHECK( view.centre() == point );
+
+    // Local origins are tile aligned and close to the centre
+    const glm::vec2 origin = view.origin( 18 );
+
+    CHECK( std::fmod( origin.x, MapView::local_extent() ) == 0.0f );
+    CHECK( std::fmod( origin.y, MapView::local_extent() ) == 0.0f );
+    CHECK( ( point.x + origin.x >= 0.0 ) && ( point.x + origin.x < MapView::local_extent() ) );
+
+    const glm::vec2 centre = window( view, 18, point );
+
+    CHECK( near( centre.x, 512.0, 1e-2 ) && near( centre.y, 384.0, 1e-2 ) );
+
+    // Small pans add up exactly instead of being lost in float rounding
+    for ( ure::uint_t i = 0; i < 100; ++i )
+      view.pan( glm::vec2( -1.0f, 0.25f ) );
+
+    CHECK( near( view.centre().x - point.x, 100.0, 1e-6 ) );
+    CHECK( near( view.centre().y - point.y, -25.0, 1e-6 ) );
+
+    const glm::vec2 moved = window( view, 18, point );
+
+    CHECK( near( moved.x, 412.0, 1e-2 ) && near( moved.y, 409.0, 1e-2 ) );
+  }
+
+  void  test_zoom()
+  {
+    MapView                             view( 19, 1.0f, 0.08f );
+    const MapView::clock_t::time_point  start = MapView::clock_t::now();
+
+    view.reset( k_size, 4 );
+
+    const glm::vec2   anchor( 100.0f, -50.0f );
+    const glm::dvec2  under = view.centre() + glm::dvec2( anchor );
+
+    CHECK( view.zoom_by( 1.0f, anchor, start ) );
+    CHECK( view.target() == 5.0f );
+    CHECK( view.animating() );
+
+    // Half way, both levels drawn
+    CHECK( view.animate( start + 56ms ) );
+    CHECK( ( view.zoom() > 4.25f ) && ( view.zoom() < 4.75f ) );
+    CHECK( ( view.levels().fade > 0.0f ) && ( view.levels().fade < 1.0f ) );
+
+    view.animate( start + 2s );
+
+    CHECK( view.zoom() == 5.0f );
+    CHECK( view.animating() == false );
+    CHECK( view.animate( start + 3s ) == false );
+    CHECK( view.levels().current == 5 );
+
+    // The point under the anchor did not move
+    const glm::dvec2 still = view.centre() + glm::dvec2( anchor );
+
+    CHECK( near( still.x, under.x * 2.0, 1e-3 ) && near( still.y, under.y * 2.0, 1e-3 ) );
+
+    const glm::vec2 drawn = window( view, 5, under * 2.0 );
+
+    CHECK( near( drawn.x, 612.0, 1e-2 ) && near( drawn.y, 334.0, 1e-2 ) );
+
+    // Target clamped to the levels
+    CHECK( view.zoom_by( 40.0f, anchor, start ) );
+    CHECK( view.target() == 18.0f );
+    CHECK( view.zoom_by( 1.0f, anchor, start ) == false );
+  }
+}
+
+int main()
+{
+  test_reset();
+  test_pan();
+  test_deep_levels();
+  test_zoom();
+
+  return test_result( "map_view_test" );
+}
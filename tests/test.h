@@ -0,0 +1,52 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+#ifndef TEST_H
+#define TEST_H
+
+#include <cstdio>
+
+/**
+ * Minimal checks for the unit tests registered with ctest.
+ *
+ * A failed CHECK() prints its location and the test keeps going, main() returns
+ * test_result() so that ctest reports the test as failed.
+ */
+inline int&  test_failures() noexcept
+{
+  static int failures = 0;
+
+  return failures;
+}
+
+/***/
+inline int   test_result( const char* name ) noexcept
+{
+  std::printf( "%s: %s, %d failed checks\n", name, ( test_failures() == 0 ) ? "passed" : "FAILED", test_failures() );
+
+  return ( test_failures() == 0 ) ? 0 : 1;
+}
+
+#define CHECK( ... )                                                                    \
+  do                                                                                    \
+  {                                                                                     \
+    if ( !( __VA_ARGS__ ) )                                                             \
+    {                                                                                   \
+      std::printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #__VA_ARGS__ );   \
+      ++test_failures();                                                                \
+    }                                                                                   \
+  } while ( false )
+
+#endif // TEST_H
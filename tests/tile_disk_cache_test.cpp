@@ -0,0 +1,211 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * TileDiskCache: payloads and formats read back, newer entries replacing older ones,
+ * tombstones surviving a reopen, pack rolling and the size cap.
+ */
+
+#include "test.h"
+
+#include "tile_disk_cache.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+  /** Empty directory removed with its content on destruction */
+  class TempDir
+  {
+  public:
+    TempDir( const char* name )
+      : m_path( std::filesystem::temp_directory_path() / ( std::string(name) + "-" + std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() ) ) )
+    {
+      std::error_code ec;
+
+      std::filesystem::remove_all( m_path, ec );
+      std::filesystem::create_directories( m_path, ec );
+    }
+
+    ~TempDir()
+    {
+      std::error_code ec;
+
+      std::filesystem::remove_all( m_path, ec );
+    }
+
+    const std::filesystem::path&  path() const noexcept
+    { return m_path; }
+
+  private:
+    const std::filesystem::path   m_path;
+  };
+
+  std::vector<ure::byte_t>  payload( ure::uint_t length, ure::byte_t seed )
+  {
+    std::vector<ure::byte_t> data( length );
+
+    for ( ure::uint_t i = 0; i < length; ++i )
+      data[i] = static_cast<ure::byte_t>( seed + i * 7 );
+
+    return data;
+  }
+
+  ure::bool_t  holds( TileDiskCache& cache, const TileKey& key, const std::vector<ure::byte_t>& data )
+  {
+    const std::optional<TileDiskCache::blob_t> blob = cache.find( key );
+
+    return blob.has_value() && ( blob->length == data.size() ) && ( std::memcmp( blob->data, data.data(), data.size() ) == 0 );
+  }
+
+  void  test_store_find()
+  {
+    TempDir        dir( "map-disk-cache-test" );
+    TileDiskCache  cache;
+
+    CHECK( cache.is_open() == false );
+    CHECK( cache.store( TileKey{ 1, 0, 0 }, payload( 10, 1 ).data(), 10 ) == false );
+
+    CHECK( cache.open( dir.path() ) );
+    CHECK( cache.is_open() );
+
+    const std::vector<ure::byte_t>  a = payload( 100, 1 );
+    const std::vector<ure::byte_t>  b = payload( 200, 2 );
+    const std::vector<ure::byte_t>  c = payload( 300, 3 );
+
+    CHECK( cache.store( TileKey{ 3, 1, 2 }, a.data(), 100 ) );
+    CHECK( cache.store( TileKey{ 3, 1, 2, 1 }, b.data(), 200, TileImage::format_t::etc2_rgb8 ) );
+
+    CHECK( holds( cache, TileKey{ 3, 1, 2 }, a ) );
+    CHECK( holds( cache, TileKey{ 3, 1, 2, 1 }, b ) );
+    CHECK( cache.find( TileKey{ 3, 1, 2 } )->format == TileImage::format_t::encoded );
+    CHECK( cache.find( TileKey{ 3, 1, 2, 1 } )->format == TileImage::format_t::etc2_rgb8 );
+    CHECK( cache.find( TileKey{ 3, 2, 1 } ).has_value() == false );
+
+    // Newer entry wins, the blob of the older one stays readable while referenced
+    const std::optional<TileDiskCache::blob_t> old = cache.find( TileKey{ 3, 1, 2 } );
+
+    CHECK( cache.store( TileKey{ 3, 1, 2 }, c.data(), 300 ) );
+    CHECK( holds( cache, TileKey{ 3, 1, 2 }, c ) );
+    CHECK( std::memcmp( old->data, a.data(), a.size() ) == 0 );
+
+    cache.erase( TileKey{ 3, 1, 2, 1 } );
+    CHECK( cache.find( TileKey{ 3, 1, 2, 1 } ).has_value() == false );
+
+    cache.close();
+    CHECK( cache.is_open() == false );
+
+    // Index, replacements and tombstones are loaded again
+    TileDiskCache  reopened;
+
+    CHECK( reopened.open( dir.path() ) );
+    CHECK( holds( reopened, TileKey{ 3, 1, 2 }, c ) );
+    CHECK( reopened.find( TileKey{ 3, 1, 2, 1 } ).has_value() == false );
+
+    // Stored again after the tombstone
+    CHECK( reopened.store( TileKey{ 3, 1, 2, 1 }, b.data(), 200 ) );
+    reopened.close();
+
+    CHECK( reopened.open( dir.path() ) );
+    CHECK( holds( reopened, TileKey{ 3, 1, 2, 1 }, b ) );
+  }
+
+  void  test_tombstone_only()
+  {
+    TempDir                         dir( "map-disk-cache-tombstone-test" );
+    const std::vector<ure::byte_t>  data = payload( 100, 4 );
+
+    {
+      TileDiskCache  cache;
+
+      CHECK( cache.open( dir.path() ) );
+      CHECK( cache.store( TileKey{ 7, 3, 3 }, data.data(), 100 ) );
+    }
+
+    // Session erasing a corrupted entry without storing anything, e.g. offline
+    {
+      TileDiskCache  cache;
+
+      CHECK( cache.open( dir.path() ) );
+      CHECK( holds( cache, TileKey{ 7, 3, 3 }, data ) );
+
+      cache.erase( TileKey{ 7, 3, 3 } );
+      CHECK( cache.find( TileKey{ 7, 3, 3 } ).has_value() == false );
+    }
+
+    TileDiskCache  cache;
+
+    CHECK( cache.open( dir.path() ) );
+    CHECK( cache.find( TileKey{ 7, 3, 3 } ).has_value() == false );
+  }
+
+  void  test_packs()
+  {
+    TempDir        dir( "map-disk-cache-packs-test" );
+    TileDiskCache  cache( 16 << 10, 4 << 10 );
+
+    CHECK( cache.open( dir.path() ) );
+
+    // About 40 KB in packs of 4 KB, the oldest packs are removed
+    for ( ure::uint_t i = 0; i < 40; ++i )
+    {
+      const std::vector<ure::byte_t> data = payload( 1000, static_cast<ure::byte_t>(i) );
+
+      CHECK( cache.store( TileKey{ 10, i, 0 }, data.data(), 1000 ) );
+      CHECK( holds( cache, TileKey{ 10, i, 0 }, data ) );
+      CHECK( cache.size() <= ( 16 << 10 ) );
+    }
+
+    CHECK( cache.find( TileKey{ 10, 0, 0 } ).has_value() == false );
+    CHECK( holds( cache, TileKey{ 10, 39, 0 }, payload( 1000, 39 ) ) );
+
+    std::size_t packs = 0;
+
+    for ( const auto& entry : std::filesystem::directory_iterator( dir.path() ) )
+      packs += ( entry.path().extension() == ".dat" ) ? 1 : 0;
+
+    CHECK( packs > 1 );
+    CHECK( packs <= 5 );
+
+    // Payloads larger than a pack get a pack of their own
+    const std::vector<ure::byte_t> large = payload( 10 << 10, 5 );
+
+    CHECK( cache.store( TileKey{ 11, 0, 0 }, large.data(), static_cast<ure::uint_t>( large.size() ) ) );
+    CHECK( holds( cache, TileKey{ 11, 0, 0 }, large ) );
+
+    cache.close();
+
+    TileDiskCache  reopened( 16 << 10, 4 << 10 );
+
+    CHECK( reopened.open( dir.path() ) );
+    CHECK( holds( reopened, TileKey{ 11, 0, 0 }, large ) );
+    CHECK( reopened.size() <= ( 16 << 10 ) );
+  }
+}
+
+int main()
+{
+  test_store_find();
+  test_tombstone_only();
+  test_packs();
+
+  return test_result( "tile_disk_cache_test" );
+}
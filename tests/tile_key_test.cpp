@@ -0,0 +1,114 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * TileKey packing, resource names and hashing, and TileUrl expansion.
+ */
+
+#include "test.h"
+
+#include "tile_key.h"
+#include "tile_url.h"
+
+#include <functional>
+#include <string>
+
+namespace
+{
+  void  test_packed()
+  {
+    const TileKey  keys[] = { { 0, 0, 0 }, { 1, 1, 0 }, { 18, 131071, 87654 }, { 29, ( 1u << 29 ) - 1, ( 1u << 29 ) - 1 } };
+
+    for ( const TileKey& key : keys )
+      CHECK( TileKey::unpack( key.packed() ) == key );
+
+    // z:6 x:29 y:29, the order of the disk cache index
+    CHECK( TileKey{ 1, 2, 3 }.packed() == ( ( std::uint64_t(1) << 58 ) | ( std::uint64_t(2) << 29 ) | 3 ) );
+    CHECK( TileKey{ 2, 0, 0 }.packed() > TileKey{ 1, 5, 5 }.packed() );
+
+    // Source is not packed, unpack() returns the base map
+    CHECK( TileKey::unpack( TileKey{ 4, 5, 6, 2 }.packed() ) == ( TileKey{ 4, 5, 6 } ) );
+  }
+
+  void  test_name()
+  {
+    char  buffer[TileKey::name_size];
+
+    CHECK( TileKey{ 12, 2047, 1362 }.name( buffer ) == "12-2047-1362" );
+    CHECK( TileKey{ 3, 1, 2, 4 }.name( buffer ) == "3-1-2-4" );
+    CHECK( TileKey{ 4294967295u, 4294967295u, 4294967295u, 4294967295u }.name( buffer ).size() == TileKey::name_size - 1 );
+
+    CHECK( TileKey::parse( "12-2047-1362" ) == ( TileKey{ 12, 2047, 1362 } ) );
+    CHECK( TileKey::parse( "3-1-2-4" ) == ( TileKey{ 3, 1, 2, 4 } ) );
+
+    const char* invalid[] = { "", "3", "3-1", "3-1-", "3-1-2-", "3-1-2-4-5", "a-1-2", "3-1-2x", "-3-1-2" };
+
+    for ( const char* name : invalid )
+      CHECK( TileKey::parse( name ).has_value() == false );
+
+    // Round trip
+    const TileKey key{ 17, 65000, 43000, 1 };
+
+    CHECK( TileKey::parse( key.name( buffer ) ) == key );
+  }
+
+  void  test_hash()
+  {
+    const std::hash<TileKey> hash;
+
+    CHECK( hash( TileKey{ 5, 1, 2 } ) == hash( TileKey{ 5, 1, 2 } ) );
+    CHECK( hash( TileKey{ 5, 1, 2 } ) != hash( TileKey{ 5, 1, 2, 1 } ) );
+    CHECK( hash( TileKey{ 5, 1, 2 } ) != hash( TileKey{ 5, 2, 1 } ) );
+  }
+
+  void  test_url()
+  {
+    std::string  url;
+
+    const TileUrl  named( "https://tile.example.org/{z}/{x}/{y}.png" );
+
+    named.expand( TileKey{ 12, 2047, 1362 }, url );
+    CHECK( url == "https://tile.example.org/12/2047/1362.png" );
+    CHECK( named.host() == "tile.example.org" );
+
+    // Previous content is replaced
+    named.expand( TileKey{ 0, 0, 0 }, url );
+    CHECK( url == "https://tile.example.org/0/0/0.png" );
+
+    const TileUrl  positional( "http://localhost:8080/%u/%u/%u.png?q=100%%" );
+
+    positional.expand( TileKey{ 3, 4, 5 }, url );
+    CHECK( url == "http://localhost:8080/3/4/5.png?q=100%" );
+    CHECK( positional.host() == "localhost:8080" );
+
+    // Fields in any order, unknown placeholders kept as text
+    const TileUrl  reordered( "tiles/{y}-{x}-{z}-{s}" );
+
+    reordered.expand( TileKey{ 1, 2, 3 }, url );
+    CHECK( url == "tiles/3-2-1-{s}" );
+    CHECK( reordered.host() == "tiles" );
+  }
+}
+
+int main()
+{
+  test_packed();
+  test_name();
+  test_hash();
+  test_url();
+
+  return test_result( "tile_key_test" );
+}
@@ -0,0 +1,159 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * TileRequests: single download per tile, exponential backoff with jitter after
+ * failures, prefetch accounting, cancellation and pruning of abandoned failures.
+ */
+
+#include "test.h"
+
+#include "tile_requests.h"
+
+#include <chrono>
+
+namespace
+{
+  using namespace std::chrono_literals;
+
+  using clock_t = TileRequests::clock_t;
+
+  constexpr TileKey  k_tile{ 5, 10, 12 };
+
+  void  test_acquire()
+  {
+    TileRequests               requests( 100ms, 1s );
+    const clock_t::time_point  now = clock_t::now();
+
+    CHECK( requests.acquire( k_tile, false, now ) );
+    CHECK( requests.acquire( k_tile, false, now ) == false );
+    CHECK( requests.is_pending( k_tile ) );
+    CHECK( requests.pending() == 1 );
+
+    // Other sources are other downloads
+    CHECK( requests.acquire( TileKey{ 5, 10, 12, 1 }, false, now ) );
+    CHECK( requests.pending() == 2 );
+
+    requests.succeeded( k_tile );
+    CHECK( requests.is_pending( k_tile ) == false );
+    CHECK( requests.pending() == 1 );
+    CHECK( requests.acquire( k_tile, false, now ) );
+  }
+
+  void  test_backoff()
+  {
+    TileRequests         requests( 100ms, 1s );
+    clock_t::time_point  now = clock_t::now();
+
+    CHECK( requests.acquire( k_tile, false, now ) );
+
+    // min_backoff * 2^(failures-1), plus up to 25% of jitter, capped at max_backoff
+    const clock_t::duration  delays[] = { 100ms, 200ms, 400ms, 800ms, 1s, 1s };
+
+    for ( const clock_t::duration delay : delays )
+    {
+      requests.failed( k_tile, now );
+
+      CHECK( requests.pending() == 0 );
+      CHECK( requests.acquire( k_tile, false, now + delay - 1ms ) == false );
+      CHECK( requests.acquire( k_tile, false, now + delay + delay / 4 + 1ms ) );
+
+      now += delay + delay / 4 + 1ms;
+    }
+
+    // Success forgets the failures
+    requests.succeeded( k_tile );
+    CHECK( requests.acquire( k_tile, false, now ) );
+    requests.failed( k_tile, now );
+    CHECK( requests.acquire( k_tile, false, now + 126ms ) );
+  }
+
+  void  test_prefetch()
+  {
+    TileRequests               requests( 100ms, 1s );
+    const clock_t::time_point  now = clock_t::now();
+
+    CHECK( requests.acquire( k_tile, true, now ) );
+    CHECK( requests.pending_prefetch() == 1 );
+
+    // Needed by a frame, no longer counted as prefetch
+    CHECK( requests.acquire( k_tile, false, now ) == false );
+    CHECK( requests.pending_prefetch() == 0 );
+    CHECK( requests.pending() == 1 );
+
+    CHECK( requests.acquire( TileKey{ 6, 0, 0 }, true, now ) );
+    CHECK( requests.pending_prefetch() == 1 );
+
+    // Cancelled before being issued, not a failure
+    requests.cancel( TileKey{ 6, 0, 0 } );
+    CHECK( requests.pending_prefetch() == 0 );
+    CHECK( requests.pending() == 1 );
+    CHECK( requests.acquire( TileKey{ 6, 0, 0 }, true, now ) );
+  }
+
+  void  test_prune()
+  {
+    // Abandoned: not acquired again within max_backoff of the retry time, the failure count is dropped
+    {
+      TileRequests               requests( 100ms, 1s );
+      const clock_t::time_point  now = clock_t::now() + 1ms;
+
+      CHECK( requests.acquire( k_tile, false, now ) );
+      requests.failed( k_tile, now );
+      requests.prune( now + 2s );
+
+      CHECK( requests.acquire( k_tile, false, now + 2s ) );
+      requests.failed( k_tile, now + 2s );
+      CHECK( requests.acquire( k_tile, false, now + 2s + 126ms ) );
+    }
+
+    // Retried in time, the failure count is kept and the next delay doubles
+    {
+      TileRequests               requests( 100ms, 1s );
+      const clock_t::time_point  now = clock_t::now() + 1ms;
+
+      CHECK( requests.acquire( k_tile, false, now ) );
+      requests.failed( k_tile, now );
+      requests.prune( now + 500ms );
+
+      CHECK( requests.acquire( k_tile, false, now + 500ms ) );
+      requests.failed( k_tile, now + 500ms );
+      CHECK( requests.acquire( k_tile, false, now + 500ms + 126ms ) == false );
+    }
+
+    // Pending downloads are never pruned
+    {
+      TileRequests               requests( 100ms, 1s );
+      const clock_t::time_point  now = clock_t::now() + 1ms;
+
+      CHECK( requests.acquire( k_tile, false, now ) );
+      requests.prune( now + 1h );
+
+      CHECK( requests.is_pending( k_tile ) );
+      CHECK( requests.pending() == 1 );
+    }
+  }
+}
+
+int main()
+{
+  test_acquire();
+  test_backoff();
+  test_prefetch();
+  test_prune();
+
+  return test_result( "tile_requests_test" );
+}
@@ -0,0 +1,262 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the terms 
+ * of the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with this program. 
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ *************************************************************************************************/
+
+/**
+ * Pre-build the overview levels of a region in a tile pack, so that the map shows
+ * them without downloading anything.
+ *
+ *   tile_pyramid --bbox 12.2,41.6,12.8,42.1 --min-zoom 8 --max-zoom 14
+ *
+ * Tiles at --max-zoom are read from the disk cache used by the map, or imported
+ * from DIR/z/x/y.png with --tiles, and downsampled level by level with TilePyramid.
+ * The box is expanded to whole tiles of --min-zoom: a tile is built only when all
+ * four children are available, missing ones are reported.
+ */
+
+#include "tile_disk_cache.h"
+#include "tile_image.h"
+#include "tile_pyramid.h"
+#include "tile_range.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  struct options_t
+  {
+    std::string         cache       = "./cache/tiles/";
+    std::string         tiles;
+    ure::double_t       bbox[4]     = { 0.0, 0.0, -1.0, -1.0 };   /* west, south, east, north */
+    ure::uint_t         min_zoom    = 0;
+    ure::uint_t         max_zoom    = 0;
+    ure::uint_t         cache_mb    = 512;
+    ure::uint_t         tile_size   = 256;     /* Side of the tiles the map stores as pixels */
+    TileImage::format_t format      = TileImage::format_t::rgba8;
+  };
+
+  struct stats_t
+  {
+    ure::uint_t   leaves;
+    ure::uint_t   missing;
+    ure::uint_t   built;
+    std::uint64_t bytes;
+  };
+
+  void  usage( const char* name )
+  {
+    printf( "usage: %s --bbox W,S,E,N --max-zoom N [options]\n"
+            "  --bbox W,S,E,N    region in degrees, expanded to whole tiles of --min-zoom\n"
+            "  --max-zoom N      level of the source tiles\n"
+            "  --min-zoom N      last level to build (0)\n"
+            "  --cache DIR       tile pack to read and write (./cache/tiles/)\n"
+            "  --cache-size MB   pack size cap, older packs are dropped past it (512)\n"
+            "  --tiles DIR       import source tiles from DIR/z/x/y.png instead of reading the pack\n"
+            "  --format F        stored format of built tiles: rgba8 or etc2 (rgba8)\n", name );
+  }
+
+  ure::bool_t  parse( int argc, char** argv, options_t& options )
+  {
+    ure::bool_t has_max = false;
+
+    for ( int i = 1; i + 1 < argc; i += 2 )
+    {
+      const std::string_view arg( argv[i] );
+      const char*            value = argv[i + 1];
+
+      if      ( arg == "--cache"      ) options.cache    = value;
+      else if ( arg == "--tiles"      ) options.tiles    = value;
+      else if ( arg == "--min-zoom"   ) options.min_zoom = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--cache-size" ) options.cache_mb = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+      else if ( arg == "--max-zoom"   )
+      {
+        options.max_zoom = static_cast<ure::uint_t>( std::strtoul( value, nullptr, 10 ) );
+        has_max          = true;
+      }
+      else if ( arg == "--bbox" )
+      {
+        if ( std::sscanf( value, "%lf,%lf,%lf,%lf", &options.bbox[0], &options.bbox[1], &options.bbox[2], &options.bbox[3] ) != 4 )
+          return false;
+      }
+      else if ( arg == "--format" )
+      {
+        if      ( std::strcmp( value, "rgba8" ) == 0 ) options.format = TileImage::format_t::rgba8;
+        else if ( std::strcmp( value, "etc2"  ) == 0 ) options.format = TileImage::format_t::etc2_rgb8;
+        else
+          return false;
+      }
+      else
+        return false;
+    }
+
+    return ( argc % 2 == 1 ) && has_max && ( options.min_zoom < options.max_zoom ) && ( options.max_zoom < TileKey::xy_bits ) &&
+           ( options.bbox[0] <= options.bbox[2] ) && ( options.bbox[1] <= options.bbox[3] );
+  }
+
+  /**
+   * Builds the tiles below a --min-zoom tile depth first, at most four images per level are alive.
+   */
+  class Builder
+  {
+  public:
+    /***/
+    Builder( const options_t& options, TileDiskCache& disk ) noexcept(true)
+      : m_options( options ), m_disk( disk ), m_stats{ 0, 0, 0, 0 }
+    {}
+
+    /**
+     * RGBA8 pixels of @p key, built from its children and stored in the pack below --max-zoom.
+     */
+    std::optional<TileImage>  build( const TileKey& key ) noexcept(true)
+    {
+      if ( key.z == m_options.max_zoom )
+        return leaf( key );
+
+      std::optional<TileImage>  children[4];
+      const TileImage*          sources[4];
+      ure::bool_t               complete = true;
+
+      // Keep visiting the other children, their own parents may still be built
+      for ( ure::uint_t i = 0; i < 4; ++i )
+      {
+        children[i] = build( TilePyramid::child( key, i ) );
+        sources[i]  = children[i].has_value() ? &children[i].value() : nullptr;
+        complete    = complete && children[i].has_value();
+      }
+
+      TileImage parent;
+
+      if ( ( complete == false ) || ( TilePyramid::downsample( sources, parent ) == false ) )
+        return std::nullopt;
+
+      TileImage stored( parent );
+
+      if ( stored.convert( m_options.format ) &&
+           m_disk.store( key, stored.pixels.data(), static_cast<ure::uint_t>( stored.bytes() ), stored.format ) )
+      {
+        ++m_stats.built;
+        m_stats.bytes += stored.bytes();
+      }
+
+      return parent;
+    }
+
+    /***/
+    const stats_t&  stats() const noexcept
+    { return m_stats; }
+
+  private:
+    /***/
+    std::optional<TileImage>  leaf( const TileKey& key ) noexcept(true)
+    {
+      TileImage   image;
+      ure::bool_t valid = false;
+
+      if ( m_options.tiles.empty() == false )
+      {
+        const std::string path = m_options.tiles + "/" + std::to_string( key.z ) + "/" + std::to_string( key.x ) + "/" + std::to_string( key.y ) + ".png";
+        std::ifstream     file( path, std::ios::binary );
+
+        const std::vector<ure::byte_t> data( ( std::istreambuf_iterator<char>(file) ), std::istreambuf_iterator<char>() );
+
+        valid = ( data.empty() == false ) && TileImage::decode( data.data(), static_cast<ure::uint_t>( data.size() ), image );
+
+        // The pack gets the source level too, as the map would have stored it
+        if ( valid )
+          m_disk.store( key, data.data(), static_cast<ure::uint_t>( data.size() ) );
+      }
+      else if ( std::optional<TileDiskCache::blob_t> blob = m_disk.find( key ); blob.has_value() )
+      {
+        if ( blob->format == TileImage::format_t::encoded )
+        {
+          valid = TileImage::decode( blob->data, blob->length, image );
+        }
+        else
+        {
+          const ure::uint_t side = m_options.tile_size;
+
+          image.width  = side;
+          image.height = side;
+          image.format = blob->format;
+          image.pixels.assign( blob->data, blob->data + blob->length );
+
+          valid = ( blob->length == TileImage::size( blob->format, side, side ) ) && image.expand();
+        }
+      }
+
+      ++( valid ? m_stats.leaves : m_stats.missing );
+
+      if ( valid == false )
+        return std::nullopt;
+
+      return image;
+    }
+
+  private:
+    const options_t&  m_options;
+    TileDiskCache&    m_disk;
+    stats_t           m_stats;
+  };
+}
+
+int main( int argc, char** argv )
+{
+  options_t options;
+
+  if ( parse( argc, argv, options ) == false )
+  {
+    usage( argv[0] );
+    return 2;
+  }
+
+  TileDiskCache disk( std::uint64_t( options.cache_mb ) << 20 );
+
+  if ( disk.open( options.cache ) == false )
+  {
+    printf( "unable to open the tile pack in [%s]\n", options.cache.c_str() );
+    return 1;
+  }
+
+  const TileRange range  = geo_tile_range( options.bbox[0], options.bbox[1], options.bbox[2], options.bbox[3], options.min_zoom );
+  const ure::uint_t depth = options.max_zoom - options.min_zoom;
+
+  printf( "levels %u-%u, %u tiles at level %u, up to %llu source tiles\n", options.min_zoom, options.max_zoom, range.count(), options.min_zoom,
+          static_cast<unsigned long long>( range.count() ) << ( 2 * depth ) );
+
+  Builder builder( options, disk );
+
+  for ( ure::int_t y = range.y0; y <= range.y1; ++y )
+  {
+    for ( ure::int_t x = range.x0; x <= range.x1; ++x )
+      builder.build( TileKey{ options.min_zoom, static_cast<ure::uint_t>(x), static_cast<ure::uint_t>(y) } );
+  }
+
+  disk.close();
+
+  const stats_t& stats = builder.stats();
+
+  printf( "source tiles      %u (missing %u)\n", stats.leaves, stats.missing );
+  printf( "built tiles       %u as %s, %.1f MB\n", stats.built, TileImage::name( options.format ), stats.bytes / 1048576.0 );
+
+  return ( stats.built > 0 ) ? 0 : 1;
+}